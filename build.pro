@@ -1,3 +1,8 @@
 TEMPLATE = subdirs
 SUBDIRS = qwt src
 CONFIG += ordered
+
+# make benchmarks, see src/src.pro
+benchmarks.commands = cd src && $(MAKE) benchmarks
+benchmarks.depends = all
+QMAKE_EXTRA_TARGETS += benchmarks
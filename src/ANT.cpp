@@ -98,6 +98,12 @@ ANT::ANT(QObject *parent, DeviceConfiguration *devConf) : QThread(parent), devCo
     kickrDeviceID = 0;
     kickrChannel = -1;
 
+    // not replaying a capture
+    replaying = false;
+    replaySpeed = 1.0;
+    replayJitter = replayDropout = 0;
+    replayBytes = 0;
+
     // vortex
     vortexID = vortexChannel = -1;
 
@@ -165,6 +171,15 @@ void ANT::setBaud(int x)
     baud = x;
 }
 
+void ANT::setReplay(QString filename, double speed, double jitter, double dropout)
+{
+    replaying = true;
+    deviceFilename = filename;
+    replaySpeed = speed > 0 ? speed : 1.0;
+    replayJitter = jitter;
+    replayDropout = dropout;
+}
+
 double ANT::channelValue2(int channel)
 {
     return antChannel[channel]->channelValue2();
@@ -852,6 +867,11 @@ ANT::processMessage(void) {
 
 int ANT::closePort()
 {
+    if (replaying) {
+        replayFile.close();
+        return 0;
+    }
+
 #ifdef WIN32
 #ifdef GC_HAVE_LIBUSB
     switch (usbMode) {
@@ -895,6 +915,15 @@ bool ANT::find()
 
 int ANT::openPort()
 {
+    // replay from a capture file, all channels available
+    if (replaying) {
+        replayFile.setFileName(deviceFilename);
+        if (!replayFile.open(QFile::ReadOnly)) return -1;
+        channels = ANT_MAX_CHANNELS;
+        replayBytes = 0;
+        return 0;
+    }
+
 #ifdef WIN32
 #ifdef GC_HAVE_LIBUSB
     int rc;
@@ -985,6 +1014,9 @@ int ANT::rawWrite(uint8_t *bytes, int size) // unix!!
 {
     int rc=0;
 
+    // nobody is listening when replaying
+    if (replaying) return size;
+
 #ifdef WIN32
 #ifdef GC_HAVE_LIBUSB
     switch (usbMode) {
@@ -1034,6 +1066,8 @@ int ANT::rawWrite(uint8_t *bytes, int size) // unix!!
 
 int ANT::rawRead(uint8_t bytes[], int size)
 {
+    if (replaying) return replayRead(bytes, size);
+
 #ifdef WIN32
 #ifdef GC_HAVE_LIBUSB
     switch (usbMode) {
@@ -1075,6 +1109,40 @@ int ANT::rawRead(uint8_t bytes[], int size)
     return -1; // keep compiler happy.
 }
 
+//
+// ANTLogger writes each message as ANT_MAX_MESSAGE_SIZE bytes with no
+// timestamp, so we pace the replay at the nominal broadcast rate and
+// apply jitter and dropouts one message at a time. The receive state
+// machine skips the padding just as it would from a real stick.
+//
+int ANT::replayRead(uint8_t bytes[], int size)
+{
+    int i=0;
+    for (i=0; i<size; i++) {
+
+        // start of a new message
+        if (replayBytes % ANT_MAX_MESSAGE_SIZE == 0) {
+
+            double period = ANT_REPLAY_PERIOD / double(antIDs.count() ? antIDs.count() : 4);
+            if (replayJitter > 0) period += replayJitter * (double(rand()%2001) / 1000.0 - 1.0);
+            period /= replaySpeed;
+            if (period >= 1) msleep((unsigned long) period);
+
+            // lose a message now and again
+            while (replayDropout > 0 && (rand()%10000) < replayDropout * 100 && !replayFile.atEnd()) {
+                replayFile.read(ANT_MAX_MESSAGE_SIZE);
+                replayBytes += ANT_MAX_MESSAGE_SIZE;
+            }
+        }
+
+        char c;
+        if (!replayFile.getChar(&c)) return i ? i : -1; // end of capture
+        bytes[i] = (uint8_t) c;
+        replayBytes++;
+    }
+    return i;
+}
+
 // convert 'p' 'c' etc into ANT values for device type
 int ANT::interpretSuffix(char c)
 {
@@ -83,6 +83,10 @@
 #define ANT_READTIMEOUT    1000
 #define ANT_WRITETIMEOUT   2000
 
+// ANT+ sport sensors broadcast at ~4Hz, the capture has no
+// timestamps so we pace replay at this rate per paired device
+#define ANT_REPLAY_PERIOD  250
+
 class ANTMessage;
 class ANTChannel;
 
@@ -326,6 +330,10 @@ public slots:
     bool find();                              // find usb device
     bool discover(QString name);              // confirm Server available at portSpec
 
+    // replay an ANTLogger capture through the normal receive path
+    // instead of reading from a stick (see ReplayController)
+    void setReplay(QString filename, double speed, double jitter, double dropout);
+
     int channelCount() { return channels; }   // how many channels we got available?
     void channelInfo(int number, int device_number, int device_id);  // found a device
     void dropInfo(int number, int drops, int received);    // we dropped a connection
@@ -381,6 +389,7 @@ public:
     int closePort();
     int rawRead(uint8_t bytes[], int size);
     int rawWrite(uint8_t *bytes, int size);
+    int replayRead(uint8_t bytes[], int size);
 
     // channels update our telemetry
     double channelValue(int channel);
@@ -471,6 +480,12 @@ private:
 
     QQueue<setChannelAtom> channelQueue; // messages for configuring channels from controller
 
+    // replaying a capture rather than reading a device
+    bool replaying;
+    QFile replayFile;
+    double replaySpeed, replayJitter, replayDropout;
+    qint64 replayBytes;
+
     // generic trainer settings
     double currentLoad, load;
     double currentGradient, gradient;
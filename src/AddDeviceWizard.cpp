@@ -205,6 +205,7 @@ DeviceScanner::quickScan(bool deep) // scan quickly or if true scan forever, as
     case DEV_FORTIUS : wizard->controller = new FortiusController(NULL, NULL); break;
 #endif
     case DEV_NULL : wizard->controller = new NullController(NULL, NULL); break;
+    case DEV_REPLAY : wizard->controller = new ReplayController(NULL, NULL); break;
     case DEV_ANTLOCAL : wizard->controller = new ANTlocalController(NULL, NULL); break;
 #ifdef GC_HAVE_WFAPI
     case DEV_KICKR : wizard->controller = new KickrController(NULL, NULL); break;
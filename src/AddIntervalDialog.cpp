@@ -22,6 +22,7 @@
 #include "Context.h"
 #include "IntervalItem.h"
 #include "RideFile.h"
+#include "IntervalSearch.h"
 #include "RideItem.h"
 #include "WPrime.h"
 #include "HelpWhatsThis.h"
@@ -382,41 +383,6 @@ clearResultsTable(QTableWidget *resultsTable)
     resultsTable->setRowCount(0);
 }
 
-static double
-intervalDuration(const RideFilePoint *start, const RideFilePoint *stop, const RideFile *ride)
-{
-    return stop->secs - start->secs + ride->recIntSecs();
-}
-
-static double
-intervalDistance(const RideFilePoint *start, const RideFilePoint *stop, const RideFile *)
-{
-    return 1000*(stop->km - start->km);// + (ride->recIntSecs()*stop->kph/3600));
-}
-
-static bool
-intervalsOverlap(const AddIntervalDialog::AddedInterval &a,
-                 const AddIntervalDialog::AddedInterval &b)
-{
-    if ((a.start <= b.start) && (a.stop > b.start))
-        return true;
-    if ((b.start <= a.start) && (b.stop > a.start))
-        return true;
-    return false;
-}
-
-struct CompareBests {
-    // Sort by decreasing power and increasing start time.
-    bool operator()(const AddIntervalDialog::AddedInterval &a,
-                    const AddIntervalDialog::AddedInterval &b) const {
-        if (a.avg > b.avg)
-            return true;
-        if (b.avg > a.avg)
-            return false;
-        return a.start < b.start;
-    }
-};
-
 void
 AddIntervalDialog::createClicked()
 {
@@ -625,41 +591,12 @@ AddIntervalDialog::findFirsts(bool typeTime, const RideFile *ride, double window
 {
     QList<AddedInterval> bests;
 
-    double secsDelta = ride->recIntSecs();
-    double totalWatts = 0.0;
-    QList<const RideFilePoint*> window;
-
-    // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    else if (windowSize > ride->dataPoints().last()->km*1000) return;
-
-    double rest = 0;
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    foreach (const RideFilePoint *point, ride->dataPoints()) {
-
-        // Add points until interval duration is >= windowSizeSecs.
-        totalWatts += point->watts;
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
-
-        if ((typeTime && duration >= (windowSize - rest)) ||
-            (!typeTime && distance >= (windowSize - rest))) {
-            double start = window.first()->secs;
-            double stop = start + duration - (typeTime?0:ride->recIntSecs()); // correction for distance
-            double avg = totalWatts * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
-            rest = (typeTime?duration-windowSize+rest:distance-windowSize+rest);
-            // Discard points
-            window.clear();
-            totalWatts = 0;
-
-            // For distance the last point of an interval is also the first point of the next
-            if (!typeTime)  {
-                totalWatts += point->watts;
-                window.append(point);
-            }
-        }
+    // consecutive intervals from the start of the ride
+    IntervalSearch search(ride);
+    foreach(const IntervalSearch::Result &first, search.firsts(windowSize, maxIntervals - results.size(),
+                                                     typeTime ? IntervalSearch::ByTime : IntervalSearch::ByDistance)) {
+        double stop = typeTime ? first.start + first.duration : first.stop; // correction for distance
+        bests.append(AddedInterval(first.start, stop, first.avg));
     }
 
     while (!bests.empty() && (results.size() < maxIntervals)) {
@@ -725,126 +662,94 @@ AddIntervalDialog::findFirsts(bool typeTime, const RideFile *ride, double window
 void
 AddIntervalDialog::findPeakPowerStandard(const RideFile *ride, QList<AddedInterval> &results)
 {
-    findBests(true, ride, 5, 1, results, tr("Peak 5s"));
-    findBests(true, ride, 10, 1, results, tr("Peak 10s"));
-    findBests(true, ride, 20, 1, results, tr("Peak 20s"));
-    findBests(true, ride, 30, 1, results, tr("Peak 30s"));
-    findBests(true, ride, 60, 1, results, tr("Peak 1min"));
-    findBests(true, ride, 120, 1, results, tr("Peak 2min"));
-    findBests(true, ride, 300, 1, results, tr("Peak 5min"));
-    findBests(true, ride, 600, 1, results, tr("Peak 10min"));
-    findBests(true, ride, 1200, 1, results, tr("Peak 20min"));
-    findBests(true, ride, 1800, 1, results, tr("Peak 30min"));
-    findBests(true, ride, 3600, 1, results, tr("Peak 60min"));
+    static const double durations[] = { 5, 10, 20, 30, 60, 120, 300, 600, 1200, 1800, 3600 };
+    const QString names[] = { tr("Peak 5s"), tr("Peak 10s"), tr("Peak 20s"), tr("Peak 30s"),
+                              tr("Peak 1min"), tr("Peak 2min"), tr("Peak 5min"), tr("Peak 10min"),
+                              tr("Peak 20min"), tr("Peak 30min"), tr("Peak 60min") };
+
+    // all durations in a single pass over the ride
+    QVector<double> sizes;
+    for (unsigned int i=0; i<sizeof(durations)/sizeof(durations[0]); i++) sizes << durations[i];
+
+    IntervalSearch search(ride);
+    QVector<IntervalSearch::Result> peaks = search.peaks(sizes);
+
+    for (int i=0; i<peaks.count(); i++) {
+        if (!peaks[i].isValid()) continue;
+
+        AddedInterval add(peaks[i].start, peaks[i].stop, peaks[i].avg);
+        add.name = QString(names[i] + " (%4w)").arg(round(add.avg));
+        results.append(add);
+    }
 }
 
 void
 AddIntervalDialog::findBests(bool typeTime, const RideFile *ride, double windowSize,
                               int maxIntervals, QList<AddedInterval> &results, QString prefix)
 {
-    QList<AddedInterval> bests;
     QList<AddedInterval> _results;
 
-    double secsDelta = ride->recIntSecs();
-    double totalWatts = 0.0;
-    QList<const RideFilePoint*> window;
-
-    // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
-
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    foreach (const RideFilePoint *point, ride->dataPoints()) {
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
-               (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
-            totalWatts -= window.first()->watts;
-            window.takeFirst();
-        }
-        // Add points until interval duration or distance is >= windowSize.
-        totalWatts += point->watts;
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
-
-        if ((typeTime && duration >= windowSize) ||
-            (!typeTime && distance >= windowSize)) {
-            double start = window.first()->secs;
-            double stop = window.last()->secs; //start + duration;
-            double avg = totalWatts * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
-        }
-    }
-
-    std::sort(bests.begin(), bests.end(), CompareBests());
-
-    while (!bests.empty() && (_results.size() < maxIntervals)) {
-        AddedInterval candidate = bests.takeFirst();
-        bool overlaps = false;
-        foreach (const AddedInterval &existing, _results) {
-            if (intervalsOverlap(candidate, existing)) {
-                overlaps = true;
-                break;
-            }
-        }
-        if (!overlaps) {
-            QString name = prefix;
-            if (prefix == "") {
-                name = tr("Best %2%3 #%1");
-                name = name.arg(_results.count()+1);
-                if (typeTime)  {
-                    // best n mins
-                    if (windowSize < 60) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("sec");
-                    } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
-                        // whole minutes
-                        name = name.arg(windowSize/60);
-                        name = name.arg("min");
-                    } else {
-                        double secs = windowSize;
-                        double mins = ((int) secs) / 60;
-                        secs = secs - mins * 60.0;
-                        double hrs = ((int) mins) / 60;
-                        mins = mins - hrs * 60.0;
-                        QString tm = "%1:%2:%3";
-                        tm = tm.arg(hrs, 0, 'f', 0);
-                        tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
-                        tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
-
-                        // mins and secs
-                        name = name.arg(tm);
-                        name = name.arg("");
-                    }
+    IntervalSearch search(ride);
+    foreach(const IntervalSearch::Result &best, search.bests(windowSize, maxIntervals,
+                                                   typeTime ? IntervalSearch::ByTime : IntervalSearch::ByDistance)) {
+
+        AddedInterval candidate(best.start, best.stop, best.avg);
+        QString name = prefix;
+        if (prefix == "") {
+            name = tr("Best %2%3 #%1");
+            name = name.arg(_results.count()+1);
+            if (typeTime)  {
+                // best n mins
+                if (windowSize < 60) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("sec");
+                } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
+                    // whole minutes
+                    name = name.arg(windowSize/60);
+                    name = name.arg("min");
+                } else {
+                    double secs = windowSize;
+                    double mins = ((int) secs) / 60;
+                    secs = secs - mins * 60.0;
+                    double hrs = ((int) mins) / 60;
+                    mins = mins - hrs * 60.0;
+                    QString tm = "%1:%2:%3";
+                    tm = tm.arg(hrs, 0, 'f', 0);
+                    tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
+                    tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
+
+                    // mins and secs
+                    name = name.arg(tm);
+                    name = name.arg("");
+                }
+            } else {
+                // best n mins
+                if (windowSize < 1000) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("m");
                 } else {
-                    // best n mins
-                    if (windowSize < 1000) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("m");
-                    } else {
-                        double dist = windowSize;
-                        double kms = ((int) dist) / 1000;
-                        dist = dist - kms * 1000.0;
-                        double ms = dist;
-
-                        QString tm = "%1,%2";
-                        tm = tm.arg(kms);
-                        tm = tm.arg(ms);
-
-                        // km and m
-                        name = name.arg(tm);
-                        name = name.arg("km");
-                    }
+                    double dist = windowSize;
+                    double kms = ((int) dist) / 1000;
+                    dist = dist - kms * 1000.0;
+                    double ms = dist;
+
+                    QString tm = "%1,%2";
+                    tm = tm.arg(kms);
+                    tm = tm.arg(ms);
+
+                    // km and m
+                    name = name.arg(tm);
+                    name = name.arg("km");
                 }
             }
-            name += " (%4w)";
-            name = name.arg(round(candidate.avg));
-            candidate.name = name;
-            name = "";
-            _results.append(candidate);
         }
+        name += " (%4w)";
+        name = name.arg(round(candidate.avg));
+        candidate.name = name;
+        name = "";
+        _results.append(candidate);
     }
     results.append(_results);
 }
@@ -26,6 +26,7 @@
 #include "Settings.h"
 #include "Units.h"
 #include "Colors.h"
+#include "LODCurveData.h"
 
 #include <cmath>
 #include <qwt_series_data.h>
@@ -479,8 +480,9 @@ Aerolab::recalc( bool new_zoom ) {
   int rideTimeSecs = (int) ceil(timeArray[arrayLength - 1]);
   int totalRideDistance = (int ) ceil(distanceArray[arrayLength - 1]);
 
-  // If the ride is really long, then avoid it like the plague.
-  if (rideTimeSecs > 7*24*60*60) {
+  // Curves are decimated for display so long rides are fine, but
+  // avoid corrupt timestamps like the plague.
+  if (rideTimeSecs > 31*24*60*60) {
     QVector<double> data;
 
     if (!veArray.empty()){
@@ -498,11 +500,11 @@ Aerolab::recalc( bool new_zoom ) {
 
   // set curves
   if (!veArray.empty()) {
-      veCurve->setSamples(xaxis.data() + startingIndex, veArray.data() + startingIndex, totalPoints);
+      veCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, veArray.data() + startingIndex, totalPoints, canvas()));
   }
 
   if (!altArray.empty()){
-      altCurve->setSamples(xaxis.data() + startingIndex, altArray.data() + startingIndex, totalPoints);
+      altCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, altArray.data() + startingIndex, totalPoints, canvas()));
   }
 
   if( new_zoom )
@@ -18,8 +18,10 @@
  */
 
 #include "AllPlot.h"
+#include "GcTrace.h"
 #include "Context.h"
 #include "Athlete.h"
+#include "RideCache.h"
 #include "AllPlotWindow.h"
 #include "AllPlotSlopeCurve.h"
 #include "ReferenceLineDialog.h"
@@ -32,6 +34,7 @@
 #include "Zones.h"
 #include "Colors.h"
 #include "WPrime.h"
+#include "LODCurveData.h"
 
 #include <qwt_plot_curve.h>
 #include <qwt_plot_canvas.h>
@@ -276,6 +279,7 @@ max(double a, double b) { if (a > b) return a; else return b; }
 AllPlotObject::AllPlotObject(AllPlot *plot) : plot(plot)
 {
     maxKM = maxSECS = 0;
+    smoother = QSharedPointer<Smoother>(new Smoother());
 
     wattsCurve = new QwtPlotCurve(tr("Power"));
     wattsCurve->setPaintAttribute(QwtPlotCurve::FilterPoints, true);
@@ -795,7 +799,7 @@ AllPlot::AllPlot(QWidget *parent, AllPlotWindow *window, Context *context, RideF
     if (appsettings->value(this, GC_SHADEZONES, true).toBool()==false)
         shade_zones = false;
 
-    smooth = 1;
+    smooth = pendingSmooth = 1;
     wantxaxis = wantaxis = true;
     setAutoDelete(false); // no - we are managing it via the AllPlotObjects now
     referencePlot = NULL;
@@ -825,6 +829,9 @@ AllPlot::AllPlot(QWidget *parent, AllPlotWindow *window, Context *context, RideF
 
     standard->intervalHighlighterCurve->setSamples(new IntervalPlotData(this, context));
 
+    // smoothing in the background
+    connect(&smoothWatcher, SIGNAL(finished()), this, SLOT(smoothingPrepared()));
+
     setAxisMaxMinor(xBottom, 0);
     enableAxis(xBottom, true);
     setAxisVisible(xBottom, true);
@@ -1444,27 +1451,86 @@ AllPlot::setHighlightIntervals(bool state)
     }
 }
 
-struct DataPoint {
-
-    double time, hr, watts, atiss, antiss, np, rv, rcad, rgct,
-           smo2, thb, o2hb, hhb, ap, xp, speed, cad, 
-           alt, temp, wind, torque, lrbalance, lte, rte, lps, rps,
-           lpco, rpco, lppb, rppb, lppe, rppe, lpppb, rpppb, lpppe, rpppe,
-           kphd, wattsd, cadd, nmd, hrd, slope;
-
-    DataPoint(double t, double h, double w, double at, double an, double n, double rv, double rcad, double rgct,
-              double smo2, double thb, double o2hb, double hhb, double l, double x, double s, double c,
-              double a, double te, double wi, double tq, double lrb, double lte, double rte, double lps, double rps,
-              double lpco, double rpco, double lppb, double rppb, double lppe, double rppe, double lpppb, double rpppb, double lpppe, double rpppe,
-              double kphd, double wattsd, double cadd, double nmd, double hrd, double sl) :
-
-              time(t), hr(h), watts(w), atiss(at), antiss(an), np(n), rv(rv), rcad(rcad), rgct(rgct),
-              smo2(smo2), thb(thb), o2hb(o2hb), hhb(hhb), ap(l), xp(x), speed(s), cad(c),
-              alt(a), temp(te), wind(wi), torque(tq), lrbalance(lrb), lte(lte), rte(rte), lps(lps), rps(rps),
-              lpco(lpco), rpco(rpco), lppb(lppb), rppb(rppb), lppe(lppe), rppe(rppe), lpppb(lpppb), rpppb(rpppb), lpppe(lpppe), rpppe(rpppe),
-              kphd(kphd), wattsd(wattsd), cadd(cadd), nmd(nmd), hrd(hrd), slope(sl) {}
+// the series smoothed by AllPlot::recalc, used as ids for the smoother cache,
+// imperial units are offset by SmoothCount since the samples differ
+enum {
+    SmoothWatts = 0, SmoothNP, SmoothRV, SmoothRCad, SmoothRGCT, SmoothSmO2, SmoothtHb,
+    SmoothO2Hb, SmoothHHb, SmoothAT, SmoothANT, SmoothXP, SmoothAP, SmoothHr, SmoothSpeed,
+    SmoothAccel, SmoothWattsD, SmoothCadD, SmoothNmD, SmoothHrD, SmoothCad, SmoothAltitude,
+    SmoothSlope, SmoothTemp, SmoothWind, SmoothTorque, SmoothBalance, SmoothLTE, SmoothRTE,
+    SmoothLPS, SmoothRPS, SmoothLPCO, SmoothRPCO, SmoothLPPB, SmoothRPPB, SmoothLPPE, SmoothRPPE,
+    SmoothLPPPB, SmoothRPPPB, SmoothLPPPE, SmoothRPPPE, SmoothCount
 };
 
+// where the samples come from, and how they are read. Every series the
+// ride has is smoothed, not just the curves showing, since the stacked
+// plots copy them all from here (setDataFromPlot) and showing a curve
+// only makes it visible, it doesn't recalc. Absent series cost nothing.
+static QList<Smoother::Series>
+smoothingSeries(const AllPlotSamples *o)
+{
+    QList<Smoother::Series> returning;
+    returning << Smoother::Series(SmoothWatts, o->wattsArray)
+              << Smoother::Series(SmoothNP, o->npArray)
+              << Smoother::Series(SmoothRV, o->rvArray)
+              << Smoother::Series(SmoothRCad, o->rcadArray)
+              << Smoother::Series(SmoothRGCT, o->rgctArray)
+              << Smoother::Series(SmoothSmO2, o->smo2Array)
+              << Smoother::Series(SmoothtHb, o->thbArray)
+              << Smoother::Series(SmoothO2Hb, o->o2hbArray)
+              << Smoother::Series(SmoothHHb, o->hhbArray)
+              << Smoother::Series(SmoothAT, o->atissArray)
+              << Smoother::Series(SmoothANT, o->antissArray)
+              << Smoother::Series(SmoothXP, o->xpArray)
+              << Smoother::Series(SmoothAP, o->apArray)
+              << Smoother::Series(SmoothHr, o->hrArray)
+              << Smoother::Series(SmoothSpeed, o->speedArray)
+              << Smoother::Series(SmoothAccel, o->accelArray)
+              << Smoother::Series(SmoothWattsD, o->wattsDArray)
+              << Smoother::Series(SmoothCadD, o->cadDArray)
+              << Smoother::Series(SmoothNmD, o->nmDArray)
+              << Smoother::Series(SmoothHrD, o->hrDArray)
+              << Smoother::Series(SmoothCad, o->cadArray)
+              << Smoother::Series(SmoothAltitude, o->altArray, Smoother::Raw, true)
+              << Smoother::Series(SmoothSlope, o->slopeArray)
+              << Smoother::Series(SmoothTemp, o->tempArray, Smoother::Temperature)
+              << Smoother::Series(SmoothWind, o->windArray)
+              << Smoother::Series(SmoothTorque, o->torqueArray)
+              << Smoother::Series(SmoothBalance, o->balanceArray, Smoother::Balance)
+              << Smoother::Series(SmoothLTE, o->lteArray, Smoother::Positive)
+              << Smoother::Series(SmoothRTE, o->rteArray, Smoother::Positive)
+              << Smoother::Series(SmoothLPS, o->lpsArray, Smoother::Positive)
+              << Smoother::Series(SmoothRPS, o->rpsArray, Smoother::Positive)
+              << Smoother::Series(SmoothLPCO, o->lpcoArray)
+              << Smoother::Series(SmoothRPCO, o->rpcoArray)
+              << Smoother::Series(SmoothLPPB, o->lppbArray, Smoother::Positive)
+              << Smoother::Series(SmoothRPPB, o->rppbArray, Smoother::Positive)
+              << Smoother::Series(SmoothLPPE, o->lppeArray, Smoother::Positive)
+              << Smoother::Series(SmoothRPPE, o->rppeArray, Smoother::Positive)
+              << Smoother::Series(SmoothLPPPB, o->lpppbArray, Smoother::Positive)
+              << Smoother::Series(SmoothRPPPB, o->rpppbArray, Smoother::Positive)
+              << Smoother::Series(SmoothLPPPE, o->lpppeArray, Smoother::Positive)
+              << Smoother::Series(SmoothRPPPE, o->rpppeArray, Smoother::Positive);
+
+    if (!o->metric)
+        for (int i=0; i<returning.count(); i++) returning[i].id += SmoothCount;
+    return returning;
+}
+
+void
+AllPlot::prepareRide(RideFile *ride, bool metric, int smooth)
+{
+    // same rules as recalc, nothing to smooth
+    if (!ride || ride->dataPoints().isEmpty() || smooth <= ride->recIntSecs()) return;
+
+    AllPlotSamples samples;
+    samples.fill(ride, metric);
+
+    QSharedPointer<Smoother> smoother = ride->smoother();
+    foreach(Smoother::Series series, smoothingSeries(&samples))
+        smoother->smooth(samples.timeArray, series, smooth);
+}
+
 bool AllPlot::shadeZones() const
 {
     return shade_zones;
@@ -1564,8 +1630,11 @@ AllPlot::recalc(AllPlotObject *objects)
     if (!rideItem || !rideItem->ride()) return;
 
 
+    // curves are decimated for display (see LODCurveData) so multi-day
+    // rides are fine, but corrupt timestamps would have us allocate
+    // per-second smoothing arrays spanning years
     int rideTimeSecs = (int) ceil(objects->timeArray[objects->timeArray.count()-1]);
-    if (rideTimeSecs > 7*24*60*60) {
+    if (rideTimeSecs > 31*24*60*60) {
 
         // clear all the curves
         QwtArray<double> data;
@@ -1637,372 +1706,97 @@ AllPlot::recalc(AllPlotObject *objects)
     // we should only smooth the curves if objects->smoothed rate is greater than sample rate
     if (applysmooth > 0) {
 
-        double totalWatts = 0.0;
-        double totalNP = 0.0;
-        double totalRCad = 0.0;
-        double totalRV = 0.0;
-        double totalRGCT = 0.0;
-        double totalSmO2 = 0.0;
-        double totaltHb = 0.0;
-        double totalO2Hb = 0.0;
-        double totalHHb = 0.0;
-        double totalATISS = 0.0;
-        double totalANTISS = 0.0;
-        double totalXP = 0.0;
-        double totalAP = 0.0;
-        double totalHr = 0.0;
-        double totalSpeed = 0.0;
-        double totalAccel = 0.0;
-        double totalWattsD = 0.0;
-        double totalCadD = 0.0;
-        double totalNmD = 0.0;
-        double totalHrD = 0.0;
-        double totalCad = 0.0;
-        double totalDist = 0.0;
-        double totalAlt = 0.0;
-        double totalSlope = 0.0;
-        double totalTemp = 0.0;
-        double totalWind = 0.0;
-        double totalTorque = 0.0;
-        double totalBalance = 0.0;
-        double totalLTE = 0.0;
-        double totalRTE = 0.0;
-        double totalLPS = 0.0;
-        double totalRPS = 0.0;
-        double totalLPCO = 0.0;
-        double totalRPCO = 0.0;
-        double totalLPPB = 0.0;
-        double totalRPPB = 0.0;
-        double totalLPPE = 0.0;
-        double totalRPPE = 0.0;
-        double totalLPPPB = 0.0;
-        double totalRPPPB = 0.0;
-        double totalLPPPE = 0.0;
-        double totalRPPPE = 0.0;
-
-
-        QList<DataPoint> list;
-
-        objects->smoothWatts.resize(rideTimeSecs + 1);
-        objects->smoothNP.resize(rideTimeSecs + 1);
-        objects->smoothGear.resize(rideTimeSecs + 1);
-        objects->smoothRV.resize(rideTimeSecs + 1);
-        objects->smoothRCad.resize(rideTimeSecs + 1);
-        objects->smoothRGCT.resize(rideTimeSecs + 1);
-        objects->smoothSmO2.resize(rideTimeSecs + 1);
-        objects->smoothtHb.resize(rideTimeSecs + 1);
-        objects->smoothO2Hb.resize(rideTimeSecs + 1);
-        objects->smoothHHb.resize(rideTimeSecs + 1);
-        objects->smoothAT.resize(rideTimeSecs + 1);
-        objects->smoothANT.resize(rideTimeSecs + 1);
-        objects->smoothXP.resize(rideTimeSecs + 1);
-        objects->smoothAP.resize(rideTimeSecs + 1);
-        objects->smoothHr.resize(rideTimeSecs + 1);
-        objects->smoothSpeed.resize(rideTimeSecs + 1);
-        objects->smoothAccel.resize(rideTimeSecs + 1);
-        objects->smoothWattsD.resize(rideTimeSecs + 1);
-        objects->smoothCadD.resize(rideTimeSecs + 1);
-        objects->smoothNmD.resize(rideTimeSecs + 1);
-        objects->smoothHrD.resize(rideTimeSecs + 1);
-        objects->smoothCad.resize(rideTimeSecs + 1);
-        objects->smoothTime.resize(rideTimeSecs + 1);
-        objects->smoothDistance.resize(rideTimeSecs + 1);
-        objects->smoothAltitude.resize(rideTimeSecs + 1);
-        objects->smoothSlope.resize(rideTimeSecs + 1);
-        objects->smoothTemp.resize(rideTimeSecs + 1);
-        objects->smoothWind.resize(rideTimeSecs + 1);
-        objects->smoothRelSpeed.resize(rideTimeSecs + 1);
-        objects->smoothTorque.resize(rideTimeSecs + 1);
-        objects->smoothBalanceL.resize(rideTimeSecs + 1);
-        objects->smoothBalanceR.resize(rideTimeSecs + 1);
-        objects->smoothLTE.resize(rideTimeSecs + 1);
-        objects->smoothRTE.resize(rideTimeSecs + 1);
-        objects->smoothLPS.resize(rideTimeSecs + 1);
-        objects->smoothRPS.resize(rideTimeSecs + 1);
-        objects->smoothLPCO.resize(rideTimeSecs + 1);
-        objects->smoothRPCO.resize(rideTimeSecs + 1);
-        objects->smoothLPP.resize(rideTimeSecs + 1);
-        objects->smoothRPP.resize(rideTimeSecs + 1);
-        objects->smoothLPPP.resize(rideTimeSecs + 1);
-        objects->smoothRPPP.resize(rideTimeSecs + 1);
-
-        // do the smoothing by calculating the average of the "applysmooth" values left
-        // of the current data point - for points in time smaller than "applysmooth"
-        // only the available datapoints left are used to build the average
-        int i = 0;
-        for (int secs = 0; secs <= rideTimeSecs; ++secs) {
-            while ((i < objects->timeArray.count()) && (objects->timeArray[i] <= secs)) {
-                DataPoint dp(objects->timeArray[i],
-                             (!objects->hrArray.empty() ? objects->hrArray[i] : 0),
-                             (!objects->wattsArray.empty() ? objects->wattsArray[i] : 0),
-                             (!objects->atissArray.empty() ? objects->atissArray[i] : 0),
-                             (!objects->antissArray.empty() ? objects->antissArray[i] : 0),
-                             (!objects->npArray.empty() ? objects->npArray[i] : 0),
-                             (!objects->rvArray.empty() ? objects->rvArray[i] : 0),
-                             (!objects->rcadArray.empty() ? objects->rcadArray[i] : 0),
-                             (!objects->rgctArray.empty() ? objects->rgctArray[i] : 0),
-                             (!objects->smo2Array.empty() ? objects->smo2Array[i] : 0),
-                             (!objects->thbArray.empty() ? objects->thbArray[i] : 0),
-                             (!objects->o2hbArray.empty() ? objects->o2hbArray[i] : 0),
-                             (!objects->hhbArray.empty() ? objects->hhbArray[i] : 0),
-                             (!objects->apArray.empty() ? objects->apArray[i] : 0),
-                             (!objects->xpArray.empty() ? objects->xpArray[i] : 0),
-                             (!objects->speedArray.empty() ? objects->speedArray[i] : 0),
-                             (!objects->cadArray.empty() ? objects->cadArray[i] : 0),
-                             (!objects->altArray.empty() ? objects->altArray[i] : 0),
-                             (!objects->tempArray.empty() ? objects->tempArray[i] : 0),
-                             (!objects->windArray.empty() ? objects->windArray[i] : 0),
-                             (!objects->torqueArray.empty() ? objects->torqueArray[i] : 0),
-                             (!objects->balanceArray.empty() ? objects->balanceArray[i] : 0),
-                             (!objects->lteArray.empty() ? objects->lteArray[i] : 0),
-                             (!objects->rteArray.empty() ? objects->rteArray[i] : 0),
-                             (!objects->lpsArray.empty() ? objects->lpsArray[i] : 0),
-                             (!objects->rpsArray.empty() ? objects->rpsArray[i] : 0),
-                             (!objects->lpcoArray.empty() ? objects->lpcoArray[i] : 0),
-                             (!objects->rpcoArray.empty() ? objects->rpcoArray[i] : 0),
-                             (!objects->lppbArray.empty() ? objects->lppbArray[i] : 0),
-                             (!objects->rppbArray.empty() ? objects->rppbArray[i] : 0),
-                             (!objects->lppeArray.empty() ? objects->lppeArray[i] : 0),
-                             (!objects->rppeArray.empty() ? objects->rppeArray[i] : 0),
-                             (!objects->lpppbArray.empty() ? objects->lpppbArray[i] : 0),
-                             (!objects->rpppbArray.empty() ? objects->rpppbArray[i] : 0),
-                             (!objects->lpppeArray.empty() ? objects->lpppeArray[i] : 0),
-                             (!objects->rpppeArray.empty() ? objects->rpppeArray[i] : 0),
-                             (!objects->accelArray.empty() ? objects->accelArray[i] : 0),
-                             (!objects->wattsDArray.empty() ? objects->wattsDArray[i] : 0),
-                             (!objects->cadDArray.empty() ? objects->cadDArray[i] : 0),
-                             (!objects->nmDArray.empty() ? objects->nmDArray[i] : 0),
-                             (!objects->hrDArray.empty() ? objects->hrDArray[i] : 0),
-                             (!objects->slopeArray.empty() ? objects->slopeArray[i] : 0));
-                if (!objects->wattsArray.empty())
-                    totalWatts += objects->wattsArray[i];
-
-                if (!objects->npArray.empty()) totalNP += objects->npArray[i];
-                if (!objects->rvArray.empty()) totalRV += objects->rvArray[i];
-                if (!objects->rcadArray.empty()) totalRCad += objects->rcadArray[i];
-                if (!objects->rgctArray.empty()) totalRGCT += objects->rgctArray[i];
-                if (!objects->smo2Array.empty()) totalSmO2 += objects->smo2Array[i];
-                if (!objects->thbArray.empty()) totaltHb += objects->thbArray[i];
-                if (!objects->o2hbArray.empty()) totalO2Hb += objects->o2hbArray[i];
-                if (!objects->hhbArray.empty()) totalHHb += objects->hhbArray[i];
-                if (!objects->atissArray.empty()) totalATISS += objects->atissArray[i];
-                if (!objects->antissArray.empty()) totalANTISS += objects->antissArray[i];
-
-                if (!objects->xpArray.empty())
-                    totalXP += objects->xpArray[i];
-                if (!objects->apArray.empty())
-                    totalAP += objects->apArray[i];
-                if (!objects->hrArray.empty())
-                    totalHr    += objects->hrArray[i];
-
-                if (!objects->accelArray.empty()) totalAccel += objects->accelArray[i];
-                if (!objects->wattsDArray.empty()) totalWattsD += objects->wattsDArray[i];
-                if (!objects->cadDArray.empty()) totalCadD += objects->cadDArray[i];
-                if (!objects->nmDArray.empty()) totalNmD += objects->nmDArray[i];
-                if (!objects->hrDArray.empty()) totalHrD += objects->hrDArray[i];
-
-                if (!objects->speedArray.empty())
-                    totalSpeed += objects->speedArray[i];
-                if (!objects->cadArray.empty())
-                    totalCad   += objects->cadArray[i];
-                if (!objects->altArray.empty())
-                    totalAlt   += objects->altArray[i];
-                if (!objects->slopeArray.empty())
-                    totalSlope   += objects->slopeArray[i];
-                if (!objects->tempArray.empty() ) {
-                    if (objects->tempArray[i] == RideFile::NoTemp) {
-                        dp.temp = (i>0 && !list.empty()?list.back().temp:0.0);
-                        totalTemp   += dp.temp;
-                    }
-                    else {
-                        totalTemp   += objects->tempArray[i];
-                    }
-                }
-                if (!objects->windArray.empty())
-                    totalWind   += objects->windArray[i];
-                if (!objects->torqueArray.empty())
-                    totalTorque   += objects->torqueArray[i];
-
-                // left/right pedal data
-                if (!objects->balanceArray.empty())
-                    totalBalance   += (objects->balanceArray[i]>0?objects->balanceArray[i]:50);
-                if (!objects->lteArray.empty())
-                    totalLTE   += (objects->lteArray[i]>0?objects->lteArray[i]:0);
-                if (!objects->rteArray.empty())
-                    totalRTE   += (objects->rteArray[i]>0?objects->rteArray[i]:0);
-                if (!objects->lpsArray.empty())
-                    totalLPS   += (objects->lpsArray[i]>0?objects->lpsArray[i]:0);
-                if (!objects->rpsArray.empty())
-                    totalRPS   += (objects->rpsArray[i]>0?objects->rpsArray[i]:0);
-                if (!objects->lpcoArray.empty())
-                    totalLPCO   += objects->lpcoArray[i];
-                if (!objects->rpcoArray.empty())
-                    totalRPCO   += objects->rpcoArray[i];
-                if (!objects->lppbArray.empty())
-                    totalLPPB   += (objects->lppbArray[i]>0?objects->lppbArray[i]:0);
-                if (!objects->rppbArray.empty())
-                    totalRPPB   += (objects->rppbArray[i]>0?objects->rppbArray[i]:0);
-                if (!objects->lppeArray.empty())
-                    totalLPPE   += (objects->lppeArray[i]>0?objects->lppeArray[i]:0);
-                if (!objects->rppeArray.empty())
-                    totalRPPE   += (objects->rppeArray[i]>0?objects->rppeArray[i]:0);
-                if (!objects->lpppbArray.empty())
-                    totalLPPPB   += (objects->lpppbArray[i]>0?objects->lpppbArray[i]:0);
-                if (!objects->rpppbArray.empty())
-                    totalRPPPB   += (objects->rpppbArray[i]>0?objects->rpppbArray[i]:0);
-                if (!objects->lpppeArray.empty())
-                    totalLPPPE   += (objects->lpppeArray[i]>0?objects->lpppeArray[i]:0);
-                if (!objects->rpppeArray.empty())
-                    totalRPPPE   += (objects->rpppeArray[i]>0?objects->rpppeArray[i]:0);
-
-                totalDist   = objects->distanceArray[i];
-                list.append(dp);
-                ++i;
+        // smooth each series, most likely already in the cache
+        QVector<QVector<double> > smoothed(SmoothCount);
+        foreach(Smoother::Series series, smoothingSeries(objects))
+            smoothed[series.id % SmoothCount] = objects->smoother->smooth(objects->timeArray, series, applysmooth);
+
+        objects->smoothWatts = smoothed[SmoothWatts];
+        objects->smoothNP = smoothed[SmoothNP];
+        objects->smoothRV = smoothed[SmoothRV];
+        objects->smoothRCad = smoothed[SmoothRCad];
+        objects->smoothRGCT = smoothed[SmoothRGCT];
+        objects->smoothSmO2 = smoothed[SmoothSmO2];
+        objects->smoothtHb = smoothed[SmoothtHb];
+        objects->smoothO2Hb = smoothed[SmoothO2Hb];
+        objects->smoothHHb = smoothed[SmoothHHb];
+        objects->smoothAT = smoothed[SmoothAT];
+        objects->smoothANT = smoothed[SmoothANT];
+        objects->smoothXP = smoothed[SmoothXP];
+        objects->smoothAP = smoothed[SmoothAP];
+        objects->smoothHr = smoothed[SmoothHr];
+        objects->smoothSpeed = smoothed[SmoothSpeed];
+        objects->smoothAccel = smoothed[SmoothAccel];
+        objects->smoothWattsD = smoothed[SmoothWattsD];
+        objects->smoothCadD = smoothed[SmoothCadD];
+        objects->smoothNmD = smoothed[SmoothNmD];
+        objects->smoothHrD = smoothed[SmoothHrD];
+        objects->smoothCad = smoothed[SmoothCad];
+        objects->smoothAltitude = smoothed[SmoothAltitude];
+        objects->smoothSlope = smoothed[SmoothSlope];
+        objects->smoothTemp = smoothed[SmoothTemp];
+        objects->smoothWind = smoothed[SmoothWind];
+        objects->smoothTorque = smoothed[SmoothTorque];
+        objects->smoothLTE = smoothed[SmoothLTE];
+        objects->smoothRTE = smoothed[SmoothRTE];
+        objects->smoothLPS = smoothed[SmoothLPS];
+        objects->smoothRPS = smoothed[SmoothRPS];
+        objects->smoothLPCO = smoothed[SmoothLPCO];
+        objects->smoothRPCO = smoothed[SmoothRPCO];
+
+        // distance is not smoothed, its where we got to
+        objects->smoothDistance = objects->smoother->latest(objects->timeArray, objects->distanceArray);
+
+        // series derived from the smoothed values
+        int count = objects->smoothWatts.count();
+        QVector<int> samples = objects->smoother->samples(objects->timeArray, applysmooth);
+
+        objects->smoothTime.resize(count);
+        objects->smoothGear.resize(count);
+        objects->smoothBalanceL.resize(count);
+        objects->smoothBalanceR.resize(count);
+        objects->smoothRelSpeed.resize(count);
+        objects->smoothLPP.resize(count);
+        objects->smoothRPP.resize(count);
+        objects->smoothLPPP.resize(count);
+        objects->smoothRPPP.resize(count);
+
+        for (int secs = 0; secs < count; ++secs) {
+
+            double x = bydist ? objects->smoothDistance[secs] : secs / 60.0;
+            objects->smoothTime[secs]  = secs / 60.0;
+
+            // left /right pedal data
+            double balance = smoothed[SmoothBalance][secs];
+            if (balance == 0) {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = 50;
+            } else if (balance >= 50) {
+                objects->smoothBalanceL[secs]    = balance;
+                objects->smoothBalanceR[secs]    = 50;
             }
-            while (!list.empty() && (list.front().time < secs - applysmooth)) {
-                DataPoint &dp = list.front();
-                totalWatts -= dp.watts;
-                totalNP -= dp.np;
-                totalRV -= dp.rv;
-                totalRCad -= dp.rcad;
-                totalRGCT -= dp.rgct;
-                totalSmO2 -= dp.smo2;
-                totaltHb -= dp.thb;
-                totalO2Hb -= dp.o2hb;
-                totalHHb -= dp.hhb;
-                totalATISS -= dp.atiss;
-                totalANTISS -= dp.antiss;
-                totalAP -= dp.ap;
-                totalXP -= dp.xp;
-                totalHr    -= dp.hr;
-                totalSpeed -= dp.speed;
-                totalAccel -= dp.kphd;
-                totalWattsD -= dp.wattsd;
-                totalCadD -= dp.cadd;
-                totalNmD -= dp.nmd;
-                totalHrD -= dp.hrd;
-                totalCad   -= dp.cad;
-                totalAlt   -= dp.alt;
-                totalSlope -= dp.slope;
-                totalTemp   -= dp.temp;
-                totalWind   -= dp.wind;
-                totalTorque   -= dp.torque;
-                totalLTE   -= dp.lte;
-                totalRTE   -= dp.rte;
-                totalLPS   -= dp.lps;
-                totalRPS   -= dp.rps;
-                totalLPCO  -= dp.lpco;
-                totalRPCO  -= dp.rpco;
-                totalLPPB   -= dp.lppb;
-                totalRPPB   -= dp.rppb;
-                totalLPPE   -= dp.lppe;
-                totalRPPE   -= dp.rppe;
-                totalLPPPB  -= dp.lpppb;
-                totalRPPPB  -= dp.rpppb;
-                totalLPPPE  -= dp.lpppe;
-                totalRPPPE  -= dp.rpppe;
-                totalBalance   -= (dp.lrbalance>0?dp.lrbalance:50);
-                list.removeFirst();
+            else {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = balance;
             }
+
             // TODO: this is wrong.  We should do a weighted average over the
             // seconds represented by each point...
-            if (list.empty()) {
-                objects->smoothWatts[secs] = 0.0;
-                objects->smoothNP[secs] = 0.0;
-                objects->smoothRV[secs] = 0.0;
-                objects->smoothRCad[secs] = 0.0;
-                objects->smoothRGCT[secs] = 0.0;
-                objects->smoothSmO2[secs] = 0.0;
-                objects->smoothtHb[secs] = 0.0;
-                objects->smoothO2Hb[secs] = 0.0;
-                objects->smoothHHb[secs] = 0.0;
-                objects->smoothAT[secs] = 0.0;
-                objects->smoothANT[secs] = 0.0;
-                objects->smoothXP[secs] = 0.0;
-                objects->smoothAP[secs] = 0.0;
-                objects->smoothHr[secs]    = 0.0;
-                objects->smoothSpeed[secs] = 0.0;
-                objects->smoothAccel[secs] = 0.0;
-                objects->smoothWattsD[secs] = 0.0;
-                objects->smoothCadD[secs] = 0.0;
-                objects->smoothNmD[secs] = 0.0;
-                objects->smoothHrD[secs] = 0.0;
-                objects->smoothCad[secs]   = 0.0;
-                objects->smoothAltitude[secs]   = ((secs > 0) ? objects->smoothAltitude[secs - 1] : objects->altArray[secs] ) ;
-                objects->smoothSlope[secs]   =  0.0;
-                objects->smoothTemp[secs]   = 0.0;
-                objects->smoothWind[secs] = 0.0;
+            if (samples[secs] == 0) {
                 objects->smoothRelSpeed[secs] =  QwtIntervalSample();
-                objects->smoothTorque[secs] = 0.0;
-                objects->smoothLTE[secs] = 0.0;
-                objects->smoothRTE[secs] = 0.0;
-                objects->smoothLPS[secs] = 0.0;
-                objects->smoothRPS[secs] = 0.0;
-                objects->smoothLPCO[secs] = 0.0;
-                objects->smoothRPCO[secs] = 0.0;
                 objects->smoothLPP[secs] = QwtIntervalSample();
                 objects->smoothRPP[secs] = QwtIntervalSample();
                 objects->smoothLPPP[secs] = QwtIntervalSample();
                 objects->smoothRPPP[secs] = QwtIntervalSample();
-                objects->smoothBalanceL[secs] = 50;
-                objects->smoothBalanceR[secs] = 50;
-            }
-            else {
-                objects->smoothWatts[secs]    = totalWatts / list.size();
-                objects->smoothNP[secs]    = totalNP / list.size();
-                objects->smoothRV[secs]    = totalRV / list.size();
-                objects->smoothRCad[secs]    = totalRCad / list.size();
-                objects->smoothRGCT[secs]    = totalRGCT / list.size();
-                objects->smoothSmO2[secs]    = totalSmO2 / list.size();
-                objects->smoothtHb[secs]    = totaltHb / list.size();
-                objects->smoothO2Hb[secs]    = totalO2Hb / list.size();
-                objects->smoothHHb[secs]    = totalHHb / list.size();
-                objects->smoothAT[secs]    = totalATISS / list.size();
-                objects->smoothANT[secs]    = totalANTISS / list.size();
-                objects->smoothXP[secs]    = totalXP / list.size();
-                objects->smoothAP[secs]    = totalAP / list.size();
-                objects->smoothHr[secs]       = totalHr / list.size();
-                objects->smoothSpeed[secs]    = totalSpeed / list.size();
-                objects->smoothAccel[secs]    = totalAccel / double(list.size());
-                objects->smoothWattsD[secs]    = totalWattsD / double(list.size());
-                objects->smoothCadD[secs]    = totalCadD / double(list.size());
-                objects->smoothNmD[secs]    = totalNmD / double(list.size());
-                objects->smoothHrD[secs]    = totalHrD / double(list.size());
-                objects->smoothCad[secs]      = totalCad / list.size();
-                objects->smoothAltitude[secs]      = totalAlt / list.size();
-                objects->smoothSlope[secs]      = totalSlope / double(list.size());
-                objects->smoothTemp[secs]      = totalTemp / list.size();
-                objects->smoothWind[secs]    = totalWind / list.size();
-                objects->smoothRelSpeed[secs] =  QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(qMin(totalWind / list.size(), totalSpeed / list.size()), qMax(totalWind / list.size(), totalSpeed / list.size()) ) );
-                objects->smoothTorque[secs]    = totalTorque / list.size();
-
-
-                // left /right pedal data
-                double balance = totalBalance / list.size();
-                if (balance == 0) {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = 50;
-                } else if (balance >= 50) {
-                    objects->smoothBalanceL[secs]    = balance;
-                    objects->smoothBalanceR[secs]    = 50;
-                }
-                else {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = balance;
-                }
-                objects->smoothLTE[secs]    = totalLTE / list.size();
-                objects->smoothRTE[secs]    = totalRTE / list.size();
-                objects->smoothLPS[secs]    = totalLPS / list.size();
-                objects->smoothRPS[secs]    = totalRPS / list.size();
-                objects->smoothLPCO[secs]   = totalLPCO / list.size();
-                objects->smoothRPCO[secs]   = totalRPCO / list.size();
-                objects->smoothLPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPB / list.size(), totalLPPE / list.size() ) );
-                objects->smoothRPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPB / list.size(), totalRPPE / list.size() ) );
-                objects->smoothLPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPPB / list.size(), totalLPPPE / list.size() ) );
-                objects->smoothRPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPPB / list.size(), totalRPPPE / list.size() ) );
+            } else {
+                double wind = objects->smoothWind[secs];
+                double speed = objects->smoothSpeed[secs];
+                objects->smoothRelSpeed[secs] =  QwtIntervalSample(x, QwtInterval(qMin(wind, speed), qMax(wind, speed)));
+                objects->smoothLPP[secs]    = QwtIntervalSample(x, QwtInterval(smoothed[SmoothLPPB][secs], smoothed[SmoothLPPE][secs]));
+                objects->smoothRPP[secs]    = QwtIntervalSample(x, QwtInterval(smoothed[SmoothRPPB][secs], smoothed[SmoothRPPE][secs]));
+                objects->smoothLPPP[secs]   = QwtIntervalSample(x, QwtInterval(smoothed[SmoothLPPPB][secs], smoothed[SmoothLPPPE][secs]));
+                objects->smoothRPPP[secs]   = QwtIntervalSample(x, QwtInterval(smoothed[SmoothRPPPB][secs], smoothed[SmoothRPPPE][secs]));
             }
-            objects->smoothDistance[secs] = totalDist;
-            objects->smoothTime[secs]  = secs / 60.0;
 
             // set data series (gearRatio) which are not smoothed at all
             if (objects->gearArray.empty() || secs >= objects->gearArray.count()) {
@@ -2130,111 +1924,111 @@ AllPlot::recalc(AllPlotObject *objects)
 
     //W' curve set to whatever data we have
     if (!objects->wprime.empty()) {
-        objects->wCurve->setSamples(bydist ? objects->wprimeDist.data() : objects->wprimeTime.data(), 
-                                    objects->wprime.data(), objects->wprime.count());
+        objects->wCurve->setSamples(new LODCurveData(bydist ? objects->wprimeDist.data() : objects->wprimeTime.data(),
+                                    objects->wprime.data(), objects->wprime.count(), canvas()));
         objects->mCurve->setSamples(bydist ? objects->matchDist.data() : objects->matchTime.data(), 
                                     objects->match.data(), objects->match.count());
         setMatchLabels(objects);
     }
 
     if (!objects->wattsArray.empty()) {
-        objects->wattsCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints);
+        objects->wattsCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->antissArray.empty()) {
-        objects->antissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints);
+        objects->antissCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->atissArray.empty()) {
-        objects->atissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints);
+        objects->atissCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->rvArray.empty()) {
-        objects->rvCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints);
+        objects->rvCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->rcadArray.empty()) {
-        objects->rcadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints);
+        objects->rcadCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->rgctArray.empty()) {
-        objects->rgctCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints);
+        objects->rgctCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->gearArray.empty()) {
-        objects->gearCurve->setSamples(xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints);
+        objects->gearCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->smo2Array.empty()) {
-        objects->smo2Curve->setSamples(xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints);
+        objects->smo2Curve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->thbArray.empty()) {
-        objects->thbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints);
+        objects->thbCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->o2hbArray.empty()) {
-        objects->o2hbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints);
+        objects->o2hbCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->hhbArray.empty()) {
-        objects->hhbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints);
+        objects->hhbCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->npArray.empty()) {
-        objects->npCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints);
+        objects->npCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->xpArray.empty()) {
-        objects->xpCurve->setSamples(xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints);
+        objects->xpCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->apArray.empty()) {
-        objects->apCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints);
+        objects->apCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->hrArray.empty()) {
-        objects->hrCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints);
+        objects->hrCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->speedArray.empty()) {
-        objects->speedCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints);
+        objects->speedCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->accelArray.empty()) {
-        objects->accelCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints);
+        objects->accelCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->wattsDArray.empty()) {
-        objects->wattsDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints);
+        objects->wattsDCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->cadDArray.empty()) {
-        objects->cadDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints);
+        objects->cadDCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->nmDArray.empty()) {
-        objects->nmDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints);
+        objects->nmDCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->hrDArray.empty()) {
-        objects->hrDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints);
+        objects->hrDCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->cadArray.empty()) {
-        objects->cadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints);
+        objects->cadCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->altArray.empty()) {
-        objects->altCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
+        objects->altCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints, canvas()));
         objects->altSlopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
     }
     if (!objects->slopeArray.empty()) {
-        objects->slopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints);
+        objects->slopeCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints, canvas()));
     }
 
     if (!objects->tempArray.empty()) {
-        objects->tempCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints);
+        objects->tempCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints, canvas()));
     }
 
 
@@ -2243,29 +2037,21 @@ AllPlot::recalc(AllPlotObject *objects)
     }
 
     if (!objects->torqueArray.empty()) {
-        objects->torqueCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints);
+        objects->torqueCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints, canvas()));
     }
 
     // left/right pedals
     if (!objects->balanceArray.empty()) {
-        objects->balanceLCurve->setSamples(xaxis.data() + startingIndex, 
-                                           objects->smoothBalanceL.data() + startingIndex, totalPoints);
-        objects->balanceRCurve->setSamples(xaxis.data() + startingIndex, 
-                                           objects->smoothBalanceR.data() + startingIndex, totalPoints);
-    }
-    if (!objects->lteArray.empty()) objects->lteCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothLTE.data() + startingIndex, totalPoints);
-    if (!objects->rteArray.empty()) objects->rteCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothRTE.data() + startingIndex, totalPoints);
-    if (!objects->lpsArray.empty()) objects->lpsCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothLPS.data() + startingIndex, totalPoints);
-    if (!objects->rpsArray.empty()) objects->rpsCurve->setSamples(xaxis.data() + startingIndex, 
-                                             objects->smoothRPS.data() + startingIndex, totalPoints);
-
-    if (!objects->lpcoArray.empty()) objects->lpcoCurve->setSamples(xaxis.data() + startingIndex,
-                                             objects->smoothLPCO.data() + startingIndex, totalPoints);
-    if (!objects->rpcoArray.empty()) objects->rpcoCurve->setSamples(xaxis.data() + startingIndex,
-                                             objects->smoothRPCO.data() + startingIndex, totalPoints);
+        objects->balanceLCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothBalanceL.data() + startingIndex, totalPoints, canvas()));
+        objects->balanceRCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothBalanceR.data() + startingIndex, totalPoints, canvas()));
+    }
+    if (!objects->lteArray.empty()) objects->lteCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothLTE.data() + startingIndex, totalPoints, canvas()));
+    if (!objects->rteArray.empty()) objects->rteCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRTE.data() + startingIndex, totalPoints, canvas()));
+    if (!objects->lpsArray.empty()) objects->lpsCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothLPS.data() + startingIndex, totalPoints, canvas()));
+    if (!objects->rpsArray.empty()) objects->rpsCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRPS.data() + startingIndex, totalPoints, canvas()));
+
+    if (!objects->lpcoArray.empty()) objects->lpcoCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothLPCO.data() + startingIndex, totalPoints, canvas()));
+    if (!objects->rpcoArray.empty()) objects->rpcoCurve->setSamples(new LODCurveData(xaxis.data() + startingIndex, objects->smoothRPCO.data() + startingIndex, totalPoints, canvas()));
     if (!objects->lppbArray.empty()) {
         objects->lppCurve->setSamples(new QwtIntervalSeriesData(objects->smoothLPP));
     }
@@ -3023,52 +2809,52 @@ AllPlot::setDataFromPlot(AllPlot *plot, int startidx, int stopidx)
     standard->rpppCurve->setVisible(rideItem->ride()->areDataPresent()->rpppb && showPPP);
 
     if (showW) {
-        standard->wCurve->setSamples(bydist ? plot->standard->wprimeDist.data() : plot->standard->wprimeTime.data(), 
-                                    plot->standard->wprime.data(), plot->standard->wprime.count());
+        standard->wCurve->setSamples(new LODCurveData(bydist ? plot->standard->wprimeDist.data() : plot->standard->wprimeTime.data(),
+                                    plot->standard->wprime.data(), plot->standard->wprime.count(), canvas()));
         standard->mCurve->setSamples(bydist ? plot->standard->matchDist.data() : plot->standard->matchTime.data(), 
                                     plot->standard->match.data(), plot->standard->match.count());
         setMatchLabels(standard);
     }
     int points = stopidx - startidx + 1; // e.g. 10 to 12 is 3 points 10,11,12, so not 12-10 !
-    standard->wattsCurve->setSamples(xaxis,smoothW,points);
-    standard->atissCurve->setSamples(xaxis,smoothAT,points);
-    standard->antissCurve->setSamples(xaxis,smoothANT,points);
-    standard->npCurve->setSamples(xaxis,smoothN,points);
-    standard->rvCurve->setSamples(xaxis,smoothRV,points);
-    standard->rcadCurve->setSamples(xaxis,smoothRCad,points);
-    standard->rgctCurve->setSamples(xaxis,smoothRGCT,points);
-    standard->gearCurve->setSamples(xaxis,smoothGear,points);
-    standard->smo2Curve->setSamples(xaxis,smoothSmO2,points);
-    standard->thbCurve->setSamples(xaxis,smoothtHb,points);
-    standard->o2hbCurve->setSamples(xaxis,smoothO2Hb,points);
-    standard->hhbCurve->setSamples(xaxis,smoothHHb,points);
-    standard->xpCurve->setSamples(xaxis,smoothX,points);
-    standard->apCurve->setSamples(xaxis,smoothL,points);
-    standard->hrCurve->setSamples(xaxis, smoothHR,points);
-    standard->speedCurve->setSamples(xaxis, smoothS, points);
-    standard->accelCurve->setSamples(xaxis, smoothAC, points);
-    standard->wattsDCurve->setSamples(xaxis, smoothWD, points);
-    standard->cadDCurve->setSamples(xaxis, smoothCD, points);
-    standard->nmDCurve->setSamples(xaxis, smoothND, points);
-    standard->hrDCurve->setSamples(xaxis, smoothHD, points);
-    standard->cadCurve->setSamples(xaxis, smoothC, points);
-    standard->altCurve->setSamples(xaxis, smoothA, points);
+    standard->wattsCurve->setSamples(new LODCurveData(xaxis, smoothW, points, canvas()));
+    standard->atissCurve->setSamples(new LODCurveData(xaxis, smoothAT, points, canvas()));
+    standard->antissCurve->setSamples(new LODCurveData(xaxis, smoothANT, points, canvas()));
+    standard->npCurve->setSamples(new LODCurveData(xaxis, smoothN, points, canvas()));
+    standard->rvCurve->setSamples(new LODCurveData(xaxis, smoothRV, points, canvas()));
+    standard->rcadCurve->setSamples(new LODCurveData(xaxis, smoothRCad, points, canvas()));
+    standard->rgctCurve->setSamples(new LODCurveData(xaxis, smoothRGCT, points, canvas()));
+    standard->gearCurve->setSamples(new LODCurveData(xaxis, smoothGear, points, canvas()));
+    standard->smo2Curve->setSamples(new LODCurveData(xaxis, smoothSmO2, points, canvas()));
+    standard->thbCurve->setSamples(new LODCurveData(xaxis, smoothtHb, points, canvas()));
+    standard->o2hbCurve->setSamples(new LODCurveData(xaxis, smoothO2Hb, points, canvas()));
+    standard->hhbCurve->setSamples(new LODCurveData(xaxis, smoothHHb, points, canvas()));
+    standard->xpCurve->setSamples(new LODCurveData(xaxis, smoothX, points, canvas()));
+    standard->apCurve->setSamples(new LODCurveData(xaxis, smoothL, points, canvas()));
+    standard->hrCurve->setSamples(new LODCurveData(xaxis, smoothHR, points, canvas()));
+    standard->speedCurve->setSamples(new LODCurveData(xaxis, smoothS, points, canvas()));
+    standard->accelCurve->setSamples(new LODCurveData(xaxis, smoothAC, points, canvas()));
+    standard->wattsDCurve->setSamples(new LODCurveData(xaxis, smoothWD, points, canvas()));
+    standard->cadDCurve->setSamples(new LODCurveData(xaxis, smoothCD, points, canvas()));
+    standard->nmDCurve->setSamples(new LODCurveData(xaxis, smoothND, points, canvas()));
+    standard->hrDCurve->setSamples(new LODCurveData(xaxis, smoothHD, points, canvas()));
+    standard->cadCurve->setSamples(new LODCurveData(xaxis, smoothC, points, canvas()));
+    standard->altCurve->setSamples(new LODCurveData(xaxis, smoothA, points, canvas()));
     standard->altSlopeCurve->setSamples(xaxis, smoothA, points);
-    standard->slopeCurve->setSamples(xaxis, smoothSL, points);
-    standard->tempCurve->setSamples(xaxis, smoothTE, points);
+    standard->slopeCurve->setSamples(new LODCurveData(xaxis, smoothSL, points, canvas()));
+    standard->tempCurve->setSamples(new LODCurveData(xaxis, smoothTE, points, canvas()));
 
     QVector<QwtIntervalSample> tmpWND(points);
     memcpy(tmpWND.data(), smoothRS, (points) * sizeof(QwtIntervalSample));
     standard->windCurve->setSamples(new QwtIntervalSeriesData(tmpWND));
-    standard->torqueCurve->setSamples(xaxis, smoothNM, points);
-    standard->balanceLCurve->setSamples(xaxis, smoothBALL, points);
-    standard->balanceRCurve->setSamples(xaxis, smoothBALR, points);
-    standard->lteCurve->setSamples(xaxis, smoothLTE, points);
-    standard->rteCurve->setSamples(xaxis, smoothRTE, points);
-    standard->lpsCurve->setSamples(xaxis, smoothLPS, points);
-    standard->rpsCurve->setSamples(xaxis, smoothRPS, points);
-    standard->lpcoCurve->setSamples(xaxis, smoothLPCO, points);
-    standard->rpcoCurve->setSamples(xaxis, smoothRPCO, points);
+    standard->torqueCurve->setSamples(new LODCurveData(xaxis, smoothNM, points, canvas()));
+    standard->balanceLCurve->setSamples(new LODCurveData(xaxis, smoothBALL, points, canvas()));
+    standard->balanceRCurve->setSamples(new LODCurveData(xaxis, smoothBALR, points, canvas()));
+    standard->lteCurve->setSamples(new LODCurveData(xaxis, smoothLTE, points, canvas()));
+    standard->rteCurve->setSamples(new LODCurveData(xaxis, smoothRTE, points, canvas()));
+    standard->lpsCurve->setSamples(new LODCurveData(xaxis, smoothLPS, points, canvas()));
+    standard->rpsCurve->setSamples(new LODCurveData(xaxis, smoothRPS, points, canvas()));
+    standard->lpcoCurve->setSamples(new LODCurveData(xaxis, smoothLPCO, points, canvas()));
+    standard->rpcoCurve->setSamples(new LODCurveData(xaxis, smoothRPCO, points, canvas()));
 
     QVector<QwtIntervalSample> tmpLDC(points);
     memcpy(tmpLDC.data(), smoothLPP, (points) * sizeof(QwtIntervalSample));
@@ -3713,10 +3499,9 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve->data()->size(); i++) array << thereCurve->data()->sample(i);
+            QVector<QPointF> array = LODCurveData::samples(thereCurve->data());
 
-            ourCurve->setSamples(array);
+            ourCurve->setSamples(new LODCurveData(array, canvas()));
             ourCurve->setYAxis(yLeft);
             ourCurve->setBaseline(thereCurve->baseline());
             ourCurve->setStyle(thereCurve->style());
@@ -3742,10 +3527,9 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve2->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
+            QVector<QPointF> array = LODCurveData::samples(thereCurve2->data());
 
-            ourCurve2->setSamples(array);
+            ourCurve2->setSamples(new LODCurveData(array, canvas()));
             ourCurve2->setYAxis(yLeft);
             ourCurve2->setBaseline(thereCurve2->baseline());
 
@@ -4407,10 +4191,9 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourCurve->attach(this);
 
                     // lets clone the data
-                    QVector<QPointF> array;
-                    for (size_t i=0; i<thereCurve->data()->size(); i++) array << thereCurve->data()->sample(i);
+                    QVector<QPointF> array = LODCurveData::samples(thereCurve->data());
 
-                    ourCurve->setSamples(array);
+                    ourCurve->setSamples(new LODCurveData(array, canvas()));
                     ourCurve->setYAxis(yLeft);
                     ourCurve->setBaseline(thereCurve->baseline());
 
@@ -4445,10 +4228,9 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourCurve2->setPen(pen);
 
                     // lets clone the data
-                    QVector<QPointF> array;
-                    for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
+                    QVector<QPointF> array = LODCurveData::samples(thereCurve2->data());
 
-                    ourCurve2->setSamples(array);
+                    ourCurve2->setSamples(new LODCurveData(array, canvas()));
                     ourCurve2->setYAxis(yLeft);
                     ourCurve2->setBaseline(thereCurve2->baseline());
 
@@ -4676,147 +4458,147 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
 
     //W' curve set to whatever data we have
     if (!object->wprime.empty()) {
-        standard->wCurve->setSamples(bydist ? object->wprimeDist.data() : object->wprimeTime.data(), 
-                                    object->wprime.data(), object->wprime.count());
+        standard->wCurve->setSamples(new LODCurveData(bydist ? object->wprimeDist.data() : object->wprimeTime.data(),
+                                    object->wprime.data(), object->wprime.count(), canvas()));
         standard->mCurve->setSamples(bydist ? object->matchDist.data() : object->matchTime.data(), 
                                     object->match.data(), object->match.count());
         setMatchLabels(standard);
     }
 
     if (!object->wattsArray.empty()) {
-        standard->wattsCurve->setSamples(xaxis.data(), object->smoothWatts.data(), totalPoints);
+        standard->wattsCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothWatts.data(), totalPoints, canvas()));
         standard->wattsCurve->attach(this);
         standard->wattsCurve->setVisible(true);
     }
 
     if (!object->antissArray.empty()) {
-        standard->antissCurve->setSamples(xaxis.data(), object->smoothANT.data(), totalPoints);
+        standard->antissCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothANT.data(), totalPoints, canvas()));
         standard->antissCurve->attach(this);
         standard->antissCurve->setVisible(true);
     }
 
     if (!object->atissArray.empty()) {
-        standard->atissCurve->setSamples(xaxis.data(), object->smoothAT.data(), totalPoints);
+        standard->atissCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothAT.data(), totalPoints, canvas()));
         standard->atissCurve->attach(this);
         standard->atissCurve->setVisible(true);
     }
 
     if (!object->npArray.empty()) {
-        standard->npCurve->setSamples(xaxis.data(), object->smoothNP.data(), totalPoints);
+        standard->npCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothNP.data(), totalPoints, canvas()));
         standard->npCurve->attach(this);
         standard->npCurve->setVisible(true);
     }
 
     if (!object->rvArray.empty()) {
-        standard->rvCurve->setSamples(xaxis.data(), object->smoothRV.data(), totalPoints);
+        standard->rvCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRV.data(), totalPoints, canvas()));
         standard->rvCurve->attach(this);
         standard->rvCurve->setVisible(true);
     }
 
     if (!object->rcadArray.empty()) {
-        standard->rcadCurve->setSamples(xaxis.data(), object->smoothRCad.data(), totalPoints);
+        standard->rcadCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRCad.data(), totalPoints, canvas()));
         standard->rcadCurve->attach(this);
         standard->rcadCurve->setVisible(true);
     }
 
     if (!object->rgctArray.empty()) {
-        standard->rgctCurve->setSamples(xaxis.data(), object->smoothRGCT.data(), totalPoints);
+        standard->rgctCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRGCT.data(), totalPoints, canvas()));
         standard->rgctCurve->attach(this);
         standard->rgctCurve->setVisible(true);
     }
 
     if (!object->gearArray.empty()) {
-        standard->gearCurve->setSamples(xaxis.data(), object->smoothGear.data(), totalPoints);
+        standard->gearCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothGear.data(), totalPoints, canvas()));
         standard->gearCurve->attach(this);
         standard->gearCurve->setVisible(true);
     }
 
     if (!object->smo2Array.empty()) {
-        standard->smo2Curve->setSamples(xaxis.data(), object->smoothSmO2.data(), totalPoints);
+        standard->smo2Curve->setSamples(new LODCurveData(xaxis.data(), object->smoothSmO2.data(), totalPoints, canvas()));
         standard->smo2Curve->attach(this);
         standard->smo2Curve->setVisible(true);
     }
 
     if (!object->thbArray.empty()) {
-        standard->thbCurve->setSamples(xaxis.data(), object->smoothtHb.data(), totalPoints);
+        standard->thbCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothtHb.data(), totalPoints, canvas()));
         standard->thbCurve->attach(this);
         standard->thbCurve->setVisible(true);
     }
 
     if (!object->o2hbArray.empty()) {
-        standard->o2hbCurve->setSamples(xaxis.data(), object->smoothO2Hb.data(), totalPoints);
+        standard->o2hbCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothO2Hb.data(), totalPoints, canvas()));
         standard->o2hbCurve->attach(this);
         standard->o2hbCurve->setVisible(true);
     }
 
     if (!object->hhbArray.empty()) {
-        standard->hhbCurve->setSamples(xaxis.data(), object->smoothHHb.data(), totalPoints);
+        standard->hhbCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothHHb.data(), totalPoints, canvas()));
         standard->hhbCurve->attach(this);
         standard->hhbCurve->setVisible(true);
     }
 
     if (!object->xpArray.empty()) {
-        standard->xpCurve->setSamples(xaxis.data(), object->smoothXP.data(), totalPoints);
+        standard->xpCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothXP.data(), totalPoints, canvas()));
         standard->xpCurve->attach(this);
         standard->xpCurve->setVisible(true);
     }
 
     if (!object->apArray.empty()) {
-        standard->apCurve->setSamples(xaxis.data(), object->smoothAP.data(), totalPoints);
+        standard->apCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothAP.data(), totalPoints, canvas()));
         standard->apCurve->attach(this);
         standard->apCurve->setVisible(true);
     }
 
     if (!object->hrArray.empty()) {
-        standard->hrCurve->setSamples(xaxis.data(), object->smoothHr.data(), totalPoints);
+        standard->hrCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothHr.data(), totalPoints, canvas()));
         standard->hrCurve->attach(this);
         standard->hrCurve->setVisible(true);
     }
 
     if (!object->speedArray.empty()) {
-        standard->speedCurve->setSamples(xaxis.data(), object->smoothSpeed.data(), totalPoints);
+        standard->speedCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothSpeed.data(), totalPoints, canvas()));
         standard->speedCurve->attach(this);
         standard->speedCurve->setVisible(true);
     }
 
     if (!object->accelArray.empty()) {
-        standard->accelCurve->setSamples(xaxis.data(), object->smoothAccel.data(), totalPoints);
+        standard->accelCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothAccel.data(), totalPoints, canvas()));
         standard->accelCurve->attach(this);
         standard->accelCurve->setVisible(true);
     }
 
     if (!object->wattsDArray.empty()) {
-        standard->wattsDCurve->setSamples(xaxis.data(), object->smoothWattsD.data(), totalPoints);
+        standard->wattsDCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothWattsD.data(), totalPoints, canvas()));
         standard->wattsDCurve->attach(this);
         standard->wattsDCurve->setVisible(true);
     }
 
     if (!object->cadDArray.empty()) {
-        standard->cadDCurve->setSamples(xaxis.data(), object->smoothCadD.data(), totalPoints);
+        standard->cadDCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothCadD.data(), totalPoints, canvas()));
         standard->cadDCurve->attach(this);
         standard->cadDCurve->setVisible(true);
     }
 
     if (!object->nmDArray.empty()) {
-        standard->nmDCurve->setSamples(xaxis.data(), object->smoothNmD.data(), totalPoints);
+        standard->nmDCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothNmD.data(), totalPoints, canvas()));
         standard->nmDCurve->attach(this);
         standard->nmDCurve->setVisible(true);
     }
 
     if (!object->hrDArray.empty()) {
-        standard->hrDCurve->setSamples(xaxis.data(), object->smoothHrD.data(), totalPoints);
+        standard->hrDCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothHrD.data(), totalPoints, canvas()));
         standard->hrDCurve->attach(this);
         standard->hrDCurve->setVisible(true);
     }
 
     if (!object->cadArray.empty()) {
-        standard->cadCurve->setSamples(xaxis.data(), object->smoothCad.data(), totalPoints);
+        standard->cadCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothCad.data(), totalPoints, canvas()));
         standard->cadCurve->attach(this);
         standard->cadCurve->setVisible(true);
     }
 
     if (!object->altArray.empty()) {
-        standard->altCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
+        standard->altCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothAltitude.data(), totalPoints, canvas()));
         standard->altCurve->attach(this);
         standard->altCurve->setVisible(true);
         standard->altSlopeCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
@@ -4825,13 +4607,13 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->slopeArray.empty()) {
-        standard->slopeCurve->setSamples(xaxis.data(), object->smoothSlope.data(), totalPoints);
+        standard->slopeCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothSlope.data(), totalPoints, canvas()));
         standard->slopeCurve->attach(this);
         standard->slopeCurve->setVisible(true);
     }
 
     if (!object->tempArray.empty()) {
-        standard->tempCurve->setSamples(xaxis.data(), object->smoothTemp.data(), totalPoints);
+        standard->tempCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothTemp.data(), totalPoints, canvas()));
         standard->tempCurve->attach(this);
         standard->tempCurve->setVisible(true);
     }
@@ -4844,14 +4626,14 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->torqueArray.empty()) {
-        standard->torqueCurve->setSamples(xaxis.data(), object->smoothTorque.data(), totalPoints);
+        standard->torqueCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothTorque.data(), totalPoints, canvas()));
         standard->torqueCurve->attach(this);
         standard->torqueCurve->setVisible(true);
     }
 
     if (!object->balanceArray.empty()) {
-        standard->balanceLCurve->setSamples(xaxis.data(), object->smoothBalanceL.data(), totalPoints);
-        standard->balanceRCurve->setSamples(xaxis.data(), object->smoothBalanceR.data(), totalPoints);
+        standard->balanceLCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothBalanceL.data(), totalPoints, canvas()));
+        standard->balanceRCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothBalanceR.data(), totalPoints, canvas()));
         standard->balanceLCurve->attach(this);
         standard->balanceLCurve->setVisible(true);
         standard->balanceRCurve->attach(this);
@@ -4859,8 +4641,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lteArray.empty()) {
-        standard->lteCurve->setSamples(xaxis.data(), object->smoothLTE.data(), totalPoints);
-        standard->rteCurve->setSamples(xaxis.data(), object->smoothRTE.data(), totalPoints);
+        standard->lteCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothLTE.data(), totalPoints, canvas()));
+        standard->rteCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRTE.data(), totalPoints, canvas()));
         standard->lteCurve->attach(this);
         standard->lteCurve->setVisible(true);
         standard->rteCurve->attach(this);
@@ -4868,8 +4650,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpsArray.empty()) {
-        standard->lpsCurve->setSamples(xaxis.data(), object->smoothLPS.data(), totalPoints);
-        standard->rpsCurve->setSamples(xaxis.data(), object->smoothRPS.data(), totalPoints);
+        standard->lpsCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothLPS.data(), totalPoints, canvas()));
+        standard->rpsCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRPS.data(), totalPoints, canvas()));
         standard->lpsCurve->attach(this);
         standard->lpsCurve->setVisible(true);
         standard->rpsCurve->attach(this);
@@ -4877,8 +4659,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpcoArray.empty()) {
-        standard->lpcoCurve->setSamples(xaxis.data(), object->smoothLPCO.data(), totalPoints);
-        standard->rpcoCurve->setSamples(xaxis.data(), object->smoothRPCO.data(), totalPoints);
+        standard->lpcoCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothLPCO.data(), totalPoints, canvas()));
+        standard->rpcoCurve->setSamples(new LODCurveData(xaxis.data(), object->smoothRPCO.data(), totalPoints, canvas()));
         standard->lpcoCurve->attach(this);
         standard->lpcoCurve->setVisible(true);
         standard->rpcoCurve->attach(this);
@@ -4984,6 +4766,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
 void
 AllPlot::setDataFromRide(RideItem *_rideItem)
 {
+    GC_TRACE("AllPlot::setDataFromRide");
+
     rideItem = _rideItem;
     if (_rideItem == NULL) return;
 
@@ -5001,12 +4785,159 @@ AllPlot::setDataFromRide(RideItem *_rideItem)
     curveColors->saveState();
 }
 
+void
+AllPlotSamples::fill(RideFile *ride, bool metric)
+{
+    const RideFileDataPresent *dataPresent = ride->areDataPresent();
+    int npoints = ride->dataPoints().size();
+    this->metric = metric;
+
+    wattsArray.resize(dataPresent->watts ? npoints : 0);
+    atissArray.resize(dataPresent->watts ? npoints : 0);
+    antissArray.resize(dataPresent->watts ? npoints : 0);
+    npArray.resize(dataPresent->np ? npoints : 0);
+    rcadArray.resize(dataPresent->rcad ? npoints : 0);
+    rvArray.resize(dataPresent->rvert ? npoints : 0);
+    rgctArray.resize(dataPresent->rcontact ? npoints : 0);
+    smo2Array.resize(dataPresent->smo2 ? npoints : 0);
+    thbArray.resize(dataPresent->thb ? npoints : 0);
+    o2hbArray.resize(dataPresent->o2hb ? npoints : 0);
+    hhbArray.resize(dataPresent->hhb ? npoints : 0);
+    gearArray.resize(dataPresent->gear ? npoints : 0);
+    xpArray.resize(dataPresent->xp ? npoints : 0);
+    apArray.resize(dataPresent->apower ? npoints : 0);
+    hrArray.resize(dataPresent->hr ? npoints : 0);
+    speedArray.resize(dataPresent->kph ? npoints : 0);
+    accelArray.resize(dataPresent->kph ? npoints : 0);
+    wattsDArray.resize(dataPresent->watts ? npoints : 0);
+    cadDArray.resize(dataPresent->cad ? npoints : 0);
+    nmDArray.resize(dataPresent->nm ? npoints : 0);
+    hrDArray.resize(dataPresent->hr ? npoints : 0);
+    cadArray.resize(dataPresent->cad ? npoints : 0);
+    altArray.resize(dataPresent->alt ? npoints : 0);
+    slopeArray.resize(dataPresent->slope ? npoints : 0);
+    tempArray.resize(dataPresent->temp ? npoints : 0);
+    windArray.resize(dataPresent->headwind ? npoints : 0);
+    torqueArray.resize(dataPresent->nm ? npoints : 0);
+    balanceArray.resize(dataPresent->lrbalance ? npoints : 0);
+    lteArray.resize(dataPresent->lte ? npoints : 0);
+    rteArray.resize(dataPresent->rte ? npoints : 0);
+    lpsArray.resize(dataPresent->lps ? npoints : 0);
+    rpsArray.resize(dataPresent->rps ? npoints : 0);
+    lpcoArray.resize(dataPresent->lpco ? npoints : 0);
+    rpcoArray.resize(dataPresent->rpco ? npoints : 0);
+    lppbArray.resize(dataPresent->lppb ? npoints : 0);
+    rppbArray.resize(dataPresent->rppb ? npoints : 0);
+    lppeArray.resize(dataPresent->lppe ? npoints : 0);
+    rppeArray.resize(dataPresent->rppe ? npoints : 0);
+    lpppbArray.resize(dataPresent->lpppb ? npoints : 0);
+    rpppbArray.resize(dataPresent->rpppb ? npoints : 0);
+    lpppeArray.resize(dataPresent->lpppe ? npoints : 0);
+    rpppeArray.resize(dataPresent->rpppe ? npoints : 0);
+    timeArray.resize(npoints);
+    distanceArray.resize(npoints);
+
+    int arrayLength = 0;
+    foreach (const RideFilePoint *point, ride->dataPoints()) {
+
+        // we round the time to nearest 100th of a second
+        // before adding to the array, to avoid situation
+        // where 'high precision' time slice is an artefact
+        // of double precision or slight timing anomalies
+        // e.g. where realtime gives timestamps like
+        // 940.002 followed by 940.998 and were previously
+        // both rounded to 940s
+        //
+        // NOTE: this rounding mechanism is identical to that
+        //       used by the Ride Editor.
+        double secs = floor(point->secs);
+        double msecs = round((point->secs - secs) * 100) * 10;
+
+        timeArray[arrayLength]  = secs + msecs/1000;
+        if (!wattsArray.empty()) wattsArray[arrayLength] = max(0, point->watts);
+        if (!atissArray.empty()) atissArray[arrayLength] = max(0, point->atiss);
+        if (!antissArray.empty()) antissArray[arrayLength] = max(0, point->antiss);
+        if (!npArray.empty()) npArray[arrayLength] = max(0, point->np);
+        if (!rvArray.empty()) rvArray[arrayLength] = max(0, point->rvert);
+        if (!rcadArray.empty()) rcadArray[arrayLength] = max(0, point->rcad);
+        if (!rgctArray.empty()) rgctArray[arrayLength] = max(0, point->rcontact);
+        if (!gearArray.empty()) gearArray[arrayLength] = max(0, point->gear);
+        if (!smo2Array.empty()) smo2Array[arrayLength] = max(0, point->smo2);
+        if (!thbArray.empty()) thbArray[arrayLength] = max(0, point->thb);
+        if (!o2hbArray.empty()) o2hbArray[arrayLength] = max(0, point->o2hb);
+        if (!hhbArray.empty()) hhbArray[arrayLength] = max(0, point->hhb);
+        if (!xpArray.empty()) xpArray[arrayLength] = max(0, point->xp);
+        if (!apArray.empty()) apArray[arrayLength] = max(0, point->apower);
+
+        if (!hrArray.empty())
+            hrArray[arrayLength]    = max(0, point->hr);
+
+        // delta series
+        if (!accelArray.empty()) accelArray[arrayLength] = point->kphd;
+        if (!wattsDArray.empty()) wattsDArray[arrayLength] = point->wattsd;
+        if (!cadDArray.empty()) cadDArray[arrayLength] = point->cadd;
+        if (!nmDArray.empty()) nmDArray[arrayLength] = point->nmd;
+        if (!hrDArray.empty()) hrDArray[arrayLength] = point->hrd;
+
+        if (!speedArray.empty())
+            speedArray[arrayLength] = max(0,
+                                          (metric
+                                           ? point->kph
+                                           : point->kph * MILES_PER_KM));
+        if (!cadArray.empty())
+            cadArray[arrayLength]   = max(0, point->cad);
+        if (!altArray.empty())
+            altArray[arrayLength]   = (metric
+                                       ? point->alt
+                                       : point->alt * FEET_PER_METER);
+
+        if (!slopeArray.empty()) slopeArray[arrayLength] = point->slope;
+
+        if (!tempArray.empty())
+            tempArray[arrayLength]   = point->temp;
+
+        if (!windArray.empty())
+            windArray[arrayLength] = max(0,
+                                         (metric
+                                          ? point->headwind
+                                          : point->headwind * MILES_PER_KM));
+
+        // pedal data
+        if (!balanceArray.empty()) balanceArray[arrayLength] = point->lrbalance;
+        if (!lteArray.empty()) lteArray[arrayLength] = point->lte;
+        if (!rteArray.empty()) rteArray[arrayLength] = point->rte;
+        if (!lpsArray.empty()) lpsArray[arrayLength] = point->lps;
+        if (!rpsArray.empty()) rpsArray[arrayLength] = point->rps;
+        if (!lpcoArray.empty()) lpcoArray[arrayLength] = point->lpco;
+        if (!rpcoArray.empty()) rpcoArray[arrayLength] = point->rpco;
+        if (!lppbArray.empty()) lppbArray[arrayLength] = point->lppb;
+        if (!rppbArray.empty()) rppbArray[arrayLength] = point->rppb;
+        if (!lppeArray.empty()) lppeArray[arrayLength] = point->lppe;
+        if (!rppeArray.empty()) rppeArray[arrayLength] = point->rppe;
+        if (!lpppbArray.empty()) lpppbArray[arrayLength] = point->lpppb;
+        if (!rpppbArray.empty()) rpppbArray[arrayLength] = point->rpppb;
+        if (!lpppeArray.empty()) lpppeArray[arrayLength] = point->lpppe;
+        if (!rpppeArray.empty()) rpppeArray[arrayLength] = point->rpppe;
+
+        distanceArray[arrayLength] = max(0,
+                                         (metric
+                                          ? point->km
+                                          : point->km * MILES_PER_KM));
+
+        if (!torqueArray.empty())
+            torqueArray[arrayLength] = max(0,
+                                          (metric
+                                           ? point->nm
+                                           : point->nm * FEET_LB_PER_NM));
+        ++arrayLength;
+    }
+}
+
 void
 AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here)
 {
     if (ride && ride->dataPoints().size()) {
         const RideFileDataPresent *dataPresent = ride->areDataPresent();
-        int npoints = ride->dataPoints().size();
 
         // fetch w' bal data
         here->match = ride->wprimeData()->mydata();
@@ -5016,50 +4947,10 @@ AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here)
         here->wprimeTime = ride->wprimeData()->xdata(false);
         here->wprimeDist = ride->wprimeData()->xdata(true);
 
-        here->wattsArray.resize(dataPresent->watts ? npoints : 0);
-        here->atissArray.resize(dataPresent->watts ? npoints : 0);
-        here->antissArray.resize(dataPresent->watts ? npoints : 0);
-        here->npArray.resize(dataPresent->np ? npoints : 0);
-        here->rcadArray.resize(dataPresent->rcad ? npoints : 0);
-        here->rvArray.resize(dataPresent->rvert ? npoints : 0);
-        here->rgctArray.resize(dataPresent->rcontact ? npoints : 0);
-        here->smo2Array.resize(dataPresent->smo2 ? npoints : 0);
-        here->thbArray.resize(dataPresent->thb ? npoints : 0);
-        here->o2hbArray.resize(dataPresent->o2hb ? npoints : 0);
-        here->hhbArray.resize(dataPresent->hhb ? npoints : 0);
-        here->gearArray.resize(dataPresent->gear ? npoints : 0);
-        here->xpArray.resize(dataPresent->xp ? npoints : 0);
-        here->apArray.resize(dataPresent->apower ? npoints : 0);
-        here->hrArray.resize(dataPresent->hr ? npoints : 0);
-        here->speedArray.resize(dataPresent->kph ? npoints : 0);
-        here->accelArray.resize(dataPresent->kph ? npoints : 0);
-        here->wattsDArray.resize(dataPresent->watts ? npoints : 0);
-        here->cadDArray.resize(dataPresent->cad ? npoints : 0);
-        here->nmDArray.resize(dataPresent->nm ? npoints : 0);
-        here->hrDArray.resize(dataPresent->hr ? npoints : 0);
-        here->cadArray.resize(dataPresent->cad ? npoints : 0);
-        here->altArray.resize(dataPresent->alt ? npoints : 0);
-        here->slopeArray.resize(dataPresent->slope ? npoints : 0);
-        here->tempArray.resize(dataPresent->temp ? npoints : 0);
-        here->windArray.resize(dataPresent->headwind ? npoints : 0);
-        here->torqueArray.resize(dataPresent->nm ? npoints : 0);
-        here->balanceArray.resize(dataPresent->lrbalance ? npoints : 0);
-        here->lteArray.resize(dataPresent->lte ? npoints : 0);
-        here->rteArray.resize(dataPresent->rte ? npoints : 0);
-        here->lpsArray.resize(dataPresent->lps ? npoints : 0);
-        here->rpsArray.resize(dataPresent->rps ? npoints : 0);
-        here->lpcoArray.resize(dataPresent->lpco ? npoints : 0);
-        here->rpcoArray.resize(dataPresent->rpco ? npoints : 0);
-        here->lppbArray.resize(dataPresent->lppb ? npoints : 0);
-        here->rppbArray.resize(dataPresent->rppb ? npoints : 0);
-        here->lppeArray.resize(dataPresent->lppe ? npoints : 0);
-        here->rppeArray.resize(dataPresent->rppe ? npoints : 0);
-        here->lpppbArray.resize(dataPresent->lpppb ? npoints : 0);
-        here->rpppbArray.resize(dataPresent->rpppb ? npoints : 0);
-        here->lpppeArray.resize(dataPresent->lpppe ? npoints : 0);
-        here->rpppeArray.resize(dataPresent->rpppe ? npoints : 0);
-        here->timeArray.resize(npoints);
-        here->distanceArray.resize(npoints);
+        // the samples, with the ride's smoother since it may
+        // have smoothed them in the background already
+        here->fill(ride, context->athlete->useMetricUnits);
+        here->smoother = ride->smoother();
 
         // attach appropriate curves
         here->wCurve->detach();
@@ -5212,100 +5103,6 @@ AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here)
         here->nmDCurve->setVisible(dataPresent->nm && showTorqueD);
         here->hrDCurve->setVisible(dataPresent->hr && showHrD);
 
-        int arrayLength = 0;
-        foreach (const RideFilePoint *point, ride->dataPoints()) {
-
-            // we round the time to nearest 100th of a second
-            // before adding to the array, to avoid situation
-            // where 'high precision' time slice is an artefact
-            // of double precision or slight timing anomalies
-            // e.g. where realtime gives timestamps like
-            // 940.002 followed by 940.998 and were previously
-            // both rounded to 940s
-            //
-            // NOTE: this rounding mechanism is identical to that
-            //       used by the Ride Editor.
-            double secs = floor(point->secs);
-            double msecs = round((point->secs - secs) * 100) * 10;
-
-            here->timeArray[arrayLength]  = secs + msecs/1000;
-            if (!here->wattsArray.empty()) here->wattsArray[arrayLength] = max(0, point->watts);
-            if (!here->atissArray.empty()) here->atissArray[arrayLength] = max(0, point->atiss);
-            if (!here->antissArray.empty()) here->antissArray[arrayLength] = max(0, point->antiss);
-            if (!here->npArray.empty()) here->npArray[arrayLength] = max(0, point->np);
-            if (!here->rvArray.empty()) here->rvArray[arrayLength] = max(0, point->rvert);
-            if (!here->rcadArray.empty()) here->rcadArray[arrayLength] = max(0, point->rcad);
-            if (!here->rgctArray.empty()) here->rgctArray[arrayLength] = max(0, point->rcontact);
-            if (!here->gearArray.empty()) here->gearArray[arrayLength] = max(0, point->gear);
-            if (!here->smo2Array.empty()) here->smo2Array[arrayLength] = max(0, point->smo2);
-            if (!here->thbArray.empty()) here->thbArray[arrayLength] = max(0, point->thb);
-            if (!here->o2hbArray.empty()) here->o2hbArray[arrayLength] = max(0, point->o2hb);
-            if (!here->hhbArray.empty()) here->hhbArray[arrayLength] = max(0, point->hhb);
-            if (!here->xpArray.empty()) here->xpArray[arrayLength] = max(0, point->xp);
-            if (!here->apArray.empty()) here->apArray[arrayLength] = max(0, point->apower);
-
-            if (!here->hrArray.empty())
-                here->hrArray[arrayLength]    = max(0, point->hr);
-
-            // delta series
-            if (!here->accelArray.empty()) here->accelArray[arrayLength] = point->kphd;
-            if (!here->wattsDArray.empty()) here->wattsDArray[arrayLength] = point->wattsd;
-            if (!here->cadDArray.empty()) here->cadDArray[arrayLength] = point->cadd;
-            if (!here->nmDArray.empty()) here->nmDArray[arrayLength] = point->nmd;
-            if (!here->hrDArray.empty()) here->hrDArray[arrayLength] = point->hrd;
-
-            if (!here->speedArray.empty())
-                here->speedArray[arrayLength] = max(0,
-                                              (context->athlete->useMetricUnits
-                                               ? point->kph
-                                               : point->kph * MILES_PER_KM));
-            if (!here->cadArray.empty())
-                here->cadArray[arrayLength]   = max(0, point->cad);
-            if (!here->altArray.empty())
-                here->altArray[arrayLength]   = (context->athlete->useMetricUnits
-                                           ? point->alt
-                                           : point->alt * FEET_PER_METER);
-
-            if (!here->slopeArray.empty()) here->slopeArray[arrayLength] = point->slope;
-
-            if (!here->tempArray.empty())
-                here->tempArray[arrayLength]   = point->temp;
-
-            if (!here->windArray.empty())
-                here->windArray[arrayLength] = max(0,
-                                             (context->athlete->useMetricUnits
-                                              ? point->headwind
-                                              : point->headwind * MILES_PER_KM));
-
-            // pedal data
-            if (!here->balanceArray.empty()) here->balanceArray[arrayLength] = point->lrbalance;
-            if (!here->lteArray.empty()) here->lteArray[arrayLength] = point->lte;
-            if (!here->rteArray.empty()) here->rteArray[arrayLength] = point->rte;
-            if (!here->lpsArray.empty()) here->lpsArray[arrayLength] = point->lps;
-            if (!here->rpsArray.empty()) here->rpsArray[arrayLength] = point->rps;
-            if (!here->lpcoArray.empty()) here->lpcoArray[arrayLength] = point->lpco;
-            if (!here->rpcoArray.empty()) here->rpcoArray[arrayLength] = point->rpco;
-            if (!here->lppbArray.empty()) here->lppbArray[arrayLength] = point->lppb;
-            if (!here->rppbArray.empty()) here->rppbArray[arrayLength] = point->rppb;
-            if (!here->lppeArray.empty()) here->lppeArray[arrayLength] = point->lppe;
-            if (!here->rppeArray.empty()) here->rppeArray[arrayLength] = point->rppe;
-            if (!here->lpppbArray.empty()) here->lpppbArray[arrayLength] = point->lpppb;
-            if (!here->rpppbArray.empty()) here->rpppbArray[arrayLength] = point->rpppb;
-            if (!here->lpppeArray.empty()) here->lpppeArray[arrayLength] = point->lpppe;
-            if (!here->rpppeArray.empty()) here->rpppeArray[arrayLength] = point->rpppe;
-
-            here->distanceArray[arrayLength] = max(0,
-                                             (context->athlete->useMetricUnits
-                                              ? point->km
-                                              : point->km * MILES_PER_KM));
-
-            if (!here->torqueArray.empty())
-                here->torqueArray[arrayLength] = max(0,
-                                              (context->athlete->useMetricUnits
-                                               ? point->nm
-                                               : point->nm * FEET_LB_PER_NM));
-            ++arrayLength;
-        }
         recalc(here);
     }
     else {
@@ -6247,6 +6044,9 @@ AllPlot::setSmoothing(int value)
 {
     smooth = value;
 
+    // rides opened in the background are smoothed the same
+    if (!referencePlot) context->athlete->rideCache->setSmoothing(value);
+
     // if anything is going on, lets stop it now!
     // ACTUALLY its quite handy to play with smooting!
     isolation = false;
@@ -6255,6 +6055,29 @@ AllPlot::setSmoothing(int value)
     recalc(standard);
 }
 
+void
+AllPlot::prepareSmoothing(int value)
+{
+    pendingSmooth = value;
+
+    // nothing worth doing in the background, same rules as recalc
+    if (referencePlot || standard->timeArray.empty() || !rideItem || !rideItem->ride() ||
+        value <= rideItem->ride()->recIntSecs()) {
+        emit smoothingReady(value);
+        return;
+    }
+
+    // fill the smoother cache, any previous request is cancelled
+    smoothWatcher.setFuture(standard->smoother->prepare(standard->timeArray, smoothingSeries(standard), value));
+}
+
+void
+AllPlot::smoothingPrepared()
+{
+    // now applying it will be quick
+    emit smoothingReady(pendingSmooth);
+}
+
 void
 AllPlot::setByDistance(int id)
 {
@@ -21,6 +21,7 @@
 #include "GoldenCheetah.h"
 #include "Colors.h"
 #include "AllPlotSlopeCurve.h"
+#include "Smoother.h"
 
 #include <qwt_plot.h>
 #include <qwt_axis_id.h>
@@ -34,6 +35,7 @@
 #include <qwt_compat.h>
 #include <QtGui>
 #include <QFont>
+#include <QFutureWatcher>
 
 #include <QTableWidget>
 #include <QStackedWidget>
@@ -307,7 +309,64 @@ class CurveColors : public QObject
 
 class AllPlot;
 class MergeAdjust;
-class AllPlotObject : public QObject
+
+// the samples of a ride as plotted, one entry per sample, which can be
+// filled on any thread so the ride plot can be smoothed in the background
+struct AllPlotSamples
+{
+    AllPlotSamples() : metric(true) {}
+
+    // from the ride, in metric or imperial units
+    void fill(RideFile *ride, bool metric);
+    bool metric;
+
+    QVector<double> hrArray;
+    QVector<double> wattsArray;
+    QVector<double> atissArray;
+    QVector<double> antissArray;
+    QVector<double> rvArray;
+    QVector<double> rcadArray;
+    QVector<double> rgctArray;
+    QVector<double> gearArray;
+    QVector<double> smo2Array;
+    QVector<double> thbArray;
+    QVector<double> o2hbArray;
+    QVector<double> hhbArray;
+    QVector<double> npArray;
+    QVector<double> xpArray;
+    QVector<double> apArray;
+    QVector<double> speedArray;
+    QVector<double> accelArray;
+    QVector<double> wattsDArray;
+    QVector<double> cadDArray;
+    QVector<double> nmDArray;
+    QVector<double> hrDArray;
+    QVector<double> cadArray;
+    QVector<double> timeArray;
+    QVector<double> distanceArray;
+    QVector<double> altArray;
+    QVector<double> slopeArray;
+    QVector<double> tempArray;
+    QVector<double> windArray;
+    QVector<double> torqueArray;
+    QVector<double> balanceArray;
+    QVector<double> lteArray;
+    QVector<double> rteArray;
+    QVector<double> lpsArray;
+    QVector<double> rpsArray;
+    QVector<double> lpcoArray;
+    QVector<double> rpcoArray;
+    QVector<double> lppbArray;
+    QVector<double> rppbArray;
+    QVector<double> lppeArray;
+    QVector<double> rppeArray;
+    QVector<double> lpppbArray;
+    QVector<double> rpppbArray;
+    QVector<double> lpppeArray;
+    QVector<double> rpppeArray;
+};
+
+class AllPlotObject : public QObject, public AllPlotSamples
 {
     Q_OBJECT;
 
@@ -387,51 +446,6 @@ class AllPlotObject : public QObject
     QVector<double> wprimeTime;
     QVector<double> wprimeDist;
 
-    QVector<double> hrArray;
-    QVector<double> wattsArray;
-    QVector<double> atissArray;
-    QVector<double> antissArray;
-    QVector<double> rvArray;
-    QVector<double> rcadArray;
-    QVector<double> rgctArray;
-    QVector<double> gearArray;
-    QVector<double> smo2Array;
-    QVector<double> thbArray;
-    QVector<double> o2hbArray;
-    QVector<double> hhbArray;
-    QVector<double> npArray;
-    QVector<double> xpArray;
-    QVector<double> apArray;
-    QVector<double> speedArray;
-    QVector<double> accelArray;
-    QVector<double> wattsDArray;
-    QVector<double> cadDArray;
-    QVector<double> nmDArray;
-    QVector<double> hrDArray;
-    QVector<double> cadArray;
-    QVector<double> timeArray;
-    QVector<double> distanceArray;
-    QVector<double> altArray;
-    QVector<double> slopeArray;
-    QVector<double> tempArray;
-    QVector<double> windArray;
-    QVector<double> torqueArray;
-    QVector<double> balanceArray;
-    QVector<double> lteArray;
-    QVector<double> rteArray;
-    QVector<double> lpsArray;
-    QVector<double> rpsArray;
-    QVector<double> lpcoArray;
-    QVector<double> rpcoArray;
-    QVector<double> lppbArray;
-    QVector<double> rppbArray;
-    QVector<double> lppeArray;
-    QVector<double> rppeArray;
-    QVector<double> lpppbArray;
-    QVector<double> rpppbArray;
-    QVector<double> lpppeArray;
-    QVector<double> rpppeArray;
-
     // smoothed data
     QVector<double> smoothWatts;
     QVector<double> smoothAT;
@@ -476,6 +490,10 @@ class AllPlotObject : public QObject
     QVector<QwtIntervalSample> smoothRPPP;
     QVector<QwtIntervalSample> smoothRelSpeed;
 
+    // smoothing engine and its cache, the ride's own when the samples
+    // came from a ride since it may have been smoothed in the background
+    QSharedPointer<Smoother> smoother;
+
     // highlighting intervals
     QwtPlotCurve *intervalHighlighterCurve,  // highlight selected intervals on the Plot
                  *intervalHoverCurve;
@@ -513,6 +531,9 @@ class AllPlot : public QwtPlot
                                                                            // reference is for settings et al
         void setMatchLabels(AllPlotObject *object); // set labels from object
 
+        // smooth a ride's samples into its smoother, from any thread
+        static void prepareRide(RideFile *ride, bool metric, int smooth);
+
         // convert from time/distance to index in *smoothed* datapoints
         int timeIndex(double) const;
         int distanceIndex(double) const;
@@ -583,6 +604,8 @@ class AllPlot : public QwtPlot
         void setPaintBrush(int state);
         void setShadeZones(bool x) { shade_zones=x; }
         void setSmoothing(int value);
+        void prepareSmoothing(int value); // in the background, then emits smoothingReady
+        void smoothingPrepared();
         void setByDistance(int value);
         void setWantAxis(bool x, bool y=false) { wantaxis = x; wantxaxis = y;}
         void configChanged(qint32);
@@ -591,6 +614,10 @@ class AllPlot : public QwtPlot
         void pointHover(QwtPlotCurve*, int);
         void intervalHover(RideFileInterval h);
 
+    signals:
+
+        void smoothingReady(int);
+
     protected:
 
         friend class ::AllPlotBackground;
@@ -651,6 +678,8 @@ class AllPlot : public QwtPlot
 
         // array / smooth state
         int smooth;
+        int pendingSmooth; // being prepared in the background
+        QFutureWatcher<void> smoothWatcher;
         bool bydist;
         bool fill;
 
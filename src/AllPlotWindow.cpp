@@ -599,6 +599,9 @@ AllPlotWindow::AllPlotWindow(Context *context) :
     HelpWhatsThis *helpFull = new HelpWhatsThis(fullPlot);
     fullPlot->setWhatsThis(helpFull->getWhatsThisText(HelpWhatsThis::ChartRides_Performance));
 
+    // smoothing slider changes are prepared in the background
+    connect(fullPlot, SIGNAL(smoothingReady(int)), this, SLOT(setSmoothing(int)));
+
     intervalPlot = new AllPlotInterval(this, context);
     intervalPlot->setFixedHeight(100);
     intervalPlot->setCanvasBackground(GColor(CRIDEPLOTBACKGROUND));
@@ -1603,10 +1606,10 @@ AllPlotWindow::setSmoothingFromSlider()
     else active = true;
 
     if (allPlot->smooth != smoothSlider->value()) {
-        setSmoothing(smoothSlider->value());
-        smoothLineEdit->setText(QString("%1").arg(fullPlot->smooth));
-        rSmoothEdit->setText(QString("%1").arg(fullPlot->smooth));
-        rSmoothSlider->setValue(rSmoothSlider->value());
+        setSmoothingInBackground(smoothSlider->value());
+        smoothLineEdit->setText(QString("%1").arg(smoothSlider->value()));
+        rSmoothEdit->setText(QString("%1").arg(smoothSlider->value()));
+        rSmoothSlider->setValue(smoothSlider->value());
     }
     active = false;
 }
@@ -1621,10 +1624,10 @@ AllPlotWindow::setrSmoothingFromSlider()
     else active = true;
 
     if (allPlot->smooth != rSmoothSlider->value()) {
-        setSmoothing(rSmoothSlider->value());
-        rSmoothEdit->setText(QString("%1").arg(fullPlot->smooth));
+        setSmoothingInBackground(rSmoothSlider->value());
+        rSmoothEdit->setText(QString("%1").arg(rSmoothSlider->value()));
         smoothSlider->setValue(rSmoothSlider->value());
-        smoothLineEdit->setText(QString("%1").arg(fullPlot->smooth));
+        smoothLineEdit->setText(QString("%1").arg(rSmoothSlider->value()));
     }
     active = false;
 }
@@ -2189,7 +2192,7 @@ AllPlotWindow::setShowNP(int value)
     bool checked = ( ( value == Qt::Checked ) && showNP->isEnabled()) ? true : false;
 
     // recalc only does it if it needs to
-    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries();
+    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries(RideFile::NP);
 
     allPlot->setShowNP(checked);
     foreach (AllPlot *plot, allPlots)
@@ -2212,7 +2215,7 @@ AllPlotWindow::setShowANTISS(int value)
     bool checked = ( ( value == Qt::Checked ) && showANTISS->isEnabled()) ? true : false;
 
     // recalc only does it if it needs to
-    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries();
+    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries(RideFile::anTISS);
 
     allPlot->setShowANTISS(checked);
     foreach (AllPlot *plot, allPlots)
@@ -2235,7 +2238,7 @@ AllPlotWindow::setShowATISS(int value)
     bool checked = ( ( value == Qt::Checked ) && showATISS->isEnabled()) ? true : false;
 
     // recalc only does it if it needs to
-    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries();
+    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries(RideFile::aTISS);
 
     allPlot->setShowATISS(checked);
     foreach (AllPlot *plot, allPlots)
@@ -2258,7 +2261,7 @@ AllPlotWindow::setShowXP(int value)
     bool checked = ( ( value == Qt::Checked ) && showXP->isEnabled()) ? true : false;
 
     // recalc only does it if it needs to
-    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries();
+    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries(RideFile::xPower);
 
     allPlot->setShowXP(checked);
     foreach (AllPlot *plot, allPlots)
@@ -2281,7 +2284,7 @@ AllPlotWindow::setShowAP(int value)
     bool checked = ( ( value == Qt::Checked ) && showAP->isEnabled()) ? true : false;
 
     // recalc only does it if it needs to
-    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries();
+    if (value && current && current->ride()) current->ride()->recalculateDerivedSeries(RideFile::aPower);
 
     allPlot->setShowAP(checked);
     foreach (AllPlot *plot, allPlots)
@@ -2992,6 +2995,16 @@ AllPlotWindow::setByDistance(int value)
     active = false;
 }
 
+void
+AllPlotWindow::setSmoothingInBackground(int value)
+{
+    // compare has LOTS of rides to smooth, so we just
+    // get on with it, otherwise the full plot smooths
+    // in the background and tells us when its ready
+    if (context->isCompareIntervals) setSmoothing(value);
+    else fullPlot->prepareSmoothing(value);
+}
+
 void
 AllPlotWindow::setSmoothing(int value)
 {
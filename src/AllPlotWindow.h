@@ -223,6 +223,7 @@ class AllPlotWindow : public GcChartWindow
         void setShowInterval(int state);
         void setShowHelp(int state);
         void setSmoothing(int value);
+        void setSmoothingInBackground(int value);
         void setByDistance(int value);
         void setStacked(int value);
         void setBySeries(int value);
@@ -33,6 +33,7 @@
 #include "IntervalItem.h"
 #include "AddIntervalDialog.h"
 #include "BestIntervalDialog.h"
+#include "IntervalSearch.h"
 
 // working with routes
 #include "Route.h"
@@ -410,17 +411,13 @@ AnalysisSidebar::addIntervals()
 }
 
 void
-AnalysisSidebar::addIntervalForPowerPeaksForSecs(RideFile *ride, int windowSizeSecs, QString name)
+AnalysisSidebar::addIntervalForPowerPeak(RideFile *ride, double start, double stop, double avg, QString name)
 {
-    QList<BestIntervalDialog::BestInterval> results;
-    BestIntervalDialog::findBests(ride, windowSizeSecs, 1, results);
-    if (results.isEmpty()) return;
-    const BestIntervalDialog::BestInterval &i = results.first();
     QTreeWidgetItem *peak =
-        new IntervalItem(ride, name+tr(" (%1 watts)").arg((int) round(i.avg)),
-                         i.start, i.stop,
-                         ride->timeToDistance(i.start),
-                         ride->timeToDistance(i.stop),
+        new IntervalItem(ride, name+tr(" (%1 watts)").arg((int) round(avg)),
+                         start, stop,
+                         ride->timeToDistance(start),
+                         ride->timeToDistance(stop),
                          context->athlete->allIntervals->childCount()+1);
     peak->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled);
     context->athlete->allIntervals->addChild(peak);
@@ -432,17 +429,20 @@ AnalysisSidebar::findPowerPeaks()
 
     if (context->ride && context->ride->ride() && context->ride->ride()->dataPoints().count()) {
 
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 5, "Peak 5s");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 10, "Peak 10s");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 20, "Peak 20s");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 30, "Peak 30s");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 60, "Peak 1min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 120, "Peak 2min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 300, "Peak 5min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 600, "Peak 10min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 1200, "Peak 20min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 1800, "Peak 30min");
-        addIntervalForPowerPeaksForSecs(context->ride->ride(), 3600, "Peak 60min");
+        static const double durations[] = { 5, 10, 20, 30, 60, 120, 300, 600, 1200, 1800, 3600 };
+        static const char *names[] = { "Peak 5s", "Peak 10s", "Peak 20s", "Peak 30s", "Peak 1min", "Peak 2min",
+                                       "Peak 5min", "Peak 10min", "Peak 20min", "Peak 30min", "Peak 60min" };
+
+        // find them all in one pass
+        QVector<double> sizes;
+        for (unsigned int i=0; i<sizeof(durations)/sizeof(durations[0]); i++) sizes << durations[i];
+
+        RideFile *ride = context->ride->ride();
+        QVector<IntervalSearch::Result> peaks = IntervalSearch(ride).peaks(sizes);
+
+        for (int i=0; i<peaks.count(); i++)
+            if (peaks[i].isValid())
+                addIntervalForPowerPeak(ride, peaks[i].start, peaks[i].start + peaks[i].duration, peaks[i].avg, names[i]);
 
         // now update the RideFileIntervals
         context->athlete->updateRideFileIntervals();
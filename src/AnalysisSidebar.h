@@ -66,7 +66,7 @@ class AnalysisSidebar : public QWidget
 
         // interval functions
         void addIntervals();
-        void addIntervalForPowerPeaksForSecs(RideFile *ride, int windowSizeSecs, QString name);
+        void addIntervalForPowerPeak(RideFile *ride, double start, double stop, double avg, QString name);
         void findPowerPeaks();
         void editInterval(); // from right click
         void deleteInterval(); // from right click
@@ -25,6 +25,7 @@
 #include "RideMetadata.h"
 #include "RideCache.h"
 #include "RideFileCache.h"
+#include "FileJournal.h"
 #include "RideMetric.h"
 #include "Settings.h"
 #include "TimeUtils.h"
@@ -51,6 +52,21 @@
 
 #include "GcUpgrade.h" // upgrade wizard
 #include "GcCrashDialog.h" // recovering from a crash?
+#include "GcBatch.h" // no dialogs when running batch
+#include <stdio.h>
+
+// tell the user, or stderr when there is no user
+static void
+zonesMessage(Context *context, bool critical, QString title, QString message)
+{
+    if (gcbatch) {
+        fprintf(stderr, "%s: %s\n", title.toLocal8Bit().constData(), message.toLocal8Bit().constData());
+    } else if (critical) {
+        QMessageBox::critical(context->mainWindow, title, message);
+    } else {
+        QMessageBox::warning(context->mainWindow, title, message);
+    }
+}
 
 Athlete::Athlete(Context *context, const QDir &homeDir)
 {
@@ -93,10 +109,9 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     QFile zonesFile(home->config().canonicalPath() + "/power.zones");
     if (zonesFile.exists()) {
         if (!zones_->read(zonesFile)) {
-            QMessageBox::critical(context->mainWindow, tr("Zones File Error"),
-				  zones_->errorString());
+            zonesMessage(context, true, tr("Zones File Error"), zones_->errorString());
         } else if (! zones_->warningString().isEmpty())
-            QMessageBox::warning(context->mainWindow, tr("Reading Zones File"), zones_->warningString());
+            zonesMessage(context, false, tr("Reading Zones File"), zones_->warningString());
     }
 
     // Heartrate Zones
@@ -104,10 +119,9 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     QFile hrzonesFile(home->config().canonicalPath() + "/hr.zones");
     if (hrzonesFile.exists()) {
         if (!hrzones_->read(hrzonesFile)) {
-            QMessageBox::critical(context->mainWindow, tr("HR Zones File Error"),
-				  hrzones_->errorString());
+            zonesMessage(context, true, tr("HR Zones File Error"), hrzones_->errorString());
         } else if (! hrzones_->warningString().isEmpty())
-            QMessageBox::warning(context->mainWindow, tr("Reading HR Zones File"), hrzones_->warningString());
+            zonesMessage(context, false, tr("Reading HR Zones File"), hrzones_->warningString());
     }
 
     // Pace Zones for Run & Swim
@@ -116,11 +130,14 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
         QFile pacezonesFile(home->config().canonicalPath() + "/" + pacezones_[i]->fileName());
         if (pacezonesFile.exists()) {
             if (!pacezones_[i]->read(pacezonesFile)) {
-                QMessageBox::critical(context->mainWindow, tr("Pace Zones File %1 Error").arg(pacezones_[i]->fileName()), pacezones_[i]->errorString());
+                zonesMessage(context, true, tr("Pace Zones File %1 Error").arg(pacezones_[i]->fileName()), pacezones_[i]->errorString());
             }
         }
     }
 
+    // zones are in, so we have a config
+    publishConfig();
+
     // read athlete's autoimport configuration
     autoImportConfig = new RideAutoImportConfig(home->config());
 
@@ -134,8 +151,15 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
 
     // Metadata
     rideCache = NULL; // let metadata know we don't have a ridecache yet
-    rideMetadata_ = new RideMetadata(context,true);
-    rideMetadata_->hide();
+    if (gcbatch) {
+        rideMetadata_ = NULL;
+        QString filename = home->config().absolutePath()+"/metadata.xml";
+        if (!QFile(filename).exists()) filename = ":/xml/metadata.xml";
+        RideMetadata::readXML(filename, keywordDefinitions, fieldDefinitions, colorfield, defaultDefinitions);
+    } else {
+        rideMetadata_ = new RideMetadata(context,true);
+        rideMetadata_->hide();
+    }
     colorEngine = new ColorEngine(context);
 
     // Date Ranges
@@ -164,7 +188,11 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
         if (errors.count() == 0) setWithings(parser.readings());
     }
 
+    // before the cache, so the config is always published first
+    connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
+
     // now most dependencies are in get cache
+    journal = new FileJournal(home->cache().canonicalPath() + "/filejournal");
     rideCache = new RideCache(context);
 
 #ifdef GC_HAVE_INTERVALS
@@ -185,11 +213,26 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
 
     // Calendar
 #ifdef GC_HAVE_ICAL
-    rideCalendar = new ICalendar(context); // my local/remote calendar entries
-    davCalendar = new CalDAV(context); // remote caldav
-    davCalendar->download(true); // refresh the diary window but do not show any error messages
+    rideCalendar = NULL;
+    davCalendar = NULL;
+    if (!gcbatch) {
+        rideCalendar = new ICalendar(context); // my local/remote calendar entries
+        davCalendar = new CalDAV(context); // remote caldav
+        davCalendar->download(true); // refresh the diary window but do not show any error messages
+    }
 #endif
 
+    // trap signals
+    connect(context,SIGNAL(rideAdded(RideItem*)),this,SLOT(checkCPX(RideItem*)));
+    connect(context,SIGNAL(rideDeleted(RideItem*)),this,SLOT(checkCPX(RideItem*)));
+
+    // no interval tree without a window
+    if (gcbatch) {
+        intervalWidget = NULL;
+        allIntervals = NULL;
+        return;
+    }
+
     //.INTERVALS TREE -- transitionary
     intervalWidget = new IntervalTreeView(context);
     intervalWidget->setColumnCount(1);
@@ -206,10 +249,6 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     allIntervals->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDropEnabled);
     allIntervals->setText(0, tr("Intervals"));
 
-    // trap signals
-    connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
-    connect(context,SIGNAL(rideAdded(RideItem*)),this,SLOT(checkCPX(RideItem*)));
-    connect(context,SIGNAL(rideDeleted(RideItem*)),this,SLOT(checkCPX(RideItem*)));
     connect(intervalWidget,SIGNAL(itemSelectionChanged()), this, SLOT(intervalTreeWidgetSelectionChanged()));
     connect(intervalWidget,SIGNAL(itemChanged(QTreeWidgetItem *,int)), this, SLOT(updateRideFileIntervals()));
 }
@@ -226,6 +265,7 @@ Athlete::~Athlete()
 {
     // close the ride cache down first
     delete rideCache;
+    delete journal;
 
     // save those preset charts
     LTMSettings reader;
@@ -255,6 +295,8 @@ Athlete::~Athlete()
     delete zones_;
     delete hrzones_;
     for (int i=0; i<2; i++) delete pacezones_[i];
+
+    qDeleteAll(configs_);
 }
 
 void Athlete::selectRideFile(QString fileName)
@@ -303,10 +345,28 @@ Athlete::updateRideFileIntervals()
     }
 }
 
+QList<KeywordDefinition>
+Athlete::metadataKeywords()
+{
+    return rideMetadata_ ? rideMetadata_->getKeywords() : keywordDefinitions;
+}
+
+QList<FieldDefinition>
+Athlete::metadataFields()
+{
+    return rideMetadata_ ? rideMetadata_->getFields() : fieldDefinitions;
+}
+
+QString
+Athlete::metadataColorField()
+{
+    return rideMetadata_ ? rideMetadata_->getColorField() : colorfield;
+}
+
 void
-Athlete::addRide(QString name, bool dosignal, bool useTempActivities)
+Athlete::addRide(QString name, bool dosignal, bool useTempActivities, bool later)
 {
-    rideCache->addRide(name, dosignal, useTempActivities);
+    rideCache->addRide(name, dosignal, useTempActivities, later);
 }
 
 void
@@ -377,6 +437,9 @@ Athlete::translateDefaultCharts(QList<LTMSettings>&charts)
 void
 Athlete::configChanged(qint32 state)
 {
+    // anything may have changed, the workers will pick it up
+    publishConfig();
+
     // change units
     if (state & CONFIG_UNITS) {
         QVariant unit = appsettings->cvalue(cyclist, GC_UNIT);
@@ -498,19 +561,21 @@ Athlete::setWithings(QList<WithingsReading>&x)
 {
     withings_ = x;
     qSort(withings_); // date order
+    publishConfig();
 }
 
 double 
 Athlete::getWithingsWeight(QDate date)
 {
-    if (withings_.count() == 0) return 0;
+    return config()->withingsWeight(date);
+}
 
-    double lastWeight=0.0f;
-    foreach(WithingsReading x, withings_) {
-        if (x.when.date() <= date) lastWeight = x.weightkg;
-        if (x.when.date() > date) break;
-    }
-    return lastWeight;
+void
+Athlete::publishConfig()
+{
+    AthleteConfig *next = new AthleteConfig(this, configs_.count() + 1);
+    configs_ << next;
+    config_.fetchAndStoreOrdered(next);
 }
 
 double
@@ -527,7 +592,7 @@ Athlete::getWeight(QDate date, RideFile *ride)
 
     // global options
     if (!weight)
-        weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
+        weight = config()->weight(); // default to 75kg
 
     // No weight default is weird, we'll set to 80kg
     if (weight <= 0.00) weight = 80.00;
@@ -544,7 +609,7 @@ Athlete::getHeight(RideFile *ride)
     if (ride) height = ride->getTag("Height", "0.0").toDouble();
 
     // global options ?
-    if (!height) height = appsettings->cvalue(context->athlete->cyclist, GC_HEIGHT, 0.0f).toString().toDouble();
+    if (!height) height = config()->height();
 
     // from weight via Stillman Average?
     if (!height && ride) height = (getWeight(ride->startTime().date(), ride)+100.0)/98.43;
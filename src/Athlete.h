@@ -28,6 +28,10 @@
 
 // for WithingsReading
 #include "WithingsParser.h"
+#include "AthleteConfig.h"
+#include "RideMetadata.h"
+
+#include <QAtomicPointer>
 
 class Zones;
 class HrZones;
@@ -55,6 +59,7 @@ class RideAutoImportConfig;
 class RideCache;
 class Context;
 class ColorEngine;
+class FileJournal;
 
 class Athlete : public QObject
 {
@@ -74,6 +79,10 @@ class Athlete : public QObject
         // metadata definitions
         RideMetadata *rideMetadata_;
         ColorEngine *colorEngine;
+        QList<KeywordDefinition> keywordDefinitions;
+        QList<FieldDefinition> fieldDefinitions;
+        QList<DefaultDefinition> defaultDefinitions;
+        QString colorfield;
 
         // zones
         const Zones *zones() const { return zones_; }
@@ -95,12 +104,25 @@ class Athlete : public QObject
         Routes *routes;
         QList<RideFileCache*> cpxCache;
         RideCache *rideCache;
+        FileJournal *journal; // what we know about files in activities and cache
         QList<WithingsReading> withings_;
+        QAtomicPointer<const AthleteConfig> config_;
+        QList<const AthleteConfig*> configs_; // all published
 
         // PMC Data
         PMCData *getPMCFor(QString metricName, int stsDays = -1, int ltsDays = -1); // no Specification used!
         QMap<QString, PMCData*> pmcData; // all the different PMC series
 
+        // settings snapshot, safe to use from any thread
+        const AthleteConfig *config() const {
+#if QT_VERSION > 0x050000
+            return config_.loadAcquire();
+#else
+            return config_;
+#endif
+        }
+        void publishConfig(); // GUI thread only
+
         // athlete measures
         // note ride can override if passed
         double getWeight(QDate date, RideFile *ride=NULL);
@@ -117,8 +139,12 @@ class Athlete : public QObject
         // Athlete's autoimport configuration
         RideAutoImportConfig *autoImportConfig;
 
-        // ride metadata definitions
+        // ride metadata definitions, there is no metadata widget
+        // when running batch so they're read from metadata.xml
         RideMetadata *rideMetadata() { return rideMetadata_; }
+        QList<KeywordDefinition> metadataKeywords();
+        QList<FieldDefinition> metadataFields();
+        QString metadataColorField();
 
         // preset charts
         QList<LTMSettings> presets;
@@ -136,7 +162,7 @@ class Athlete : public QObject
 
         // ride collection
         void selectRideFile(QString);
-        void addRide(QString name, bool bSelect=true, bool useTempActivities=false);
+        void addRide(QString name, bool bSelect=true, bool useTempActivities=false, bool later=false);
         void removeCurrentRide();
 
         // interval selection
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "AthleteConfig.h"
+
+#include "Athlete.h"
+#include "Zones.h"
+#include "HrZones.h"
+#include "PaceZones.h"
+#include "WithingsParser.h"
+#include "Settings.h"
+
+#include <algorithm>
+
+AthleteConfig::AthleteConfig(Athlete *athlete, int version) : version_(version)
+{
+    // withings, already sorted by date
+    foreach(WithingsReading x, athlete->withings()) {
+        weightDays << x.when.date().toJulianDay();
+        weightKg << x.weightkg;
+    }
+
+    // settings, with the same defaults as everywhere else
+    QString cyclist = athlete->cyclist;
+    weight_ = appsettings->cvalue(cyclist, GC_WEIGHT, "75.0").toString().toDouble();
+    height_ = appsettings->cvalue(cyclist, GC_HEIGHT, 0.0f).toString().toDouble();
+    dob_ = appsettings->cvalue(cyclist, GC_DOB).toDate();
+    male_ = appsettings->cvalue(cyclist, GC_SEX).toInt() == 0;
+    wbalTau_ = appsettings->cvalue(cyclist, GC_WBALTAU, 300).toInt();
+
+    const Zones *zones = athlete->zones();
+    const HrZones *hrZones = athlete->hrZones();
+    const PaceZones *paceZones = athlete->paceZones(false);
+    const PaceZones *swimZones = athlete->paceZones(true);
+
+    // every day a range starts or ends
+    QList<QDate> dates;
+    for (int i=0; i<zones->getRangeSize(); i++) dates << zones->getStartDate(i) << zones->getEndDate(i);
+    for (int i=0; i<hrZones->getRangeSize(); i++) dates << hrZones->getStartDate(i) << hrZones->getEndDate(i);
+    for (int i=0; i<paceZones->getRangeSize(); i++) dates << paceZones->getStartDate(i) << paceZones->getEndDate(i);
+    for (int i=0; i<swimZones->getRangeSize(); i++) dates << swimZones->getStartDate(i) << swimZones->getEndDate(i);
+    foreach(QDate date, dates) if (date.isValid()) changes << date.toJulianDay();
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+
+    // and what applies from each of those days, the
+    // first is before any of them and the last forever
+    for (int i=0; i<=changes.count(); i++) {
+
+        QDate date;
+        if (i) date = QDate::fromJulianDay(changes[i-1]);
+        else if (changes.count()) date = QDate::fromJulianDay(changes[0]).addDays(-1);
+        else date = QDate::currentDate();
+
+        Segment add;
+        add.power = zones->whichRange(date);
+        add.hr = hrZones->whichRange(date);
+        add.pace = paceZones->whichRange(date);
+        add.swim = swimZones->whichRange(date);
+        add.fingerprint = static_cast<unsigned long>(zones->getFingerprint(date))
+                        + static_cast<unsigned long>(paceZones->getFingerprint(date))
+                        + static_cast<unsigned long>(hrZones->getFingerprint(date));
+        segments << add;
+    }
+
+    fingerprint_ = static_cast<unsigned long>(zones->getFingerprint())
+                 + static_cast<unsigned long>(paceZones->getFingerprint())
+                 + static_cast<unsigned long>(hrZones->getFingerprint());
+}
+
+int
+AthleteConfig::segment(QDate date) const
+{
+    if (!date.isValid()) return 0;
+
+    // after the last change on or before date
+    return std::upper_bound(changes.constBegin(), changes.constEnd(), int(date.toJulianDay())) - changes.constBegin();
+}
+
+double
+AthleteConfig::withingsWeight(QDate date) const
+{
+    // the last reading on or before the date
+    int i = std::upper_bound(weightDays.constBegin(), weightDays.constEnd(), int(date.toJulianDay())) - weightDays.constBegin();
+    return i ? weightKg[i-1] : 0;
+}
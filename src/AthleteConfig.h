@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_AthleteConfig_h
+#define _GC_AthleteConfig_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QDate>
+
+class Athlete;
+
+//
+// The athlete settings the metric refresh and train mode keep asking for,
+// read once each time the configuration changes.
+//
+// A snapshot is never changed once made, so any thread can read it without
+// locking; Athlete::config() returns the latest and Athlete::publishConfig()
+// makes a new one on the GUI thread when the config or withings change.
+// Old snapshots are kept until the athlete is closed so a worker that is
+// part way through a ride can carry on with the one it started with.
+//
+// Weights and zone ranges are date timelines looked up by binary search,
+// rather than the linear scans of the withings readings and zone ranges.
+//
+class AthleteConfig
+{
+    public:
+        AthleteConfig(Athlete *athlete, int version);
+
+        // goes up by one each time a new one is published
+        int version() const { return version_; }
+
+        // latest withings weight on or before date, 0 if none
+        double withingsWeight(QDate date) const;
+
+        // athlete settings
+        double weight() const { return weight_; } // 75kg if not set
+        double height() const { return height_; } // 0 if not set
+        QDate dob() const { return dob_; }
+        bool male() const { return male_; }
+        int wbalTau() const { return wbalTau_; }
+
+        // as Zones::whichRange et al, -1 if not in any range
+        int zoneRange(QDate date) const { return segments[segment(date)].power; }
+        int hrZoneRange(QDate date) const { return segments[segment(date)].hr; }
+        int paceZoneRange(QDate date, bool isSwim=false) const {
+            return isSwim ? segments[segment(date)].swim : segments[segment(date)].pace;
+        }
+
+        // power, pace and hr fingerprints added, for the date or for all
+        unsigned long fingerprint(QDate date) const { return segments[segment(date)].fingerprint; }
+        unsigned long fingerprint() const { return fingerprint_; }
+
+    private:
+        int version_;
+
+        QVector<int> weightDays; // julian days, in order
+        QVector<double> weightKg;
+
+        double weight_, height_;
+        QDate dob_;
+        bool male_;
+        int wbalTau_;
+
+        // the zone ranges only change on the days a range
+        // starts or ends, so between them it's all the same
+        struct Segment {
+            int power, hr, pace, swim;
+            unsigned long fingerprint;
+        };
+        QVector<int> changes; // julian days, in order
+        QVector<Segment> segments; // one more than changes
+        unsigned long fingerprint_;
+
+        int segment(QDate date) const;
+};
+
+#endif // _GC_AthleteConfig_h
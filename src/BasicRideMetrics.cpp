@@ -339,7 +339,7 @@ class AthleteWeight : public RideMetric {
         if (!weight) weight = ride->getTag("Weight", "0.0").toDouble();
 
         // global options
-        if (!weight) weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
+        if (!weight) weight = context->athlete->config()->weight(); // default to 75kg
 
         // No weight default is weird, we'll set to 80kg
         if (weight <= 0.00) weight = 80.00;
@@ -2649,8 +2649,8 @@ struct TotalCalories : public RideMetric {
         athlete_weight = deps.value("athlete_weight")->value(true);
         duration = deps.value("time_riding")->value(true); // time_riding or workout_time ?
 
-        athlete_age = ride->startTime().date().year() - appsettings->cvalue(context->athlete->cyclist, GC_DOB).toDate().year();
-        bool male = appsettings->cvalue(context->athlete->cyclist, GC_SEX).toInt() == 0;
+        athlete_age = ride->startTime().date().year() - context->athlete->config()->dob().year();
+        bool male = context->athlete->config()->male();
 
         double kcalories = 0.0;
 
@@ -22,6 +22,7 @@
 #include "IntervalItem.h"
 #include "RideFile.h"
 #include "RideItem.h"
+#include "IntervalSearch.h"
 #include "HelpWhatsThis.h"
 #include <QMap>
 #include <cmath>
@@ -117,35 +118,6 @@ clearResultsTable(QTableWidget *resultsTable)
     }
 }
 
-static double
-intervalDuration(const RideFilePoint *start, const RideFilePoint *stop, const RideFile *ride)
-{
-    return stop->secs - start->secs + ride->recIntSecs();
-}
-
-static bool
-intervalsOverlap(const BestIntervalDialog::BestInterval &a,
-                 const BestIntervalDialog::BestInterval &b)
-{
-    if ((a.start <= b.start) && (a.stop > b.start))
-        return true;
-    if ((b.start <= a.start) && (b.stop > a.start))
-        return true;
-    return false;
-}
-
-struct CompareBests {
-    // Sort by decreasing power and increasing start time.
-    bool operator()(const BestIntervalDialog::BestInterval &a,
-                    const BestIntervalDialog::BestInterval &b) const {
-        if (a.avg > b.avg)
-            return true;
-        if (b.avg > a.avg)
-            return false;
-        return a.start < b.start;
-    }
-};
-
 void
 BestIntervalDialog::findClicked()
 {
@@ -256,49 +228,9 @@ void
 BestIntervalDialog::findBests(const RideFile *ride, double windowSizeSecs,
                               int maxIntervals, QList<BestInterval> &results)
 {
-    QList<BestInterval> bests;
-
-    double secsDelta = ride->recIntSecs();
-    double totalWatts = 0.0;
-    QList<const RideFilePoint*> window;
-
-    // ride is shorter than the window size!
-    if (windowSizeSecs > ride->dataPoints().last()->secs + secsDelta) return;
-
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    foreach (const RideFilePoint *point, ride->dataPoints()) {
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while (!window.empty() && (intervalDuration(window.first(), point, ride) >= windowSizeSecs + secsDelta)) {
-            totalWatts -= window.first()->watts;
-            window.takeFirst();
-        }
-        // Add points until interval duration is >= windowSizeSecs.
-        totalWatts += point->watts;
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        if (duration >= windowSizeSecs) {
-            double start = window.first()->secs;
-            double stop = start + duration;
-            double avg = totalWatts * secsDelta / duration;
-            bests.append(BestInterval(start, stop, avg));
-        }
-    }
-
-    std::sort(bests.begin(), bests.end(), CompareBests());
-
-    while (!bests.empty() && (results.size() < maxIntervals)) {
-        BestInterval candidate = bests.takeFirst();
-        bool overlaps = false;
-        foreach (const BestInterval &existing, results) {
-            if (intervalsOverlap(candidate, existing)) {
-                overlaps = true;
-                break;
-            }
-        }
-        if (!overlaps)
-            results.append(candidate);
-    }
-
+    IntervalSearch search(ride);
+    foreach(const IntervalSearch::Result &best, search.bests(windowSizeSecs, maxIntervals))
+        results.append(BestInterval(best.start, best.start + best.duration, best.avg));
 }
 
 void
@@ -23,6 +23,7 @@
 #include "Zones.h"
 #include "Colors.h"
 #include "CPPlot.h"
+#include "GcTrace.h"
 
 #include <unistd.h>
 #include <QDebug>
@@ -1356,6 +1357,8 @@ CPPlot::setRide(RideItem *rideItem)
     // null ride ?
     if (!rideItem) return;
 
+    GC_TRACE("CPPlot::setRide");
+
     // Season Compare Mode -- so nothing for us to do
     if (rangemode && context->isCompareDateRanges) return calculateForDateRanges(context->compareDateRanges);
 
@@ -1700,9 +1703,9 @@ CPPlot::setPlotType(int index)
 void
 CPPlot::plotCentile(RideItem *rideItem)
 {
+    GC_TRACE("CPPlot::plotCentile");
+
     qDebug() << "calculateCentile";
-    QTime elapsed;
-    elapsed.start();
 
     qDebug() << "prepare datas ";
     cpintdata data;
@@ -1750,7 +1753,6 @@ CPPlot::plotCentile(RideItem *rideItem)
         ride_centiles[i] = QVector <double>(total_secs);
     }
 
-    qDebug() << "end prepare datas " << elapsed.elapsed();
     qDebug() << "calcul for first 6min ";
 
     // loop through the decritized data from top
@@ -1808,7 +1810,6 @@ CPPlot::plotCentile(RideItem *rideItem)
         slice ++;
     }
 
-    qDebug() << "end calcul for first 6min " << elapsed.elapsed();
     qDebug() << "downsampling to 5s after 6min ";
 
     QVector<double> downsampled(0);
@@ -1841,7 +1842,6 @@ CPPlot::plotCentile(RideItem *rideItem)
         }
     }
 
-    qDebug() << "end downsampling to 5s after 6min " << elapsed.elapsed();
     qDebug() << "calcul for rest of ride ";
 
     for (int slice = 360; slice < ride_centiles[9].size();) {
@@ -1900,7 +1900,6 @@ CPPlot::plotCentile(RideItem *rideItem)
         else slice += 600; // 10mins after that
     }
 
-    qDebug() << "end calcul for rest of ride " << elapsed.elapsed();
     qDebug() << "fill gaps ";
 
     /*for (int i = 0; i<ride_centiles.size(); i++) {
@@ -1919,7 +1918,6 @@ CPPlot::plotCentile(RideItem *rideItem)
         }
     }
 
-    qDebug() << "end fill gaps " << elapsed.elapsed();
     qDebug() << "plotting ";
 
 
@@ -1952,7 +1950,6 @@ CPPlot::plotCentile(RideItem *rideItem)
     }
 
 
-    qDebug() << "end plotting " << elapsed.elapsed();
     zoomer->setZoomBase(false);
 }
 
@@ -23,6 +23,7 @@
 #include "RideMetadata.h"
 #include <QObject>
 #include <QByteArray>
+#include <QMutexLocker>
 #include <QDir>
 #include "Settings.h"
 
@@ -301,27 +302,33 @@ ColorEngine::ColorEngine(Context* context) : QObject(context), defaultColor(QCol
 
 void ColorEngine::configChanged(qint32)
 {
-    // clear existing
-    workoutCodes.clear();
+    // built aside, then swapped in for colorFor
+    QMap<QString, QColor> codes;
 
     // reverse
     reverseColor = GColor(CPLOTBACKGROUND);
 
     // setup the keyword/color combinations from config settings
-    foreach (KeywordDefinition keyword, context->athlete->rideMetadata()->getKeywords()) {
+    foreach (KeywordDefinition keyword, context->athlete->metadataKeywords()) {
         if (keyword.name == "Default")
             defaultColor = keyword.color; // we actually ignore this now
         else if (keyword.name == "Reverse")
             reverseColor = keyword.color;  // to set the foreground when use as background is set
         else {
-            workoutCodes[keyword.name] = keyword.color;
+            codes[keyword.name] = keyword.color;
 
             // alternative texts in notes
             foreach (QString token, keyword.tokens) {
-                workoutCodes[token] = keyword.color;
+                codes[token] = keyword.color;
             }
         }
     }
+
+    QString field = context->athlete->metadataColorField();
+
+    QMutexLocker locker(&lock);
+    workoutCodes = codes;
+    colorField = field;
 }
 
 QColor
@@ -329,14 +336,30 @@ ColorEngine::colorFor(QString text)
 {
     QColor color = QColor(1,1,1,1); // the default color has an alpha of 1, not possible otherwise
 
-    foreach(QString code, workoutCodes.keys()) {
-        if (text.contains(code, Qt::CaseInsensitive)) {
-           color = workoutCodes[code];
+    lock.lock();
+    QMap<QString, QColor> codes = workoutCodes;
+    lock.unlock();
+
+    QMapIterator<QString, QColor> i(codes);
+    while (i.hasNext()) {
+        i.next();
+        if (text.contains(i.key(), Qt::CaseInsensitive)) {
+           color = i.value();
         }
     }
     return color;
 }
 
+QColor
+ColorEngine::colorFor(const QMap<QString,QString> &metadata)
+{
+    lock.lock();
+    QString field = colorField;
+    lock.unlock();
+
+    return colorFor(metadata.value(field, ""));
+}
+
 QString
 GCColor::css(bool ridesummary)
 {
@@ -23,6 +23,7 @@
 #include <QString>
 #include <QObject>
 #include <QColor>
+#include <QMutex>
 #include <QLabel>
 
 class Context;
@@ -128,14 +129,19 @@ class ColorEngine : public QObject
     public:
         ColorEngine(Context *);
 
+        // safe to use from any thread, the codes are replaced
+        // as a whole when the config changes and copied to use
         QColor colorFor(QString);
+        QColor colorFor(const QMap<QString,QString> &metadata); // by the color field
         QColor defaultColor, reverseColor;
 
     public slots:
         void configChanged(qint32);
 
     private:
+        QMutex lock;
         QMap<QString, QColor> workoutCodes;
+        QString colorField;
         Context *context;
 };
 
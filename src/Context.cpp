@@ -18,6 +18,9 @@
 
 #include "Context.h"
 #include "Athlete.h"
+#include "RideItem.h"
+
+#include <QThread>
 
 Context::Context(MainWindow *mainWindow): mainWindow(mainWindow)
 {
@@ -25,6 +28,82 @@ Context::Context(MainWindow *mainWindow): mainWindow(mainWindow)
     workout = NULL;
     isfiltered = ishomefiltered = false;
     isCompareIntervals = isCompareDateRanges = false;
+
+    batchQueued = false;
+    batchTimer.setSingleShot(true);
+    batchTimer.setInterval(CONTEXT_BATCH_MS);
+    connect(&batchTimer, SIGNAL(timeout()), this, SLOT(flushChanges()));
+}
+
+void
+Context::notifyRideChanged(RideItem *x)
+{
+    // on the gui thread we tell them now
+    if (QThread::currentThread() == thread()) {
+        emit rideChanged(x);
+        return;
+    }
+
+    // refresh workers get batched, and only the selected ride
+    // is interesting to rideChanged() when it arrives
+    batch(x, x->dateTime.date());
+}
+
+void
+Context::notifyRefreshUpdate(QDate date)
+{
+    batch(NULL, date);
+}
+
+void
+Context::batch(RideItem *item, QDate date)
+{
+    QMutexLocker locker(&batchLock);
+
+    if (item) batchRides.insert(item);
+    if (date.isValid()) {
+        if (!batchFrom.isValid() || date < batchFrom) batchFrom = date;
+        if (!batchTo.isValid() || date > batchTo) batchTo = date;
+    }
+
+    // timers can only be started on the gui thread
+    if (!batchQueued) {
+        batchQueued = true;
+        QMetaObject::invokeMethod(this, "startBatch", Qt::QueuedConnection);
+    }
+}
+
+void
+Context::startBatch()
+{
+    if (!batchTimer.isActive()) batchTimer.start();
+}
+
+void
+Context::flushChanges()
+{
+    batchTimer.stop();
+
+    QMutexLocker locker(&batchLock);
+    QList<RideItem*> rides = batchRides.toList();
+    QDate from = batchFrom, to = batchTo;
+    batchRides.clear();
+    batchFrom = batchTo = QDate();
+    batchQueued = false;
+    locker.unlock();
+
+    if (rides.isEmpty() && !to.isValid()) return;
+
+    // the rides will have their own dates too
+    foreach(RideItem *item, rides) {
+        QDate date = item->dateTime.date();
+        if (!from.isValid() || date < from) from = date;
+        if (!to.isValid() || date > to) to = date;
+    }
+
+    emit ridesChanged(rides, from, to);
+    emit refreshUpdate(to);
+    if (ride && rides.contains(ride)) emit rideChanged(ride);
 }
 
 void 
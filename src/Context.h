@@ -26,6 +26,10 @@
 #include "CompareDateRange.h" // what intervals are being compared?
 #include "RideFile.h"
 
+#include <QMutex>
+#include <QTimer>
+#include <QSet>
+
 // when config changes we need to notify widgets what changed
 // but there is so much config these days we need to be a little
 // more specific, not too specific since we would have a million
@@ -52,6 +56,11 @@
 #define CONFIG_WBAL              0x2000     // which w'bal formula to use ?
 #define CONFIG_WORKOUTS          0x4000     // workout location / files
 
+// ride changes and refresh progress arriving within this many ms of
+// each other are sent on as one, so a background refresh doesn't
+// replot every chart for every ride it does
+#define CONTEXT_BATCH_MS 40
+
 class RideItem;
 class IntervalItem;
 class ErgFile;
@@ -145,7 +154,7 @@ class Context : public QObject
         void notifyRideSelected(RideItem*x) { ride=x; rideSelected(x); }
         void notifyRideAdded(RideItem *x) { ride=x; rideAdded(x); }
         void notifyRideDeleted(RideItem *x) { ride=x; rideDeleted(x); }
-        void notifyRideChanged(RideItem *x) { rideChanged(x); }
+        void notifyRideChanged(RideItem *x); // any thread, batched from workers
         void notifyRideSaved(RideItem *x) { rideSaved(x); }
 
         void notifyIntervalZoom(IntervalItem*x) { emit intervalZoom(x); }
@@ -158,8 +167,11 @@ class Context : public QObject
         void notifyMetadataFlush() { metadataFlush(); }
 
         void notifyRefreshStart() { emit refreshStart(); }
-        void notifyRefreshEnd() { emit refreshEnd(); }
-        void notifyRefreshUpdate(QDate date) { emit refreshUpdate(date); }
+        void notifyRefreshEnd() { flushChanges(); emit refreshEnd(); }
+        void notifyRefreshUpdate(QDate date); // batched
+
+        // send on whatever has been batched up
+        void flushChanges();
 
         void notifyCompareIntervals(bool state);
         void notifyCompareIntervalsChanged();
@@ -183,7 +195,11 @@ class Context : public QObject
         // refreshing stats
         void refreshStart();
         void refreshEnd();
-        void refreshUpdate(QDate);
+        void refreshUpdate(QDate); // latest date refreshed in the batch
+
+        // everything that changed in the batch, the dates are the earliest
+        // and latest rides in it, for those that only care about some dates
+        void ridesChanged(QList<RideItem*>, QDate from, QDate to);
 
         void rideSelected(RideItem*);
 
@@ -221,5 +237,18 @@ class Context : public QObject
         void compareIntervalsChanged();
         void compareDateRangesStateChanged(bool);
         void compareDateRangesChanged();
+
+    private slots:
+        void startBatch();
+
+    private:
+        // changes waiting to go, from any thread
+        QMutex batchLock;
+        QSet<RideItem*> batchRides;
+        QDate batchFrom, batchTo;
+        bool batchQueued;
+        QTimer batchTimer;
+
+        void batch(RideItem *item, QDate date);
 };
 #endif // _GC_Context_h
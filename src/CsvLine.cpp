@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "CsvLine.h"
+
+// powers of ten that are exact as a double
+static const double exactPowers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAXEXACTPOWER 22
+
+// largest integer a double holds exactly (2^53)
+#define MAXEXACTMANTISSA Q_UINT64_C(9007199254740992)
+
+CsvLine::CsvLine(QChar separator) : separator(separator), line(NULL)
+{
+}
+
+void
+CsvLine::parse(const QString &line)
+{
+    this->line = &line;
+    starts.resize(0);
+    lengths.resize(0);
+
+    // indexOf(QChar) is a vectorised scan in Qt5
+    int from = 0;
+    forever {
+        int to = line.indexOf(separator, from);
+        if (to == -1) to = line.length();
+
+        // drop surrounding blanks and quotes
+        int start = from, end = to;
+        while (start < end && (line.at(start).isSpace() || line.at(start) == '"')) start++;
+        while (end > start && (line.at(end-1).isSpace() || line.at(end-1) == '"')) end--;
+
+        starts << start;
+        lengths << (end - start);
+
+        if (to == line.length()) break;
+        from = to + 1;
+    }
+}
+
+QStringRef
+CsvLine::field(int i) const
+{
+    if (line == NULL || i < 0 || i >= starts.count()) return QStringRef();
+    return QStringRef(line, starts[i], lengths[i]);
+}
+
+double
+CsvLine::toDouble(const QStringRef &text, bool *ok)
+{
+    const QChar *p = text.unicode();
+    const QChar *end = p + text.length();
+
+    while (p < end && p->isSpace()) p++;
+    while (end > p && (end-1)->isSpace()) end--;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    // digits and fraction as one integer, with a power of ten to apply
+    quint64 mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool valid = false;
+
+    while (p < end && p->unicode() >= '0' && p->unicode() <= '9') {
+        if (mantissa || *p != '0') digits++;
+        mantissa = mantissa * 10 + (p->unicode() - '0');
+        valid = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && p->unicode() >= '0' && p->unicode() <= '9') {
+            if (mantissa || *p != '0') digits++;
+            mantissa = mantissa * 10 + (p->unicode() - '0');
+            exponent--;
+            valid = true;
+            p++;
+        }
+    }
+    if (valid && p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negexp = false;
+        if (p < end && (*p == '-' || *p == '+')) negexp = (*p++ == '-');
+        int e = 0;
+        valid = false;
+        while (p < end && p->unicode() >= '0' && p->unicode() <= '9') {
+            if (e < 10000) e = e * 10 + (p->unicode() - '0');
+            valid = true;
+            p++;
+        }
+        exponent += negexp ? -e : e;
+    }
+
+    // an exactly held mantissa scaled by an exact power of ten
+    // is correctly rounded, anything else is left to Qt
+    if (valid && p == end && digits <= 19 && mantissa <= MAXEXACTMANTISSA
+        && exponent >= -MAXEXACTPOWER && exponent <= MAXEXACTPOWER) {
+
+        double value = double(mantissa);
+        if (exponent < 0) value /= exactPowers[-exponent];
+        else value *= exactPowers[exponent];
+
+        if (ok) *ok = true;
+        return negative ? -value : value;
+    }
+    return text.toString().toDouble(ok);
+}
+
+int
+CsvLine::toInt(const QStringRef &text, bool *ok)
+{
+    const QChar *p = text.unicode();
+    const QChar *end = p + text.length();
+
+    while (p < end && p->isSpace()) p++;
+    while (end > p && (end-1)->isSpace()) end--;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    // anything longer than 9 digits might overflow, leave it to Qt
+    if (p < end && end - p <= 9) {
+        int value = 0;
+        while (p < end && p->unicode() >= '0' && p->unicode() <= '9')
+            value = value * 10 + (p++->unicode() - '0');
+
+        if (p == end) {
+            if (ok) *ok = true;
+            return negative ? -value : value;
+        }
+    }
+    return text.toString().toInt(ok);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_CsvLine_h
+#define _GC_CsvLine_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+
+//
+// Splits a line of comma separated values into fields once, without
+// copying them, and converts the fields to numbers without making a
+// QString for each one.
+//
+// Use one for every line of a file so the field offsets are only
+// allocated once, rather than calling QString::section for every
+// column, which rescans the line from the start each time.
+//
+class CsvLine
+{
+    public:
+        CsvLine(QChar separator = QChar(','));
+
+        // find the fields, the line must outlive any use of them
+        void parse(const QString &line);
+
+        int count() const { return starts.count(); }
+
+        // surrounding blanks and double quotes are dropped, a field
+        // past the end of the line is empty, just like QString::section
+        QStringRef field(int i) const;
+
+        // 0 when missing or not a number, just like QString::toDouble
+        double toDouble(int i) const { return toDouble(field(i)); }
+        int toInt(int i) const { return toInt(field(i)); }
+
+        static double toDouble(const QStringRef &text, bool *ok = NULL);
+        static int toInt(const QStringRef &text, bool *ok = NULL);
+
+    private:
+        QChar separator;
+        const QString *line;
+        QVector<int> starts, lengths;
+};
+
+#endif // _GC_CsvLine_h
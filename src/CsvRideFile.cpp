@@ -19,6 +19,7 @@
  */
 
 #include "CsvRideFile.h"
+#include "CsvLine.h"
 #include "Units.h"
 #include <QRegExp>
 #include <QTextStream>
@@ -159,6 +160,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
     }
     int lineno = 1;
     QTextStream is(&file);
+    CsvLine csv;
     RideFile *rideFile = new RideFile();
     int iBikeInterval = 0;
     bool dfpmExists   = false;
@@ -178,7 +180,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
         // then split and loop through each line
         // otherwise, there will be nothing to split and it will read each line as expected.
         QString linesIn = is.readLine();
-        QStringList lines = linesIn.split('\r');
+        QStringList lines = linesIn.contains('\r') ? linesIn.split('\r') : QStringList(linesIn);
         // workaround for empty lines
         if(lines.isEmpty()) {
             lineno++;
@@ -391,21 +393,23 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 
                 quint64 ms;
 
+                csv.parse(line);
+
                 if (csvType == powertap || csvType == joule) {
-                     minutes = line.section(',', 0, 0).toDouble();
-                     nm = line.section(',', 1, 1).toDouble();
-                     kph = line.section(',', 2, 2).toDouble();
-                     watts = line.section(',', 3, 3).toDouble();
-                     km = line.section(',', 4, 4).toDouble();
-                     cad = line.section(',', 5, 5).toDouble();
-                     hr = line.section(',', 6, 6).toDouble();
-                     interval = line.section(',', 7, 7).toInt();
-                     alt = line.section(',', 8, 8).toDouble();
+                     minutes = csv.toDouble(0);
+                     nm = csv.toDouble(1);
+                     kph = csv.toDouble(2);
+                     watts = csv.toDouble(3);
+                     km = csv.toDouble(4);
+                     cad = csv.toDouble(5);
+                     hr = csv.toDouble(6);
+                     interval = csv.toInt(7);
+                     alt = csv.toDouble(8);
                     if (csvType == joule && tempType != degNone) {
                         // is the position always the same?
                         // should we read the header and assign positions
                         // to each item instead?
-                        temp = line.section(',', 9, 9).toDouble();
+                        temp = csv.toDouble(9);
                         if (tempType == degF) {
                            // convert to deg C
                            temp *= FAHRENHEIT_PER_CENTIGRADE + FAHRENHEIT_ADD_CENTIGRADE;
@@ -420,57 +424,57 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                 } else if (csvType == gc) {
                     // GoldenCheetah CVS Format "secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, slope, temp, interval, lrbalance, lte, rte, lps, rps, smo2, thb, o2hb, hhb\n";
 
-                    seconds = line.section(',', 0, 0).toDouble();
+                    seconds = csv.toDouble(0);
                     minutes = seconds / 60.0f;
-                    cad = line.section(',', 1, 1).toDouble();
-                    hr = line.section(',', 2, 2).toDouble();
-                    km = line.section(',', 3, 3).toDouble();
-                    kph = line.section(',', 4, 4).toDouble();
-                    nm = line.section(',', 5, 5).toDouble();
-                    watts = line.section(',', 6, 6).toDouble();
-                    alt = line.section(',', 7, 7).toDouble();
-                    lon = line.section(',', 8, 8).toDouble();
-                    lat = line.section(',', 9, 9).toDouble();
-                    headwind = line.section(',', 10, 10).toDouble();
-                    slope = line.section(',', 11, 11).toDouble();
-                    temp = line.section(',', 12, 12).toDouble();
-                    interval = line.section(',', 13, 13).toInt();
-                    lrbalance = line.section(',', 14, 14).toInt();
-                    lte = line.section(',', 15, 15).toInt();
-                    rte = line.section(',', 16, 16).toInt();
-                    lps = line.section(',', 17, 17).toInt();
-                    rps = line.section(',', 18, 18).toInt();
-                    smo2 = line.section(',', 19, 19).toInt();
-                    thb = line.section(',', 20, 20).toInt();
-                    o2hb = line.section(',', 21, 21).toInt();
-                    hhb = line.section(',', 22, 22).toInt();
+                    cad = csv.toDouble(1);
+                    hr = csv.toDouble(2);
+                    km = csv.toDouble(3);
+                    kph = csv.toDouble(4);
+                    nm = csv.toDouble(5);
+                    watts = csv.toDouble(6);
+                    alt = csv.toDouble(7);
+                    lon = csv.toDouble(8);
+                    lat = csv.toDouble(9);
+                    headwind = csv.toDouble(10);
+                    slope = csv.toDouble(11);
+                    temp = csv.toDouble(12);
+                    interval = csv.toInt(13);
+                    lrbalance = csv.toInt(14);
+                    lte = csv.toInt(15);
+                    rte = csv.toInt(16);
+                    lps = csv.toInt(17);
+                    rps = csv.toInt(18);
+                    smo2 = csv.toInt(19);
+                    thb = csv.toInt(20);
+                    o2hb = csv.toInt(21);
+                    hhb = csv.toInt(22);
 
                 } else if (csvType == peripedal) {
 
                     //mm-dd,hh:mm:ss,SmO2 Live,SmO2 Averaged,THb,Target Power,Heart Rate,Speed,Power,Cadence
                     // ignore lines with wrong number of entries
-                    if (line.split(",").count() != 10) continue;
+                    if (csv.count() != 10) continue;
 
-                    seconds = moxySeconds(line.section(',',1,1));
+                    seconds = moxySeconds(csv.field(1).toString());
                     minutes = seconds / 60.0f;
 
                     if (startTime == QDateTime()) {
-                        QDate date = periDate(line.section(',',0,0));
+                        QDate date = periDate(csv.field(0).toString());
                         QTime time = QTime(0,0,0).addSecs(seconds);
                         startTime = QDateTime(date,time);
                     }
 
-                    double aSmo2 = line.section(',', 3, 3).toDouble();
-                    smo2 = line.section(',', 2, 2).toDouble();
+                    double aSmo2 = csv.toDouble(3);
+                    smo2 = csv.toDouble(2);
 
                     // use average if live not available
                     if (aSmo2 && !smo2) smo2 = aSmo2;
 
-                    thb = line.section(',', 4, 4).toDouble();
-                    hr = line.section(',', 6, 6).toDouble();
-                    kph = line.section(',', 7, 7).toDouble();
-                    watts = line.section(',', 8, 8).toDouble();
-                    cad = line.section(',', 10, 10).toDouble();
+                    thb = csv.toDouble(4);
+                    hr = csv.toDouble(6);
+                    kph = csv.toDouble(7);
+                    watts = csv.toDouble(8);
+                    cad = csv.toDouble(10);
 
                     // dervice distance from speed
                     km = lastKM + (kph/3600.0f);
@@ -499,13 +503,13 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                     }
                     // Time,Miles,MPH,Watts,HR,RPM
 
-                    seconds = QTime::fromString(line.section(',', 0, 0), "m:s").second();
-                    minutes = QTime::fromString(line.section(',', 0, 0), "m:s").minute() + seconds / 60.0f;
-                    cad = line.section(',', 5, 5).toDouble();
-                    hr = line.section(',', 4, 4).toDouble();
-                    km = line.section(',', 1, 1).toDouble();
-                    kph = line.section(',', 2, 2).toDouble();
-                    watts = line.section(',', 3, 3).toDouble();
+                    seconds = QTime::fromString(csv.field(0).toString(), "m:s").second();
+                    minutes = QTime::fromString(csv.field(0).toString(), "m:s").minute() + seconds / 60.0f;
+                    cad = csv.toDouble(5);
+                    hr = csv.toDouble(4);
+                    km = csv.toDouble(1);
+                    kph = csv.toDouble(2);
+                    watts = csv.toDouble(3);
 
                     if (!metric) {
                         km *= KM_PER_MILE;
@@ -522,27 +526,27 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                     // use "power" field until a the "dfpm" field becomes non-zero.
                      minutes = (recInterval * lineno - unitsHeader)/60.0;
                      nm = 0; //no torque
-                     kph = line.section(',', 0, 0).toDouble();
-                     dfpm = line.section( ',', 11, 11).toDouble();
-                     headwind = line.section(',', 1, 1).toDouble();
+                     kph = csv.toDouble(0);
+                     dfpm = csv.toDouble(11);
+                     headwind = csv.toDouble(1);
                      if( iBikeVersion >= 11 && ( dfpm > 0.0 || dfpmExists ) ) {
                          dfpmExists = true;
                          watts = dfpm;
                      }
                      else {
-                         watts = line.section(',', 2, 2).toDouble();
+                         watts = csv.toDouble(2);
                      }
-                     km = line.section(',', 3, 3).toDouble();
-                     cad = line.section(',', 4, 4).toDouble();
-                     hr = line.section(',', 5, 5).toDouble();
-                     alt = line.section(',', 6, 6).toDouble();
-                     slope = line.section(',', 7, 7).toDouble();
-                     temp = line.section(',', 8, 8).toDouble();
-                     lat = line.section(',', 12, 12).toDouble();
-                     lon = line.section(',', 13, 13).toDouble();
+                     km = csv.toDouble(3);
+                     cad = csv.toDouble(4);
+                     hr = csv.toDouble(5);
+                     alt = csv.toDouble(6);
+                     slope = csv.toDouble(7);
+                     temp = csv.toDouble(8);
+                     lat = csv.toDouble(12);
+                     lon = csv.toDouble(13);
 
 
-                     int lap = line.section(',', 9, 9).toInt();
+                     int lap = csv.toInt(9);
                      if (lap > 0) {
                          iBikeInterval += 1;
                          interval = iBikeInterval;
@@ -565,18 +569,18 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                     // need to get time from second column and note that
                     // there will be gaps when recording drops so shouldn't
                     // assume it is a continuous stream
-                    double seconds = moxySeconds(line.section(',',1,1));
+                    double seconds = moxySeconds(csv.field(1).toString());
 
                     if (startTime == QDateTime()) {
-                        QDate date = moxyDate(line.section(',',0,0));
+                        QDate date = moxyDate(csv.field(0).toString());
                         QTime time = QTime(0,0,0).addSecs(seconds);
                         startTime = QDateTime(date,time);
                     }
 
                     if (seconds >0) {
                         minutes = seconds / 60.0f;
-                        smo2 = line.section(',', 2, 2).remove("\"").toDouble();
-                        thb = line.section(',', 4, 4).remove("\"").toDouble();
+                        smo2 = csv.toDouble(2);
+                        thb = csv.toDouble(4);
                     }
                 }
                else if(csvType == motoactv) {
@@ -584,21 +588,21 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                      *  "double","double",.. so we need to filter out "
                      */
 
-                    km = line.section(',', 0,0).remove("\"").toDouble()/1000;
-                    hr = line.section(',', 2, 2).remove("\"").toDouble();
-                    kph = line.section(',', 3, 3).remove("\"").toDouble()*3.6;
+                    km = csv.toDouble(0)/1000;
+                    hr = csv.toDouble(2);
+                    kph = csv.toDouble(3)*3.6;
 
-                    lat = line.section(',', 5, 5).remove("\"").toDouble();
+                    lat = csv.toDouble(5);
                     /* Item 8 is crank torque, 13 is wheel torque */
-                    nm = line.section(',', 8, 8).remove("\"").toDouble();
+                    nm = csv.toDouble(8);
 
                     /* Ok there's no crank torque, try the wheel */
                     if(nm == 0.0) {
-                         nm = line.section(',', 13, 13).remove("\"").toDouble();
+                         nm = csv.toDouble(13);
                     }
                     if(epoch_set == false) {
                          epoch_set = true;
-                         epoch_offset = line.section(',', 9,9).remove("\"").toULongLong(&ok, 10);
+                         epoch_offset = csv.field(9).toString().toULongLong(&ok, 10);
 
                          /* We use this first value as the start time */
                          startTime = QDateTime();
@@ -606,14 +610,14 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                          rideFile->setStartTime(startTime);
                     }
 
-                    ms = line.section(',', 9,9).remove("\"").toULongLong(&ok, 10);
+                    ms = csv.field(9).toString().toULongLong(&ok, 10);
                     ms -= epoch_offset;
                     seconds = ms/1000;
 
-                    alt = line.section(',', 10, 10).remove("\"").toDouble();
-                    watts = line.section(',', 11, 11).remove("\"").toDouble();
-                    lon = line.section(',', 15, 15).remove("\"").toDouble();
-                    cad = line.section(',', 16, 16).remove("\"").toDouble();
+                    alt = csv.toDouble(10);
+                    watts = csv.toDouble(11);
+                    lon = csv.toDouble(15);
+                    cad = csv.toDouble(16);
                }
                 else if (csvType == ergomo) {
                      // for ergomo formatted CSV files
@@ -651,14 +655,14 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                      }
                 } else if (csvType == cpexport) {
                     // seconds, value, (model), date
-                    seconds = line.section(',',0,0).toDouble();
+                    seconds = csv.toDouble(0);
                     if (seconds == precSecs)
                         continue;
                     minutes = seconds / 60.0f;
 
 
                     //seconds = lineno -1 ;
-                    double avgWatts = line.section(',', 1, 1).toDouble();
+                    double avgWatts = csv.toDouble(1);
                     if ( avgWatts > maxWatts ) {
                         maxWatts = avgWatts;
                     }
@@ -688,7 +692,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 
                } else {
                     if (secsIndex > -1) {
-                        seconds = line.section(',', secsIndex, secsIndex).toDouble();
+                        seconds = csv.toDouble(secsIndex);
                         minutes = seconds / 60.0f;
                      }
                 }
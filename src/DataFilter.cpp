@@ -385,7 +385,7 @@ void DataFilter::configChanged(qint32)
     }
 
     // now add the ride metadata fields -- should be the same generally
-    foreach(FieldDefinition field, context->athlete->rideMetadata()->getFields()) {
+    foreach(FieldDefinition field, context->athlete->metadataFields()) {
             QString underscored = field.name;
             if (!context->specialFields.isMetric(underscored)) {
 
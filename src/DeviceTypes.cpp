@@ -67,6 +67,10 @@ DeviceTypes::DeviceTypes()
         tr("Testing device used for development only. If an ERG file is selected it will "
         "replay back, with a little randomness thrown in."),
         "" },
+      { DEV_REPLAY,   DEV_TCP,     (char *) "Replay", true,   false,
+        tr("Testing device used for development only. Replays an ANT+ capture (antlog.bin) "
+        "or a ride file through train mode, the device profile may set speed=, jitter= and dropout=."),
+        "" },
 #endif
       { 0, 0, NULL, 0, 0, "", "" }
     };
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "FileJournal.h"
+#include "RideFile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QMutexLocker>
+
+#ifndef Q_OS_WIN
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#define FILEJOURNAL_MAGIC 0x47434a4e // "GCJN"
+
+FileJournal::FileJournal(QString filename) : filename(filename), dirty(false)
+{
+    load();
+}
+
+FileJournal::~FileJournal()
+{
+    save();
+}
+
+void
+FileJournal::load()
+{
+    QMutexLocker locker(&lock);
+    entries.clear();
+    dirty = false;
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) return;
+
+    QDataStream in(&file);
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (magic != FILEJOURNAL_MAGIC || version != FILEJOURNAL_VERSION) return;
+
+    for (quint32 i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        QString path;
+        Entry add;
+        in >> path >> add.inode >> add.size >> add.modified >> add.hascrc >> add.crc >> add.header;
+        entries.insert(path, add);
+    }
+
+    // truncated, start again
+    if (in.status() != QDataStream::Ok) entries.clear();
+}
+
+void
+FileJournal::save()
+{
+    QMutexLocker locker(&lock);
+    if (!dirty) return;
+
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) return;
+
+    QDataStream out(&file);
+    out << quint32(FILEJOURNAL_MAGIC) << quint32(FILEJOURNAL_VERSION) << quint32(entries.count());
+
+    QHashIterator<QString, Entry> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        const Entry &e = i.value();
+        out << i.key() << e.inode << e.size << e.modified << e.hascrc << e.crc << e.header;
+    }
+    file.close();
+    dirty = false;
+}
+
+// the file as it is on disk now, size -1 if it isn't there
+static void
+fileStat(QString path, quint64 &inode, qint64 &size, qint64 &modified)
+{
+#ifdef Q_OS_WIN
+    QFileInfo info(path);
+    inode = 0;
+    size = info.exists() ? info.size() : -1;
+    modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+#else
+    struct stat buf;
+    if (::stat(QFile::encodeName(path).constData(), &buf) == 0) {
+        inode = buf.st_ino;
+        size = buf.st_size;
+#if defined(Q_OS_MAC)
+        modified = qint64(buf.st_mtimespec.tv_sec) * 1000000000 + buf.st_mtimespec.tv_nsec;
+#else
+        modified = qint64(buf.st_mtim.tv_sec) * 1000000000 + buf.st_mtim.tv_nsec;
+#endif
+    } else {
+        inode = 0;
+        size = -1;
+        modified = 0;
+    }
+#endif
+}
+
+FileJournal::Entry &
+FileJournal::current(QString path, quint64 inode, qint64 size, qint64 modified)
+{
+    // lock must be held
+    Entry &e = entries[path];
+    if (e.inode != inode || e.size != size || e.modified != modified) {
+        e = Entry();
+        e.inode = inode;
+        e.size = size;
+        e.modified = modified;
+        dirty = true;
+    }
+    return e;
+}
+
+unsigned long
+FileJournal::crc(QString path)
+{
+    quint64 inode;
+    qint64 size, modified;
+    fileStat(path, inode, size, modified);
+
+    QMutexLocker locker(&lock);
+    Entry &e = current(path, inode, size, modified);
+    if (e.hascrc) return e.crc;
+    locker.unlock();
+
+    // read it all, without holding everyone else up
+    unsigned long returning = RideFile::computeFileCRC(path);
+
+    locker.relock();
+    Entry &update = current(path, inode, size, modified);
+    if (update.size >= 0) {
+        update.hascrc = true;
+        update.crc = returning;
+        dirty = true;
+    }
+    return returning;
+}
+
+QByteArray
+FileJournal::header(QString path, int bytes)
+{
+    quint64 inode;
+    qint64 size, modified;
+    fileStat(path, inode, size, modified);
+
+    QMutexLocker locker(&lock);
+    Entry &e = current(path, inode, size, modified);
+    if (e.header.size() >= bytes) return e.header.left(bytes);
+    locker.unlock();
+
+    QByteArray returning;
+    QFile file(path);
+    if (file.open(QFile::ReadOnly)) {
+        returning = file.read(bytes);
+        file.close();
+    }
+
+    locker.relock();
+    Entry &update = current(path, inode, size, modified);
+    if (update.size >= 0 && returning.size() > update.header.size()) {
+        update.header = returning;
+        dirty = true;
+    }
+    return returning;
+}
+
+void
+FileJournal::remove(QString path)
+{
+    QMutexLocker locker(&lock);
+    if (entries.remove(path)) dirty = true;
+}
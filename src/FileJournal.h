@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_FileJournal_h
+#define _GC_FileJournal_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+// bump if the format changes, old journals are ignored
+#define FILEJOURNAL_VERSION 2
+
+//
+// Remembers what we worked out about the ride and .cpx files last time,
+// alongside the inode, size and modification time they had then. The
+// time is kept in nanoseconds where the platform has them, milliseconds
+// on Windows, since a rewrite within the second is easily missed.
+//
+// Checking for stale rides at startup needs the crc of any ride file
+// that was touched and the header of every .cpx file; if the file is
+// just as it was we can use what we found before instead of reading it.
+//
+// Kept in the athlete's cache folder and safe to use from any thread.
+//
+class FileJournal
+{
+    public:
+        FileJournal(QString filename);
+        ~FileJournal(); // saves
+
+        void load();
+        void save(); // only if anything changed
+
+        // RideFile::computeFileCRC, only worked out again if the file changed
+        unsigned long crc(QString path);
+
+        // the first bytes of the file, only read again if it changed
+        QByteArray header(QString path, int bytes);
+
+        // forget a file that has been deleted
+        void remove(QString path);
+
+    private:
+        struct Entry {
+            quint64 inode;
+            qint64 size;
+            qint64 modified;
+            bool hascrc;
+            quint32 crc;
+            QByteArray header;
+            Entry() : inode(0), size(-1), modified(0), hascrc(false), crc(0) {}
+        };
+
+        // the entry for the file as it is now, reset if it changed
+        Entry &current(QString path, quint64 inode, qint64 size, qint64 modified);
+
+        QString filename;
+        QMutex lock;
+        QHash<QString, Entry> entries;
+        bool dirty;
+};
+
+#endif // _GC_FileJournal_h
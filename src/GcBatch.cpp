@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "GcBatch.h"
+
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "RideFileCache.h"
+#include "JsonRideFile.h"
+#include "Settings.h"
+#include "GcUpgrade.h" // for VERSION_LATEST
+#include "GcBenchmark.h"
+#include "GcTrace.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QEventLoop>
+#include <QTimer>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <stdio.h>
+
+#if QT_VERSION > 0x050000
+# include <QtConcurrent>
+#else
+# include <QtConcurrentMap>
+#endif
+
+bool gcbatch = false;
+
+GcBatch::GcBatch(QDir home, QStringList options) :
+    home(home), threads(0), rebuild(false), cpx(false), rides(0), iterations(0), context(NULL)
+{
+    if (!parse(options)) {
+        athletes.clear();
+        benchmarkFile.clear();
+    }
+}
+
+void
+GcBatch::usage()
+{
+    fprintf(stderr, "usage: GoldenCheetah --batch [options] [directory] athlete [athlete ...]\n\n");
+    fprintf(stderr, "--threads=n         threads to use when refreshing metrics\n");
+    fprintf(stderr, "--import=dir        import the activity files in dir\n");
+    fprintf(stderr, "--rebuild           recompute the metrics for every activity\n");
+    fprintf(stderr, "--cpx               rebuild the mean max and distribution cache\n");
+    fprintf(stderr, "--metrics=file      export activity metrics as CSV\n");
+    fprintf(stderr, "--meanmax=file      export athlete bests as CSV, or JSON if file ends .json\n");
+    fprintf(stderr, "--trace=file        write a Chrome trace and a summary of the slowest operations\n\n");
+    fprintf(stderr, "--benchmark=file    run the benchmarks instead, results as JSON\n");
+    fprintf(stderr, "--corpus=dir        the test folder from the source, with rides and workouts\n");
+    fprintf(stderr, "--rides=n           rides in the synthetic athlete (%d)\n", GCBENCHMARK_RIDES);
+    fprintf(stderr, "--iterations=n      times to repeat each of the corpus benchmarks\n\n");
+    fprintf(stderr, "Use %%1 in file names for the athlete name when processing more than one.\n");
+}
+
+bool
+GcBatch::parse(QStringList options)
+{
+    foreach(QString option, options) {
+
+        QString value = option.section('=', 1);
+
+        if (option.startsWith("--threads=")) {
+            bool ok;
+            threads = value.toInt(&ok);
+            if (!ok || threads < 1) {
+                fprintf(stderr, "bad thread count: %s\n", value.toLocal8Bit().constData());
+                return false;
+            }
+        } else if (option == "--rebuild") {
+            rebuild = true;
+        } else if (option == "--cpx") {
+            cpx = true;
+        } else if (option.startsWith("--import=")) {
+            importDir = value;
+        } else if (option.startsWith("--trace=")) {
+            traceFile = value;
+        } else if (option.startsWith("--benchmark=")) {
+            benchmarkFile = value;
+        } else if (option.startsWith("--corpus=")) {
+            corpusDir = value;
+        } else if (option.startsWith("--rides=")) {
+            rides = value.toInt();
+        } else if (option.startsWith("--iterations=")) {
+            iterations = value.toInt();
+        } else if (option.startsWith("--metrics=")) {
+            metricsFile = value;
+        } else if (option.startsWith("--meanmax=")) {
+            meanmaxFile = value;
+        } else if (option.startsWith("--")) {
+            fprintf(stderr, "unknown option: %s\n", option.toLocal8Bit().constData());
+            return false;
+        } else {
+            athletes << option;
+        }
+    }
+
+    // first may be the directory the athletes are in
+    if (athletes.count() > 1 && QFileInfo(athletes.first()).isDir() && !home.exists(athletes.first())) {
+        home = QDir(athletes.takeFirst());
+    }
+    return true;
+}
+
+int
+GcBatch::exec()
+{
+    if (threads) QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    int returning = 0;
+    if (!benchmarkFile.isEmpty()) {
+        GcBenchmark benchmark(QDir(corpusDir.isEmpty() ? "test" : corpusDir), rides, iterations);
+        if (!benchmark.run(benchmarkFile)) returning = 2;
+
+    } else if (athletes.isEmpty()) {
+        usage();
+        return 1;
+    }
+
+    foreach(QString athlete, athletes) if (!process(athlete)) returning = 2;
+
+    if (!traceFile.isEmpty()) {
+        if (GcTrace::write(traceFile)) fprintf(stdout, "\n%s", GcTrace::summary().toLocal8Bit().constData());
+        else {
+            fprintf(stderr, "cannot write %s\n", traceFile.toLocal8Bit().constData());
+            returning = 2;
+        }
+    }
+    return returning;
+}
+
+void
+GcBatch::step(QString message)
+{
+    fprintf(stdout, "%8.3fs %s\n", timer.elapsed() / 1000.0, message.toLocal8Bit().constData());
+    fflush(stdout);
+}
+
+void
+GcBatch::progress()
+{
+    if (context && context->athlete->rideCache->isRunning())
+        step(QString("refreshing %1%").arg(context->athlete->rideCache->progress(), 0, 'f', 0));
+}
+
+QString
+GcBatch::outputFile(QString name, QString athlete)
+{
+    if (name.contains("%1")) return name.arg(athlete);
+    if (athletes.count() == 1) return name;
+
+    // one per athlete
+    QFileInfo info(name);
+    return info.dir().filePath(athlete + "_" + info.fileName());
+}
+
+bool
+GcBatch::process(QString athlete)
+{
+    timer.start();
+
+    QDir dir(home);
+    if (!dir.cd(athlete)) {
+        fprintf(stderr, "%s: no such athlete in %s\n", athlete.toLocal8Bit().constData(),
+                                                        home.canonicalPath().toLocal8Bit().constData());
+        return false;
+    }
+
+    // we can't ask the user anything, so the athlete must
+    // be upgraded already and have closed cleanly last time
+    if (appsettings->cvalue(athlete, GC_SAFEEXIT, true).toBool() == false ||
+        appsettings->cvalue(athlete, GC_UPGRADE_FOLDER_SUCCESS, false).toBool() == false ||
+        appsettings->cvalue(athlete, GC_VERSION_USED, 0).toInt() < VERSION_LATEST) {
+
+        fprintf(stderr, "%s: open the athlete in GoldenCheetah first, it needs upgrading or recovering\n",
+                        athlete.toLocal8Bit().constData());
+        return false;
+    }
+
+    // open just as the MainWindow does, the metrics
+    // for any new or changed activities are refreshed
+    context = new Context(NULL);
+    context->athlete = new Athlete(context, dir);
+    step(QString("%1 opened, %2 activities").arg(athlete).arg(context->athlete->rideCache->count()));
+
+    QTimer ticker;
+    connect(&ticker, SIGNAL(timeout()), this, SLOT(progress()));
+    ticker.start(1000);
+
+    waitForRefresh();
+    step("metrics up to date");
+
+    bool ok = true;
+
+    if (!importDir.isEmpty()) {
+        int imported = importFiles();
+        if (imported < 0) ok = false;
+        else step(QString("imported %1 activities").arg(imported));
+
+        // their metrics, all at once
+        context->athlete->rideCache->refresh();
+        waitForRefresh();
+    }
+
+    if (rebuild) {
+        rebuildMetrics();
+        step("metrics recomputed");
+    }
+
+    if (cpx) {
+        rebuildCPX();
+        step("cache rebuilt");
+    }
+
+    ticker.stop();
+
+    if (!metricsFile.isEmpty()) {
+        QString filename = outputFile(metricsFile, athlete);
+
+        // check first, the cache would tell the user
+        QFile check(filename);
+        if (check.open(QFile::WriteOnly)) {
+            check.close();
+            context->athlete->rideCache->writeAsCSV(filename);
+            step(QString("metrics written to %1").arg(filename));
+        } else {
+            fprintf(stderr, "cannot write %s\n", filename.toLocal8Bit().constData());
+            ok = false;
+        }
+    }
+
+    if (!meanmaxFile.isEmpty()) {
+        QString filename = outputFile(meanmaxFile, athlete);
+        if (writeMeanMax(filename)) step(QString("bests written to %1").arg(filename));
+        else ok = false;
+    }
+
+    // close as the MainWindow does
+    context->athlete->close();
+    delete context->athlete;
+    delete context;
+    context = NULL;
+
+    step(QString("%1 closed").arg(athlete));
+    return ok;
+}
+
+void
+GcBatch::waitForRefresh()
+{
+    // the cache refreshes in the background
+    // and saves when it has finished
+    QEventLoop loop;
+    connect(context, SIGNAL(refreshEnd()), &loop, SLOT(quit()));
+    connect(context->athlete->rideCache, SIGNAL(checked()), &loop, SLOT(quit()));
+    if (context->athlete->rideCache->isRunning()) loop.exec();
+
+    // let the cache save etc
+    QCoreApplication::processEvents();
+}
+
+void
+GcBatch::rebuildMetrics()
+{
+    RideCache *cache = context->athlete->rideCache;
+
+    cache->cancel();
+    foreach(RideItem *item, cache->rides()) item->isstale = true;
+    cache->refresh();
+
+    waitForRefresh();
+}
+
+static void
+cpxRefresh(RideItem *&item)
+{
+    // always recompute, the ride is read if we need it
+    QString path = item->context->athlete->home->activities().canonicalPath() + "/" + item->fileName;
+    QString cache = item->context->athlete->home->cache().canonicalPath() + "/" + QFileInfo(path).baseName() + ".cpx";
+    QFile::remove(cache);
+
+    RideFileCache updater(item->context, path, item->getWeight(), NULL, true);
+}
+
+void
+GcBatch::rebuildCPX()
+{
+    QVector<RideItem*> rides = context->athlete->rideCache->rides();
+    QtConcurrent::blockingMap(rides, cpxRefresh);
+}
+
+int
+GcBatch::importFiles()
+{
+    QDir source(importDir);
+    if (!source.exists()) {
+        fprintf(stderr, "%s: no such directory\n", importDir.toLocal8Bit().constData());
+        return -1;
+    }
+
+    QDir activities = context->athlete->home->activities();
+    QDir tmpActivities = context->athlete->home->tmpActivities();
+    QDir imports = context->athlete->home->imports();
+    QStringList suffixes = RideFileFactory::instance().suffixes();
+    QChar zero = QLatin1Char('0');
+
+    int imported = 0;
+    foreach(QFileInfo info, source.entryInfoList(QDir::Files, QDir::Name)) {
+
+        if (!suffixes.contains(info.suffix().toLower())) continue;
+
+        QStringList errors;
+        QFile thisfile(info.absoluteFilePath());
+        RideFile *ride = RideFileFactory::instance().openRideFile(context, thisfile, errors);
+
+        if (!ride) {
+            fprintf(stderr, "%s: %s\n", info.fileName().toLocal8Bit().constData(),
+                                        errors.join(", ").toLocal8Bit().constData());
+            continue;
+        }
+
+        // named as the import wizard does
+        QDateTime ridedatetime = ride->startTime();
+        QString targetnosuffix = QString ( "%1_%2_%3_%4_%5_%6" )
+                .arg ( ridedatetime.date().year(), 4, 10, zero )
+                .arg ( ridedatetime.date().month(), 2, 10, zero )
+                .arg ( ridedatetime.date().day(), 2, 10, zero )
+                .arg ( ridedatetime.time().hour(), 2, 10, zero )
+                .arg ( ridedatetime.time().minute(), 2, 10, zero )
+                .arg ( ridedatetime.time().second(), 2, 10, zero );
+        QString activitiesTarget = targetnosuffix + ".json";
+        QString tmpActivitiesFulltarget = tmpActivities.canonicalPath() + "/" + activitiesTarget;
+        QString finalActivitiesFulltarget = activities.canonicalPath() + "/" + activitiesTarget;
+
+        if (QFileInfo(finalActivitiesFulltarget).exists()) {
+            step(QString("%1 skipped, %2 exists").arg(info.fileName()).arg(activitiesTarget));
+            delete ride;
+            continue;
+        }
+
+        // keep the source in imports, unless that is where it came from,
+        // and don't import it if we can't since the tag would be wrong
+        QString importsTarget = info.fileName();
+        if (info.canonicalPath() != imports.canonicalPath()) {
+            importsTarget = info.baseName() + "_" + targetnosuffix + "." + info.suffix();
+            QString importsFulltarget = imports.canonicalPath() + "/" + importsTarget;
+            if (!QFileInfo(importsFulltarget).exists() && !QFile::copy(info.absoluteFilePath(), importsFulltarget)) {
+                fprintf(stderr, "%s: cannot copy to %s, skipped\n", info.fileName().toLocal8Bit().constData(),
+                                                                    importsFulltarget.toLocal8Bit().constData());
+                delete ride;
+                continue;
+            }
+        }
+
+        ride->setTag("Source Filename", importsTarget);
+        ride->setTag("Filename", activitiesTarget);
+
+        // via tmpActivities, just like the wizard
+        JsonFileReader reader;
+        QFile target(tmpActivitiesFulltarget);
+        if (reader.writeRideFile(context, ride, target)) {
+
+            context->athlete->addRide(activitiesTarget, false, true, true);
+
+            if (QFile::rename(tmpActivitiesFulltarget, finalActivitiesFulltarget)) {
+                context->ride->setFileName(activities.canonicalPath(), activitiesTarget);
+                imported++;
+            } else {
+                fprintf(stderr, "%s: cannot move to activities\n", activitiesTarget.toLocal8Bit().constData());
+            }
+        } else {
+            fprintf(stderr, "%s: cannot write %s\n", info.fileName().toLocal8Bit().constData(),
+                                                     activitiesTarget.toLocal8Bit().constData());
+        }
+        delete ride;
+    }
+    return imported;
+}
+
+bool
+GcBatch::writeMeanMax(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        fprintf(stderr, "cannot write %s\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    // bests for all time
+    RideFileCache bests(context, QDate(1900,1,1), QDate(3000,12,31));
+
+    QList<RideFile::SeriesType> series;
+    QStringList names;
+    series << RideFile::watts << RideFile::wattsKg << RideFile::hr << RideFile::cad << RideFile::nm << RideFile::kph;
+    names << "watts" << "wattsKg" << "hr" << "cad" << "nm" << "kph";
+
+    int secs = 0;
+    foreach(RideFile::SeriesType s, series)
+        if (bests.meanMaxArray(s).count() > secs) secs = bests.meanMaxArray(s).count();
+
+    QTextStream out(&file);
+    if (filename.endsWith(".json", Qt::CaseInsensitive)) {
+
+        out << "{\n    \"athlete\": \"" << context->athlete->cyclist << "\",\n    \"meanmax\": {\n";
+        for (int i=0; i<series.count(); i++) {
+            QVector<double> &values = bests.meanMaxArray(series[i]);
+            out << "        \"" << names[i] << "\": [";
+            for (int j=0; j<values.count(); j++) out << (j ? "," : "") << values[j];
+            out << "]" << (i < series.count()-1 ? "," : "") << "\n";
+        }
+        out << "    }\n}\n";
+
+    } else {
+
+        out << "secs," << names.join(",") << "\n";
+        for (int j=1; j<secs; j++) {
+            out << j;
+            foreach(RideFile::SeriesType s, series) {
+                QVector<double> &values = bests.meanMaxArray(s);
+                out << ",";
+                if (j < values.count()) out << values[j];
+            }
+            out << "\n";
+        }
+    }
+    file.close();
+    return true;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_GcBatch_h
+#define _GC_GcBatch_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QDir>
+#include <QTime>
+
+class Context;
+
+// set when running batch, so nothing waits for a user
+extern bool gcbatch;
+
+//
+// Batch processing of athletes from the command line with no window,
+// e.g. on a build server for a squad of athletes:
+//
+//   GoldenCheetah --batch [options] [directory] athlete [athlete ...]
+//
+//   --threads=n      threads to use when refreshing
+//   --import=dir     import the activity files in dir
+//   --rebuild        recompute the metrics for every ride
+//   --cpx            rebuild the mean max and distribution cache
+//   --metrics=file   export the ride metrics as CSV
+//   --meanmax=file   export the athlete bests as CSV or JSON (.json)
+//   --trace=file     write a Chrome trace when done (needs GC_WANT_TRACE)
+//
+// or to run the benchmarks, see GcBenchmark.h, with no athletes:
+//
+//   --benchmark=file --corpus=dir [--rides=n] [--iterations=n]
+//
+// There is no display, it runs in a QCoreApplication and the athlete is
+// opened without any of its widgets (the metadata form, interval tree
+// and calendars), the steps run in the order above and progress and
+// timings are written to stdout.
+// When processing more than one athlete use %1 in export file names
+// for the athlete name.
+//
+// Athletes that need upgrading or did not close cleanly are skipped,
+// they need to be opened in GoldenCheetah first.
+//
+class GcBatch : public QObject
+{
+    Q_OBJECT
+
+    public:
+        GcBatch(QDir home, QStringList options);
+
+        // returns the exit code for main
+        int exec();
+
+        // print usage to stderr
+        static void usage();
+
+    public slots:
+        void progress();
+
+    private:
+        QDir home;
+        QStringList athletes;
+
+        int threads;
+        bool rebuild, cpx;
+        QString importDir, metricsFile, meanmaxFile;
+        QString benchmarkFile, corpusDir, traceFile;
+        int rides, iterations;
+
+        Context *context;
+        QTime timer;
+
+        bool parse(QStringList options);
+        bool process(QString athlete);
+        QString outputFile(QString name, QString athlete);
+
+        void waitForRefresh();
+        void rebuildMetrics();
+        void rebuildCPX();
+        int importFiles();
+        bool writeMeanMax(QString filename);
+
+        void step(QString message); // print with elapsed time
+};
+
+#endif // _GC_GcBatch_h
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "GcBenchmark.h"
+
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "RideFileCache.h"
+#include "RideMetric.h"
+#include "MetricRollup.h"
+#include "JsonRideFile.h"
+#include "WPrime.h"
+#include "AddIntervalDialog.h" // interval finders
+#include "ErgFile.h"
+#include "Settings.h"
+#include "GcUpgrade.h" // for VERSION_LATEST
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTextStream>
+#include <QEventLoop>
+#include <QTime>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <stdio.h>
+#include <cmath>
+
+// the synthetic athlete lives in the temp folder
+static const QString benchmarkAthlete = "GcBenchmark";
+
+static void
+removeAll(QDir dir)
+{
+    foreach(QFileInfo info, dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden)) {
+        if (info.isDir()) removeAll(QDir(info.absoluteFilePath()));
+        else QFile::remove(info.absoluteFilePath());
+    }
+    dir.rmdir(dir.absolutePath());
+}
+
+GcBenchmark::GcBenchmark(QDir corpus, int rides, int iterations) :
+    corpus(corpus), rides(rides), iterations(iterations), context(NULL)
+{
+    if (this->rides < 1) this->rides = GCBENCHMARK_RIDES;
+    if (this->iterations < 1) this->iterations = 1;
+}
+
+void
+GcBenchmark::add(QString name, int count, int ms, qint64 bytes, QString detail)
+{
+    Result add;
+    add.name = name;
+    add.count = count;
+    add.ms = ms;
+    add.bytes = bytes;
+    add.detail = detail;
+    results << add;
+
+    fprintf(stdout, "%-28s %8d in %8dms %10.1f/s %s\n", name.toLocal8Bit().constData(), count, ms,
+                    ms ? count * 1000.0 / ms : 0.0, detail.toLocal8Bit().constData());
+    fflush(stdout);
+}
+
+bool
+GcBenchmark::run(QString filename)
+{
+    // check we can write results before spending minutes on them
+    QFile check(filename);
+    if (!check.open(QFile::WriteOnly)) {
+        fprintf(stderr, "cannot write %s\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+    check.close();
+
+    // start from nothing every time
+    QDir temp = QDir::temp();
+    if (temp.exists(benchmarkAthlete)) removeAll(QDir(temp.absoluteFilePath(benchmarkAthlete)));
+    if (!temp.mkdir(benchmarkAthlete) || !synthesise(QDir(temp.absoluteFilePath(benchmarkAthlete)))) {
+        fprintf(stderr, "cannot create %s in %s\n", benchmarkAthlete.toLocal8Bit().constData(),
+                                                     temp.absolutePath().toLocal8Bit().constData());
+        return false;
+    }
+
+    // macro benchmarks open the athlete, the micro
+    // benchmarks need it for zones and the like
+    athlete(QDir(temp.absoluteFilePath(benchmarkAthlete)));
+
+    QList<RideFile*> parsed = parse();
+    perRide(parsed);
+    foreach(RideFile *ride, parsed) delete ride;
+    workouts();
+
+    context->athlete->close();
+    delete context->athlete;
+    delete context;
+    context = NULL;
+
+    // leave nothing behind
+    removeAll(QDir(temp.absoluteFilePath(benchmarkAthlete)));
+    appsettings->remove(benchmarkAthlete);
+
+    return write(filename);
+}
+
+bool
+GcBenchmark::synthesise(QDir athlete)
+{
+    if (!athlete.mkdir("activities")) return false;
+    QDir activities(athlete.absoluteFilePath("activities"));
+
+    // an hour of steady riding with a hard minute every ten
+    RideFile *ride = new RideFile(QDateTime(QDate(2015,1,1), QTime(7,0,0)), 1.0);
+    ride->setDeviceType("Synthetic");
+    double km = 0;
+    for (int i=0; i<GCBENCHMARK_SECS; i++) {
+        RideFilePoint p;
+        p.secs = i;
+        p.watts = 200 + 40 * sin(i / 60.0) + ((i % 600) < 60 ? 200 : 0);
+        p.hr = 120 + p.watts / 10;
+        p.cad = 85 + 5 * sin(i / 30.0);
+        p.kph = 25 + p.watts / 40;
+        p.alt = 100 + 50 * sin(i / 900.0);
+        km += p.kph / 3600.0;
+        p.km = km;
+        ride->appendPoint(p);
+    }
+
+    // the rest are copies, two a day going backwards
+    QTime timer;
+    timer.start();
+    QString first;
+    JsonFileReader writer;
+    for (int i=0; i<rides; i++) {
+
+        QDateTime when(QDate(2015,6,30).addDays(-(i/2)), QTime(i%2 ? 18 : 7, 0, 0));
+        QString name = when.toString("yyyy_MM_dd_hh_mm_ss") + ".json";
+
+        if (first.isEmpty()) {
+            ride->setStartTime(when);
+            QFile file(activities.absoluteFilePath(name));
+            if (!writer.writeRideFile(NULL, ride, file)) break;
+            first = name;
+        } else if (!QFile::copy(activities.absoluteFilePath(first), activities.absoluteFilePath(name))) {
+            break;
+        }
+    }
+    delete ride;
+    if (first.isEmpty()) return false;
+
+    add("synthesise", rides, timer.elapsed());
+
+    // it's new, so nothing to upgrade and nothing to recover
+    appsettings->setCValue(benchmarkAthlete, GC_UPGRADE_FOLDER_SUCCESS, true);
+    appsettings->setCValue(benchmarkAthlete, GC_VERSION_USED, VERSION_LATEST);
+    appsettings->setCValue(benchmarkAthlete, GC_SAFEEXIT, true);
+    return true;
+}
+
+void
+GcBenchmark::athlete(QDir athlete)
+{
+    QTime timer;
+    timer.start();
+
+    // opening starts the refresh of every ride
+    context = new Context(NULL);
+    context->athlete = new Athlete(context, athlete);
+    RideCache *cache = context->athlete->rideCache;
+    add("athlete.open", cache->count(), timer.elapsed());
+
+    // what is left of the refresh once open has returned
+    timer.restart();
+    QEventLoop loop;
+    QObject::connect(context, SIGNAL(refreshEnd()), &loop, SLOT(quit()));
+    QObject::connect(cache, SIGNAL(checked()), &loop, SLOT(quit()));
+    if (cache->isRunning()) loop.exec();
+    QCoreApplication::processEvents();
+    add("ridecache.refresh", cache->count(), timer.elapsed(),
+        0, QString("%1 threads").arg(QThreadPool::globalInstance()->maxThreadCount()));
+
+    // the trend charts, first time and then cached
+    QStringList symbols;
+    symbols << "total_distance" << "workout_time" << "coggan_tss" << "average_power" << "average_hr";
+
+    for (int pass=0; pass<2; pass++) {
+        timer.start();
+        foreach(QString symbol, symbols)
+            cache->rollup()->months(symbol, false, FilterSet(), QDate(), QDate());
+        add(pass ? "ltm.rollup.cached" : "ltm.rollup", symbols.count(), timer.elapsed());
+    }
+
+    timer.start();
+    RideFileCache bests(context, QDate(1900,1,1), QDate(3000,12,31));
+    add("ltm.bests", cache->count(), timer.elapsed());
+
+    timer.start();
+    QString detail = cache->benchmarkCPModels();
+    add("cpmodels", cache->count(), timer.elapsed(), 0, detail);
+}
+
+QList<RideFile*>
+GcBenchmark::parse()
+{
+    QList<RideFile*> returning;
+
+    QDir dir(corpus.absoluteFilePath("rides"));
+    QStringList suffixes = RideFileFactory::instance().suffixes();
+
+    // by reader, which is by suffix
+    QMap<QString, QList<QFileInfo> > readers;
+    foreach(QFileInfo info, dir.entryInfoList(QDir::Files, QDir::Name)) {
+        QString suffix = info.suffix().toLower();
+        if (suffixes.contains(suffix)) readers[suffix] << info;
+    }
+
+    QMapIterator<QString, QList<QFileInfo> > it(readers);
+    while (it.hasNext()) {
+        it.next();
+
+        int count = 0, failed = 0;
+        qint64 bytes = 0;
+        QTime timer;
+        timer.start();
+
+        for (int i=0; i<iterations; i++) {
+            foreach(QFileInfo info, it.value()) {
+
+                QStringList errors;
+                QFile file(info.absoluteFilePath());
+                RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+                count++;
+                bytes += info.size();
+
+                if (!ride) failed++;
+                else if (i == iterations-1) returning << ride; // keep for the next ones
+                else delete ride;
+            }
+        }
+        add("parse." + it.key(), count, timer.elapsed(), bytes,
+            failed ? QString("%1 failed").arg(failed) : QString());
+    }
+    return returning;
+}
+
+void
+GcBenchmark::perRide(QList<RideFile*> rides)
+{
+    QTime timer;
+    int samples = 0;
+    foreach(RideFile *ride, rides) samples += ride->dataPoints().count();
+    QString detail = QString("%1 samples").arg(samples);
+
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    timer.start();
+    for (int i=0; i<iterations; i++) {
+        foreach(RideFile *ride, rides)
+            RideMetric::computeMetrics(context, ride, context->athlete->zones(), context->athlete->hrZones(),
+                                       factory.allMetrics());
+    }
+    add("metrics", rides.count() * iterations, timer.elapsed(), 0, detail);
+
+    timer.start();
+    for (int i=0; i<iterations; i++) {
+        foreach(RideFile *ride, rides) {
+            RideFileCache cache(ride);
+        }
+    }
+    add("ridefilecache.compute", rides.count() * iterations, timer.elapsed(), 0, detail);
+
+    timer.start();
+    for (int i=0; i<iterations; i++) {
+        foreach(RideFile *ride, rides) {
+            WPrime wprime;
+            wprime.setRide(ride);
+        }
+    }
+    add("wprime.setride", rides.count() * iterations, timer.elapsed(), 0, detail);
+
+    timer.start();
+    for (int i=0; i<iterations; i++) {
+        foreach(RideFile *ride, rides) {
+            QList<AddIntervalDialog::AddedInterval> found;
+            AddIntervalDialog::findPeakPowerStandard(ride, found);
+            AddIntervalDialog::findBests(true, ride, 1200, 3, found, "");
+            AddIntervalDialog::findFirsts(true, ride, 1200, 3, found);
+        }
+    }
+    add("intervals.find", rides.count() * iterations, timer.elapsed(), 0, detail);
+}
+
+void
+GcBenchmark::workouts()
+{
+    QDir dir(corpus.absoluteFilePath("workouts"));
+    QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Name);
+
+    int count = 0, failed = 0;
+    qint64 bytes = 0;
+    QTime timer;
+    timer.start();
+    for (int i=0; i<iterations; i++) {
+        foreach(QFileInfo info, files) {
+            int mode = 0;
+            ErgFile *workout = new ErgFile(info.absoluteFilePath(), mode, context);
+            if (!workout->isValid()) failed++;
+            delete workout;
+            count++;
+            bytes += info.size();
+        }
+    }
+    add("parse.workouts", count, timer.elapsed(), bytes, failed ? QString("%1 failed").arg(failed) : QString());
+}
+
+bool
+GcBenchmark::write(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        fprintf(stderr, "cannot write %s\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\n";
+    out << "    \"version\": \"" << VERSION_STRING << "\",\n";
+    out << "    \"build\": " << VERSION_LATEST << ",\n";
+    out << "    \"date\": \"" << QDateTime::currentDateTime().toString(Qt::ISODate) << "\",\n";
+    out << "    \"threads\": " << QThreadPool::globalInstance()->maxThreadCount() << ",\n";
+    out << "    \"iterations\": " << iterations << ",\n";
+    out << "    \"results\": [\n";
+    for (int i=0; i<results.count(); i++) {
+        const Result &r = results[i];
+        out << "        { \"name\": \"" << r.name << "\""
+            << ", \"count\": " << r.count
+            << ", \"ms\": " << r.ms
+            << ", \"perSecond\": " << (r.ms ? r.count * 1000.0 / r.ms : 0.0);
+        if (r.bytes) out << ", \"bytes\": " << r.bytes;
+        if (!r.detail.isEmpty()) out << ", \"detail\": \"" << r.detail << "\"";
+        out << " }" << (i < results.count()-1 ? "," : "") << "\n";
+    }
+    out << "    ]\n}\n";
+    file.close();
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_GcBenchmark_h
+#define _GC_GcBenchmark_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDir>
+
+class Context;
+class RideFile;
+
+// rides in the synthetic athlete, and how long each one is
+#define GCBENCHMARK_RIDES 5000
+#define GCBENCHMARK_SECS 3600
+
+//
+// Benchmarks run from batch mode, or with "make benchmarks":
+//
+//   GoldenCheetah --batch --benchmark=results.json --corpus=test [--rides=n]
+//
+// A synthetic athlete with GCBENCHMARK_RIDES rides is created in the temp
+// folder to time opening, refreshing the ride cache, the trend aggregates
+// and the CP model fits. Then the sample rides and workouts in the corpus
+// (test/rides and test/workouts in the source tree) are used to time each
+// of the file readers, computing metrics, the mean max cache, W' and the
+// interval finders.
+//
+// Results are written as JSON so they can be compared between builds,
+// each with the number of items, the elapsed time and items per second.
+//
+class GcBenchmark
+{
+    public:
+        GcBenchmark(QDir corpus, int rides, int iterations);
+
+        // returns false if nothing could be run
+        bool run(QString filename);
+
+    private:
+        struct Result {
+            QString name, detail;
+            int count, ms;
+            qint64 bytes;
+        };
+        QList<Result> results;
+
+        QDir corpus;
+        int rides, iterations;
+        Context *context;
+
+        void add(QString name, int count, int ms, qint64 bytes = 0, QString detail = "");
+        bool write(QString filename);
+
+        // macro, whole athlete
+        bool synthesise(QDir athlete);
+        void athlete(QDir athlete);
+
+        // micro, one ride at a time
+        QList<RideFile*> parse();
+        void perRide(QList<RideFile*> rides);
+        void workouts();
+};
+
+#endif // _GC_GcBenchmark_h
@@ -17,6 +17,7 @@
  */
 
 #include "GcRideFile.h"
+#include "RideXmlReader.h"
 #include <algorithm> // for std::sort
 #include <QDomDocument>
 #include <QVector>
@@ -32,132 +33,134 @@ static int gcFileReaderRegistered =
 RideFile *
 GcFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    QDomDocument doc("GoldenCheetah");
     if (!file.open(QIODevice::ReadOnly)) {
         errors << "Could not open file.";
         return NULL;
     }
 
-    bool parsed = doc.setContent(&file);
-    file.close();
-    if (!parsed) {
-        errors << "Could not parse file.";
-        return NULL;
-    }
-
     RideFile *rideFile = new RideFile();
-    QDomElement root = doc.documentElement();
-    QDomNode attributes = root.firstChildElement("attributes");
-
-    for (QDomElement attr = attributes.firstChildElement("attribute");
-         !attr.isNull(); attr = attr.nextSiblingElement("attribute")) {
-        QString key = attr.attribute("key");
-        QString value = attr.attribute("value");
-        if (key == "Device type")
-            rideFile->setDeviceType(value);
-        else if (key == "File Format")
-            rideFile->setFileFormat(value);
-        if (key == "Start time") {
-            // by default QDateTime is localtime - the source however is UTC
-            QDateTime aslocal = QDateTime::fromString(value, DATETIME_FORMAT);
-            // construct in UTC so we can honour the conversion to localtime
-            QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
-            // now set in localtime
-            rideFile->setStartTime(asUTC.toLocalTime());
-        }
-        if (key == "Identifier") {
-            rideFile->setId(value);
+    QVector<double> intervalStops; // used to set the interval number for each point
+    bool hasSamples = false;       // manual file will have no samples
+    bool recIntSet = false;
+    bool parsed;
+
+    // stream it, a sample at a time
+    {
+        RideXmlReader xml(file);
+        while (!xml.atEnd()) {
+
+            if (xml.readNext() != QXmlStreamReader::StartElement) continue;
+
+            QStringRef name = xml.name();
+            QXmlStreamAttributes attrs = xml.attributes();
+
+            if (name == QLatin1String("sample")) {
+
+                double secs, cad, hr, km, kph, nm, watts, alt, lon, lat;
+                double headwind = 0.0;
+                secs = xml.number(attrs, "secs");
+                cad = xml.number(attrs, "cad");
+                hr = xml.number(attrs, "hr");
+                km = xml.number(attrs, "km");
+                kph = xml.number(attrs, "kph");
+                nm = xml.number(attrs, "nm");
+                watts = xml.number(attrs, "watts");
+                alt = xml.number(attrs, "alt");
+                lon = xml.number(attrs, "lon");
+                lat = xml.number(attrs, "lat");
+                rideFile->appendPoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, 0.0, RideFile::NoTemp, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0);
+                if (!recIntSet) {
+                    rideFile->setRecIntSecs(xml.number(attrs, "len"));
+                    recIntSet = true;
+                }
+
+            } else if (name == QLatin1String("samples")) {
+
+                hasSamples = true;
+
+            } else if (name == QLatin1String("attribute")) {
+
+                QString key = attrs.value(QLatin1String("key")).toString();
+                QString value = attrs.value(QLatin1String("value")).toString();
+                if (key == "Device type")
+                    rideFile->setDeviceType(value);
+                else if (key == "File Format")
+                    rideFile->setFileFormat(value);
+                if (key == "Start time") {
+                    // by default QDateTime is localtime - the source however is UTC
+                    QDateTime aslocal = QDateTime::fromString(value, DATETIME_FORMAT);
+                    // construct in UTC so we can honour the conversion to localtime
+                    QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
+                    // now set in localtime
+                    rideFile->setStartTime(asUTC.toLocalTime());
+                }
+                if (key == "Identifier") {
+                    rideFile->setId(value);
+                }
+
+            } else if (name == QLatin1String("metric")) {
+
+                // read in metric overrides:
+                //  <override>
+                //    <metric name="skiba_bike_score" value="100"/>
+                //    <metric name="average_speed" secs="3600" km="30"/>
+                //  </override>
+
+                // setup the metric overrides QMap
+                QMap<QString, QString> bsm;
+
+                // for now only value is known to be maintained
+                bsm.insert("value", attrs.value(QLatin1String("value")).toString());
+
+                // insert into the rideFile overrides
+                rideFile->metricOverrides.insert(attrs.value(QLatin1String("name")).toString(), bsm);
+
+            } else if (name == QLatin1String("tag")) {
+
+                // the name/value metadata pairs
+                rideFile->setTag(attrs.value(QLatin1String("name")).toString(),
+                                 attrs.value(QLatin1String("value")).toString());
+
+            } else if (name == QLatin1String("interval")) {
+
+                // record the stops for old-style datapoint interval numbering
+                double stop = xml.number(attrs, "stop");
+                intervalStops.append(stop);
+
+                // add a new interval to the new-style interval ranges
+                rideFile->addInterval(xml.number(attrs, "start"), stop, attrs.value(QLatin1String("name")).toString());
+            }
         }
+        parsed = !xml.hasError();
     }
+    file.close();
 
-    // read in metric overrides:
-    //  <override>
-    //    <metric name="skiba_bike_score" value="100"/>
-    //    <metric name="average_speed" secs="3600" km="30"/>
-    //  </override>
-
-    QDomNode overrides = root.firstChildElement("override");
-    if (!overrides.isNull()) {
-
-        for (QDomElement override = overrides.firstChildElement("metric");
-            !override.isNull();
-            override = override.nextSiblingElement("metric")) {
-
-            // setup the metric overrides QMap
-            QMap<QString, QString> bsm;
-
-            // for now only value is known to be maintained
-            bsm.insert("value", override.attribute("value"));
-
-            // insert into the rideFile overrides
-            rideFile->metricOverrides.insert(override.attribute("name"), bsm);
-        }
+    if (!parsed) {
+        errors << "Could not parse file.";
+        delete rideFile;
+        return NULL;
     }
 
-    // read in the name/value metadata pairs
-    QDomNode tags = root.firstChildElement("tags");
-    if (!tags.isNull()) {
-
-        for (QDomElement tag = tags.firstChildElement("tag");
-             !tag.isNull();
-             tag = tag.nextSiblingElement("tag")) {
+    if (!hasSamples) return rideFile; // manual file will have no samples
 
-            rideFile->setTag(tag.attribute("name"), tag.attribute("value"));
-        }
+    if (!recIntSet) {
+        errors << "no samples in ride file";
+        delete rideFile;
+        return NULL;
     }
 
-    QVector<double> intervalStops; // used to set the interval number for each point
-    RideFileInterval add;          // used to add each named interval to RideFile
-    QDomNode intervals = root.firstChildElement("intervals");
-    if (!intervals.isNull()) {
-        for (QDomElement interval = intervals.firstChildElement("interval");
-             !interval.isNull(); interval = interval.nextSiblingElement("interval")) {
-
-            // record the stops for old-style datapoint interval numbering
-            double stop = interval.attribute("stop").toDouble();
-            intervalStops.append(stop);
-
-            // add a new interval to the new-style interval ranges
-            add.stop = stop;
-            add.start = interval.attribute("start").toDouble();
-            add.name = interval.attribute("name");
-            rideFile->addInterval(add.start, add.stop, add.name);
-        }
-    }
+    // old-style datapoint interval numbering, the intervals
+    // may come before or after the samples so do it last
     std::sort(intervalStops.begin(), intervalStops.end()); // just in case
     int interval = 0;
-
-    QDomElement samples = root.firstChildElement("samples");
-    if (samples.isNull()) return rideFile; // manual file will have no samples
-
-    bool recIntSet = false;
-    for (QDomElement sample = samples.firstChildElement("sample");
-         !sample.isNull(); sample = sample.nextSiblingElement("sample")) {
-        double secs, cad, hr, km, kph, nm, watts, alt, lon, lat;
-        double headwind = 0.0;
-        secs = sample.attribute("secs", "0.0").toDouble();
-        cad = sample.attribute("cad", "0.0").toDouble();
-        hr = sample.attribute("hr", "0.0").toDouble();
-        km = sample.attribute("km", "0.0").toDouble();
-        kph = sample.attribute("kph", "0.0").toDouble();
-        nm = sample.attribute("nm", "0.0").toDouble();
-        watts = sample.attribute("watts", "0.0").toDouble();
-        alt = sample.attribute("alt", "0.0").toDouble();
-        lon = sample.attribute("lon", "0.0").toDouble();
-        lat = sample.attribute("lat", "0.0").toDouble();
-        while ((interval < intervalStops.size()) && (secs >= intervalStops[interval]))
+    foreach(RideFilePoint *point, rideFile->dataPoints()) {
+        while ((interval < intervalStops.size()) && (point->secs >= intervalStops[interval]))
             ++interval;
-        rideFile->appendPoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, 0.0, RideFile::NoTemp, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, interval);
-        if (!recIntSet) {
-            rideFile->setRecIntSecs(sample.attribute("len").toDouble());
-            recIntSet = true;
-        }
+        point->interval = interval;
     }
 
-    if (!recIntSet) {
-        errors << "no samples in ride file";
-        return NULL;
-    }
+    // appendPoint only saw interval 0, so tell it what we found
+    if (interval) rideFile->setDataPresent(RideFile::interval, true);
 
     return rideFile;
 }
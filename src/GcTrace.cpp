@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "GcTrace.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadStorage>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+
+#ifdef GC_WANT_TRACE
+volatile bool GcTrace::enabled_ = true;
+#else
+volatile bool GcTrace::enabled_ = false;
+#endif
+
+// one clock for every thread, started before main
+static QElapsedTimer traceClock;
+static struct TraceClockStart { TraceClockStart() { traceClock.start(); } } traceClockStart;
+
+struct TraceEvent {
+    const char *name;
+    qint64 start, duration;
+    int thread;
+};
+
+// a buffer per thread, handed on to a new thread when its
+// thread finishes so there are only as many as run at once
+struct TraceBuffer {
+    QMutex lock; // only ever contended when writing out
+    QVector<TraceEvent> events;
+    int next; // oldest once full
+    int thread; // current owner
+    TraceBuffer() : next(0), thread(0) {}
+};
+
+static QMutex registryLock;
+static QList<TraceBuffer*> buffers, spare;
+static QStringList threadNames;
+
+struct TraceHolder {
+    TraceBuffer *buffer;
+    ~TraceHolder() {
+        QMutexLocker locker(&registryLock);
+        spare << buffer;
+    }
+};
+static QThreadStorage<TraceHolder*> local;
+
+static TraceBuffer *
+threadBuffer()
+{
+    if (local.hasLocalData()) return local.localData()->buffer;
+
+    QMutexLocker locker(&registryLock);
+
+    TraceHolder *holder = new TraceHolder;
+    if (spare.count()) holder->buffer = spare.takeFirst();
+    else {
+        holder->buffer = new TraceBuffer;
+        buffers << holder->buffer;
+    }
+
+    // name it for the trace
+    QThread *thread = QThread::currentThread();
+    QString name = thread->objectName();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) name = "main";
+    else if (name.isEmpty()) name = QString("thread %1").arg(threadNames.count());
+
+    QMutexLocker bufferLocker(&holder->buffer->lock);
+    holder->buffer->thread = threadNames.count();
+    threadNames << name;
+
+    local.setLocalData(holder);
+    return holder->buffer;
+}
+
+qint64
+GcTrace::now()
+{
+    return traceClock.nsecsElapsed();
+}
+
+void
+GcTrace::record(const char *name, qint64 start, qint64 duration)
+{
+    TraceBuffer *buffer = threadBuffer();
+
+    TraceEvent add;
+    add.name = name;
+    add.start = start;
+    add.duration = duration;
+    add.thread = buffer->thread;
+
+    QMutexLocker locker(&buffer->lock);
+    if (buffer->events.count() < GCTRACE_EVENTS) buffer->events << add;
+    else {
+        buffer->events[buffer->next] = add;
+        buffer->next = (buffer->next + 1) % GCTRACE_EVENTS;
+    }
+}
+
+void
+GcTrace::clear()
+{
+    QMutexLocker locker(&registryLock);
+    foreach(TraceBuffer *buffer, buffers) {
+        QMutexLocker bufferLocker(&buffer->lock);
+        buffer->events.clear();
+        buffer->next = 0;
+    }
+}
+
+// a copy of everything, so nothing waits while we work on it
+static QVector<TraceEvent>
+allEvents(QStringList &names)
+{
+    QVector<TraceEvent> returning;
+    QMutexLocker locker(&registryLock);
+    foreach(TraceBuffer *buffer, buffers) {
+        QMutexLocker bufferLocker(&buffer->lock);
+        returning += buffer->events;
+    }
+    names = threadNames;
+    return returning;
+}
+
+// names are literals but may have quotes
+static QString
+protect(const char *name)
+{
+    QString returning(name);
+    returning.replace("\\", "\\\\");
+    returning.replace("\"", "\\\"");
+    return returning;
+}
+
+bool
+GcTrace::write(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) return false;
+
+    QStringList names;
+    QVector<TraceEvent> events = allEvents(names);
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // thread names first
+    for (int i=0; i<names.count(); i++) {
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+            << ",\"args\":{\"name\":\"" << protect(names[i].toUtf8().constData()) << "\"}},\n";
+    }
+
+    // complete events, times in microseconds
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(3);
+    for (int i=0; i<events.count(); i++) {
+        const TraceEvent &e = events[i];
+        out << "{\"name\":\"" << protect(e.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+            << ",\"ts\":" << (e.start / 1000.0) << ",\"dur\":" << (e.duration / 1000.0) << "}"
+            << (i < events.count()-1 ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    file.close();
+    return true;
+}
+
+struct TraceTotal {
+    int count;
+    qint64 total, max;
+    TraceTotal() : count(0), total(0), max(0) {}
+};
+
+static bool totalLessThan(const QPair<QString, TraceTotal> &a, const QPair<QString, TraceTotal> &b)
+{
+    return a.second.total > b.second.total;
+}
+
+static bool slowerThan(const TraceEvent &a, const TraceEvent &b)
+{
+    return a.duration > b.duration;
+}
+
+QString
+GcTrace::summary(int count)
+{
+    QStringList names;
+    QVector<TraceEvent> events = allEvents(names);
+
+#ifndef GC_WANT_TRACE
+    if (events.isEmpty()) return "Nothing traced, built without GC_WANT_TRACE\n";
+#else
+    if (events.isEmpty()) return "Nothing traced\n";
+#endif
+
+    QHash<QString, TraceTotal> totals;
+    foreach(TraceEvent e, events) {
+        TraceTotal &t = totals[e.name];
+        t.count++;
+        t.total += e.duration;
+        if (e.duration > t.max) t.max = e.duration;
+    }
+
+    QList<QPair<QString, TraceTotal> > sorted;
+    QHashIterator<QString, TraceTotal> it(totals);
+    while (it.hasNext()) {
+        it.next();
+        sorted << QPair<QString, TraceTotal>(it.key(), it.value());
+    }
+    qSort(sorted.begin(), sorted.end(), totalLessThan);
+
+    QString returning;
+    returning += QString("%1 %2 %3 %4 %5\n").arg("operation", -36).arg("calls", 8)
+                 .arg("total ms", 12).arg("mean ms", 10).arg("max ms", 10);
+    for (int i=0; i<sorted.count() && i<count; i++) {
+        const TraceTotal &t = sorted[i].second;
+        returning += QString("%1 %2 %3 %4 %5\n").arg(sorted[i].first, -36).arg(t.count, 8)
+                     .arg(t.total / 1000000.0, 12, 'f', 1)
+                     .arg(t.total / 1000000.0 / t.count, 10, 'f', 3)
+                     .arg(t.max / 1000000.0, 10, 'f', 1);
+    }
+
+    qSort(events.begin(), events.end(), slowerThan);
+    returning += QString("\n%1 %2 %3 %4\n").arg("slowest", -36).arg("thread", -16).arg("at ms", 12).arg("took ms", 10);
+    for (int i=0; i<events.count() && i<count; i++) {
+        const TraceEvent &e = events[i];
+        returning += QString("%1 %2 %3 %4\n").arg(e.name, -36).arg(names.value(e.thread), -16)
+                     .arg(e.start / 1000000.0, 12, 'f', 1).arg(e.duration / 1000000.0, 10, 'f', 1);
+    }
+    return returning;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_GcTrace_h
+#define _GC_GcTrace_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+
+// events kept for each thread, the oldest are overwritten
+#define GCTRACE_EVENTS 65536
+
+//
+// Timing the things users wait for. Put GC_TRACE("Class::method") at the
+// top of a block and the time spent in it is recorded when the block
+// exits. The name must be a string literal, it is not copied.
+//
+// Only built with DEFINES += GC_WANT_TRACE in gcconfig.pri, otherwise the
+// macro is empty and costs nothing at all.
+//
+// Each thread records into its own buffer so threads never wait on each
+// other. The trace can be written as Chrome trace JSON, which loads into
+// chrome://tracing or ui.perfetto.dev, and summarised as the operations
+// that took the most time in total and the slowest single calls.
+//
+class GcTrace
+{
+    public:
+
+        // recording can be paused, on from the start if built in
+        static void setEnabled(bool enabled) { enabled_ = enabled; }
+        static bool isEnabled() { return enabled_; }
+
+        // nanoseconds since the start
+        static qint64 now();
+
+        // add to this thread's buffer
+        static void record(const char *name, qint64 start, qint64 duration);
+
+        // discard everything recorded
+        static void clear();
+
+        // write Chrome trace JSON, false if it can't be written
+        static bool write(QString filename);
+
+        // the operations that took longest, as text
+        static QString summary(int count = 20);
+
+    private:
+        static volatile bool enabled_;
+};
+
+class GcTraceScope
+{
+    public:
+        GcTraceScope(const char *name) : name(name), start(GcTrace::isEnabled() ? GcTrace::now() : -1) {}
+        ~GcTraceScope() { if (start >= 0) GcTrace::record(name, start, GcTrace::now() - start); }
+
+    private:
+        const char *name;
+        qint64 start;
+};
+
+#ifdef GC_WANT_TRACE
+#define GC_TRACE_JOIN(a,b) a##b
+#define GC_TRACE_NAME(line) GC_TRACE_JOIN(gcTraceScope, line)
+#define GC_TRACE(name) GcTraceScope GC_TRACE_NAME(__LINE__)(name)
+#else
+#define GC_TRACE(name)
+#endif
+
+#endif // _GC_GcTrace_h
@@ -67,7 +67,7 @@ GcWindowRegistry* GcWindows;
 void
 GcWindowRegistry::initialize()
 {
-  static GcWindowRegistry GcWindowsInit[31] = {
+  static GcWindowRegistry GcWindowsInit[32] = {
     // name                     GcWinID
     { VIEW_HOME|VIEW_DIARY, tr("Metric Trends"),GcWindowTypes::LTM },
     { VIEW_HOME|VIEW_DIARY, tr("Collection TreeMap"),GcWindowTypes::TreeMap },
@@ -82,6 +82,7 @@ GcWindowRegistry::initialize()
     { VIEW_ANALYSIS, tr("Critical Mean Maximals"),GcWindowTypes::CriticalPower },
     { VIEW_ANALYSIS, tr("Histogram"),GcWindowTypes::Histogram },
     { VIEW_HOME|VIEW_DIARY, tr("Distribution"),GcWindowTypes::Distribution },
+    { VIEW_HOME|VIEW_DIARY, tr("Pedal Force vs Velocity"),GcWindowTypes::PfPvSummary },
     { VIEW_ANALYSIS, tr("Pedal Force vs Velocity"),GcWindowTypes::PfPv },
     { VIEW_ANALYSIS, tr("Heartrate vs Power"),GcWindowTypes::HrPw },
     { VIEW_ANALYSIS|VIEW_INTERVAL, tr("Google Map"),GcWindowTypes::GoogleMap },
@@ -182,6 +183,7 @@ GcWindowRegistry::newGcWindow(GcWinID id, Context *context)
     case GcWindowTypes::Model: returning = new GcWindow(); break;
 #endif
     case GcWindowTypes::PfPv: returning = new PfPvWindow(context); break;
+    case GcWindowTypes::PfPvSummary: returning = new PfPvWindow(context, true); break;
     case GcWindowTypes::HrPw: returning = new HrPwWindow(context); break;
     case GcWindowTypes::RideEditor: returning = new RideEditor(context); break;
     case GcWindowTypes::RideSummary: returning = new RideSummaryWindow(context, true); break;
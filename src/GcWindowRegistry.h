@@ -61,7 +61,8 @@ enum gcwinid {
         DateRangeSummary = 32,
         CriticalPowerSummary = 33,
         Distribution = 34,
-        RouteSegment = 35
+        RouteSegment = 35,
+        PfPvSummary = 36
 };
 };
 typedef enum GcWindowTypes::gcwinid GcWinID;
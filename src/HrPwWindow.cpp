@@ -24,6 +24,7 @@
 #include "SmallPlot.h"
 #include "RideItem.h"
 #include "HelpWhatsThis.h"
+#include "SignalAlign.h"
 #include <cmath>
 #include <stdlib.h>
 #include <QVector>
@@ -339,25 +340,12 @@ HrPwWindow::findDelay(QVector<double> &wattsArray, QVector<double> &hrArray, int
 
     if (rideTimeSecs>= 60) {
 
-        for (int a = 10; a <=60; ++a) {
+        // hr lags power by 10 to 60 seconds
+        QVector<double> watts = wattsArray.mid(0, rideTimeSecs);
+        QVector<double> hr = hrArray.mid(0, rideTimeSecs);
 
-            QVector<double> delayHr(rideTimeSecs);
-
-            for (int j = a; j<rideTimeSecs; ++j) {
-                delayHr[j-a] = hrArray[j];
-            }
-            for (int j = rideTimeSecs-a; j<rideTimeSecs; ++j) {
-                delayHr[j] = 0.0;
-            }
-
-            double r = corr(wattsArray, delayHr, rideTimeSecs-a);
-            //fprintf(stderr, "findDelay %d: %.2f \n", a, r);
-
-            if (r>maxr) {
-                maxr = r;
-                delay = a;
-            }
-        }
+        int a = SignalAlign::align(hr, watts, 10, 60, maxr);
+        if (maxr > 0) delay = a;
     } 
 
     delayEdit->setText(QString("%1").arg(delay));
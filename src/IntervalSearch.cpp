@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "IntervalSearch.h"
+
+#include <QMap>
+#include <algorithm> // for std::make_heap et al
+
+// a window ending at each sample
+struct IntervalCandidate {
+    int begin, end;
+    double avg;
+    IntervalCandidate() : begin(0), end(0), avg(0) {}
+    IntervalCandidate(int begin, int end, double avg) : begin(begin), end(end), avg(avg) {}
+};
+
+// heap order; higher average then earlier start is better
+struct WorseCandidate {
+    bool operator()(const IntervalCandidate &a, const IntervalCandidate &b) const {
+        if (a.avg != b.avg) return a.avg < b.avg;
+        return a.begin > b.begin;
+    }
+};
+
+IntervalSearch::IntervalSearch(const RideFile *ride, RideFile::SeriesType series)
+    : recIntSecs(ride->recIntSecs())
+{
+    int n = ride->dataPoints().count();
+    secs.resize(n);
+    km.resize(n);
+    sum.resize(n+1);
+
+    double total = 0;
+    sum[0] = 0;
+    for (int i=0; i<n; i++) {
+        const RideFilePoint *p = ride->dataPoints()[i];
+        secs[i] = p->secs;
+        km[i] = p->km;
+        total += (series == RideFile::watts) ? p->watts : p->value(series);
+        sum[i+1] = total;
+    }
+}
+
+IntervalSearch::Result
+IntervalSearch::result(int begin, int end) const
+{
+    Result r;
+    r.begin = begin;
+    r.end = end;
+    r.start = secs[begin];
+    r.stop = secs[end];
+    r.duration = secs[end] - secs[begin] + recIntSecs;
+    r.avg = r.duration > 0 ? (sum[end+1] - sum[begin]) * recIntSecs / r.duration : 0;
+    return r;
+}
+
+bool
+IntervalSearch::tooShort(double windowSize, Type type) const
+{
+    if (secs.isEmpty()) return true;
+    if (type == ByTime) return windowSize > secs.last() + recIntSecs;
+    else return windowSize > km.last() * 1000;
+}
+
+QList<IntervalSearch::Result>
+IntervalSearch::bests(double windowSize, int maxIntervals, Type type) const
+{
+    QList<Result> results;
+    if (maxIntervals < 1 || tooShort(windowSize, type)) return results;
+
+    // We're looking for intervals with durations in [windowSize, windowSize + recIntSecs)
+    // or spanning windowSize meters, the start of the window only moves forward
+    QVector<IntervalCandidate> candidates;
+    IntervalCandidate best(-1, -1, 0);
+    int n = secs.count();
+    int i = 0;
+    for (int j=0; j<n; j++) {
+
+        if (type == ByTime) {
+            while (i < j && secs[j] - secs[i] + recIntSecs >= windowSize + recIntSecs) i++;
+        } else {
+            while (i+1 < j && 1000 * (km[j] - km[i+1]) >= windowSize) i++;
+        }
+
+        double duration = secs[j] - secs[i] + recIntSecs;
+        if (duration <= 0) continue;
+
+        if ((type == ByTime && duration >= windowSize) ||
+            (type == ByDistance && 1000 * (km[j] - km[i]) >= windowSize)) {
+
+            IntervalCandidate c(i, j, (sum[j+1] - sum[i]) * recIntSecs / duration);
+
+            // only want the best, so don't collect them all
+            if (maxIntervals == 1) {
+                if (best.begin < 0 || c.avg > best.avg) best = c;
+            } else {
+                candidates << c;
+            }
+        }
+    }
+
+    if (maxIntervals == 1) {
+        if (best.begin >= 0) results << result(best.begin, best.end);
+        return results;
+    }
+
+    // pull off the best until we have enough that don't overlap
+    // chosen maps first sample to last sample and never overlap
+    // so we only need to check the neighbours either side
+    QMap<int,int> chosen;
+    std::make_heap(candidates.begin(), candidates.end(), WorseCandidate());
+    while (!candidates.isEmpty() && results.count() < maxIntervals) {
+
+        std::pop_heap(candidates.begin(), candidates.end(), WorseCandidate());
+        IntervalCandidate c = candidates.last();
+        candidates.pop_back();
+
+        QMap<int,int>::const_iterator it = chosen.lowerBound(c.begin);
+        if (it != chosen.constEnd() && it.key() <= c.end) continue; // one starts inside us
+        if (it != chosen.constBegin() && (--it).value() >= c.begin) continue; // we start inside one
+
+        chosen.insert(c.begin, c.end);
+        results << result(c.begin, c.end);
+    }
+    return results;
+}
+
+IntervalSearch::Result
+IntervalSearch::peak(double windowSize) const
+{
+    QList<Result> best = bests(windowSize, 1, ByTime);
+    if (best.isEmpty()) return Result();
+    return best.first();
+}
+
+QVector<IntervalSearch::Result>
+IntervalSearch::peaks(const QVector<double> &windowSizes) const
+{
+    int k = windowSizes.count();
+    QVector<Result> results(k);
+    QVector<IntervalCandidate> best(k, IntervalCandidate(-1, -1, 0));
+    QVector<int> from(k, 0); // window start for each size
+
+    // all sizes advance together over the ride
+    int n = secs.count();
+    for (int j=0; j<n; j++) {
+        for (int w=0; w<k; w++) {
+
+            double windowSize = windowSizes[w];
+            int i = from[w];
+            while (i < j && secs[j] - secs[i] + recIntSecs >= windowSize + recIntSecs) i++;
+            from[w] = i;
+
+            double duration = secs[j] - secs[i] + recIntSecs;
+            if (duration <= 0 || duration < windowSize) continue;
+
+            double avg = (sum[j+1] - sum[i]) * recIntSecs / duration;
+            if (best[w].begin < 0 || avg > best[w].avg) best[w] = IntervalCandidate(i, j, avg);
+        }
+    }
+
+    for (int w=0; w<k; w++)
+        if (best[w].begin >= 0 && !tooShort(windowSizes[w], ByTime))
+            results[w] = result(best[w].begin, best[w].end);
+
+    return results;
+}
+
+QList<IntervalSearch::Result>
+IntervalSearch::firsts(double windowSize, int maxIntervals, Type type) const
+{
+    QList<Result> results;
+    if (tooShort(windowSize, type)) return results;
+
+    // consecutive windows, any overshoot is carried into the next
+    double rest = 0;
+    int n = secs.count();
+    int i = 0;
+    for (int j=0; j<n && results.count() < maxIntervals; j++) {
+
+        double duration = secs[j] - secs[i] + recIntSecs;
+        double distance = 1000 * (km[j] - km[i]);
+
+        if ((type == ByTime && duration >= (windowSize - rest)) ||
+            (type == ByDistance && distance >= (windowSize - rest))) {
+
+            results << result(i, j);
+            rest = (type == ByTime ? duration : distance) - windowSize + rest;
+
+            // For distance the last point of an interval is also the first point of the next
+            i = (type == ByTime) ? j+1 : j;
+        }
+    }
+    return results;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_IntervalSearch_h
+#define _GC_IntervalSearch_h 1
+#include "GoldenCheetah.h"
+
+#include <QList>
+#include <QVector>
+#include "RideFile.h"
+
+//
+// Sliding window search for best and first intervals in a ride.
+//
+// The series is summed once into a prefix array so the average of any
+// window is O(1) and the window start only ever moves forward, making
+// each search a single pass. Top-n selection pulls candidates off a heap
+// and rejects overlaps against the (ordered, disjoint) chosen windows,
+// so there is no sort of every candidate and no n^2 overlap check.
+//
+// It holds no references to widgets or the context and only reads the
+// ride, so it can be used from metrics and worker threads; create one
+// per thread.
+//
+class IntervalSearch
+{
+    public:
+
+        enum type { ByTime, ByDistance };
+        typedef enum type Type;
+
+        struct Result {
+            int begin, end;     // first and last sample index
+            double start, stop; // secs of first and last sample
+            double duration;    // secs, including the last sample
+            double avg;         // average of the series over the window
+
+            Result() : begin(-1), end(-1), start(0), stop(0), duration(0), avg(0) {}
+            bool isValid() const { return begin >= 0; }
+        };
+
+        IntervalSearch(const RideFile *ride, RideFile::SeriesType series = RideFile::watts);
+
+        // best n non-overlapping windows of windowSize secs (or meters), best first
+        QList<Result> bests(double windowSize, int maxIntervals, Type type = ByTime) const;
+
+        // the single best window for each of the window sizes (secs) in one pass
+        // a result is invalid if the ride is shorter than the window
+        QVector<Result> peaks(const QVector<double> &windowSizes) const;
+        Result peak(double windowSize) const;
+
+        // consecutive windows from the start of the ride
+        QList<Result> firsts(double windowSize, int maxIntervals, Type type = ByTime) const;
+
+    private:
+
+        Result result(int begin, int end) const;
+        bool tooShort(double windowSize, Type type) const;
+
+        double recIntSecs;
+        QVector<double> secs, km;
+        QVector<double> sum;    // sum[i] is the total for samples 0 .. i-1
+};
+
+#endif // _GC_IntervalSearch_h
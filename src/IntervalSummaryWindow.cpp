@@ -193,26 +193,10 @@ void IntervalSummaryWindow::calcInterval(IntervalItem* interval, QString& html)
 {
 	const RideFile* ride = context->ride ? context->ride->ride() : NULL;
 
-    RideFile f(const_cast<RideFile*>(ride));
+    // a view on the interval, no need to copy the samples
     int start = ride->timeIndex(interval->start);
     int end = ride->timeIndex(interval->stop);
-    for (int i = start; i <= end; ++i) {
-        const RideFilePoint *p = ride->dataPoints()[i];
-        f.appendPoint(p->secs, p->cad, p->hr, p->km, p->kph, p->nm,
-                      p->watts, p->alt, p->lon, p->lat, p->headwind, p->slope, p->temp, p->lrbalance, 
-                      p->lte, p->rte, p->lps, p->rps,
-                      p->lpco, p->rpco,
-                      p->lppb, p->rppb, p->lppe, p->rppe,
-                      p->lpppb, p->rpppb, p->lpppe, p->rpppe,
-                      p->smo2, p->thb,
-                      p->rvert, p->rcad, p->rcontact, 0);
-
-        // derived data
-        RideFilePoint *l = f.dataPoints().last();
-        l->np = p->np;
-        l->xp = p->xp;
-        l->apower = p->apower;
-    }
+    RideFile f(const_cast<RideFile*>(ride), start, end);
 
     summary(f, interval->text(0), html);
 }
@@ -276,26 +260,11 @@ void IntervalSummaryWindow::calcInterval(RideFileInterval interval, QString& htm
 
     bool metricUnits = context->athlete->useMetricUnits;
 
-    RideFile f(const_cast<RideFile*>(ride));
+    // a view on the interval, no need to copy the samples
     int start = ride->timeIndex(interval.start);
     int end = ride->timeIndex(interval.stop);
-    for (int i = start; i <= end; ++i) {
-        const RideFilePoint *p = ride->dataPoints()[i];
-        f.appendPoint(p->secs, p->cad, p->hr, p->km, p->kph, p->nm,
-                      p->watts, p->alt, p->lon, p->lat, p->headwind, p->slope, p->temp, p->lrbalance, 
-                      p->lte, p->rte, p->lps, p->rps,
-                      p->lpco, p->rpco,
-                      p->lppb, p->rppb, p->lppe, p->rppe,
-                      p->lpppb, p->rpppb, p->lpppe, p->rpppe,
-                      p->smo2, p->thb,
-                      p->rvert, p->rcad, p->rcontact, 0);
-
-        // derived data
-        RideFilePoint *l = f.dataPoints().last();
-        l->np = p->np;
-        l->xp = p->xp;
-        l->apower = p->apower;
-    }
+    RideFile f(const_cast<RideFile*>(ride), start, end);
+
     if (f.dataPoints().size() == 0) {
         // Interval empty, do not compute any metrics
         html += "<i>" + tr("empty interval") + "</tr>";
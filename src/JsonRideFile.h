@@ -25,6 +25,7 @@
 #include <algorithm> // for std::sort
 #include <QDomDocument>
 #include <QVector>
+#include <QTextStream>
 #include <assert.h>
 #include <QDebug>
 #define DATETIME_FORMAT "yyyy/MM/dd hh:mm:ss' UTC'"
@@ -34,6 +35,13 @@ struct JsonFileReader : public RideFileReader {
     virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const; 
     bool writeRideFile(Context *, const RideFile *ride, QFile &file) const;
     bool hasWrite() const { return true; }
+
+    // just the metadata, tags and intervals to the sidecar, see
+    // RideFileFactory::sidecarFileName, the samples are left alone
+    bool writeRideMetadata(const RideFile *ride, QString filename) const;
+
+    private:
+        static void writeRide(QTextStream &out, const RideFile *ride, bool samples);
 };
 
 #endif // _JsonRideFile_h
@@ -391,6 +391,49 @@ JsonFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) cons
     out.setCodec("UTF-8");
     out.setGenerateByteOrderMark(true);
 
+    writeRide(out, ride, true);
+
+    // close
+    file.close();
+
+    return true;
+}
+
+bool
+JsonFileReader::writeRideMetadata(const RideFile *ride, QString filename) const
+{
+    // written to a temporary file then renamed over the old one
+    // so a crash part way through never leaves half a sidecar
+    QString temp = filename + ".tmp";
+    QFile file(temp);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out.setGenerateByteOrderMark(true);
+
+    writeRide(out, ride, false);
+
+    out.flush();
+    bool ok = (file.error() == QFile::NoError);
+    file.close();
+
+    if (ok) {
+#ifdef Q_OS_WIN
+        // rename won't replace on windows
+        QFile::remove(filename);
+        ok = QFile::rename(temp, filename);
+#else
+        ok = (::rename(QFile::encodeName(temp).constData(), QFile::encodeName(filename).constData()) == 0);
+#endif
+    }
+    if (!ok) QFile::remove(temp);
+    return ok;
+}
+
+void
+JsonFileReader::writeRide(QTextStream &out, const RideFile *ride, bool samples)
+{
     // start of document and ride
     out << "{\n\t\"RIDE\":{\n";
 
@@ -484,7 +527,7 @@ JsonFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) cons
     //
     // CALIBRATION
     //
-    if (!ride->calibrations().empty()) {
+    if (samples && !ride->calibrations().empty()) {
 
         out << ",\n\t\t\"CALIBRATIONS\":[\n";
         bool first = true;
@@ -504,7 +547,7 @@ JsonFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) cons
     //
     // REFERENCES
     //
-    if (!ride->referencePoints().empty()) {
+    if (samples && !ride->referencePoints().empty()) {
 
         out << ",\n\t\t\"REFERENCES\":[\n";
         bool first = true;
@@ -528,7 +571,7 @@ JsonFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) cons
     //
     // SAMPLES
     //
-    if (ride->dataPoints().count()) {
+    if (samples && ride->dataPoints().count()) {
 
         out << ",\n\t\t\"SAMPLES\":[\n";
         bool first = true;
@@ -586,9 +629,4 @@ JsonFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) cons
 
     // end of ride and document
     out << "\n\t}\n}\n";
-
-    // close
-    file.close();
-
-    return true;
 }
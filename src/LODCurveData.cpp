@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "LODCurveData.h"
+
+#include <QWidget>
+#include <algorithm>
+#include <string.h> // for memcpy
+
+LODCurveData::LODCurveData(const double *x, const double *y, size_t count, const QWidget *canvas) : canvas(canvas)
+{
+    xdata.resize(count);
+    ydata.resize(count);
+    if (count) {
+        memcpy(xdata.data(), x, count * sizeof(double));
+        memcpy(ydata.data(), y, count * sizeof(double));
+    }
+    init();
+}
+
+LODCurveData::LODCurveData(const QVector<QPointF> &points, const QWidget *canvas) : canvas(canvas)
+{
+    xdata.resize(points.count());
+    ydata.resize(points.count());
+    for (int i=0; i<points.count(); i++) {
+        xdata[i] = points[i].x();
+        ydata[i] = points[i].y();
+    }
+    init();
+}
+
+void
+LODCurveData::init()
+{
+    // until we know what is visible we show everything
+    decimated = false;
+    from = 0;
+    count = xdata.count();
+
+    // bounds and check x is ordered, one pass
+    monotonic = true;
+    if (xdata.count() == 0) {
+        bounds = QRectF(1.0, 1.0, -2.0, -2.0); // invalid, as qwt does
+        return;
+    }
+
+    double minx = xdata[0], maxx = xdata[0];
+    double miny = ydata[0], maxy = ydata[0];
+    for (int i=1; i<xdata.count(); i++) {
+        if (!(xdata[i] >= xdata[i-1])) monotonic = false;
+        if (xdata[i] < minx) minx = xdata[i];
+        if (xdata[i] > maxx) maxx = xdata[i];
+        if (ydata[i] < miny) miny = ydata[i];
+        if (ydata[i] > maxy) maxy = ydata[i];
+    }
+    bounds = QRectF(minx, miny, maxx - minx, maxy - miny);
+}
+
+size_t
+LODCurveData::size() const
+{
+    return decimated ? view.count() : count;
+}
+
+QPointF
+LODCurveData::sample(size_t i) const
+{
+    int index = decimated ? view[i] : from + int(i);
+    return QPointF(xdata[index], ydata[index]);
+}
+
+QRectF
+LODCurveData::boundingRect() const
+{
+    // always the whole series, so autoscaling is unaffected by zoom
+    return bounds;
+}
+
+void
+LODCurveData::build(int depth)
+{
+    while (levels.count() < depth) {
+
+        // children are raw samples for the first level
+        int n = xdata.count();
+        int children = levels.count() ? levels.last().lo.count() : n;
+        int buckets = (children + 1) / 2;
+
+        Level add;
+        add.lo.resize(buckets);
+        add.hi.resize(buckets);
+
+        for (int b=0; b<buckets; b++) {
+
+            int c0 = 2*b, c1 = 2*b+1;
+            int lo0, hi0, lo1, hi1;
+
+            if (levels.count()) {
+                const Level &prev = levels.last();
+                lo0 = prev.lo[c0]; hi0 = prev.hi[c0];
+                if (c1 < children) { lo1 = prev.lo[c1]; hi1 = prev.hi[c1]; }
+                else { lo1 = lo0; hi1 = hi0; }
+            } else {
+                lo0 = hi0 = c0;
+                lo1 = hi1 = (c1 < children) ? c1 : c0;
+            }
+
+            add.lo[b] = ydata[lo1] < ydata[lo0] ? lo1 : lo0;
+            add.hi[b] = ydata[hi1] > ydata[hi0] ? hi1 : hi0;
+        }
+        levels << add;
+    }
+}
+
+void
+LODCurveData::setRectOfInterest(const QRectF &rect)
+{
+    int n = xdata.count();
+
+    // can't search unordered data, so show everything
+    if (!monotonic || n == 0) {
+        decimated = false;
+        from = 0;
+        count = n;
+        return;
+    }
+
+    double x0 = qMin(rect.left(), rect.right());
+    double x1 = qMax(rect.left(), rect.right());
+
+    // one sample either side so lines run off the edge of the canvas
+    int first = std::lower_bound(xdata.constBegin(), xdata.constEnd(), x0) - xdata.constBegin() - 1;
+    int last = std::upper_bound(xdata.constBegin(), xdata.constEnd(), x1) - xdata.constBegin();
+    if (first < 0) first = 0;
+    if (last > n-1) last = n-1;
+    if (last < first) { first = 0; last = n-1; }
+
+    int columns = (canvas && canvas->width() > 0) ? canvas->width() : LODCURVE_COLUMNS;
+    int visible = last - first + 1;
+
+    // zoomed in close enough to just show the samples
+    if (visible <= 2 * columns) {
+        decimated = false;
+        from = first;
+        count = visible;
+        return;
+    }
+
+    // smallest bucket size giving no more than one bucket per column
+    int depth = 1;
+    while ((visible >> depth) > columns) depth++;
+    build(depth);
+
+    // min and max of each bucket, in the order they occur
+    const Level &level = levels[depth-1];
+    int b0 = first >> depth;
+    int b1 = last >> depth;
+
+    view.resize(0);
+    view.reserve(2 * (b1 - b0 + 1));
+    for (int b=b0; b<=b1; b++) {
+        int lo = level.lo[b];
+        int hi = level.hi[b];
+        if (lo < hi) view << lo << hi;
+        else if (hi < lo) view << hi << lo;
+        else view << lo;
+    }
+    decimated = true;
+}
+
+QVector<QPointF>
+LODCurveData::samples(const QwtSeriesData<QPointF> *data)
+{
+    QVector<QPointF> returning;
+    if (!data) return returning;
+
+    const LODCurveData *lod = dynamic_cast<const LODCurveData*>(data);
+    if (lod) {
+        returning.resize(lod->rawSize());
+        for (size_t i=0; i<lod->rawSize(); i++) returning[i] = lod->rawSample(i);
+    } else {
+        returning.resize(data->size());
+        for (size_t i=0; i<data->size(); i++) returning[i] = data->sample(i);
+    }
+    return returning;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_LODCurveData_h
+#define _GC_LODCurveData_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <qwt_series_data.h>
+
+class QWidget;
+
+// canvas width assumed when we don't have one
+#define LODCURVE_COLUMNS 1024
+
+//
+// Curve data for long, dense series such as the per-second ride plots
+//
+// Qwt passes the visible scale range via setRectOfInterest() before each
+// replot. When the visible samples would be more than a couple per pixel
+// column we only hand back the min and max of each bucket of samples from
+// a decimation pyramid, so a 24hr ride plots as ~2 points per column at any
+// zoom level, but peaks and troughs are never lost.
+//
+// The pyramid levels are built on demand, when zoomed in close enough no
+// levels are needed and the raw samples are returned. The x values must be
+// non-decreasing (time or distance), if they are not all samples are
+// returned as with QwtPointArrayData.
+//
+// Indexes passed to sample() refer to the current view, so code that needs
+// all the samples (e.g. to clone a curve) should use LODCurveData::samples()
+//
+class LODCurveData : public QwtSeriesData<QPointF>
+{
+    public:
+        LODCurveData(const double *x, const double *y, size_t count, const QWidget *canvas = NULL);
+        LODCurveData(const QVector<QPointF> &points, const QWidget *canvas = NULL);
+
+        // QwtSeriesData
+        size_t size() const;
+        QPointF sample(size_t i) const;
+        QRectF boundingRect() const;
+        void setRectOfInterest(const QRectF &rect);
+
+        // full resolution, regardless of the current view
+        size_t rawSize() const { return xdata.count(); }
+        QPointF rawSample(size_t i) const { return QPointF(xdata[i], ydata[i]); }
+
+        // all samples at full resolution for any series
+        static QVector<QPointF> samples(const QwtSeriesData<QPointF> *data);
+
+    private:
+        void init();
+        void build(int depth); // pyramid up to depth
+
+        const QWidget *canvas;
+        QVector<double> xdata, ydata;
+        QRectF bounds;
+        bool monotonic;
+
+        // level n has buckets of 2^(n+1) samples and holds
+        // the index of the min and max sample in each bucket
+        struct Level {
+            QVector<int> lo, hi;
+        };
+        QList<Level> levels;
+
+        // current view, a range of raw samples or a decimated list
+        bool decimated;
+        int from, count;
+        QVector<int> view;
+};
+
+#endif // _GC_LODCurveData_h
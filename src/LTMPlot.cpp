@@ -19,6 +19,7 @@
 #include "Athlete.h"
 #include "Context.h"
 #include "LTMPlot.h"
+#include "GcTrace.h"
 #include "LTMTool.h"
 #include "LTMTrend.h"
 #include "LTMTrend2.h"
@@ -26,6 +27,7 @@
 #include "LTMWindow.h"
 #include "RideMetric.h"
 #include "RideCache.h"
+#include "MetricRollup.h"
 #include "RideFileCache.h"
 #include "Settings.h"
 #include "Colors.h"
@@ -210,6 +212,8 @@ LTMPlot::setAxisTitle(QwtAxisId axis, QString label)
 void
 LTMPlot::setData(LTMSettings *set)
 {
+    GC_TRACE("LTMPlot::setData");
+
     QTime timer;
     timer.start();
 
@@ -2367,108 +2371,105 @@ LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail
     x.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
     y.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
 
-    // do we aggregate ?
-    bool aggZero = metricDetail.metric ? metricDetail.metric->aggregateZero() : false;
-
     n=-1;
     int lastDay=0;
-    unsigned long secondsPerGroupBy=0;
     bool wantZero = forceZero ? 1 : (metricDetail.curveStyle == QwtPlotCurve::Steps);
 
-    foreach (RideItem *ride, context->athlete->rideCache->rides()) { 
-
-        // filter out unwanted stuff
-        if (!settings->specification.pass(ride)) continue;
-
-        // day we are on
-        int currentDay = groupForDate(ride->dateTime.date(), settings->groupBy);
-
-        // value for day
-        double value;
-        if (metricDetail.type == METRIC_META)
-            value = ride->getText(metricDetail.symbol, "0.0").toDouble();
-        else
-            value = ride->getForSymbol(metricDetail.symbol);
-
-        // check values are bounded to stop QWT going berserk
-        if (std::isnan(value) || std::isinf(value)) value = 0;
-
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metricDetail.metric && metricDetail.metric->symbol() == "average_temp" && value == RideFile::NoTemp) {
-            value = 0;
-            aggZero = false;
+    // aggregate by group from the rollup, rather than visiting every ride
+    MetricRollup *rollup = context->athlete->rideCache->rollup();
+    bool meta = (metricDetail.type == METRIC_META);
+    FilterSet fs = settings->specification.filterSet();
+    DateRange dr = settings->specification.dateRange();
+
+    QMap<int, MetricRollup::Bucket> groups;
+    if (settings->groupBy == LTM_MONTH || settings->groupBy == LTM_YEAR || settings->groupBy == LTM_ALL) {
+
+        // months are whole in the rollup
+        QMapIterator<int, MetricRollup::Bucket> it(rollup->months(metricDetail.symbol, meta, fs, dr.from, dr.to));
+        while (it.hasNext()) {
+            it.next();
+            int year = (it.key()-1) / 12;
+            QDate date(year, it.key() - (year*12), 1);
+            groups[groupForDate(date, settings->groupBy)].merge(it.value());
         }
 
-        if (metricDetail.metric) {
-            // convert from stored metric value to imperial
-            if (context->athlete->useMetricUnits == false) {
-                value *= metricDetail.metric->conversion();
-                value += metricDetail.metric->conversionSum();
-            }
+    } else {
 
-            // convert seconds to hours
-            if (metricDetail.metric->units(true) == "seconds" ||
-                metricDetail.metric->units(true) == tr("seconds")) value /= 3600;
+        QMapIterator<int, MetricRollup::Bucket> it(rollup->days(metricDetail.symbol, meta, fs, dr.from, dr.to));
+        while (it.hasNext()) {
+            it.next();
+            groups[groupForDate(QDate::fromJulianDay(it.key()), settings->groupBy)].merge(it.value());
         }
+    }
 
-        if (value || wantZero) {
-            unsigned long seconds = ride->getForSymbol("workout_time");
-            if (currentDay > lastDay) {
-                if (lastDay && wantZero) {
-                    while (lastDay<currentDay) {
-                        lastDay++;
-                        n++;
-                        x[n]=lastDay - groupForDate(settings->start.date(), settings->groupBy);
-                        y[n]=0;
-                    }
-                } else {
-                    n++;
-                }
-
-                // first time thru
-                if (n<0) n=0;
-
-                y[n] = value;
-                x[n] = currentDay - groupForDate(settings->start.date(), settings->groupBy);
-
-                // only increment counter if nonzero or we aggregate zeroes
-                if (value || aggZero) secondsPerGroupBy = seconds; 
+    // sum totals, average averages and choose best for Peaks
+    int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
+    if (metricDetail.uunits == "Ramp" ||
+        metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
+    if (metricDetail.type == METRIC_BEST) type = RideMetric::Peak;
+
+    // convert from stored metric value to imperial and seconds to hours
+    double c = 1.0, sum = 0.0;
+    if (metricDetail.metric) {
+        if (context->athlete->useMetricUnits == false) {
+            c = metricDetail.metric->conversion();
+            sum = metricDetail.metric->conversionSum();
+        }
+        if (metricDetail.metric->units(true) == "seconds" ||
+            metricDetail.metric->units(true) == tr("seconds")) {
+            c /= 3600;
+            sum /= 3600;
+        }
+    }
 
-            } else {
-                // sum totals, average averages and choose best for Peaks
-                int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
+    QMapIterator<int, MetricRollup::Bucket> it(groups);
+    while (it.hasNext()) {
+        it.next();
 
-                if (metricDetail.uunits == "Ramp" ||
-                    metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
+        const MetricRollup::Bucket &agg = it.value();
+        int currentDay = it.key();
 
-                if (metricDetail.type == METRIC_BEST) type = RideMetric::Peak;
+        // rides that would be plotted
+        int count = wantZero ? agg.count : agg.nonzero;
+        if (count == 0) continue;
 
-                // first time thru
-                if (n<0) n=0;
+        // value for the group
+        double value = 0;
+        switch (type) {
+        case RideMetric::Total:
+            value = (agg.sum * c) + (count * sum);
+            break;
+        case RideMetric::Average:
+            // average should be calculated taking into account
+            // the duration of the ride, otherwise high value but
+            // short rides will skew the overall average
+            value = (agg.mean() * c) + sum;
+            break;
+        case RideMetric::Low:
+            value = ((wantZero ? agg.min : agg.nzmin) * c) + sum;
+            break;
+        case RideMetric::Peak:
+            value = ((wantZero ? agg.max : agg.nzmax) * c) + sum;
+            break;
+        }
 
-                switch (type) {
-                case RideMetric::Total:
-                    y[n] += value;
-                    break;
-                case RideMetric::Average:
-                    {
-                    // average should be calculated taking into account
-                    // the duration of the ride, otherwise high value but
-                    // short rides will skew the overall average
-                    if (value || aggZero) y[n] = ((y[n]*secondsPerGroupBy)+(seconds*value)) / (secondsPerGroupBy+seconds);
-                    break;
-                    }
-                case RideMetric::Low:
-                    if (value < y[n]) y[n] = value;
-                    break;
-                case RideMetric::Peak:
-                    if (value > y[n]) y[n] = value;
-                    break;
-                }
-                secondsPerGroupBy += seconds; // increment for same group
+        if (lastDay && wantZero) {
+            while (lastDay<currentDay) {
+                lastDay++;
+                n++;
+                x[n]=lastDay - groupForDate(settings->start.date(), settings->groupBy);
+                y[n]=0;
             }
-            lastDay = currentDay;
+        } else {
+            n++;
         }
+
+        // first time thru
+        if (n<0) n=0;
+
+        y[n] = value;
+        x[n] = currentDay - groupForDate(settings->start.date(), settings->groupBy);
+        lastDay = currentDay;
     }
 }
 
@@ -44,6 +44,7 @@
 #include "LibraryParser.h"
 #include "TrainDB.h"
 #include "GcUpgrade.h"
+#include "GcTrace.h"
 #include "HelpWhatsThis.h"
 
 // DIALOGS / DOWNLOADS / UPLOADS
@@ -634,6 +635,9 @@ MainWindow::MainWindow(const QDir &home)
 #endif
     optionsMenu->addAction(tr("Create Heat Map..."), this, SLOT(generateHeatMap()), tr(""));
     optionsMenu->addAction(tr("Export Metrics as CSV..."), this, SLOT(exportMetrics()), tr(""));
+#ifdef GC_WANT_TRACE
+    optionsMenu->addAction(tr("Export Performance Trace..."), this, SLOT(exportTrace()), tr(""));
+#endif
     optionsMenu->addSeparator();
     optionsMenu->addAction(tr("Find intervals..."), this, SLOT(addIntervals()), tr (""));
 
@@ -1764,6 +1768,27 @@ MainWindow::exportMetrics()
     currentTab->context->athlete->rideCache->writeAsCSV(fileName);
 }
 
+#ifdef GC_WANT_TRACE
+void
+MainWindow::exportTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName( this, tr("Export Performance Trace"), QDir::homePath(), tr("Chrome Trace (*.json)"));
+    if (fileName.length() == 0) return;
+
+    if (!GcTrace::write(fileName)) {
+        QMessageBox::warning(this, tr("Export Performance Trace"), tr("Cannot write to %1").arg(fileName));
+        return;
+    }
+
+    // and show what took the longest
+    QMessageBox summary(this);
+    summary.setWindowTitle(tr("Export Performance Trace"));
+    summary.setText(tr("Trace written to %1, open it in chrome://tracing or ui.perfetto.dev").arg(fileName));
+    summary.setDetailedText(GcTrace::summary());
+    summary.exec();
+}
+#endif
+
 /*----------------------------------------------------------------------
  * Twitter
  *--------------------------------------------------------------------*/
@@ -172,6 +172,9 @@ class MainWindow : public QMainWindow
         void exportBatch();
         void generateHeatMap();
         void exportMetrics();
+#ifdef GC_WANT_TRACE
+        void exportTrace();
+#endif
 #ifdef GC_HAVE_KQOAUTH
         void tweetRide();
 #endif
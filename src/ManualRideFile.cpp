@@ -17,6 +17,7 @@
  */
 
 #include "ManualRideFile.h"
+#include "CsvLine.h"
 #include "RideMetric.h"
 #include "Units.h"
 #include <QRegExp>
@@ -53,6 +54,7 @@ RideFile *ManualFileReader::openRideFile(QFile &file, QStringList &errors, QList
     int lineno = 1;
     QStringList columnNames;
     QTextStream is(&file);
+    CsvLine csv;
     RideFile *rideFile = new RideFile();
     while (!is.atEnd()) {
 	// the readLine() method doesn't handle old Macintosh CR line endings
@@ -97,22 +99,22 @@ RideFile *ManualFileReader::openRideFile(QFile &file, QStringList &errors, QList
 		double minutes=0,kph=0,watts=0,km=0,hr=0,alt=0,bs=0;
 		double cad=0, nm=0;
 		int interval=0;
-                QStringList fields = line.split(",");
-                minutes = fields[0].toDouble();
-                kph = fields[1].toDouble();
-                watts = fields[2].toDouble();
-                km = fields[3].toDouble();
-                hr = fields[4].toDouble();
-                bs = fields[5].toDouble();
+                csv.parse(line);
+                minutes = csv.toDouble(0);
+                kph = csv.toDouble(1);
+                watts = csv.toDouble(2);
+                km = csv.toDouble(3);
+                hr = csv.toDouble(4);
+                bs = csv.toDouble(5);
 		if (!metric) {
 		    km *= KM_PER_MILE;
 		    kph *= KM_PER_MILE;
 		}
                 const RideMetricFactory &factory = RideMetricFactory::instance();
-                for (int i = 6; i < fields.size(); ++i) {
+                for (int i = 6; i < csv.count() && i < columnNames.count(); ++i) {
                     if (factory.haveMetric(columnNames[i])) {
                         QMap<QString,QString> map;
-                        map.insert("value", QString("%1").arg(fields[i]));
+                        map.insert("value", csv.field(i).toString());
                         rideFile->metricOverrides.insert(columnNames[i], map);
                     }
                     else {
@@ -22,6 +22,7 @@
 #include "RideCache.h"
 #include "MainWindow.h"
 #include "HelpWhatsThis.h"
+#include "SignalAlign.h"
 
 // minimum R-squared fit when trying to find offsets to
 // merge ride files. Lower numbers mean happier to take
@@ -110,6 +111,33 @@ MergeActivityWizard::setRide(RideFile **here, RideFile *with)
     else *here = NULL;
 }
 
+// how well f fits b when offset, 1 - SSres/SStot over where they overlap
+static double
+rsquared(const QVector<double> &b, const QVector<double> &f, int offset)
+{
+    double SStot=0.0f, SSres=0.0f;
+    double mean =0.0f;
+    int count=0;
+
+    for(int i=0; (i+offset)<b.count() && i<f.count(); i++) {
+        if ((i+offset)>=0) {
+            mean += b[i+offset];
+            count++;
+        }
+    }
+    if (count == 0) return 0;
+    mean /= double(count);
+
+    for(int i=0; (i+offset)<b.count() && i<f.count(); i++) {
+        if((i+offset)>=0) {
+            SSres += pow(b[i+offset] - f[i], 2);
+            SStot += pow(b[i+offset] - mean, 2);
+        }
+    }
+    if (SStot == 0) return 0;
+    return 1.0f - (SSres/SStot);
+}
+
 void 
 MergeActivityWizard::analyse()
 {
@@ -147,7 +175,7 @@ MergeActivityWizard::analyse()
             break;
 
     case 1: // align on shared series
-            // using a shotgun algorithm
+            // using cross-correlation
     {
             // calculate the R2 fit using the current offset
             // for the first shared series
@@ -176,39 +204,16 @@ MergeActivityWizard::analyse()
                     // for each shared series look for best fit
                     RideFile::SeriesType shared = i.key();
 
-                    double bestR2 = 0.0f;
-                    int bestOffset = 0;
+                    // the series from each ride
+                    QVector<double> b(base->dataPoints().count()), f(fit->dataPoints().count());
+                    for (int j=0; j<b.count(); j++) b[j] = base->dataPoints()[j]->value(shared);
+                    for (int j=0; j<f.count(); j++) f[j] = fit->dataPoints()[j]->value(shared);
 
                     // no more than shifting by a third of the ride backwards or forwards
-                    for(int offset=-1 * (base->dataPoints().count()/3); 
-                            offset<base->dataPoints().count()/3; 
-                            offset++) {
-
-                        double SStot=0.0f, SSres=0.0f;
-                        double mean =0.0f;
-                        int count=0;
-
-                        for(int i=0; (i+offset)<base->dataPoints().count(); i++) {
-                            if ((i+offset)>0) {
-                                mean += base->dataPoints()[i+offset]->value(shared);
-                            }
-                            count++;
-                        }
-                        mean /= double(count);
-                
-                        for(int i=0; (i+offset)<base->dataPoints().count() && i<fit->dataPoints().count(); i++) {
-                            if((i+offset)>0) {
-                                SSres += pow(base->dataPoints()[i+offset]->value(shared) - fit->dataPoints()[i]->value(shared), 2);
-                                SStot += pow(base->dataPoints()[i+offset]->value(shared) - mean, 2);
-                            }
-                        }
-
-                        double R2= 1.0f - (SSres/SStot);
-                        if (R2 > bestR2) {
-                            bestR2= R2;
-                            bestOffset=offset;
-                        }
-                    }
+                    // find the offset that correlates best, then how well it fits there
+                    double r;
+                    int bestOffset = SignalAlign::align(b, f, -1 * (b.count()/3), (b.count()/3) - 1, r);
+                    double bestR2 = r > 0 ? rsquared(b, f, bestOffset) : 0.0f;
 
                     // is this a better fit ?
                     if (bestR2 > bestFit) {
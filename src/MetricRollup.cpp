@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MetricRollup.h"
+
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideMetric.h"
+#include "RideFile.h" // for NoTemp
+
+#include <cmath>
+
+// when lots of days have changed it is quicker to start again
+#define METRICROLLUP_DIRTY 64
+
+//
+// Buckets
+//
+void
+MetricRollup::Bucket::add(double value, double duration, bool include)
+{
+    if (count == 0) min = max = value;
+    else {
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    count++;
+    sum += value;
+
+    if (value) {
+        if (nonzero == 0) nzmin = nzmax = value;
+        else {
+            if (value < nzmin) nzmin = value;
+            if (value > nzmax) nzmax = value;
+        }
+        nonzero++;
+    }
+
+    if (include) {
+        counted++;
+        csum += value;
+        wsum += value * duration;
+        seconds += duration;
+    }
+}
+
+void
+MetricRollup::Bucket::merge(const Bucket &other)
+{
+    if (other.count == 0) return;
+
+    if (count == 0) {
+        min = other.min;
+        max = other.max;
+    } else {
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+
+    if (other.nonzero) {
+        if (nonzero == 0) {
+            nzmin = other.nzmin;
+            nzmax = other.nzmax;
+        } else {
+            if (other.nzmin < nzmin) nzmin = other.nzmin;
+            if (other.nzmax > nzmax) nzmax = other.nzmax;
+        }
+    }
+
+    count += other.count;
+    nonzero += other.nonzero;
+    counted += other.counted;
+    sum += other.sum;
+    csum += other.csum;
+    wsum += other.wsum;
+    seconds += other.seconds;
+}
+
+double
+MetricRollup::Bucket::mean() const
+{
+    if (seconds > 0) return wsum / seconds;
+    if (counted) return csum / double(counted); // no durations (e.g. manual entries)
+    return 0;
+}
+
+//
+// Rollups
+//
+MetricRollup::MetricRollup(Context *context) : context(context)
+{
+    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(refreshed()));
+    connect(context, SIGNAL(refreshEnd()), this, SLOT(refreshed()));
+}
+
+QString
+MetricRollup::key(QString symbol, bool meta, FilterSet &fs)
+{
+    return QString("%1:%2:%3").arg(symbol).arg(meta ? 1 : 0).arg(fs.key());
+}
+
+int
+MetricRollup::monthFor(int julianDay)
+{
+    QDate date = QDate::fromJulianDay(julianDay);
+    return (date.year()*12) + date.month();
+}
+
+double
+MetricRollup::value(RideItem *item, QString symbol, bool meta, bool &counted)
+{
+    double value;
+    bool aggZero = false;
+
+    if (meta) {
+        value = item->getText(symbol, "0.0").toDouble();
+    } else {
+        value = item->getForSymbol(symbol);
+        const RideMetric *metric = RideMetricFactory::instance().rideMetric(symbol);
+        if (metric) aggZero = metric->aggregateZero();
+    }
+
+    // check values are bounded, just in case
+    if (std::isnan(value) || std::isinf(value)) value = 0;
+
+    // no temperature recorded
+    if (symbol == "average_temp" && value == RideFile::NoTemp) {
+        value = 0;
+        aggZero = false;
+    }
+
+    counted = (value || aggZero);
+    return value;
+}
+
+MetricRollup::Cube &
+MetricRollup::cube(QString symbol, bool meta, FilterSet &fs)
+{
+    QString k = key(symbol, meta, fs);
+
+    // filters come and go, don't keep them all
+    if (!cubes.contains(k) && cubes.count() >= METRICROLLUP_MAX) cubes.clear();
+
+    Cube &returning = cubes[k];
+    update(returning, symbol, meta, fs);
+    return returning;
+}
+
+void
+MetricRollup::build(Cube &cube, QString symbol, bool meta, FilterSet &fs)
+{
+    cube.days.clear();
+    cube.months.clear();
+    cube.dirty.clear();
+
+    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+
+        int day = item->dateTime.date().toJulianDay();
+        rideDay.insert(item, day);
+
+        if (!fs.pass(item->fileName)) continue;
+
+        bool counted;
+        double v = value(item, symbol, meta, counted);
+        cube.days[day].add(v, item->getForSymbol("workout_time"), counted);
+    }
+
+    QMapIterator<int, Bucket> it(cube.days);
+    while (it.hasNext()) {
+        it.next();
+        cube.months[monthFor(it.key())].merge(it.value());
+    }
+    cube.built = true;
+}
+
+void
+MetricRollup::update(Cube &cube, QString symbol, bool meta, FilterSet &fs)
+{
+    if (!cube.built || cube.dirty.count() > METRICROLLUP_DIRTY) {
+        build(cube, symbol, meta, fs);
+        return;
+    }
+    if (cube.dirty.isEmpty()) return;
+
+    // recompute the days that changed
+    QSet<int> months;
+    foreach(int day, cube.dirty) {
+        cube.days.remove(day);
+        months.insert(monthFor(day));
+    }
+
+    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+
+        int day = item->dateTime.date().toJulianDay();
+        if (!cube.dirty.contains(day) || !fs.pass(item->fileName)) continue;
+
+        bool counted;
+        double v = value(item, symbol, meta, counted);
+        cube.days[day].add(v, item->getForSymbol("workout_time"), counted);
+    }
+    cube.dirty.clear();
+
+    // and the months they are in
+    foreach(int month, months) {
+
+        int year = (month-1) / 12;
+        QDate first(year, month - (year*12), 1);
+        int from = first.toJulianDay();
+        int to = first.addMonths(1).toJulianDay();
+
+        Bucket add;
+        QMap<int, Bucket>::const_iterator it = cube.days.lowerBound(from);
+        for (; it != cube.days.constEnd() && it.key() < to; ++it) add.merge(it.value());
+
+        if (add.count) cube.months.insert(month, add);
+        else cube.months.remove(month);
+    }
+}
+
+QMap<int, MetricRollup::Bucket>
+MetricRollup::days(QString symbol, bool meta, FilterSet fs, QDate from, QDate to)
+{
+    Cube &c = cube(symbol, meta, fs);
+
+    QMap<int, Bucket> returning;
+    QMap<int, Bucket>::const_iterator it = from.isValid() ? c.days.lowerBound(from.toJulianDay())
+                                                          : c.days.constBegin();
+    for (; it != c.days.constEnd(); ++it) {
+        if (to.isValid() && it.key() > to.toJulianDay()) break;
+        returning.insert(it.key(), it.value());
+    }
+    return returning;
+}
+
+QMap<int, MetricRollup::Bucket>
+MetricRollup::months(QString symbol, bool meta, FilterSet fs, QDate from, QDate to)
+{
+    Cube &c = cube(symbol, meta, fs);
+
+    int fromDay = from.isValid() ? from.toJulianDay() : 0;
+    int toDay = to.isValid() ? to.toJulianDay() : 0;
+
+    QMap<int, Bucket> returning;
+    QMap<int, Bucket>::const_iterator it = from.isValid() ? c.months.lowerBound(monthFor(fromDay))
+                                                          : c.months.constBegin();
+    for (; it != c.months.constEnd(); ++it) {
+
+        if (to.isValid() && it.key() > monthFor(toDay)) break;
+
+        int year = (it.key()-1) / 12;
+        QDate first(year, it.key() - (year*12), 1);
+        int start = first.toJulianDay();
+        int end = first.addMonths(1).toJulianDay() - 1;
+
+        // whole month in the range
+        if ((!from.isValid() || start >= fromDay) && (!to.isValid() || end <= toDay)) {
+            returning.insert(it.key(), it.value());
+            continue;
+        }
+
+        // part of a month, so from the days
+        if (from.isValid() && start < fromDay) start = fromDay;
+        if (to.isValid() && end > toDay) end = toDay;
+
+        Bucket add;
+        QMap<int, Bucket>::const_iterator d = c.days.lowerBound(start);
+        for (; d != c.days.constEnd() && d.key() <= end; ++d) add.merge(d.value());
+        if (add.count) returning.insert(it.key(), add);
+    }
+    return returning;
+}
+
+MetricRollup::Bucket
+MetricRollup::total(QString symbol, bool meta, Specification spec)
+{
+    DateRange dr = spec.dateRange();
+
+    Bucket returning;
+    foreach(Bucket month, months(symbol, meta, spec.filterSet(), dr.from, dr.to)) returning.merge(month);
+    return returning;
+}
+
+void
+MetricRollup::dirty(int day)
+{
+    QMutableHashIterator<QString, Cube> it(cubes);
+    while (it.hasNext()) {
+        it.next();
+        if (it.value().built) it.value().dirty.insert(day);
+    }
+}
+
+void
+MetricRollup::rideAdded(RideItem *item)
+{
+    int day = item->dateTime.date().toJulianDay();
+    rideDay.insert(item, day);
+    dirty(day);
+}
+
+void
+MetricRollup::rideDeleted(RideItem *item)
+{
+    dirty(rideDay.value(item, item->dateTime.date().toJulianDay()));
+    dirty(item->dateTime.date().toJulianDay());
+    rideDay.remove(item);
+}
+
+void
+MetricRollup::itemChanged(RideItem *item)
+{
+    // the date may have changed too
+    int day = item->dateTime.date().toJulianDay();
+    if (rideDay.contains(item) && rideDay.value(item) != day) dirty(rideDay.value(item));
+    rideDay.insert(item, day);
+    dirty(day);
+}
+
+void
+MetricRollup::refreshed()
+{
+    // metrics were recomputed, start again
+    cubes.clear();
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MetricRollup_h
+#define _GC_MetricRollup_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QString>
+#include <QDate>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+
+#include "Specification.h"
+
+class Context;
+class RideItem;
+
+// most filtered rollups we keep before starting again
+#define METRICROLLUP_MAX 64
+
+//
+// Pre-aggregated metric values by day and month, for the trend charts
+// and the date range summaries.
+//
+// Rather than every chart curve visiting every ride on every refresh we
+// keep per metric (and filter) the aggregate of the rides on each day, and
+// of each month, so a query is proportional to the number of buckets
+// that are plotted. They are built on first use and maintained as rides
+// are added, deleted or changed.
+//
+// Values are held as stored (metric units), conversion to imperial or
+// from seconds to hours is linear so is applied by the caller.
+//
+class MetricRollup : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        // the aggregate of a set of rides
+        struct Bucket {
+            Bucket() : count(0), nonzero(0), counted(0), sum(0), csum(0), wsum(0), seconds(0),
+                       min(0), max(0), nzmin(0), nzmax(0) {}
+
+            int count;          // rides
+            int nonzero;        // rides with a non-zero value
+            int counted;        // rides included in the average
+            double sum;         // of all values
+            double csum, wsum;  // of counted values, and weighted by duration
+            double seconds;     // duration of counted rides
+            double min, max;    // of all rides
+            double nzmin, nzmax;// of rides with a non-zero value
+
+            void add(double value, double seconds, bool counted);
+            void merge(const Bucket &other);
+
+            // duration weighted mean, so short rides don't skew it
+            double mean() const;
+        };
+
+        MetricRollup(Context *context);
+
+        // rides passing the filter between the dates (inclusive) by julian day
+        QMap<int, Bucket> days(QString symbol, bool meta, FilterSet fs, QDate from, QDate to);
+
+        // by month (year*12 + month), using whole months where we can
+        QMap<int, Bucket> months(QString symbol, bool meta, FilterSet fs, QDate from, QDate to);
+
+        // all rides passing the specification
+        Bucket total(QString symbol, bool meta, Specification spec);
+
+    public slots:
+
+        // keeping up to date
+        void rideAdded(RideItem *);
+        void rideDeleted(RideItem *);
+        void itemChanged(RideItem *);
+        void refreshed();
+
+    private:
+
+        struct Cube {
+            Cube() : built(false) {}
+
+            bool built;
+            QMap<int, Bucket> days;   // julian day
+            QMap<int, Bucket> months; // year*12 + month
+            QSet<int> dirty;          // days to recompute
+        };
+
+        Context *context;
+        QHash<QString, Cube> cubes; // symbol, meta and filter
+        QHash<RideItem*, int> rideDay; // day each ride was last aggregated
+
+        static QString key(QString symbol, bool meta, FilterSet &fs);
+        static int monthFor(int julianDay);
+
+        Cube &cube(QString symbol, bool meta, FilterSet &fs);
+        void build(Cube &cube, QString symbol, bool meta, FilterSet &fs);
+        void update(Cube &cube, QString symbol, bool meta, FilterSet &fs);
+        void dirty(int day);
+        double value(RideItem *item, QString symbol, bool meta, bool &counted);
+};
+
+#endif // _GC_MetricRollup_h
@@ -18,6 +18,21 @@
 
 #include "PDModel.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QByteArray>
+
+#if QT_VERSION > 0x050000
+# include <QtConcurrent>
+#else
+# include <QtConcurrentMap>
+#endif
+
+// memoised fits, shared by all models on all threads
+static QMutex fitLock;
+static QHash<QString, QList<double> > fits;
+
 // base class for all models
 PDModel::PDModel(Context *context) :
     QwtSyntheticPointData(PDMODEL_MAXT),
@@ -30,6 +45,17 @@ PDModel::PDModel(Context *context) :
     setSize(PDMODEL_MAXT);
 }
 
+// the hash and a crc together, so different curves
+// are very unlikely to be mistaken for each other
+static QString
+hashOf(const QVector<double> &data)
+{
+    const char *bytes = (const char*)data.constData();
+    uint len = data.size() * sizeof(double);
+    return QString("%1:%2:%3").arg(data.size()).arg(qHash(QByteArray::fromRawData(bytes, len)))
+                              .arg(qChecksum(bytes, len));
+}
+
 // set data using doubles always
 void 
 PDModel::setData(QVector<double> meanMaxPower)
@@ -37,6 +63,7 @@ PDModel::setData(QVector<double> meanMaxPower)
     cp = tau = t0 = 0; // reset on new data
     data.resize(meanMaxPower.size());
     data = meanMaxPower;
+    dataHash = hashOf(data);
     emit dataChanged();
 }
 
@@ -73,6 +100,7 @@ PDModel::setData(QVector<float> meanMaxPower)
     cp = tau = t0 = 0; // reset on new data
     data.resize(meanMaxPower.size());
     for (int i=0; i< data.size(); i++) data[i] = meanMaxPower[i];
+    dataHash = hashOf(data);
     emit dataChanged();
 }
 
@@ -93,6 +121,58 @@ PDModel::setIntervals(double sanI1, double sanI2, double anI1, double anI2,
     emit intervalsChanged();
 }
 
+void
+PDModel::forgetFits()
+{
+    QMutexLocker locker(&fitLock);
+    fits.clear();
+}
+
+QList<double>
+PDModel::cpStart() const
+{
+    // deriveCPParameters() re-estimates cp from tau on every pass and
+    // always starts t0 at zero, so only tau matters, zero means 1
+    QList<double> start;
+    start << (tau == 0 ? 1 : tau);
+    return start;
+}
+
+bool
+PDModel::recall(QString stage, QList<double> start)
+{
+    // the fit depends upon the data and the intervals we search
+    // and for the iterative fits where we start from as well
+    fitKey = QString("%1:%2:%3:%4").arg(code()).arg(stage).arg(minutes ? 1 : 0).arg(dataHash);
+
+    double intervals[8] = { sanI1, sanI2, anI1, anI2, aeI1, aeI2, laeI1, laeI2 };
+    for (int i=0; i<8; i++) fitKey += QString(":%1").arg(intervals[i], 0, 'g', 17);
+    foreach(double value, start) fitKey += QString(":%1").arg(value, 0, 'g', 17);
+
+    QMutexLocker locker(&fitLock);
+    QHash<QString, QList<double> >::const_iterator it = fits.constFind(fitKey);
+    if (it == fits.constEnd()) return false;
+
+    QList<double> parameters = it.value();
+    locker.unlock();
+
+    loadParameters(parameters);
+    return true;
+}
+
+void
+PDModel::remember()
+{
+    QList<double> parameters;
+    saveParameters(parameters);
+
+    QMutexLocker locker(&fitLock);
+
+    // curves come and go, don't keep them all
+    if (fits.count() >= PDMODEL_FITS) fits.clear();
+    fits.insert(fitKey, parameters);
+}
+
 // using the data and intervals from above, derive the
 // cp, tau and t0 values needed for the model
 // this is the function originally found in CPPlot
@@ -110,6 +190,9 @@ PDModel::deriveCPParameters(bool three)
     // bounds of these time values in the data
     int i1, i2, i3, i4;
 
+    // nothing fitted if the data is too short
+    cp = t0 = 0;
+
     // find the indexes associated with the bounds
     // the first point must be at least the minimum for the anaerobic interval, or quit
     for (i1 = 0; i1 < t1; i1++)
@@ -239,14 +322,20 @@ void CP2Model::onDataChanged()
 { 
     // calc tau etc and make sure the interval is
     // set correctly - i.e. 'domain of validity'
-    deriveCPParameters(); 
+    if (!recall("fit", cpStart())) {
+        deriveCPParameters(); 
+        remember();
+    }
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 
 }
 
 void CP2Model::onIntervalsChanged() 
 { 
-    deriveCPParameters(); 
+    if (!recall("fit", cpStart())) {
+        deriveCPParameters(); 
+        remember();
+    }
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 }
 
@@ -310,14 +399,20 @@ void CP3Model::onDataChanged()
 { 
     // calc tau etc and make sure the interval is
     // set correctly - i.e. 'domain of validity'
-    deriveCPParameters(true); 
+    if (!recall("fit", cpStart())) {
+        deriveCPParameters(true); 
+        remember();
+    }
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 
 }
 
 void CP3Model::onIntervalsChanged() 
 { 
-    deriveCPParameters(true); 
+    if (!recall("fit", cpStart())) {
+        deriveCPParameters(true); 
+        remember();
+    }
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 }
 
@@ -362,6 +457,7 @@ MultiModel::MultiModel(Context *context) :
     aeI2=3600;
 
     variant = 0; // use exp top/bottom by default.
+    w1 = p1 = p2 = tau1 = tau2 = alpha = beta = 0;
 
     connect (this, SIGNAL(dataChanged()), this, SLOT(onDataChanged()));
     connect (this, SIGNAL(intervalsChanged()), this, SLOT(onIntervalsChanged()));
@@ -450,6 +546,10 @@ void MultiModel::onDataChanged()
 { 
     // calc tau etc and make sure the interval is
     // set correctly - i.e. 'domain of validity'
+    if (recall("data", cpStart())) {
+        setInterval(QwtInterval(tau, PDMODEL_MAXT));
+        return;
+    }
     deriveCPParameters(true); 
 
     // and veloclinic parameters too;
@@ -466,11 +566,17 @@ void MultiModel::onDataChanged()
     // the resulting W' is higher.
     //w1 = (cp + (cp-CP())) * tau * 60;
 
+    remember();
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 }
 
 void MultiModel::onIntervalsChanged() 
 { 
+    // W' below depends upon the variant
+    if (recall(QString("intervals%1").arg(variant), cpStart())) {
+        setInterval(QwtInterval(tau, PDMODEL_MAXT));
+        return;
+    }
     deriveCPParameters(true); 
 
     // and veloclinic paramters too;
@@ -487,7 +593,7 @@ void MultiModel::onIntervalsChanged()
     // the resulting W' is higher.
     w1 = (cp + (cp-CP())) * tau * 60;
 
-
+    remember();
     setInterval(QwtInterval(tau, PDMODEL_MAXT));
 }
 
@@ -507,6 +613,8 @@ ExtendedModel::ExtendedModel(Context *context) :
     laeI1=3600;
     laeI2=30000;
 
+    paa = paa_dec = ecp = etau = ecp_del = tau_del = ecp_dec = ecp_dec_del = 0;
+
     connect (this, SIGNAL(dataChanged()), this, SLOT(onDataChanged()));
     connect (this, SIGNAL(intervalsChanged()), this, SLOT(onIntervalsChanged()));
 }
@@ -563,7 +671,10 @@ ExtendedModel::onDataChanged()
 {
     // calc tau etc and make sure the interval is
     // set correctly - i.e. 'domain of validity'
-    deriveExtCPParameters();
+    if (!recall("fit")) {
+        deriveExtCPParameters();
+        remember();
+    }
     setInterval(QwtInterval(etau, PDMODEL_MAXT));
 
 }
@@ -571,7 +682,10 @@ ExtendedModel::onDataChanged()
 void
 ExtendedModel::onIntervalsChanged()
 {
-    deriveExtCPParameters();
+    if (!recall("fit")) {
+        deriveExtCPParameters();
+        remember();
+    }
     setInterval(QwtInterval(etau, PDMODEL_MAXT));
 }
 
@@ -597,6 +711,9 @@ ExtendedModel::deriveExtCPParameters()
     // bounds of these time values in the data
     int i1, i2, i3, i4, i5, i6, i7, i8;
 
+    // nothing fitted if the data is too short
+    paa = paa_dec = ecp = etau = ecp_del = tau_del = ecp_dec = ecp_dec_del = 0;
+
     // find the indexes associated with the bounds
     // the first point must be at least the minimum for the anaerobic interval, or quit
     for (i1 = 0; i1 < t1; i1++)
@@ -668,6 +785,28 @@ ExtendedModel::deriveExtCPParameters()
     // maximum number of loops
     const int max_loops = 100;
 
+    // terms that don't change from one iteration to the next are
+    // computed once up front, for i up to i6 and for the long aerobic
+    // samples every 120s from i7, the same expressions as before
+    const int n = qMax(i6, 8) + 1;
+    const int m = (i8 >= i7) ? ((i8 - i7) / 120) + 1 : 0;
+    QVector<double> sA(n), sT(n), sE(n), sD(n);
+    QVector<double> lA(m), lT(m), lE(m), lD(m);
+    for (int i = 0; i < n; i++) {
+        sA[i] = (1.20-0.20*exp(-1*(i/60.0)));
+        sT[i] = (1-exp(tau_del*i/60.0));
+        sE[i] = (1-exp(ecp_del*i/60.0));
+        sD[i] = exp(ecp_dec_del/(i/60.0));
+    }
+    for (int j = 0; j < m; j++) {
+        int i = i7 + (j * 120);
+        lA[j] = (1.20-0.20*exp(-1*(i/60.0)));
+        lT[j] = (1-exp(tau_del*i/60.0));
+        lE[j] = (1-exp(ecp_del*i/60.0));
+        lD[j] = exp(ecp_dec_del/(i / 60.0));
+    }
+    const double *A = sA.constData(), *T = sT.constData(), *E = sE.constData(), *D = sD.constData();
+
     // loop to convergence
     int iteration = 0;
     do {
@@ -686,7 +825,7 @@ ExtendedModel::deriveExtCPParameters()
         int i;
         ecp = 0;
         for (i = i5; i <= i6; i++) {
-            double ecpn = (data[i] - paa * (1.20-0.20*exp(-1*(i/60.0))) * exp(paa_dec*(i/60.0))) / (1-exp(tau_del*i/60.0)) / (1-exp(ecp_del*i/60.0)) / (1+ecp_dec*exp(ecp_dec_del/(i/60.0))) / ( 1 + etau/(i/60.0));
+            double ecpn = (data[i] - paa * A[i] * exp(paa_dec*(i/60.0))) / T[i] / E[i] / (1+ecp_dec*D[i]) / ( 1 + etau/(i/60.0));
 
             if (ecp < ecpn)
                 ecp = ecpn;
@@ -700,7 +839,7 @@ ExtendedModel::deriveExtCPParameters()
         // estimate etau, given ecp
         etau = etau_min;
         for (i = i3; i <= i4; i++) {
-            double etaun = ((data[i] - paa * (1.20-0.20*exp(-1*(i/60.0))) * exp(paa_dec*(i/60.0))) / ecp / (1-exp(tau_del*i/60.0)) / (1-exp(ecp_del*i/60.0)) / (1+ecp_dec*exp(ecp_dec_del/(i/60.0))) - 1) * (i/60.0);
+            double etaun = ((data[i] - paa * A[i] * exp(paa_dec*(i/60.0))) / ecp / T[i] / E[i] / (1+ecp_dec*D[i]) - 1) * (i/60.0);
 
             if (etau < etaun)
                 etau = etaun;
@@ -709,7 +848,7 @@ ExtendedModel::deriveExtCPParameters()
         // estimate paa_dec
         paa_dec = paa_dec_min;
         for (i = i1; i <= i2; i++) {
-            double paa_decn = log((data[i] - ecp * (1-exp(tau_del*i/60.0)) * (1-exp(ecp_del*i/60.0)) * (1+ecp_dec*exp(ecp_dec_del/(i/60.0))) * ( 1 + etau/(i/60.0)) ) / paa / (1.20-0.20*exp(-1*(i/60.0))) ) / (i/60.0);
+            double paa_decn = log((data[i] - ecp * T[i] * E[i] * (1+ecp_dec*D[i]) * ( 1 + etau/(i/60.0)) ) / paa / A[i] ) / (i/60.0);
 
             if (paa_dec < paa_decn && paa_decn < paa_dec_max) {
                 paa_dec = paa_decn;
@@ -720,7 +859,7 @@ ExtendedModel::deriveExtCPParameters()
         double _avg_paa = 0.0;
         int count=1;
         for (i = 2; i <= 8; i++) {
-            double paan = (data[i] - ecp * (1-exp(tau_del*i/60.0)) * (1-exp(ecp_del*i/60.0)) * (1+ecp_dec*exp(ecp_dec_del/(i/60.0))) * ( 1 + etau/(i/60.0))) / exp(paa_dec*(i/60.0)) / (1.20-0.20*exp(-1*(i/60.0)));
+            double paan = (data[i] - ecp * T[i] * E[i] * (1+ecp_dec*D[i]) * ( 1 + etau/(i/60.0))) / exp(paa_dec*(i/60.0)) / A[i];
             _avg_paa = (double)((count-1)*_avg_paa+paan)/count;
 
             if (paa < paan)
@@ -733,8 +872,9 @@ ExtendedModel::deriveExtCPParameters()
 
 
         ecp_dec = ecp_dec_min;
-        for (i = i7; i <= i8; i=i+120) {
-            double ecp_decn = ((data[i] - paa * (1.20-0.20*exp(-1*(i/60.0))) * exp(paa_dec*(i/60.0))) / ecp / (1-exp(tau_del*i/60.0)) / (1-exp(ecp_del*i/60.0)) / ( 1 + etau/(i/60.0)) -1 ) / exp(ecp_dec_del/(i / 60.0));
+        for (int j = 0; j < m; j++) {
+            i = i7 + (j * 120);
+            double ecp_decn = ((data[i] - paa * lA[j] * exp(paa_dec*(i/60.0))) / ecp / lT[j] / lE[j] / ( 1 + etau/(i/60.0)) -1 ) / lD[j];
 
             if (ecp_decn > 0) ecp_decn = 0;
 
@@ -862,3 +1002,68 @@ void CP3Model::saveParameters(QList<double>&here)
     here << tau;
     here << t0;
 }
+
+//
+// Fitting all the models to the bests for a date range
+//
+static void
+addEstimate(QList<PDEstimate> &here, PDModel *model, const PDFit &bests, bool wpk)
+{
+    PDEstimate add;
+
+    // set the data
+    if (wpk) model->setData(bests.wpk);
+    else model->setData(bests.power);
+    model->saveParameters(add.parameters); // save the computed parms
+
+    add.wpk = wpk;
+    add.from = bests.from;
+    add.to = bests.to;
+    add.model = model->code();
+    add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
+    add.CP = model->hasCP() ? model->CP() : 0;
+    add.PMax = model->hasPMax() ? model->PMax() : 0;
+    add.FTP = model->hasFTP() ? model->FTP() : 0;
+
+    if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+
+    // so long as the important model derived values are sensible ...
+    if (!wpk && add.WPrime > 1000 && add.CP > 100) here << add;
+    if (wpk && add.WPrime > 100.0f && add.CP > 1.0f && add.PMax > 1.0f && add.FTP > 1.0f) here << add;
+}
+
+QList<PDEstimate>
+PDFit::fit(const PDFit &bests)
+{
+    QList<PDEstimate> returning;
+
+    // the models we support, created on the thread
+    // we're running on so the signals are delivered directly
+    CP2Model p2model(bests.context);
+    CP3Model p3model(bests.context);
+    MultiModel multimodel(bests.context);
+    ExtendedModel extmodel(bests.context);
+
+    QList <PDModel *> models;
+    models << &p2model;
+    models << &p3model;
+    models << &multimodel;
+    models << &extmodel;
+
+    foreach(PDModel *model, models) {
+        addEstimate(returning, model, bests, false);
+        addEstimate(returning, model, bests, true);
+    }
+    return returning;
+}
+
+QList<PDEstimate>
+PDFit::fitAll(QList<PDFit> bests)
+{
+    // each date range is independent
+    QList<QList<PDEstimate> > fitted = QtConcurrent::blockingMapped(bests, PDFit::fit);
+
+    QList<PDEstimate> returning;
+    foreach(QList<PDEstimate> estimates, fitted) returning << estimates;
+    return returning;
+}
@@ -18,6 +18,9 @@
 
 #include <QObject>
 #include <QString>
+#include <QVector>
+#include <QList>
+#include <QDate>
 
 #include "Context.h"
 
@@ -53,9 +56,16 @@
 //
 // 6. The setIntervals method can be used to setup the intervals the
 //    base derviceCPparameters will use
+//
+// 7. Fits are memoised across all models by curve, intervals and any
+//    starting values the fit depends upon, since the same bests are
+//    fitted over and over by the CP chart, ride summary and trends.
+//    A subclass checks recall() before deriving and calls remember()
+//    when done. Models can be used from any thread.
 
 #define PDMODEL_MAXT 18000 // maximum value for t we will provide p(t) for
 #define PDMODEL_INTERVAL 1 // intervals used in seconds; 0t, 1t, 2t .. 18000t
+#define PDMODEL_FITS 4096  // fits remembered before starting again
 
 class PDModel : public QObject, public QwtSyntheticPointData
 {
@@ -103,12 +113,22 @@ class PDModel : public QObject, public QwtSyntheticPointData
 
         bool inverseTime;
 
+        // forget all the memoised fits
+        static void forgetFits();
+
     protected:
 
+        // memoised fits, recall() loads the parameters if we have
+        // fitted this before, otherwise remember() once derived
+        // start holds any starting values the fit depends upon
+        bool recall(QString stage, QList<double> start = QList<double>());
+        void remember();
+
         // using data from setData() and intervals from setIntervals()
         // this is the old function from CPPlot to extract the best points
         // in the data series to calculate cp, tau and t0.
         void deriveCPParameters(bool three=false); 
+        QList<double> cpStart() const; // its starting values for recall()
 
     signals:
 
@@ -130,6 +150,8 @@ class PDModel : public QObject, public QwtSyntheticPointData
 
         // mean max power data set by setData
         QVector<double> data;
+        QString dataHash; // identifies the data for memoised fits
+        QString fitKey; // set by recall()
 
         bool minutes;
 };
@@ -155,6 +177,24 @@ class PDEstimate
                                   // parameters
 };
 
+// bests for a date range to fit all the models to, as used by
+// the trends estimates. Each is independent so we fit many at once
+class PDFit
+{
+    public:
+        PDFit() : context(NULL) {}
+
+        Context *context;
+        QDate from, to;
+        QVector<float> power, wpk; // bests for watts and w/kg
+
+        // estimates from all the models, for power then w/kg
+        static QList<PDEstimate> fit(const PDFit &bests);
+
+        // fitted concurrently, estimates returned in the order given
+        static QList<PDEstimate> fitAll(QList<PDFit> bests);
+};
+
 // 2 parameter model
 class CP2Model : public PDModel
 {
@@ -186,6 +186,14 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     configLayout->addWidget(hystlabel, 7,0, Qt::AlignRight);
     configLayout->addWidget(hystedit, 7,1, Qt::AlignLeft);
 
+    // memory for open rides GC_RIDEMEMORY, 0 is no limit
+    QLabel *memoryLabel = new QLabel(tr("Memory for open activities (MB):"));
+    memoryEdit = new QLineEdit(appsettings->value(this, GC_RIDEMEMORY, 512).toString(),this);
+    memoryEdit->setValidator(new QIntValidator(0, 65536, this));
+
+    configLayout->addWidget(memoryLabel, 5,0, Qt::AlignRight);
+    configLayout->addWidget(memoryEdit, 5,1, Qt::AlignLeft);
+
     // wbal formula preference
     QLabel *wbalFormLabel = new QLabel(tr("W' bal formula:"));
     wbalForm = new QComboBox(this);
@@ -306,6 +314,7 @@ GeneralPage::saveClicked()
     appsettings->setValue(GC_WORKOUTDIR, workoutDirectory->text());
     appsettings->setValue(GC_HOMEDIR, athleteDirectory->text());
     appsettings->setValue(GC_ELEVATION_HYSTERESIS, hystedit->text());
+    appsettings->setValue(GC_RIDEMEMORY, memoryEdit->text().toInt());
 
     // wbal formula
     appsettings->setValue(GC_WBALFORM, wbalForm->currentIndex() ? "int" : "diff");
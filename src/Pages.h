@@ -76,6 +76,7 @@ class GeneralPage : public QWidget
         QLineEdit *wheelSizeEdit;
         QLineEdit *garminHWMarkedit;
         QLineEdit *hystedit;
+        QLineEdit *memoryEdit;
         QLineEdit *athleteDirectory;
         QLineEdit *workoutDirectory;
         QPushButton *workoutBrowseButton;
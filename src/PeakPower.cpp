@@ -17,7 +17,7 @@
  */
 
 #include "RideMetric.h"
-#include "BestIntervalDialog.h"
+#include "IntervalSearch.h"
 #include "Zones.h"
 #include <cmath>
 #include <QApplication>
@@ -132,9 +132,8 @@ class PeakPower : public RideMetric {
                  const Context *) {
 
         if (!ride->dataPoints().isEmpty()) {
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0 && results.first().avg < 3000) watts = results.first().avg;
+            IntervalSearch::Result best = IntervalSearch(ride).peak(secs);
+            if (best.isValid() && best.avg < 3000) watts = best.avg;
             else watts = 0.0;
         } else {
             watts = 0.0;
@@ -433,18 +432,13 @@ class PeakPowerHr : public RideMetric {
                  const QHash<QString,RideMetric*> &, const Context *) {
 
         if (!ride->dataPoints().isEmpty()){
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0) {
-                double start = results.first().start;
-                double stop = results.first().stop;
+            IntervalSearch::Result best = IntervalSearch(ride).peak(secs);
+            if (best.isValid()) {
                 int points = 0;
 
-                foreach(const RideFilePoint *point, ride->dataPoints()) {
-                    if (point->secs >= start && point->secs < stop) {
-                        points++;
-                        hr = (point->hr + (points-1)*hr) / (points);
-                    }
+                for (int i=best.begin; i<=best.end; i++) {
+                    points++;
+                    hr = (ride->dataPoints()[i]->hr + (points-1)*hr) / (points);
                 }
             }
         } else {
@@ -65,7 +65,7 @@ public:
         const Zones *zones;
         int zone_range = -1;
 
-        if (parent->context->isCompareIntervals) {
+        if (!parent->rangemode && parent->context->isCompareIntervals) {
 
             zones = parent->context->athlete->zones();
             if (!zones) return;
@@ -83,6 +83,12 @@ public:
             zones = parent->context->athlete->zones();
             zone_range = zones->whichRange(rideItem->dateTime.date());
 
+        } else if (parent->rangemode && parent->context->athlete->zones()) {
+
+            zones = parent->context->athlete->zones();
+            zone_range = zones->whichRange(parent->rangeTo);
+            if (zone_range == -1) zone_range = zones->whichRange(QDate::currentDate());
+
         } else {
 
             return; // nulls
@@ -144,7 +150,7 @@ public:
 
 
 PfPvPlot::PfPvPlot(Context *context)
-    : rideItem (NULL), context(context), hover(NULL), cp_ (0), cad_ (85), cl_ (0.175), shade_zones(true)
+    : rideItem (NULL), context(context), hover(NULL), cp_ (0), cad_ (85), cl_ (0.175), shade_zones(true), rangemode(false)
 {
     static_cast<QwtPlotCanvas*>(canvas())->setFrameStyle(QFrame::NoFrame);
 
@@ -294,7 +300,7 @@ PfPvPlot::refreshZoneItems()
     int zone_range = -1;
 
     // comparing does zones for items selected not current ride
-    if (context->isCompareIntervals) {
+    if (!rangemode && context->isCompareIntervals) {
 
         // no athlete zones anyway!
         if (!zones) return;
@@ -313,6 +319,12 @@ PfPvPlot::refreshZoneItems()
 
         zone_range = zones->whichRange(rideItem->dateTime.date());
 
+    } else if (rangemode && zones) {
+
+        // zones at the end of the date range
+        zone_range = zones->whichRange(rangeTo);
+        if (zone_range == -1) zone_range = zones->whichRange(QDate::currentDate());
+
     } else {
 
         return; // null ride and not compare etc
@@ -522,6 +534,7 @@ PfPvPlot::setData(RideItem *_rideItem)
     }
 
     rideItem = _rideItem;
+    rangemode = false;
     RideFile *ride = rideItem->ride();
 
     if (ride) {
@@ -677,6 +690,74 @@ PfPvPlot::setData(RideItem *_rideItem)
     replot();
 }
 
+void
+PfPvPlot::setData(RideFileCache *cache, QDate to)
+{
+    // no ride, no intervals, no gear ratios
+    foreach(QwtPlotCurve *c, intervalCurves) {
+        c->detach();
+        delete c;
+    }
+    intervalCurves.clear();
+    foreach(QwtPlotCurve *c, gearRatioCurves) {
+        c->detach();
+        delete c;
+    }
+    gearRatioCurves.clear();
+    if (hover) {
+        hover->detach();
+        delete hover;
+        hover = NULL;
+    }
+
+    rideItem = NULL;
+    rangemode = true;
+    rangeTo = to;
+    range = cache->jointDistribution(RideFileJoint::powerCad);
+
+    // one point for each cell we spent any time in, they're
+    // already unique so no need to strip out duplicates
+    QwtArray<double> aepfArray;
+    QwtArray<double> cpvArray;
+    double tot_cad = 0;
+    double tot_secs = 0;
+
+    for (int i=0; i<range.cells.size(); i++) {
+
+        double watts = RideFileJoint::x(RideFileJoint::powerCad, range.cells[i]);
+        double cad = RideFileJoint::y(RideFileJoint::powerCad, range.cells[i]);
+
+        double aepf = (watts * 60.0) / (cad * cl_ * 2.0 * PI);
+        double cpv = (cad * cl_ * 2.0 * PI) / 60.0;
+
+        if (aepf <= 2500) { // > 2500 newtons is our out of bounds
+            aepfArray.append(aepf);
+            cpvArray.append(cpv);
+            tot_cad += cad * range.secs[i];
+            tot_secs += range.secs[i];
+        }
+    }
+
+    setCAD(tot_secs ? tot_cad / tot_secs : 0);
+
+    curve->setSamples(cpvArray, aepfArray);
+
+    QwtSymbol *sym = new QwtSymbol;
+    sym->setStyle(QwtSymbol::Ellipse);
+    sym->setSize(4);
+    sym->setPen(QPen(Qt::red));
+    sym->setBrush(QBrush(Qt::red));
+    curve->setSymbol(sym);
+    curve->setStyle(QwtPlotCurve::Dots);
+    curve->setRenderHint(QwtPlotItem::RenderAntialiased);
+
+    refreshZoneItems();
+    refreshIntervalMarkers(); // clears them
+    mainCurvesSetVisible(tot_secs > 0);
+
+    replot();
+}
+
 void
 PfPvPlot::intervalHover(RideFileInterval x)
 {
@@ -1012,7 +1093,7 @@ void
 PfPvPlot::recalc()
 {
     // we're for a ride only..
-    if (context->isCompareIntervals) {
+    if (!rangemode && context->isCompareIntervals) {
         recalcCompare();
         return;
     }
@@ -1024,8 +1105,23 @@ PfPvPlot::recalc()
     maxAEPF = 600;
     maxCPV = 3;
 
-    RideFile *ride;
-    if (rideItem && (ride=rideItem->ride())) {
+    RideFile *ride = NULL;
+    if (rangemode) {
+
+        // calculate maximums from the joint distribution
+        for (int i=0; i<range.cells.size(); i++) {
+
+            double watts = RideFileJoint::x(RideFileJoint::powerCad, range.cells[i]);
+            double cad = RideFileJoint::y(RideFileJoint::powerCad, range.cells[i]);
+
+            double aepf = (watts * 60.0) / (cad * cl_ * 2.0 * PI);
+            double cpv = (cad * cl_ * 2.0 * PI) / 60.0;
+
+            if (aepf < 255 && aepf > maxAEPF) maxAEPF = aepf;
+            if (cpv > maxCPV) maxCPV = cpv;
+        }
+
+    } else if (rideItem && (ride=rideItem->ride())) {
 
         // calculate maximums
         foreach(const RideFilePoint *p1, ride->dataPoints()) {
@@ -1083,14 +1179,29 @@ PfPvPlot::recalc()
     mY->setYValue(aepf);
 
     // watch out for null rides
-    if (rideItem && (ride=rideItem->ride())) {
+    if (rangemode || (rideItem && (ride=rideItem->ride()))) {
 
         timeInQuadrant[0]=
         timeInQuadrant[1]=
         timeInQuadrant[2]=
         timeInQuadrant[3]= 0.0;
 
-        foreach(const RideFilePoint *p1, ride->dataPoints()) {
+        // time in each cell of the date range
+        for (int i=0; rangemode && i<range.cells.size(); i++) {
+
+            double watts = RideFileJoint::x(RideFileJoint::powerCad, range.cells[i]);
+            double cad = RideFileJoint::y(RideFileJoint::powerCad, range.cells[i]);
+
+            double aepf_ = (watts * 60.0) / (cad * cl_ * 2.0 * PI);
+            double cpv_ = (cad * cl_ * 2.0 * PI) / 60.0;
+
+            if (aepf_ > aepf && cpv_ > cpv) timeInQuadrant[0] += range.secs[i];
+            else if (aepf_ > aepf && cpv_ <= cpv) timeInQuadrant[1] += range.secs[i];
+            else if (aepf_ <= aepf && cpv_ <= cpv) timeInQuadrant[2] += range.secs[i];
+            else if (aepf_ <= aepf && cpv_ > cpv) timeInQuadrant[3] += range.secs[i];
+        }
+
+        if (!rangemode) foreach(const RideFilePoint *p1, ride->dataPoints()) {
             if (p1->watts != 0 && p1->cad != 0) {
 
                 double aepf_ = (p1->watts * 60.0) / (p1->cad * cl_ * 2.0 * PI);
@@ -1235,7 +1346,7 @@ void
 PfPvPlot::setGearRatioDisplay(bool value)
 {
     gear_ratio_display = value;
-    if (context->isCompareIntervals) return;
+    if (!rangemode && context->isCompareIntervals) return;
     mainCurvesSetVisible(true);
     replot();
 }
@@ -1373,6 +1484,7 @@ PfPvPlot::mainCurvesSetVisible(bool visible) {
         }
     }
 
-    curve->setVisible(visible ? !gear_ratio_display : false);
+    // no gear ratios for a date range
+    curve->setVisible(visible ? (!gear_ratio_display || rangemode) : false);
 
 }
@@ -21,6 +21,7 @@
 #define _GC_QaPlot_h 1
 #include "GoldenCheetah.h"
 #include "RideFile.h"
+#include "RideFileCache.h"
 
 #include <qwt_plot.h>
 #include <qwt_point_3d.h>
@@ -45,6 +46,7 @@ class PfPvPlot : public QwtPlot
         PfPvPlot(Context *context);
         void refreshZoneItems();
         void setData(RideItem *_rideItem);
+        void setData(RideFileCache *cache, QDate to); // date range from the joint distribution
         void showIntervals(RideItem *_rideItem);
         void refreshIntervalMarkers();
         void mouseTrack(double cpv, double aepf);
@@ -112,6 +114,11 @@ class PfPvPlot : public QwtPlot
         bool merge_intervals, frame_intervals;
         bool gear_ratio_display;
 
+        // date range mode plots the power/cadence joint distribution
+        bool rangemode;
+        QDate rangeTo; // for zones
+        RideFileJoint range;
+
         double timeInQuadrant[4]; // time in seconds spent in each quadrant
         QwtPlotMarker *tiqMarker[4]; // time in seconds spent in each quadrant
 
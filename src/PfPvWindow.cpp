@@ -22,6 +22,7 @@
 #include "PfPvPlot.h"
 #include "RideItem.h"
 #include "RideFile.h"
+#include "RideFileCache.h"
 #include "Settings.h"
 #include "Colors.h"
 #include "HelpWhatsThis.h"
@@ -72,8 +73,8 @@ PfPvDoubleClickPicker::trackerTextF( const QPointF &pos ) const
     return returning;
 }
 
-PfPvWindow::PfPvWindow(Context *context) :
-    GcChartWindow(context), context(context), current(NULL), compareStale(true), stale(false)
+PfPvWindow::PfPvWindow(Context *context, bool rangemode) :
+    GcChartWindow(context), context(context), current(NULL), compareStale(true), stale(false), rangemode(rangemode)
 {
     QWidget *c = new QWidget;
     HelpWhatsThis *helpConfig = new HelpWhatsThis(c);
@@ -196,19 +197,35 @@ PfPvWindow::PfPvWindow(Context *context) :
     connect(doubleClickPicker, SIGNAL(doubleClicked(int, int)), this, SLOT(doubleClicked(int, int)));
 
     // GC signals
-    connect(this, SIGNAL(rideItemChanged(RideItem*)), this, SLOT(rideSelected()));
-    connect(context, SIGNAL(rideChanged(RideItem*)), this, SLOT(forceReplot()));
-    connect(context, SIGNAL(intervalSelected()), this, SLOT(intervalSelected()));
-    connect(context, SIGNAL(intervalsChanged()), this, SLOT(intervalSelected()));
-    connect(context, SIGNAL(intervalHover(RideFileInterval)), this, SLOT(intervalHover(RideFileInterval)));
+    if (rangemode) {
+
+        // no intervals or gear ratios when plotting a date range
+        mergeIntervalPfPvCheckBox->hide();
+        frameIntervalPfPvCheckBox->hide();
+        gearRatioDisplayPfPvCheckBox->hide();
+        rFrameInterval->hide();
+
+        connect(this, SIGNAL(dateRangeChanged(DateRange)), this, SLOT(dateRangeChanged(DateRange)));
+        connect(context, SIGNAL(filterChanged()), this, SLOT(forceReplot()));
+        connect(context, SIGNAL(homeFilterChanged()), this, SLOT(forceReplot()));
+        connect(context, SIGNAL(refreshEnd()), this, SLOT(forceReplot()));
+
+    } else {
+
+        connect(this, SIGNAL(rideItemChanged(RideItem*)), this, SLOT(rideSelected()));
+        connect(context, SIGNAL(rideChanged(RideItem*)), this, SLOT(forceReplot()));
+        connect(context, SIGNAL(intervalSelected()), this, SLOT(intervalSelected()));
+        connect(context, SIGNAL(intervalsChanged()), this, SLOT(intervalSelected()));
+        connect(context, SIGNAL(intervalHover(RideFileInterval)), this, SLOT(intervalHover(RideFileInterval)));
+
+        // comparing things
+        connect(context, SIGNAL(compareIntervalsStateChanged(bool)), this, SLOT(compareChanged()));
+        connect(context, SIGNAL(compareIntervalsChanged()), this, SLOT(compareChanged()));
+    }
     connect(context->athlete, SIGNAL(zonesChanged()), this, SLOT(zonesChanged()));
     connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
     connect(context, SIGNAL(configChanged(qint32)), pfPvPlot, SLOT(configChanged(qint32)));
 
-    // comparing things
-    connect(context, SIGNAL(compareIntervalsStateChanged(bool)), this, SLOT(compareChanged()));
-    connect(context, SIGNAL(compareIntervalsChanged()), this, SLOT(compareChanged()));
-
     configChanged(CONFIG_APPEARANCE);
     // share current setting with Plot
     setGearRatioDisplayPfPvFromCheckBox();
@@ -223,14 +240,38 @@ PfPvWindow::configChanged(qint32)
 bool
 PfPvWindow::isCompare() const
 {
-    return context->isCompareIntervals;
+    return !rangemode && context->isCompareIntervals;
 }
 
 void
 PfPvWindow::forceReplot()
 {
     stale= true;
-    rideSelected();
+    if (rangemode) dateRangeChanged(myDateRange);
+    else rideSelected();
+}
+
+void
+PfPvWindow::dateRangeChanged(DateRange dateRange)
+{
+    // has it changed?
+    if (dateRange.from != cfrom || dateRange.to != cto)
+        stale = true;
+
+    // don't do it if we're invisible or nothing has changed
+    if (!amVisible() || !stale) return;
+
+    // aggregated joint distributions across the date range
+    RideFileCache cache(context, dateRange.from, dateRange.to, false, QStringList(), true);
+    setIsBlank(cache.jointDistribution(RideFileJoint::powerCad).cells.isEmpty());
+    pfPvPlot->setData(&cache, dateRange.to);
+
+    cfrom = dateRange.from;
+    cto = dateRange.to;
+    stale = false;
+
+    // update the QLabel widget with the CP value for the range
+    qaCPValue->setText(QString("%1").arg(pfPvPlot->getCP()));
 }
 
 void
@@ -67,7 +67,7 @@ class PfPvWindow : public GcChartWindow
 
     public:
 
-        PfPvWindow(Context *context);
+        PfPvWindow(Context *context, bool rangemode = false);
 
         // reveal
         bool hasReveal() { return true; }
@@ -93,6 +93,7 @@ class PfPvWindow : public GcChartWindow
     public slots:
 
         void rideSelected();
+        void dateRangeChanged(DateRange);
         void forceReplot();
         void intervalSelected();
         void intervalHover(RideFileInterval);
@@ -134,6 +135,10 @@ class PfPvWindow : public GcChartWindow
         QCheckBox *rShade, *rMergeInterval, *rFrameInterval;
         bool compareStale;
         bool stale;
+
+        // date range mode uses the joint distributions in the cache
+        bool rangemode;
+        QDate cfrom, cto;
 };
 
 #endif // _GC_PfPvWindow_h
@@ -19,6 +19,7 @@
 #include "PwxRideFile.h"
 #include "Athlete.h"
 #include "Settings.h"
+#include "RideXmlReader.h"
 #include <QDomDocument>
 #include <QVector>
 
@@ -28,410 +29,199 @@ static int pwxFileReaderRegistered =
     RideFileFactory::instance().registerReader(
         "pwx", "TrainingPeaks PWX", new PwxFileReader());
 
-RideFile *
-PwxFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+//
+// The samples, intervals and summary data are handed to a PwxBuilder as
+// readPwx() streams through the file, or through a workout downloaded
+// from TrainingPeaks, it then finishes the ride off
+//
+class PwxBuilder
 {
-    QDomDocument doc("TrainingPeaks PWX");
-    if (!file.open(QIODevice::ReadOnly)) {
-        errors << "Could not open file.";
-        return NULL;
-    }
-
-    bool parsed = doc.setContent(&file);
-    file.close();
-    if (!parsed) {
-        errors << "Could not parse file.";
-        return NULL;
-    }
-
-    return PwxFromDomDoc(doc, errors);
-}
-
-RideFile *
-PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList&) const
+    public:
+        PwxBuilder(RideFile *rideFile);
+
+        void addInterval(RideFileInterval add);
+        void addSample(RideFilePoint &add);
+        RideFile *finish();
+
+        RideFile *rideFile;
+        int intervals;
+
+        // we collect summary data but discard it for all
+        // bar manual ride files where this is all we are
+        // gonna get !
+        double manualDuration;
+        double manualWork;
+        double manualTSS;
+        double manualHR;
+        double manualSpeed;
+        double manualPower;
+        double manualKM;
+        double manualElevation;
+
+    private:
+        // the Smart Recording paramaters
+        QVariant isGarminSmartRecording;
+        QVariant GarminHWM;
+
+        int samples;
+
+        // in case we need to calculate distance
+        double rtime;
+        double rdist;
+};
+
+PwxBuilder::PwxBuilder(RideFile *rideFile) : rideFile(rideFile), intervals(0),
+    manualDuration(0), manualWork(0), manualTSS(0), manualHR(0), manualSpeed(0),
+    manualPower(0), manualKM(0), manualElevation(0), samples(0), rtime(0), rdist(0)
 {
-    RideFile *rideFile = new RideFile();
-    QDomElement root = doc.documentElement();
-    QDomNode workout = root.firstChildElement("workout");
-    QDomNode node = workout.firstChild();
-
     // get the Smart Recording paramaters
-    QVariant isGarminSmartRecording = appsettings->value(NULL, GC_GARMIN_SMARTRECORD,Qt::Checked);
-    QVariant GarminHWM = appsettings->value(NULL, GC_GARMIN_HWMARK);
+    isGarminSmartRecording = appsettings->value(NULL, GC_GARMIN_SMARTRECORD,Qt::Checked);
+    GarminHWM = appsettings->value(NULL, GC_GARMIN_HWMARK);
     if (GarminHWM.isNull() || GarminHWM.toInt() == 0) GarminHWM.setValue(25); // default to 25 seconds.
+}
 
-    // can arrive at any time, so lets cache them
-    // and sort out at the end
-    QDateTime rideDate;
-
-    // we collect summary data but discard it for all
-    // bar manual ride files where this is all we are 
-    // gonna get !
-    double manualDuration = 0.00f;
-    double manualWork = 0.00f;
-    double manualTSS = 0.00f;
-    double manualHR = 0.00f;
-    double manualSpeed = 0.00f;
-    double manualPower = 0.00f;
-    double manualKM = 0.00f;
-    double manualElevation = 0.00f;
-
-    int intervals = 0;
-    int samples = 0;
-
-    // in case we need to calculate distance
-    double rtime = 0;
-    double rdist = 0;
-
-    while (!node.isNull()) {
-
-        // athlete
-        if (node.nodeName() == "athlete") {
-
-            QDomElement name = node.firstChildElement("name");
-            if (!name.isNull()) {
-                rideFile->setTag("Athlete Name", name.text());
-            }
-
-            QDomElement weight = node.firstChildElement("weight");
-            if (!weight.isNull()) {
-                rideFile->setTag("Weight", weight.text());
-            }
-
-        // workout code
-        } else if (node.nodeName() == "code") {
-
-            QDomElement code = node.toElement();
-            rideFile->setTag("Workout Code", code.text());
-
-        // workout title
-        } else if (node.nodeName() == "title") {
-
-            QDomElement title = node.toElement();
-            rideFile->setTag("Workout Title", title.text());
-
-        // goal / objective
-        } else if (node.nodeName() == "goal") {
-
-            QDomElement goal = node.toElement();
-            rideFile->setTag("Objective", goal.text());
-
-        // sport
-        } else if (node.nodeName() == "sportType") {
-
-            QDomElement sport = node.toElement();
-            rideFile->setTag("Sport", sport.text());
-
-        // notes
-        } else if (node.nodeName() == "cmt") {
-
-            // Add the PWX cmt tag as notes
-            QDomElement notes = node.toElement();
-            rideFile->setTag("Notes", notes.text());
-
-        // device type and info
-        } else if (node.nodeName() == "device") {
-
-            QString devicetype;
-            // make and model
-            QDomElement make = node.firstChildElement("make");
-            if (!make.isNull()) devicetype = make.text();
-            QDomElement model = node.firstChildElement("model");
-            if (!model.isNull()) {
-                if (devicetype != "") devicetype += " ";
-                devicetype += model.text();
-            }
-            rideFile->setDeviceType(devicetype);
-            rideFile->setFileFormat("Peaksware Data File (pwx)");
-
-            // device settings data
-            QString deviceinfo;
-            QDomElement extension = node.firstChildElement("extension");
-            if (!extension.isNull()) {
-                for (QDomElement info=extension.firstChildElement();
-                    !info.isNull();
-                    info = info.nextSiblingElement()) {
-                    deviceinfo += info.tagName();
-                    deviceinfo += ": ";
-                    deviceinfo += info.text();
-                    deviceinfo += '\n';
-                }
-            }
-            rideFile->setTag("Device Info", deviceinfo);
-
-        // start date/time
-        } else if (node.nodeName() == "time") {
-            QDomElement date = node.toElement();
-            rideDate = QDateTime::fromString(date.text(), Qt::ISODate);
-            rideFile->setStartTime(rideDate);
-
-        // interval data
-        } else if (node.nodeName() == "segment") {
-            RideFileInterval add;
-
-            // name
-            QDomElement name = node.firstChildElement("name");
-            if (!name.isNull()) add.name = name.text();
-            else add.name = QString("Interval #%1").arg(++intervals);
-
-            QDomElement summary = node.firstChildElement("summarydata");
-            if (!summary.isNull()) {
-
-                // start
-                QDomElement beginning = summary.firstChildElement("beginning");
-                if (!beginning.isNull()) add.start = beginning.text().toDouble();
-                else add.start = -1;
-
-                // duration - convert to end
-                QDomElement duration = summary.firstChildElement("duration");
-                if (!duration.isNull() && add.start != -1)
-                    add.stop = duration.text().toDouble() + add.start;
-                else
-                    add.stop = -1;
-
-                // add interval
-                if (add.start != -1 && add.stop != -1) {
-                    rideFile->addInterval(round(add.start+1), round(add.stop), add.name);
-                }
-            }
-
-        // data points: offset, hr, spd, pwr, torq, cad, dist, lat, lon, alt, temp
-        } else if (node.nodeName() == "sample") {
-            RideFilePoint add;
-
-            // offset (secs)
-            QDomElement off = node.firstChildElement("timeoffset");
-            if (!off.isNull()) add.secs = round(off.text().toDouble());
-            else add.secs = 0.0;
-            // hr
-            QDomElement hr = node.firstChildElement("hr");
-            if (!hr.isNull()) add.hr = hr.text().toDouble();
-            else add.hr = 0.0;
-            // spd in meters per second converted to kph
-            QDomElement spd = node.firstChildElement("spd");
-            if (!spd.isNull()) add.kph = spd.text().toDouble() * 3.6;
-            else add.kph = 0.0;
-            // pwr
-            QDomElement pwr = node.firstChildElement("pwr");
-            if (!pwr.isNull()) {
-                add.watts = pwr.text().toDouble();
-                // NOTE! undo the fudge to set zero values to
-                //       1 in the writer (below). This is to keep
-                //       the TP upload web-service happy with zero values
-                if (add.watts == 1) add.watts = 0.0;
-            } else add.watts = 0.0;
-            // torq
-            QDomElement torq = node.firstChildElement("torq");
-            if (!torq.isNull()) add.nm = torq.text().toDouble();
-            else add.nm = 0.0;
-            // cad
-            QDomElement cad = node.firstChildElement("cad");
-            if (!cad.isNull()) add.cad = cad.text().toDouble();
-            else add.cad = 0.0;
-            // dist
-            QDomElement dist = node.firstChildElement("dist");
-            if (!dist.isNull()) add.km = dist.text().toDouble() /1000;
-            else add.km = 0.0;
+void
+PwxBuilder::addInterval(RideFileInterval add)
+{
+    // start and stop are -1 if missing
+    if (add.start != -1 && add.stop != -1) {
+        rideFile->addInterval(round(add.start+1), round(add.stop), add.name);
+    }
+}
 
-            // lat
-            QDomElement lat = node.firstChildElement("lat");
-            if (!lat.isNull()) add.lat = lat.text().toDouble();
-            else add.lat = 0.0;
-            // lon
-            QDomElement lon = node.firstChildElement("lon");
-            if (!lon.isNull()) add.lon = lon.text().toDouble();
-            else add.lon = 0.0;
-            // alt
-            QDomElement alt = node.firstChildElement("alt");
-            if (!alt.isNull()) add.alt = alt.text().toDouble();
-            else add.alt = 0.0;
-            // temp
-            QDomElement temp = node.firstChildElement("temp");
-            if (!temp.isNull()) add.temp = temp.text().toDouble();
-            else add.temp = RideFile::NoTemp;
-
-            // if there are data points && a time difference > 1sec && smartRecording processing is requested at all
-            if ((!rideFile->dataPoints().empty()) && (add.secs > rtime + 1) && (isGarminSmartRecording.toInt() != 0)) {
-                bool badgps = false;
-                bool lapSwim = false;
-                // Handle smart recording if configured in preferences.  Linearly interpolate missing points.
-                RideFilePoint *prevPoint = rideFile->dataPoints().back();
-                double deltaSecs = add.secs - prevPoint->secs;
-
-                // If the last lat/lng was missing (0/0) then all points up to lat/lng are marked as 0/0.
-                if (prevPoint->lat == 0 && prevPoint->lon == 0 ) badgps = true;
-
-                double deltaCad = add.cad - prevPoint->cad;
-                double deltaHr = add.hr - prevPoint->hr;
-                double deltaDist = add.km - prevPoint->km;
-                if (add.km < 0.00001) deltaDist = 0.000f; // effectively zero distance
-                double deltaSpeed = add.kph - prevPoint->kph;
-                double deltaTorque = add.nm - prevPoint->nm;
-                double deltaPower = add.watts - prevPoint->watts;
-                double deltaAlt = add.alt - prevPoint->alt;
-                double deltaLon = add.lon - prevPoint->lon;
-                double deltaLat = add.lat - prevPoint->lat;
-                double deltaHeadwind = add.headwind - prevPoint->headwind;
-                double deltaSlope = add.slope - prevPoint->slope;
-                double deltaLeftRightBalance = add.lrbalance - prevPoint->lrbalance;
-                double deltaLeftTE = add.lte - prevPoint->lte;
-                double deltaRightTE = add.rte - prevPoint->rte;
-                double deltaLeftPS = add.lps - prevPoint->lps;
-                double deltaRightPS = add.rps - prevPoint->rps;
-                double deltaLeftPedalCenterOffset = add.lpco - prevPoint->lpco;
-                double deltaRightPedalCenterOffset = add.rpco - prevPoint->rpco;
-                double deltaLeftTopDeathCenter = add.lppb - prevPoint->lppb;
-                double deltaRightTopDeathCenter = add.rppb - prevPoint->rppb;
-                double deltaLeftBottomDeathCenter = add.lppe - prevPoint->lppe;
-                double deltaRightBottomDeathCenter = add.rppe - prevPoint->rppe;
-                double deltaLeftTopPeakPowerPhase = add.lpppb - prevPoint->lpppb;
-                double deltaRightTopPeakPowerPhase = add.rpppb - prevPoint->rpppb;
-                double deltaLeftBottomPeakPowerPhase = add.lpppe - prevPoint->lpppe;
-                double deltaRightBottomPeakPowerPhase = add.rpppe - prevPoint->rpppe;
-                double deltaSmO2 = add.smo2 - prevPoint->smo2;
-                double deltaTHb = add.thb - prevPoint->thb;
-                double deltarvert = add.rvert - prevPoint->rvert;
-                double deltarcad = add.rcad - prevPoint->rcad;
-                double deltarcontact = add.rcontact - prevPoint->rcontact;
-
-                // Swim with distance and no GPS => pool swim
-                // limited to account for weird intervals or pauses
-                if (rideFile->isSwim() && badgps && (add.km > 0 || rdist > 0)) {    lapSwim = true;
-                    add.kph = add.km > rdist ? (add.km - rdist)*3600/deltaSecs : 0.0;
-                    if (add.kph == 0.0) add.cad = 0; // rest => no stroke rate
-                }
+void
+PwxBuilder::addSample(RideFilePoint &add)
+{
+    // if there are data points && a time difference > 1sec && smartRecording processing is requested at all
+    if ((!rideFile->dataPoints().empty()) && (add.secs > rtime + 1) && (isGarminSmartRecording.toInt() != 0)) {
+        bool badgps = false;
+        bool lapSwim = false;
+        // Handle smart recording if configured in preferences.  Linearly interpolate missing points.
+        RideFilePoint *prevPoint = rideFile->dataPoints().back();
+        double deltaSecs = add.secs - prevPoint->secs;
+
+        // If the last lat/lng was missing (0/0) then all points up to lat/lng are marked as 0/0.
+        if (prevPoint->lat == 0 && prevPoint->lon == 0 ) badgps = true;
+
+        double deltaCad = add.cad - prevPoint->cad;
+        double deltaHr = add.hr - prevPoint->hr;
+        double deltaDist = add.km - prevPoint->km;
+        if (add.km < 0.00001) deltaDist = 0.000f; // effectively zero distance
+        double deltaSpeed = add.kph - prevPoint->kph;
+        double deltaTorque = add.nm - prevPoint->nm;
+        double deltaPower = add.watts - prevPoint->watts;
+        double deltaAlt = add.alt - prevPoint->alt;
+        double deltaLon = add.lon - prevPoint->lon;
+        double deltaLat = add.lat - prevPoint->lat;
+        double deltaHeadwind = add.headwind - prevPoint->headwind;
+        double deltaSlope = add.slope - prevPoint->slope;
+        double deltaLeftRightBalance = add.lrbalance - prevPoint->lrbalance;
+        double deltaLeftTE = add.lte - prevPoint->lte;
+        double deltaRightTE = add.rte - prevPoint->rte;
+        double deltaLeftPS = add.lps - prevPoint->lps;
+        double deltaRightPS = add.rps - prevPoint->rps;
+        double deltaLeftPedalCenterOffset = add.lpco - prevPoint->lpco;
+        double deltaRightPedalCenterOffset = add.rpco - prevPoint->rpco;
+        double deltaLeftTopDeathCenter = add.lppb - prevPoint->lppb;
+        double deltaRightTopDeathCenter = add.rppb - prevPoint->rppb;
+        double deltaLeftBottomDeathCenter = add.lppe - prevPoint->lppe;
+        double deltaRightBottomDeathCenter = add.rppe - prevPoint->rppe;
+        double deltaLeftTopPeakPowerPhase = add.lpppb - prevPoint->lpppb;
+        double deltaRightTopPeakPowerPhase = add.rpppb - prevPoint->rpppb;
+        double deltaLeftBottomPeakPowerPhase = add.lpppe - prevPoint->lpppe;
+        double deltaRightBottomPeakPowerPhase = add.rpppe - prevPoint->rpppe;
+        double deltaSmO2 = add.smo2 - prevPoint->smo2;
+        double deltaTHb = add.thb - prevPoint->thb;
+        double deltarvert = add.rvert - prevPoint->rvert;
+        double deltarcad = add.rcad - prevPoint->rcad;
+        double deltarcontact = add.rcontact - prevPoint->rcontact;
+
+        // Swim with distance and no GPS => pool swim
+        // limited to account for weird intervals or pauses
+        if (rideFile->isSwim() && badgps && (add.km > 0 || rdist > 0)) {    lapSwim = true;
+            add.kph = add.km > rdist ? (add.km - rdist)*3600/deltaSecs : 0.0;
+            if (add.kph == 0.0) add.cad = 0; // rest => no stroke rate
+        }
 
-                // only smooth the maximal smart recording gap defined in
-                // preferences - we don't want to crash / stall on bad
-                // or corrupt files, lap swimming lenghts/pauses limited
-                // to 10x HWM for the same reason.
-                if (deltaSecs > 0 && (deltaSecs < GarminHWM.toInt() || (lapSwim && deltaSecs < 10*GarminHWM.toInt()))) {
-
-                    for (int i = 1; i < deltaSecs; i++) {
-                        double weight = i /deltaSecs;
-                        // running totals
-                        samples++;
-                        rtime++;
-                        rdist = prevPoint->km + (deltaDist * weight);
-                        // add the data point
-                        rideFile->appendPoint(
-                            rtime,
-                            lapSwim ? add.cad : prevPoint->cad + (deltaCad * weight),
-                            prevPoint->hr + (deltaHr * weight),
-                            rdist,
-                            lapSwim ? add.kph : prevPoint->kph + (deltaSpeed * weight),
-                            prevPoint->nm + (deltaTorque * weight),
-                            prevPoint->watts + (deltaPower * weight),
-                            prevPoint->alt + (deltaAlt * weight),
-                            (badgps == 1) ? 0 : prevPoint->lon + (deltaLon * weight),
-                            (badgps == 1) ? 0 : prevPoint->lat + (deltaLat * weight),
-                            prevPoint->headwind + (deltaHeadwind * weight),
-                            prevPoint->slope + (deltaSlope * weight),
-                            add.temp,
-                            prevPoint->lrbalance + (deltaLeftRightBalance * weight),
-                            prevPoint->lte + (deltaLeftTE * weight),
-                            prevPoint->rte + (deltaRightTE * weight),
-                            prevPoint->lps + (deltaLeftPS * weight),
-                            prevPoint->rps + (deltaRightPS * weight),
-                            prevPoint->lpco + (deltaLeftPedalCenterOffset * weight),
-                            prevPoint->rpco + (deltaRightPedalCenterOffset * weight),
-                            prevPoint->lppb + (deltaLeftTopDeathCenter * weight),
-                            prevPoint->rppb + (deltaRightTopDeathCenter * weight),
-                            prevPoint->lppe + (deltaLeftBottomDeathCenter * weight),
-                            prevPoint->rppe + (deltaRightBottomDeathCenter * weight),
-                            prevPoint->lpppb + (deltaLeftTopPeakPowerPhase * weight),
-                            prevPoint->rpppb + (deltaRightTopPeakPowerPhase * weight),
-                            prevPoint->lpppe + (deltaLeftBottomPeakPowerPhase * weight),
-                            prevPoint->rpppe + (deltaRightBottomPeakPowerPhase * weight),
-                            prevPoint->smo2 + (deltaSmO2 * weight),
-                            prevPoint->thb + (deltaTHb * weight),
-                            prevPoint->rvert + (deltarvert * weight),
-                            prevPoint->rcad + (deltarcad * weight),
-                            prevPoint->rcontact + (deltarcontact * weight),
-                            add.interval);
-                    }
-                }
-            } else if (add.km == 0.0 && samples) {
-                // do we need to calculate distance?
-                // delta secs * kph/3600
-                add.km = rdist + ((add.secs - rtime) * (add.kph/3600));
-            }
+        // only smooth the maximal smart recording gap defined in
+        // preferences - we don't want to crash / stall on bad
+        // or corrupt files, lap swimming lenghts/pauses limited
+        // to 10x HWM for the same reason.
+        if (deltaSecs > 0 && (deltaSecs < GarminHWM.toInt() || (lapSwim && deltaSecs < 10*GarminHWM.toInt()))) {
 
-            // add the data point avoiding duplicates
-            if (add.secs > rtime || rideFile->dataPoints().empty()) {
-                if (add.secs == 0.0) add.kph = 0.0; // avoids a glitch in km
+            for (int i = 1; i < deltaSecs; i++) {
+                double weight = i /deltaSecs;
                 // running totals
                 samples++;
-                rtime = add.secs;
-                rdist = add.km;
-                rideFile->appendPoint(add.secs, add.cad, add.hr, add.km, add.kph,
-                    add.nm, add.watts, add.alt, add.lon, add.lat, add.headwind,
-                    add.slope, add.temp, add.lrbalance,
-                    add.lte, add.rte, add.lps, add.rps,
-                    add.lpco, add.rpco,
-                    add.lppb, add.rppb, add.lppe, add.rppe,
-                    add.lpppb, add.rpppb, add.lpppe, add.rpppe,
-                    add.smo2, add.thb,
-                    add.rvert, add.rcad, add.rcontact,
+                rtime++;
+                rdist = prevPoint->km + (deltaDist * weight);
+                // add the data point
+                rideFile->appendPoint(
+                    rtime,
+                    lapSwim ? add.cad : prevPoint->cad + (deltaCad * weight),
+                    prevPoint->hr + (deltaHr * weight),
+                    rdist,
+                    lapSwim ? add.kph : prevPoint->kph + (deltaSpeed * weight),
+                    prevPoint->nm + (deltaTorque * weight),
+                    prevPoint->watts + (deltaPower * weight),
+                    prevPoint->alt + (deltaAlt * weight),
+                    (badgps == 1) ? 0 : prevPoint->lon + (deltaLon * weight),
+                    (badgps == 1) ? 0 : prevPoint->lat + (deltaLat * weight),
+                    prevPoint->headwind + (deltaHeadwind * weight),
+                    prevPoint->slope + (deltaSlope * weight),
+                    add.temp,
+                    prevPoint->lrbalance + (deltaLeftRightBalance * weight),
+                    prevPoint->lte + (deltaLeftTE * weight),
+                    prevPoint->rte + (deltaRightTE * weight),
+                    prevPoint->lps + (deltaLeftPS * weight),
+                    prevPoint->rps + (deltaRightPS * weight),
+                    prevPoint->lpco + (deltaLeftPedalCenterOffset * weight),
+                    prevPoint->rpco + (deltaRightPedalCenterOffset * weight),
+                    prevPoint->lppb + (deltaLeftTopDeathCenter * weight),
+                    prevPoint->rppb + (deltaRightTopDeathCenter * weight),
+                    prevPoint->lppe + (deltaLeftBottomDeathCenter * weight),
+                    prevPoint->rppe + (deltaRightBottomDeathCenter * weight),
+                    prevPoint->lpppb + (deltaLeftTopPeakPowerPhase * weight),
+                    prevPoint->rpppb + (deltaRightTopPeakPowerPhase * weight),
+                    prevPoint->lpppe + (deltaLeftBottomPeakPowerPhase * weight),
+                    prevPoint->rpppe + (deltaRightBottomPeakPowerPhase * weight),
+                    prevPoint->smo2 + (deltaSmO2 * weight),
+                    prevPoint->thb + (deltaTHb * weight),
+                    prevPoint->rvert + (deltarvert * weight),
+                    prevPoint->rcad + (deltarcad * weight),
+                    prevPoint->rcontact + (deltarcontact * weight),
                     add.interval);
             }
-        
-        } else if (node.nodeName() == "summarydata") {
-
-            // get the summary data in case there are no samples
-            // this is when there is a manual entry, so we can
-            // set the overrides from this
-
-            //<summarydata xmlns="http://www.peaksware.com/PWX/1/0">
-            //<duration>600</duration>
-            //<work>514.632000296428</work>
-            //<tss>100</tss>
-            //<hr></hr>
-            //<spd></spd>
-            //<pwr></pwr>
-            //<dist>23000</dist>
-            //<climbingelevation>14</climbingelevation>
-            //</summarydata>
-
-            // duration
-            QDomElement off = node.firstChildElement("duration");
-            if (!off.isNull()) manualDuration = off.text().toDouble();
-
-            // work
-            off = node.firstChildElement("work");
-            if (!off.isNull()) manualWork = off.text().toDouble();
-
-            // tss
-            off = node.firstChildElement("tss");
-            if (!off.isNull()) manualTSS = off.text().toDouble();
-
-            // hr
-            off = node.firstChildElement("hr");
-            if (!off.isNull()) manualHR = off.text().toDouble();
-
-            // speed
-            off = node.firstChildElement("spd");
-            if (!off.isNull()) manualSpeed = off.text().toDouble();
-
-            // power
-            off = node.firstChildElement("pwr");
-            if (!off.isNull()) manualPower = off.text().toDouble();
-
-            // distance
-            off = node.firstChildElement("dist");
-            if (!off.isNull()) manualKM = off.text().toDouble();
-
-            // Elevation
-            off = node.firstChildElement("climbingelevation");
-            if (!off.isNull()) manualElevation = off.text().toDouble();
-
-
-        } else if (node.nodeName() == "extension") {
         }
+    } else if (add.km == 0.0 && samples) {
+        // do we need to calculate distance?
+        // delta secs * kph/3600
+        add.km = rdist + ((add.secs - rtime) * (add.kph/3600));
+    }
 
-        node = node.nextSibling();
+    // add the data point avoiding duplicates
+    if (add.secs > rtime || rideFile->dataPoints().empty()) {
+        if (add.secs == 0.0) add.kph = 0.0; // avoids a glitch in km
+        // running totals
+        samples++;
+        rtime = add.secs;
+        rdist = add.km;
+        rideFile->appendPoint(add.secs, add.cad, add.hr, add.km, add.kph,
+            add.nm, add.watts, add.alt, add.lon, add.lat, add.headwind,
+            add.slope, add.temp, add.lrbalance,
+            add.lte, add.rte, add.lps, add.rps,
+            add.lpco, add.rpco,
+            add.lppb, add.rppb, add.lppe, add.rppe,
+            add.lpppb, add.rpppb, add.lpppe, add.rpppe,
+            add.smo2, add.thb,
+            add.rvert, add.rcad, add.rcontact,
+            add.interval);
     }
+}
 
+RideFile *
+PwxBuilder::finish()
+{
     // post-process and check
     if (samples < 2) {
 
@@ -541,6 +331,232 @@ PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList&) const
     return rideFile;
 }
 
+// walk a <workout> handing everything to the builder as it is read
+static void
+readWorkout(RideXmlReader &xml, PwxBuilder &pwx)
+{
+    RideFile *rideFile = pwx.rideFile;
+
+    while (xml.readNextStartElement()) {
+
+        QStringRef name = xml.name();
+
+        // data points: offset, hr, spd, pwr, torq, cad, dist, lat, lon, alt, temp
+        if (name == QLatin1String("sample")) {
+
+            RideFilePoint add;
+            add.temp = RideFile::NoTemp;
+
+            while (xml.readNextStartElement()) {
+                QStringRef value = xml.name();
+
+                // offset (secs)
+                if (value == QLatin1String("timeoffset")) add.secs = round(xml.number());
+                // hr
+                else if (value == QLatin1String("hr")) add.hr = xml.number();
+                // spd in meters per second converted to kph
+                else if (value == QLatin1String("spd")) add.kph = xml.number() * 3.6;
+                // pwr
+                else if (value == QLatin1String("pwr")) {
+                    add.watts = xml.number();
+                    // NOTE! undo the fudge to set zero values to
+                    //       1 in the writer (below). This is to keep
+                    //       the TP upload web-service happy with zero values
+                    if (add.watts == 1) add.watts = 0.0;
+                }
+                // torq
+                else if (value == QLatin1String("torq")) add.nm = xml.number();
+                // cad
+                else if (value == QLatin1String("cad")) add.cad = xml.number();
+                // dist
+                else if (value == QLatin1String("dist")) add.km = xml.number() / 1000;
+                // lat
+                else if (value == QLatin1String("lat")) add.lat = xml.number();
+                // lon
+                else if (value == QLatin1String("lon")) add.lon = xml.number();
+                // alt
+                else if (value == QLatin1String("alt")) add.alt = xml.number();
+                // temp
+                else if (value == QLatin1String("temp")) add.temp = xml.number();
+                else xml.skipCurrentElement();
+            }
+            pwx.addSample(add);
+
+        // athlete
+        } else if (name == QLatin1String("athlete")) {
+
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("name")) rideFile->setTag("Athlete Name", xml.readElementText());
+                else if (xml.name() == QLatin1String("weight")) rideFile->setTag("Weight", xml.readElementText());
+                else xml.skipCurrentElement();
+            }
+
+        // workout code
+        } else if (name == QLatin1String("code")) {
+            rideFile->setTag("Workout Code", xml.readElementText());
+
+        // workout title
+        } else if (name == QLatin1String("title")) {
+            rideFile->setTag("Workout Title", xml.readElementText());
+
+        // goal / objective
+        } else if (name == QLatin1String("goal")) {
+            rideFile->setTag("Objective", xml.readElementText());
+
+        // sport
+        } else if (name == QLatin1String("sportType")) {
+            rideFile->setTag("Sport", xml.readElementText());
+
+        // notes
+        } else if (name == QLatin1String("cmt")) {
+
+            // Add the PWX cmt tag as notes
+            rideFile->setTag("Notes", xml.readElementText());
+
+        // device type and info
+        } else if (name == QLatin1String("device")) {
+
+            QString make, model, deviceinfo;
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("make")) make = xml.readElementText();
+                else if (xml.name() == QLatin1String("model")) model = xml.readElementText();
+                else if (xml.name() == QLatin1String("extension")) {
+
+                    // device settings data
+                    while (xml.readNextStartElement()) {
+                        deviceinfo += xml.name().toString();
+                        deviceinfo += ": ";
+                        deviceinfo += xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                        deviceinfo += '\n';
+                    }
+                } else xml.skipCurrentElement();
+            }
+
+            // make and model
+            QString devicetype = make;
+            if (model != "") {
+                if (devicetype != "") devicetype += " ";
+                devicetype += model;
+            }
+            rideFile->setDeviceType(devicetype);
+            rideFile->setFileFormat("Peaksware Data File (pwx)");
+            rideFile->setTag("Device Info", deviceinfo);
+
+        // start date/time
+        } else if (name == QLatin1String("time")) {
+            rideFile->setStartTime(QDateTime::fromString(xml.readElementText(), Qt::ISODate));
+
+        // interval data
+        } else if (name == QLatin1String("segment")) {
+
+            RideFileInterval add;
+            bool named = false, summary = false;
+            add.start = add.stop = -1;
+            double duration = -1;
+
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("name")) {
+                    add.name = xml.readElementText();
+                    named = true;
+                } else if (xml.name() == QLatin1String("summarydata")) {
+                    summary = true;
+                    while (xml.readNextStartElement()) {
+                        if (xml.name() == QLatin1String("beginning")) add.start = xml.number();
+                        else if (xml.name() == QLatin1String("duration")) duration = xml.number();
+                        else xml.skipCurrentElement();
+                    }
+                } else xml.skipCurrentElement();
+            }
+
+            // name
+            if (!named) add.name = QString("Interval #%1").arg(++pwx.intervals);
+
+            // duration - convert to end
+            if (duration != -1 && add.start != -1) add.stop = duration + add.start;
+
+            if (summary) pwx.addInterval(add);
+
+        } else if (name == QLatin1String("summarydata")) {
+
+            // get the summary data in case there are no samples
+            // this is when there is a manual entry, so we can
+            // set the overrides from this
+            while (xml.readNextStartElement()) {
+                QStringRef value = xml.name();
+
+                if (value == QLatin1String("duration")) pwx.manualDuration = xml.number();
+                else if (value == QLatin1String("work")) pwx.manualWork = xml.number();
+                else if (value == QLatin1String("tss")) pwx.manualTSS = xml.number();
+                else if (value == QLatin1String("hr")) pwx.manualHR = xml.number();
+                else if (value == QLatin1String("spd")) pwx.manualSpeed = xml.number();
+                else if (value == QLatin1String("pwr")) pwx.manualPower = xml.number();
+                else if (value == QLatin1String("dist")) pwx.manualKM = xml.number();
+                else if (value == QLatin1String("climbingelevation")) pwx.manualElevation = xml.number();
+                else xml.skipCurrentElement();
+            }
+
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+}
+
+// walk the <pwx> document, the file and TrainingPeaks downloads both come here
+static bool
+readPwx(RideXmlReader &xml, PwxBuilder &pwx)
+{
+    // <pwx><workout> ...
+    if (xml.readNextStartElement()) {
+
+        if (xml.name() != QLatin1String("pwx")) {
+            xml.raiseError("Not a PWX file.");
+            return false;
+        }
+
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("workout")) readWorkout(xml, pwx);
+            else xml.skipCurrentElement();
+        }
+    }
+    return !xml.hasError();
+}
+
+RideFile *
+PwxFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        errors << "Could not open file.";
+        return NULL;
+    }
+
+    // stream it, a sample at a time
+    PwxBuilder pwx(new RideFile());
+    bool parsed;
+    {
+        RideXmlReader xml(file);
+        parsed = readPwx(xml, pwx);
+    }
+    file.close();
+
+    if (!parsed) {
+        errors << "Could not parse file.";
+        delete pwx.rideFile;
+        return NULL;
+    }
+
+    return pwx.finish();
+}
+
+RideFile *
+PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList&) const
+{
+    // same walk as a file, without indenting since it isn't for reading
+    RideXmlReader xml(doc.toByteArray(-1));
+    PwxBuilder pwx(new RideFile());
+    readPwx(xml, pwx);
+    return pwx.finish();
+}
+
 bool
 PwxFileReader::writeRideFile(Context *context, const RideFile *ride, QFile &file) const
 {
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ReplayController.h"
+#include "RealtimeData.h"
+#include "RideFile.h"
+#include "ANT.h"
+
+#include <QFileInfo>
+#include <cmath>
+
+ReplayController::ReplayController(TrainSidebar *parent, DeviceConfiguration *dc)
+  : RealtimeController(parent, dc), speed(1.0), jitter(0), dropout(0),
+    ant(NULL), ride(NULL), elapsed(0), running(false), paused(false)
+{
+    if (dc) {
+        antConf = *dc;
+        filename = dc->portSpec;
+        parseProfile(dc->deviceProfile);
+    }
+}
+
+ReplayController::~ReplayController()
+{
+    stop();
+}
+
+// split replay settings out from the ANT ids
+void
+ReplayController::parseProfile(QString profile)
+{
+    QStringList ids;
+    foreach(QString token, profile.split(",", QString::SkipEmptyParts)) {
+
+        token = token.trimmed();
+        if (!token.contains("=")) {
+            ids << token;
+            continue;
+        }
+
+        QString key = token.section("=", 0, 0).trimmed().toLower();
+        double value = token.section("=", 1).trimmed().toDouble();
+
+        if (key == "speed") setSpeed(value);
+        else if (key == "jitter") setJitter(value);
+        else if (key == "dropout") setDropout(value);
+    }
+    antConf.deviceProfile = ids.join(",");
+}
+
+long
+ReplayController::replayMsecs() const
+{
+    if (!running || paused) return elapsed;
+    return elapsed + clock.elapsed();
+}
+
+int
+ReplayController::start()
+{
+    stop();
+
+    // ANT captures go through the ANT receive path
+    if (QFileInfo(filename).suffix().toLower() == "bin") {
+
+        ant = new ANT(this, &antConf);
+        ant->setReplay(filename, speed, jitter, dropout);
+        ant->start();
+        ant->setup();
+
+    } else {
+
+        // otherwise it needs to be a ride file we can read
+        QString suffix = QFileInfo(filename).suffix().toLower();
+        if (!RideFileFactory::instance().suffixes().contains(suffix)) return DEVICE_ERROR;
+
+        QFile file(filename);
+        QStringList errors;
+        ride = RideFileFactory::instance().openRideFile(NULL, file, errors);
+        if (!ride) return DEVICE_ERROR;
+    }
+
+    elapsed = 0;
+    clock.start();
+    running = true;
+    paused = false;
+    return DEVICE_OK;
+}
+
+int
+ReplayController::stop()
+{
+    if (ant) {
+        ant->stop();
+        ant->wait();
+        delete ant;
+        ant = NULL;
+    }
+    if (ride) {
+        delete ride;
+        ride = NULL;
+    }
+    running = paused = false;
+    return DEVICE_OK;
+}
+
+int
+ReplayController::pause()
+{
+    if (!running || paused) return DEVICE_OK;
+
+    elapsed += clock.elapsed();
+    paused = true;
+    if (ant) return ant->pause();
+    return DEVICE_OK;
+}
+
+int
+ReplayController::restart()
+{
+    if (!running || !paused) return DEVICE_OK;
+
+    clock.start();
+    paused = false;
+    if (ant) return ant->restart();
+    return DEVICE_OK;
+}
+
+bool
+ReplayController::find()
+{
+    // nothing configured yet (e.g. add device wizard)
+    if (filename == "") return true;
+    return QFileInfo(filename).exists();
+}
+
+bool
+ReplayController::discover(QString name)
+{
+    return QFileInfo(name).exists();
+}
+
+void
+ReplayController::getRealtimeData(RealtimeData &rtData)
+{
+    if (ant) {
+        ant->getRealtimeData(rtData);
+        processRealtimeData(rtData);
+        return;
+    }
+
+    if (!ride || ride->dataPoints().isEmpty()) return;
+
+    // lost this one, the sensors repeat the last values
+    if (dropout > 0 && (rand()%10000) < dropout * 100) {
+        rtData.setWatts(last.getWatts());
+        rtData.setHr(last.getHr());
+        rtData.setCadence(last.getCadence());
+        rtData.setSpeed(last.getSpeed());
+        return;
+    }
+
+    // where are we in the ride?, wrap at the end so it can run forever
+    const RideFilePoint *first = ride->dataPoints().first();
+    double duration = ride->dataPoints().last()->secs - first->secs + ride->recIntSecs();
+    double secs = double(replayMsecs()) * speed / 1000.0;
+    if (jitter > 0) secs += jitter * (double(rand()%2001) / 1000.0 - 1.0) / 1000.0;
+    if (secs < 0) secs = 0;
+    if (duration > 0) secs = fmod(secs, duration);
+
+    const RideFilePoint *p = ride->dataPoints().at(ride->timeIndex(first->secs + secs));
+
+    rtData.setName((char *)"Replay");
+    rtData.setWatts(p->watts);
+    rtData.setHr(p->hr);
+    rtData.setCadence(p->cad);
+    rtData.setSpeed(p->kph);
+    rtData.setLRBalance(p->lrbalance);
+    rtData.setLTE(p->lte);
+    rtData.setRTE(p->rte);
+    rtData.setLPS(p->lps);
+    rtData.setRPS(p->rps);
+    rtData.setHb(p->smo2, p->thb);
+    processRealtimeData(rtData);
+
+    last = rtData;
+}
+
+void ReplayController::pushRealtimeData(RealtimeData &) {
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_ReplayController_h
+#define _GC_ReplayController_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QTime>
+
+#include "RealtimeController.h"
+#include "RealtimeData.h"
+#include "DeviceTypes.h"
+#include "DeviceConfiguration.h"
+
+class ANT;
+class RideFile;
+
+//
+// Replays recorded data through the realtime pipeline so train mode
+// can be exercised (and timed) without any hardware attached.
+//
+// The port is the file to replay:
+//   - an ANTLogger capture (.bin) is fed byte by byte through the
+//     normal ANT receive path, so the channel decoders do the work
+//   - anything else is opened with the RideFileFactory and samples
+//     are served at the replay clock, wrapping at the end of the ride
+//
+// The device profile holds the ANT ids used when the capture was made
+// along with optional replay settings, e.g. "1234p,5678h,speed=4,jitter=50,dropout=2"
+//   speed   - replay speed multiplier (1x by default)
+//   jitter  - +/- msecs of timing noise on each message or sample
+//   dropout - percentage of messages or samples that are lost
+//
+class ReplayController : public RealtimeController
+{
+    Q_OBJECT
+
+    public:
+
+        ReplayController(TrainSidebar *parent, DeviceConfiguration *dc);
+        ~ReplayController();
+
+        int start();
+        int stop();
+        int pause();
+        int restart();
+        bool find();
+        bool discover(QString);
+        bool doesPush() {  return false; }
+        bool doesPull() {  return true; }
+        bool doesLoad() {  return false; }
+        void getRealtimeData(RealtimeData &rtData);
+        void pushRealtimeData(RealtimeData &rtData);
+
+        // settings, usually parsed from the device profile
+        void setFilename(QString x) { filename = x; }
+        void setSpeed(double x) { speed = x > 0 ? x : 1.0; }
+        void setJitter(double msecs) { jitter = msecs; }
+        void setDropout(double percent) { dropout = percent; }
+
+    private:
+
+        void parseProfile(QString profile);
+        long replayMsecs() const;
+
+        QString filename;
+        double speed, jitter, dropout;
+
+        DeviceConfiguration antConf; // profile with replay settings removed
+        ANT *ant;                    // when replaying an ANT capture
+        RideFile *ride;              // when replaying a ride
+
+        QTime clock;                 // running since last start/restart
+        long elapsed;                // msecs replayed before last pause
+        bool running, paused;
+
+        RealtimeData last;           // sent again when a sample drops out
+};
+
+#endif // _GC_ReplayController_h
@@ -17,15 +17,20 @@
  */
 
 #include "RideCache.h"
+#include "GcTrace.h"
 
 #include "Context.h"
 #include "Athlete.h"
+#include "FileJournal.h"
 #include "RideFileCache.h"
 #include "RideCacheModel.h"
 #include "Specification.h"
+#include "MetricRollup.h"
+#include "Settings.h"
 
 #include "Route.h"
 #include "RouteWindow.h"
+#include "AllPlot.h"
 
 #include "Zones.h"
 #include "HrZones.h"
@@ -33,6 +38,10 @@
 
 #include "JsonRideFile.h" // for DATETIME_FORMAT
 
+#include <QTime>
+#include <QSet>
+#include <QApplication>
+
 #ifdef SLOW_REFRESH
 #include "unistd.h"
 #endif
@@ -41,15 +50,29 @@
 bool rideCacheGreaterThan(const RideItem *a, const RideItem *b) { return a->dateTime > b->dateTime; }
 bool rideCacheLessThan(const RideItem *a, const RideItem *b) { return a->dateTime < b->dateTime; }
 
+// what is in the activities folder, to tell our own changes from anyone else's
+static FileListing
+activitiesListing(const QDir &dir)
+{
+    FileListing returning;
+    foreach(QFileInfo info, dir.entryInfoList(QDir::Files | QDir::Hidden))
+        returning.insert(info.fileName(), qMakePair(info.size(), uint(info.lastModified().toTime_t())));
+    return returning;
+}
+
 RideCache::RideCache(Context *context) : context(context)
 {
     progress_ = 100;
     exiting = false;
+    rescan = checking = false;
+    smoothing_ = 0;
+
+    // aggregates for the trend charts, kept up to date as we go
+    rollup_ = new MetricRollup(context);
+    connect(this, SIGNAL(itemChanged(RideItem*)), rollup_, SLOT(itemChanged(RideItem*)));
 
     // get the new zone configuration fingerprint
-    fingerprint = static_cast<unsigned long>(context->athlete->zones()->getFingerprint())
-                  + static_cast<unsigned long>(context->athlete->paceZones()->getFingerprint())
-                  + static_cast<unsigned long>(context->athlete->hrZones()->getFingerprint());
+    fingerprint = context->athlete->config()->fingerprint();
 
     // set the list
     // populate ride list
@@ -77,16 +100,30 @@ RideCache::RideCache(Context *context) : context(context)
     // set model once we have the basics
     model_ = new RideCacheModel(context, this);
 
+    // staleness is checked in the background first
+    connect(&scanWatcher, SIGNAL(finished()), this, SLOT(scanned()));
+
     // now refresh just in case.
     refresh();
 
+    // and again when files are changed behind our back, once
+    // they stop changing, a save or import touches several
+    listing_ = activitiesListing(context->athlete->home->activities());
+    rescanTimer.setSingleShot(true);
+    rescanTimer.setInterval(RIDECACHE_RESCANDELAY);
+    connect(&rescanTimer, SIGNAL(timeout()), this, SLOT(rescanActivities()));
+    activities.addPath(context->athlete->home->activities().canonicalPath());
+    connect(&activities, SIGNAL(directoryChanged(QString)), this, SLOT(activitiesChanged()));
+
     // do we have any stale items ?
     connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
 
     // future watching
     connect(&watcher, SIGNAL(finished()), this, SLOT(garbageCollect()));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(trim()));
     connect(&watcher, SIGNAL(finished()), this, SLOT(save()));
     connect(&watcher, SIGNAL(finished()), context, SLOT(notifyRefreshEnd()));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(refreshed()));
     connect(&watcher, SIGNAL(started()), context, SLOT(notifyRefreshStart()));
     connect(&watcher, SIGNAL(progressValueChanged(int)), this, SLOT(progressing(int)));
 }
@@ -98,8 +135,13 @@ RideCache::~RideCache()
     // cancel any refresh that may be running
     cancel();
 
+    // and wait for any rides being opened in the background
+    foreach(RideItem *item, prefetch_.keys()) delete takePrefetched(item);
+
     // save to store
     save();
+
+    delete rollup_;
 }
 
 void
@@ -111,6 +153,167 @@ RideCache::garbageCollect()
     delete_.clear();
 }
 
+void
+RideCache::opened(RideItem *item)
+{
+    item->lastUsed = tick();
+
+    QMutexLocker locker(&residentLock);
+    resident_ << item;
+    locker.unlock();
+
+    // we may be in a worker thread, so trim back on the gui thread
+    // and only once for however many get opened before it runs
+    if (trimQueued.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "trim", Qt::QueuedConnection);
+}
+
+void
+RideCache::closed(RideItem *item)
+{
+    QMutexLocker locker(&residentLock);
+    resident_.removeAll(item);
+}
+
+// roughly what an open ride costs, the samples are nearly all of it
+static qint64
+rideBytes(RideItem *item)
+{
+    RideFile *ride = item->ride(false);
+    if (!ride) return 0;
+    return qint64(ride->dataPoints().count()) * (sizeof(RideFilePoint) + sizeof(RideFilePoint*));
+}
+
+static bool
+leastRecentlyUsed(const RideItem *a, const RideItem *b)
+{
+    return a->lastUsed < b->lastUsed;
+}
+
+void
+RideCache::trim()
+{
+    trimQueued = 0;
+
+    // refresh opens and closes rides as it goes, we go again when it ends
+    if (exiting || isRunning()) return;
+
+    // 0 means no limit
+    qint64 budget = qint64(appsettings->value(this, GC_RIDEMEMORY, 512).toInt()) * 1024 * 1024;
+    if (budget <= 0) return;
+
+    QMutexLocker locker(&residentLock);
+    QList<RideItem*> open = resident_;
+    locker.unlock();
+
+    qint64 used = 0;
+    foreach(RideItem *item, open) used += rideBytes(item);
+    if (used <= budget) return;
+
+    // charts keep the ride they last showed even when they're not
+    // visible, along with its samples and .cpx, so they stay open
+    QSet<RideItem*> held;
+    held << context->ride;
+    if (context->mainWindow) {
+        foreach(GcWindow *chart, context->mainWindow->findChildren<GcWindow*>())
+            held << chart->rideItem();
+    }
+
+    // oldest first, never the most recent few
+    qSort(open.begin(), open.end(), leastRecentlyUsed);
+    for (int i=0; i<open.count()-RIDECACHE_KEEPOPEN && used > budget; i++) {
+
+        RideItem *item = open[i];
+
+        // rides in use, unsaved changes and anything not ours stay open
+        if (held.contains(item) || item->isDirty() || item->isedit || !rides_.contains(item)) continue;
+
+        used -= rideBytes(item);
+        item->close();
+
+        // the mean maximals are in the .cpx, no need to hold them too
+        delete item->fileCache_;
+        item->fileCache_ = NULL;
+    }
+}
+
+// open a ride and work out what the charts need first, away from the gui thread
+static RideFile *
+prefetchRide(Context *context, QString filename, bool metric, int smoothing)
+{
+    QFile file(filename);
+    QStringList errors;
+    RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+    if (ride) {
+        ride->recalculateDerivedSeries();
+        ride->wprimeData();
+        AllPlot::prepareRide(ride, metric, smoothing);
+
+        // its the gui thread's from now on
+        ride->moveToThread(QApplication::instance()->thread());
+    }
+    return ride;
+}
+
+void
+RideCache::prefetch(RideItem *item)
+{
+    // already open, or on its way
+    if (exiting || item == NULL || item->isOpen()) return;
+
+    QMutexLocker locker(&prefetchLock);
+    if (prefetch_.contains(item)) return;
+
+    QFutureWatcher<RideFile*> *watcher = new QFutureWatcher<RideFile*>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(prefetchDone()));
+    watcher->setFuture(QtConcurrent::run(prefetchRide, context, item->path + "/" + item->fileName,
+                                           context->athlete->useMetricUnits, smoothing_));
+    prefetch_.insert(item, watcher);
+}
+
+RideFile *
+RideCache::takePrefetched(RideItem *item)
+{
+    QMutexLocker locker(&prefetchLock);
+    QFutureWatcher<RideFile*> *watcher = prefetch_.take(item);
+    locker.unlock();
+
+    if (watcher == NULL) return NULL;
+
+    // may be called from the refresh threads
+    QFuture<RideFile*> future = watcher->future();
+    watcher->deleteLater();
+
+    future.waitForFinished();
+    return future.result();
+}
+
+void
+RideCache::prefetchDone()
+{
+    QList<RideItem*> ready, failed;
+    QMutexLocker locker(&prefetchLock);
+    QHashIterator<RideItem*, QFutureWatcher<RideFile*>*> i(prefetch_);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value()->isFinished()) {
+            if (i.value()->future().result()) ready << i.key();
+            else failed << i.key();
+        }
+    }
+    locker.unlock();
+
+    // it didn't open, leave it closed rather than trying again here
+    foreach(RideItem *item, failed) takePrefetched(item);
+
+    foreach(RideItem *item, ready) {
+
+        // deleted or opened some other way whilst we were busy
+        if (!rides_.contains(item) || item->isOpen()) delete takePrefetched(item);
+        else item->ride(); // takes it, and counts it against the memory budget
+    }
+}
+
 void
 RideCache::configChanged(qint32 what)
 {
@@ -153,7 +356,7 @@ RideCache::itemChanged()
 
 // add a new ride
 void
-RideCache::addRide(QString name, bool dosignal, bool useTempActivities)
+RideCache::addRide(QString name, bool dosignal, bool useTempActivities, bool later)
 {
     // ignore malformed names
     QDateTime dt;
@@ -187,8 +390,13 @@ RideCache::addRide(QString name, bool dosignal, bool useTempActivities)
         model_->endReset();
     }
 
-    // refresh metrics for *this ride only* 
-    last->refresh();
+    // we put it there
+    written(last->path + "/" + last->fileName);
+
+    // refresh metrics for *this ride only*, unless they
+    // will all be refreshed in the background afterwards
+    if (!later) last->refresh();
+    rollup_->rideAdded(last);
 
     if (dosignal) context->notifyRideAdded(last); // here so emitted BEFORE rideSelected is emitted!
 
@@ -243,11 +451,13 @@ RideCache::removeCurrentRide()
     rides_.remove(index, 1);
     delete_<<todelete;
     model_->endRemove(index);
+    rollup_->rideDeleted(todelete);
 
     // delete the file by renaming it
     QString strOldFileName = context->ride->fileName;
 
     QFile file(context->athlete->home->activities().canonicalPath() + "/" + strOldFileName);
+    QString sidecar = RideFileFactory::sidecarFileName(file.fileName());
     // purposefully don't remove the old ext so the user wouldn't have to figure out what the old file type was
     QString strNewName = strOldFileName + ".bak";
 
@@ -260,6 +470,14 @@ RideCache::removeCurrentRide()
             .arg(strOldFileName).arg(strNewName).arg(context->athlete->home->fileBackup().canonicalPath()));
     }
 
+    // the metadata saved since goes with it
+    if (QFile::exists(sidecar)) {
+        QString backup = RideFileFactory::sidecarFileName(context->athlete->home->fileBackup().canonicalPath() + "/" + strNewName);
+        QFile::remove(backup);
+        QFile::rename(sidecar, backup);
+    }
+    written(context->athlete->home->activities().canonicalPath() + "/" + strOldFileName);
+
     // remove any other derived/additional files; notes, cpi etc (they can only exist in /cache )
     QStringList extras;
     extras << "notes" << "cpi" << "cpx";
@@ -354,9 +572,9 @@ itemRefresh(RideItem *&item)
     if (item->isstale) {
         item->refresh();
 
-        // and trap changes during refresh to current ride
-        if (item == item->context->currentRideItem())
-            item->context->notifyRideChanged(item);
+        // batched up and sent on from the gui thread, rideChanged()
+        // only goes out if it's the current ride
+        item->context->notifyRideChanged(item);
 
 #ifdef SLOW_REFRESH
         sleep(1);
@@ -379,109 +597,247 @@ RideCache::progressing(int value)
 void
 RideCache::cancel()
 {
+    rescan = false;
+    if (scanning.isRunning()) {
+        scanning.cancel();
+        scanning.waitForFinished();
+    }
     if (future.isRunning()) {
         future.cancel();
         future.waitForFinished();
     }
 }
 
+void
+itemCheckStale(RideItem *&item)
+{
+    // sets isstale, the journal saves us reading
+    // files that haven't changed since last time
+    item->checkStale();
+
+    // and the color, the engine is safe to use from any thread
+    item->color = item->context->athlete->colorEngine->colorFor(item->check.metadata);
+    item->check.metadata.clear();
+}
+
 // check if we need to refresh the metrics then start the thread if needed
 void
 RideCache::refresh()
 {
-    // already on it !
-    if (future.isRunning()) return;
+    GC_TRACE("RideCache::refresh");
 
-    // how many need refreshing ?
-    int staleCount = 0;
+    // already on it, go again when done since files may have
+    // changed or rides been added since it started
+    if (scanning.isRunning() || future.isRunning()) {
+        rescan = true;
+        return;
+    }
 
-    foreach(RideItem *item, rides_) {
+    // check every ride in parallel, off the gui thread
+    // and refresh the stale ones when we know which, all
+    // we do here is take a shared copy of the metadata
+    checking = true;
+    foreach(RideItem *item, rides_) item->prepareCheck();
+    scan_ = rides_;
+    scanning = QtConcurrent::map(scan_, itemCheckStale);
+    scanWatcher.setFuture(scanning);
+}
 
-        // ok set stale so we refresh
-        if (item->checkStale()) 
-            staleCount++;
+void
+RideCache::refreshed()
+{
+    // rides were added whilst we were refreshing
+    if (rescan && !exiting && !future.isCanceled()) {
+        rescan = false;
+        refresh();
     }
+}
 
-    // start if there is work to do
-    // and future watcher can notify of updates
-    if (staleCount)  {
-        reverse_ = rides_;
-        qSort(reverse_.begin(), reverse_.end(), rideCacheGreaterThan);
-        future = QtConcurrent::map(reverse_, itemRefresh);
-        watcher.setFuture(future);
+void
+RideCache::activitiesChanged()
+{
+    // wait till it stops changing
+    rescanTimer.start();
+}
+
+void
+RideCache::written(QString filename)
+{
+    // whatever the journal remembers about it is out of date, even
+    // if the filesystem doesn't record when in the same second
+    context->athlete->journal->remove(filename);
+
+    QDir dir = context->athlete->home->activities();
+    if (QFileInfo(filename).absoluteDir().canonicalPath() != dir.canonicalPath()) return;
+
+    // the ride, its metadata and the backup when converted
+    QStringList names;
+    names << filename << RideFileFactory::sidecarFileName(filename) << filename + ".bak";
+    foreach(QString name, names) {
+        QFileInfo info(name);
+        if (info.exists()) listing_.insert(info.fileName(), qMakePair(info.size(), uint(info.lastModified().toTime_t())));
+        else listing_.remove(info.fileName());
     }
 }
 
-QString
-RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, bool nofmt)
+void
+RideCache::rescanActivities()
 {
-    // get the metric details, so we can convert etc
-    const RideMetric *metric = RideMetricFactory::instance().rideMetric(name);
-    if (!metric) return QString("%1 unknown").arg(name);
+    if (exiting) return;
 
-    // what we will return
-    double rvalue = 0;
-    double rcount = 0; // using double to avoid rounding issues with int when dividing
+    // the refresh works on the ride list, so wait for it
+    if (isRunning()) {
+        rescanTimer.start();
+        return;
+    }
 
-    // loop through and aggregate
-    foreach (RideItem *item, rides()) {
+    // nothing changed, or only what we wrote ourselves
+    QDir dir = context->athlete->home->activities();
+    FileListing now = activitiesListing(dir);
+    if (now == listing_) return;
+    listing_ = now;
 
-        // skip filtered rides
-        if (!spec.pass(item)) continue;
+    QString path = dir.canonicalPath();
+    RideItem *current = context->ride;
+    bool reselect = false;
 
-        // get this value
-        double value = item->getForSymbol(name);
-        double count = item->getForSymbol("workout_time"); // for averaging
+    // deleted, we keep any with unsaved changes so they can be saved again
+    for (int index=0; index < rides_.count();) {
 
-        // check values are bounded, just in case
-        if (std::isnan(value) || std::isinf(value)) value = 0;
+        RideItem *item = rides_[index];
+        if (item->path != path || now.contains(item->fileName) || item->isDirty()) {
+            index++;
+            continue;
+        }
 
-        // imperial / metric conversion
-        if (useMetricUnits == false) {
-            value *= metric->conversion();
-            value += metric->conversionSum();
+        model_->startRemove(index);
+        rides_.remove(index, 1);
+        delete_ << item;
+        model_->endRemove(index);
+        rollup_->rideDeleted(item);
+
+        // no point remembering them
+        context->athlete->journal->remove(dir.absolutePath() + "/" + item->fileName);
+        context->athlete->journal->remove(path + "/" + item->fileName);
+        context->athlete->journal->remove(context->athlete->home->cache().canonicalPath() + "/" +
+                                          QFileInfo(item->fileName).baseName() + ".cpx");
+
+        // the one after it, or the one before if it was the last
+        if (item == current) {
+            current = rides_.isEmpty() ? NULL : rides_[qMin(index, rides_.count()-1)];
+            reselect = true;
         }
+        context->notifyRideDeleted(item);
+    }
 
-        // do we aggregate zero values ?
-        bool aggZero = metric->aggregateZero();
+    // added, they're stale so the refresh will open them
+    QSet<QString> known;
+    foreach(RideItem *item, rides_) if (item->path == path) known << item->fileName;
 
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metric->symbol() == "average_temp" && value == RideFile::NoTemp) {
-            value = 0;
-            aggZero = false;
-        }
+    QList<RideItem*> added;
+    foreach(QString name, RideFileFactory::instance().listRideFiles(dir)) {
 
-        switch (metric->type()) {
-        case RideMetric::Total:
-            rvalue += value;
-            break;
-        case RideMetric::Average:
-            {
-            // average should be calculated taking into account
-            // the duration of the ride, otherwise high value but
-            // short rides will skew the overall average
-            if (value || aggZero) {
-                rvalue += value*count;
-                rcount += count;
-            }
-            break;
-            }
-        case RideMetric::Low:
-            {
-            if (value < rvalue) rvalue = value;
-            break;
-            }
-        case RideMetric::Peak:
-            {
-            if (value > rvalue) rvalue = value;
-            break;
-            }
+        QDateTime dt;
+        if (known.contains(name) || !RideFile::parseRideFileName(name, &dt)) continue;
+
+        RideItem *item = new RideItem(path, name, dt, context);
+        connect(item, SIGNAL(rideDataChanged()), this, SLOT(itemChanged()));
+        connect(item, SIGNAL(rideMetadataChanged()), this, SLOT(itemChanged()));
+        added << item;
+    }
+
+    if (added.count()) {
+        model_->beginReset();
+        foreach(RideItem *item, added) rides_ << item;
+        qSort(rides_.begin(), rides_.end(), rideCacheLessThan);
+        model_->endReset();
+
+        foreach(RideItem *item, added) {
+            rollup_->rideAdded(item);
+            context->notifyRideAdded(item);
         }
     }
 
-    // now compute the average
-    if (metric->type() == RideMetric::Average) {
-        if (rcount) rvalue = rvalue / rcount;
+    // the notifiers set the ride, but the user is still looking at theirs
+    context->ride = current;
+    if (reselect) context->notifyRideSelected(current);
+
+    // and any that were changed
+    refresh();
+}
+
+void
+RideCache::scanned()
+{
+    GC_TRACE("RideCache::scanned");
+
+    if (exiting || scanning.isCanceled()) {
+        checking = false;
+        return;
+    }
+
+    // again, files changed while we were checking
+    if (rescan) {
+        rescan = false;
+        refresh();
+        return;
+    }
+
+    // remember what we found out
+    context->athlete->journal->save();
+
+    // how many need refreshing ?
+    int staleCount = 0;
+    foreach(RideItem *item, rides_) if (item->isstale) staleCount++;
+
+    checking = false;
+
+    // nothing to do, but anyone waiting needs to know we're done
+    if (staleCount == 0) {
+        emit checked();
+        return;
+    }
+
+    // start if there is work to do
+    // and future watcher can notify of updates
+    reverse_ = rides_;
+    qSort(reverse_.begin(), reverse_.end(), rideCacheGreaterThan);
+    future = QtConcurrent::map(reverse_, itemRefresh);
+    watcher.setFuture(future);
+}
+
+QString
+RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, bool nofmt)
+{
+    // get the metric details, so we can convert etc
+    const RideMetric *metric = RideMetricFactory::instance().rideMetric(name);
+    if (!metric) return QString("%1 unknown").arg(name);
+
+    // aggregated from the rollup rather than visiting every ride
+    MetricRollup::Bucket agg = rollup_->total(name, false, spec);
+
+    // imperial / metric conversion
+    double c = useMetricUnits ? 1.0 : metric->conversion();
+    double sum = useMetricUnits ? 0.0 : metric->conversionSum();
+
+    // what we will return
+    double rvalue = 0;
+
+    switch (metric->type()) {
+    case RideMetric::Total:
+        rvalue = (agg.sum * c) + (agg.count * sum);
+        break;
+    case RideMetric::Average:
+        // average is weighted by the duration of the ride, otherwise
+        // high value but short rides will skew the overall average
+        if (agg.counted) rvalue = (agg.mean() * c) + sum;
+        break;
+    case RideMetric::Low:
+        if (agg.count && (agg.min * c) + sum < rvalue) rvalue = (agg.min * c) + sum;
+        break;
+    case RideMetric::Peak:
+        if (agg.count && (agg.max * c) + sum > rvalue) rvalue = (agg.max * c) + sum;
+        break;
     }
 
     const_cast<RideMetric*>(metric)->setValue(rvalue);
@@ -599,18 +955,17 @@ class RollingBests {
         }
 };
 
-void
-RideCache::refreshCPModelMetrics()
+QList<PDFit>
+RideCache::modelBests()
 {
+    QList<PDFit> weeks;
+
     // this needs to be done once all the other metrics
     // Calculate a *monthly* estimate of CP, W' etc using
     // bests data from the previous 12 weeks
     RollingBests bests(12);
     RollingBests bestsWPK(12);
 
-    // clear any previous calculations
-    context->athlete->PDEstimates.clear(); 
-
     // we do this by aggregating power data into bests
     // for each month, and having a rolling set of 3 aggregates
     // then aggregating those up into a rolling 3 month 'bests'
@@ -635,91 +990,46 @@ RideCache::refreshCPModelMetrics()
         }
     }
 
-    // if we don't have 2 rides or more then skip this but add a blank estimate
-    if (from == to || to == QDate()) {
-        context->athlete->PDEstimates << PDEstimate();
-        return;
-    }
-
-    // set up the models we support
-    CP2Model p2model(context);
-    CP3Model p3model(context);
-    MultiModel multimodel(context);
-    ExtendedModel extmodel(context);
-
-    QList <PDModel *> models;
-    models << &p2model;
-    models << &p3model;
-    models << &multimodel;
-    models << &extmodel;
-
+    // if we don't have 2 rides or more then skip this
+    if (from == to || to == QDate()) return weeks;
 
     // from has first ride with Power data / looking at the next 7 days of data with Power
     // calculate Estimates for all data per week including the week of the last Power recording
     QDate date = from;
     while (date < to) {
 
-        QDate begin = date;
-        QDate end = date.addDays(6);
+        PDFit add;
+        add.context = context;
+        add.from = date;
+        add.to = date.addDays(6);
 
         // let others know where we got to...
         emit modelProgress(date.year(), date.month());
 
         // months is a rolling 3 months sets of bests
         QVector<float> wpk; // for getting the wpk values
-        bests.addBests(RideFileCache::meanMaxPowerFor(context, wpk, begin, end));
+        bests.addBests(RideFileCache::meanMaxPowerFor(context, wpk, add.from, add.to));
         bestsWPK.addBests(wpk);
 
         // we now have the data
-        foreach(PDModel *model, models) {
-
-            PDEstimate add;
-
-            // set the data
-            model->setData(bests.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
-
-            add.wpk = false;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
-
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
-
-            // so long as the important model derived values are sensible ...
-            if (add.WPrime > 1000 && add.CP > 100) 
-                context->athlete->PDEstimates << add;
-
-            //qDebug()<<add.to<<add.from<<model->code()<< "W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
-
-            // set the wpk data
-            model->setData(bestsWPK.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
-
-            add.wpk = true;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
-
-            // so long as the model derived values are sensible ...
-            if (add.WPrime > 100.0f && add.CP > 1.0f && add.PMax > 1.0f && add.FTP > 1.0f)
-                context->athlete->PDEstimates << add;
-
-            //qDebug()<<add.from<<model->code()<< "KG W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
-        }
+        add.power = bests.aggregate();
+        add.wpk = bestsWPK.aggregate();
+        weeks << add;
 
         // go forward a week
         date = date.addDays(7);
     }
+    return weeks;
+}
+
+void
+RideCache::refreshCPModelMetrics()
+{
+    // clear any previous calculations
+    context->athlete->PDEstimates.clear(); 
+
+    // fit the models to each week, many at once
+    context->athlete->PDEstimates << PDFit::fitAll(modelBests());
 
     // add a dummy entry if we have no estimates to stop constantly trying to refresh
     if (context->athlete->PDEstimates.count() == 0) {
@@ -729,6 +1039,36 @@ RideCache::refreshCPModelMetrics()
     emit modelProgress(0, 0); // all done
 }
 
+QString
+RideCache::benchmarkCPModels()
+{
+    QList<PDFit> weeks = modelBests();
+    emit modelProgress(0, 0);
+
+    QTime timer;
+    int estimates = 0;
+
+    // one at a time from scratch, as we used to
+    PDModel::forgetFits();
+    timer.start();
+    foreach(PDFit week, weeks) estimates += PDFit::fit(week).count();
+    int serial = timer.elapsed();
+
+    // all at once from scratch
+    PDModel::forgetFits();
+    timer.start();
+    PDFit::fitAll(weeks);
+    int parallel = timer.elapsed();
+
+    // and again, as when the charts refresh
+    timer.start();
+    PDFit::fitAll(weeks);
+    int memoised = timer.elapsed();
+
+    return QString("%1 weeks, %2 estimates: serial %3ms parallel %4ms memoised %5ms")
+           .arg(weeks.count()).arg(estimates).arg(serial).arg(parallel).arg(memoised);
+}
+
 QList<QDateTime> 
 RideCache::getAllDates()
 {
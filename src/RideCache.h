@@ -26,7 +26,13 @@
 #include "PDModel.h"
 
 #include <QVector>
+#include <QHash>
 #include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QPair>
 
 #include <QFuture>
 #include <QFutureWatcher>
@@ -41,6 +47,19 @@ class RideCacheBackgroundRefresh;
 class Specification;
 class AthleteBest;
 class RideCacheModel;
+class MetricRollup;
+
+// the most recently used rides are never closed to save memory
+#define RIDECACHE_KEEPOPEN 4
+
+// how many rides either side of the selected ride to open in the background
+#define RIDECACHE_PREFETCH 1
+
+// ms to let the activities folder settle before looking at what changed
+#define RIDECACHE_RESCANDELAY 2000
+
+// size and modification time of each file in the activities folder
+typedef QHash<QString, QPair<qint64, uint> > FileListing;
 
 class RideCache : public QObject
 {
@@ -54,6 +73,9 @@ class RideCache : public QObject
         // table model
         RideCacheModel *model() { return model_; }
 
+        // aggregates by day/month
+        MetricRollup *rollup() { return rollup_; }
+
         // query the cache
         int count() const { return rides_.count(); }
         RideItem *getRide(QString filename);
@@ -70,14 +92,16 @@ class RideCache : public QObject
         QHash<QString,int> getRankedValues(QString name); // metadata
         QStringList getDistinctValues(QString name); // metadata
 
-        // is running ?
-        bool isRunning() { return future.isRunning(); }
+        // is running ? (checking or refreshing)
+        bool isRunning() { return checking || future.isRunning(); }
 
         // the ride list
 	    QVector<RideItem*>&rides() { return rides_; } 
 
         // add/remove a ride to the list
-        void addRide(QString name, bool dosignal, bool useTempActivities);
+        // later leaves the metrics to a refresh() the caller starts
+        // once it has added them all, rather than one at a time here
+        void addRide(QString name, bool dosignal, bool useTempActivities, bool later=false);
         void removeCurrentRide();
 
         // export metrics in CSV format
@@ -89,6 +113,28 @@ class RideCache : public QObject
 
         // PD Model refreshing (temporary move)
         void refreshCPModelMetrics();
+        QList<PDFit> modelBests(); // rolling 12 week bests for each week
+
+        // time fitting the models to every week
+        QString benchmarkCPModels();
+
+        // rides opened and closed, from any thread, so we can close the
+        // least recently used when they take more than GC_RIDEMEMORY MB
+        void opened(RideItem *item);
+        void closed(RideItem *item);
+        int tick() { return ticks.fetchAndAddRelaxed(1) + 1; }
+
+        // we wrote to the activities folder, so it isn't rescanned for it
+        void written(QString filename);
+
+        // open and prepare a ride in the background before it is needed,
+        // smoothed as the ride plot was last smoothed
+        void prefetch(RideItem *item);
+        void setSmoothing(int value) { smoothing_ = value; }
+
+        // take the ride opened in the background, waiting if it isn't
+        // ready yet, NULL if there isn't one or it failed to open
+        RideFile *takePrefetched(RideItem *item);
 
     public slots:
 
@@ -111,6 +157,24 @@ class RideCache : public QObject
         // clear deleted objects
         void garbageCollect();
 
+        // close old rides till we're back within the memory budget
+        void trim();
+
+        // staleness check finished, refresh any that need it
+        void scanned();
+
+        // refresh finished, again if asked for whilst it was running
+        void refreshed();
+
+        // something changed in the activities folder
+        void activitiesChanged();
+
+        // add and remove rides for files added or deleted behind our back
+        void rescanActivities();
+
+        // rides opened in the background are handed to their items
+        void prefetchDone();
+
     signals:
 
         void modelProgress(int, int); // let others know when we're refreshing the model estimates
@@ -118,6 +182,9 @@ class RideCache : public QObject
         // us telling the world the item changed
         void itemChanged(RideItem*);
 
+        // checked and nothing needed refreshing
+        void checked();
+
     protected:
 
         friend class ::RideCacheBackgroundRefresh;
@@ -125,6 +192,7 @@ class RideCache : public QObject
         Context *context;
         QVector<RideItem*> rides_, reverse_, delete_;
         RideCacheModel *model_;
+        MetricRollup *rollup_;
         bool exiting;
 	    double progress_; // percent
         unsigned long fingerprint; // zone configuration fingerprint
@@ -132,6 +200,25 @@ class RideCache : public QObject
         QFuture<void> future;
         QFutureWatcher<void> watcher;
 
+        // checking which rides are stale, before refreshing them
+        QVector<RideItem*> scan_;
+        QFuture<void> scanning;
+        QFutureWatcher<void> scanWatcher;
+        bool checking, rescan;
+        QFileSystemWatcher activities;
+        QTimer rescanTimer;
+        FileListing listing_;
+
+        // rides that are open and when they were last used
+        QMutex residentLock;
+        QList<RideItem*> resident_;
+        QAtomicInt ticks, trimQueued;
+
+        // rides being opened in the background
+        QMutex prefetchLock;
+        QHash<RideItem*, QFutureWatcher<RideFile*>*> prefetch_;
+        int smoothing_;
+
 };
 
 class AthleteBest
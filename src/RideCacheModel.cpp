@@ -32,6 +32,7 @@ RideCacheModel::RideCacheModel(Context *context, RideCache *cache) : QAbstractTa
     connect(context, SIGNAL(refreshStart()), this, SLOT(refreshStart()));
     connect(context, SIGNAL(refreshEnd()), this, SLOT(refreshEnd()));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(refreshUpdate(QDate)));
+    connect(context, SIGNAL(ridesChanged(QList<RideItem*>,QDate,QDate)), this, SLOT(ridesChanged(QList<RideItem*>)));
     connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(itemAdded(RideItem*)));
     connect(rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(itemChanged(RideItem*)));
 }
@@ -60,13 +61,13 @@ RideCacheModel::flags(const QModelIndex &index) const
 QVariant 
 RideCacheModel::data(const QModelIndex &index, int role) const
 {
-    Q_UNUSED(role);
-
     if (!index.isValid() || index.row() < 0 || index.row() >= rideCache->count() ||
         index.column() < 0 || index.column() >= columns_) return QVariant();
 
     RideItem *item = rideCache->rides()[index.row()];
 
+    if (role == SORTROLE) return sortValue(item, index.column());
+
     switch (index.column()) {
         case 0 : return item->path;
         case 1 : return item->fileName;
@@ -82,13 +83,7 @@ RideCacheModel::data(const QModelIndex &index, int role) const
             if (index.column()-5 < factory->metricCount()) {
 
                 // is a metric
-                int i=index.column()-5;
-
-                // unpack metric value into ridemetric and use it to get a stringified
-                // version using the right metric/imperial conversion
-                RideMetric *m = const_cast<RideMetric*>(factory->rideMetric(factory->metricName(i)));
-                m->setValue(rideCache->rides().at(index.row())->metrics_[m->index()]);
-                return m->toString(context->athlete->useMetricUnits);
+                return metricText(item, index.column()-5);
 
             } else {
 
@@ -100,9 +95,61 @@ RideCacheModel::data(const QModelIndex &index, int role) const
     }
 }
 
+QString
+RideCacheModel::metricText(RideItem *item, int i) const
+{
+    QVector<QString> &text = formatted[item];
+    if (text.count() != factory->metricCount()) text.resize(factory->metricCount());
+
+    if (text[i].isNull()) {
+
+        // unpack metric value into ridemetric and use it to get a stringified
+        // version using the right metric/imperial conversion
+        RideMetric *m = const_cast<RideMetric*>(factory->rideMetric(factory->metricName(i)));
+        m->setValue(item->metrics_[m->index()]);
+        text[i] = m->toString(context->athlete->useMetricUnits);
+    }
+    return text[i];
+}
+
+QVariant
+RideCacheModel::sortValue(RideItem *item, int column) const
+{
+    switch (column) {
+        case 0 : return item->path;
+        case 1 : return item->fileName;
+        case 2 : return item->dateTime;
+        case 3 : return item->present;
+        case 4 : return item->color.name();
+        case 5 : return item->isRun;
+
+        default:
+        {
+            if (column-5 < factory->metricCount()) {
+
+                // the value as stored, converting units won't change the order
+                const RideMetric *m = factory->rideMetric(factory->metricName(column-5));
+                return item->metrics_[m->index()];
+
+            } else {
+
+                // numeric fields sort as numbers not text
+                int i = column -5 - factory->metricCount();
+                QString text = item->getText(metadata[i].name, "");
+                if (metadata[i].type == FIELD_INTEGER || metadata[i].type == FIELD_DOUBLE)
+                    return text.toDouble();
+                return text;
+            }
+        }
+    }
+}
+
 void
 RideCacheModel::itemChanged(RideItem *item)
 {
+    // needs formatting again
+    formatted.remove(item);
+
     // ok so lets signal that
     int row = rideCache->rides().indexOf(item);
     if (row >= 0 && row <= rideCache->count()) {
@@ -110,7 +157,24 @@ RideCacheModel::itemChanged(RideItem *item)
     }
 }
 
-void RideCacheModel::beginReset() { beginResetModel(); }
+void
+RideCacheModel::ridesChanged(QList<RideItem*> items)
+{
+    // one signal for the rows spanning them all
+    QSet<RideItem*> changed = items.toSet();
+    foreach(RideItem *item, changed) formatted.remove(item);
+
+    int first = -1, last = -1;
+    for (int row=0; row < rideCache->count(); row++) {
+        if (changed.contains(rideCache->rides().at(row))) {
+            if (first < 0) first = row;
+            last = row;
+        }
+    }
+    if (first >= 0) emit dataChanged(createIndex(first,0), createIndex(last,columns_-1));
+}
+
+void RideCacheModel::beginReset() { formatted.clear(); beginResetModel(); }
 void RideCacheModel::endReset() { endResetModel(); }
 
 void 
@@ -124,6 +188,7 @@ RideCacheModel::itemAdded(RideItem*)
 void
 RideCacheModel::startRemove(int index)
 {
+    if (index >= 0 && index < rideCache->count()) formatted.remove(rideCache->rides().at(index));
     beginRemoveRows(QModelIndex(), index, index);
 }
 
@@ -159,11 +224,12 @@ RideCacheModel::headerData(int section, Qt::Orientation orientation, int role) c
 void 
 RideCacheModel::configChanged(qint32)
 {
-    // we are resetting
+    // we are resetting, units may have changed too
     beginResetModel();
+    formatted.clear();
 
     // get field config
-    metadata = context->athlete->rideMetadata()->getFields();
+    metadata = context->athlete->metadataFields();
 
     // set new column count
     // 0    QString path;
@@ -227,4 +293,6 @@ RideCacheModel::refreshStart()
 void 
 RideCacheModel::refreshEnd()
 {
+    // format the refreshed values afresh
+    formatted.clear();
 }
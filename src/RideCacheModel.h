@@ -30,6 +30,11 @@
 #include <QAbstractTableModel>
 #include <QModelIndex>
 #include <QVariant>
+#include <QVector>
+#include <QHash>
+
+// data() role for the value to sort by, numbers rather than the formatted text
+#define SORTROLE (Qt::UserRole+3)
 
 class Context;
 
@@ -61,6 +66,7 @@ class RideCacheModel : public QAbstractTableModel
         // and updates to ride items
         void itemChanged(RideItem *item);
         void itemAdded(RideItem *item);
+        void ridesChanged(QList<RideItem*> items); // refreshed in the background
 
         // model reset on add (if needed)
         void beginReset();
@@ -80,6 +86,12 @@ class RideCacheModel : public QAbstractTableModel
 
         // the fields as defined
         QList<FieldDefinition> metadata;
+
+        // metric values formatted for display, by ride and metric, it is
+        // filled in as cells are painted and dropped when the ride changes
+        mutable QHash<RideItem*, QVector<QString> > formatted;
+        QString metricText(RideItem *item, int i) const;
+        QVariant sortValue(RideItem *item, int column) const;
 };
 
 #endif
@@ -18,6 +18,8 @@
  */
 
 #include "RideDB.h"
+#include "GcTrace.h"
+#include "Route.h"
 
 // using context (we are reentrant)
 struct RideDBContext {
@@ -188,6 +190,8 @@ string: STRING                                               { jc->JsonString =
 void 
 RideCache::load()
 {
+    GC_TRACE("RideCache::load");
+
     // only load if it exists !
     QFile rideDB(QString("%1/rideDB.json").arg(context->athlete->home->cache().canonicalPath()));
     if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
@@ -260,6 +264,7 @@ static QString protect(const QString string)
 // save cache to disk, "cache/rideDB.json"
 void RideCache::save()
 {
+    GC_TRACE("RideCache::save");
 
     // now save data away
     QFile rideDB(QString("%1/rideDB.json").arg(context->athlete->home->cache().canonicalPath()));
@@ -346,5 +351,8 @@ void RideCache::save()
 
         rideDB.close();
     }
+
+    // the gps index is maintained alongside the metrics
+    context->athlete->routes->index->save();
 }
 
@@ -1373,6 +1373,17 @@ RideEditor::endCommand(bool undo, RideCommand *cmd)
 
             break;
         }
+        case RideCommand::SetPointValues:
+        {
+            SetPointValuesCommand *spv = (SetPointValuesCommand*)cmd;
+
+            // only ever part of a LUW, so just remember the corners
+            foreach(const SetPointValuesCommand::Run &run, spv->runs) {
+                itemselection << model->index(run.row, model->columnFor(run.series));
+                itemselection << model->index(run.row + run.newvalues.count() - 1, model->columnFor(run.series));
+            }
+            break;
+        }
         case RideCommand::InsertPoint:
         {
             InsertPointCommand *ip = (InsertPointCommand *)cmd;
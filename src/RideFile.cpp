@@ -19,7 +19,9 @@
  */
 
 #include "RideFile.h"
+#include "GcTrace.h"
 #include "WPrime.h"
+#include "Smoother.h"
 #include "Athlete.h"
 #include "DataProcessor.h"
 #include "RideEditor.h"
@@ -27,6 +29,7 @@
 #include "Settings.h"
 #include "Colors.h"
 #include "Units.h"
+#include "JsonRideFile.h"
 
 #include <QtXml/QtXml>
 #include <algorithm> // for std::lower_bound
@@ -47,7 +50,7 @@ const QChar deltaChar(0x0394);
 RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
             startTime_(startTime), recIntSecs_(recIntSecs),
             deviceType_("unknown"), data(NULL), wprime_(NULL), 
-            wstale(true), weight_(0), totalCount(0), totalTemp(0), dstale(true)
+            wstale(true), weight_(0), totalCount(0), totalTemp(0), dstale(DerivedAll), view_(false), samplesSaved_(false)
 {
     command = new RideFileCommand(this);
 
@@ -62,7 +65,7 @@ RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
 // and we want to get special fields and ESPECIALLY "CP" and "Weight"
 RideFile::RideFile(RideFile *p) :
     recIntSecs_(p->recIntSecs_), deviceType_(p->deviceType_), data(NULL), wprime_(NULL), 
-    wstale(true), weight_(p->weight_), totalCount(0), dstale(true)
+    wstale(true), weight_(p->weight_), totalCount(0), dstale(DerivedAll), view_(false), samplesSaved_(false)
 {
     startTime_ = p->startTime_;
     tags_ = p->tags_;
@@ -83,7 +86,7 @@ RideFile::RideFile(RideFile *p) :
 
 RideFile::RideFile() : 
     recIntSecs_(0.0), deviceType_("unknown"), data(NULL), wprime_(NULL), 
-    wstale(true), weight_(0), totalCount(0), dstale(true)
+    wstale(true), weight_(0), totalCount(0), dstale(DerivedAll), view_(false), samplesSaved_(false)
 {
     command = new RideFileCommand(this);
 
@@ -93,11 +96,60 @@ RideFile::RideFile() :
     totalPoint = new RideFilePoint();
 }
 
+// a view on part of another ride, used when computing metrics for
+// intervals, rather than copying every sample we share them
+RideFile::RideFile(RideFile *p, int begin, int end) :
+    recIntSecs_(p->recIntSecs_), deviceType_(p->deviceType_), data(NULL), wprime_(NULL),
+    wstale(true), weight_(p->weight_), totalCount(0), totalTemp(0), dstale(0), view_(true), samplesSaved_(false)
+{
+    startTime_ = p->startTime_;
+    tags_ = p->tags_;
+    referencePoints_ = p->referencePoints_;
+    fileFormat_ = p->fileFormat_;
+    intervals_ = p->intervals_;
+    calibrations_ = p->calibrations_;
+    context = p->context;
+
+    command = new RideFileCommand(this);
+    minPoint = new RideFilePoint();
+    maxPoint = new RideFilePoint();
+    avgPoint = new RideFilePoint();
+    totalPoint = new RideFilePoint();
+
+    // we use the parent's derived data, which is computed
+    // over the whole ride (e.g. NP rolls into the interval)
+    p->recalculateDerivedSeries();
+
+    if (begin < 0) begin = 0;
+    if (end >= p->dataPoints_.count()) end = p->dataPoints_.count()-1;
+    if (end < begin) return;
+
+    dataPoints_ = p->dataPoints_.mid(begin, end - begin + 1);
+    foreach(RideFilePoint *point, dataPoints_) {
+        updatePresent(point);
+        updateMin(point);
+        updateMax(point);
+        updateAvg(point);
+    }
+
+    // derived series are as the parent's
+    dataPresent.np = p->dataPresent.np;
+    dataPresent.xp = p->dataPresent.xp;
+    dataPresent.apower = p->dataPresent.apower;
+    dataPresent.atiss = p->dataPresent.atiss;
+    dataPresent.antiss = p->dataPresent.antiss;
+    dataPresent.gear = p->dataPresent.gear;
+    dataPresent.hhb = p->dataPresent.hhb;
+    dataPresent.o2hb = p->dataPresent.o2hb;
+}
+
 RideFile::~RideFile()
 {
     emit deleted();
-    foreach(RideFilePoint *point, dataPoints_)
-        delete point;
+    if (!view_) {
+        foreach(RideFilePoint *point, dataPoints_)
+            delete point;
+    }
     delete command;
     if (wprime_) delete wprime_;
     //!!! if (data) delete data; // need a mechanism to notify the editor
@@ -134,6 +186,19 @@ RideFile::wprimeData()
     return wprime_;
 }
 
+QSharedPointer<Smoother>
+RideFile::smoother()
+{
+    if (!smoother_) smoother_ = QSharedPointer<Smoother>(new Smoother());
+    return smoother_;
+}
+
+void
+RideFile::forgetSmoothed()
+{
+    if (smoother_) smoother_->clear();
+}
+
 bool
 RideFile::isRun() const
 {
@@ -503,14 +568,36 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
     suffix.remove(0, dot + 1);
     RideFileReader *reader = readFuncs_.value(suffix.toLower());
     assert(reader);
-//qDebug()<<"open"<<file.fileName()<<"start:"<<QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+    GC_TRACE("RideFileFactory::openRideFile");
     RideFile *result = reader->openRideFile(file, errors, rideList);
-//qDebug()<<"open"<<file.fileName()<<"end:"<<QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
 
     // NULL returned to indicate openRide failed
     if (result) {
         result->context = context;
 
+        // metadata saved on its own since, replaces what's in the file
+        QFile sidecar(sidecarFileName(file.fileName()));
+        if (sidecar.exists()) {
+            JsonFileReader reader;
+            QStringList sidecarErrors;
+            RideFile *meta = reader.openRideFile(sidecar, sidecarErrors);
+            if (meta) {
+                result->setRecIntSecs(meta->recIntSecs());
+                result->setDeviceType(meta->deviceType());
+                result->setId(meta->id());
+                result->metricOverrides = meta->metricOverrides;
+                QMapIterator<QString,QString> i(meta->tags());
+                while (i.hasNext()) {
+                    i.next();
+                    result->setTag(i.key(), i.value());
+                }
+                result->clearIntervals();
+                foreach(RideFileInterval interval, meta->intervals())
+                    result->addInterval(interval.start, interval.stop, interval.name);
+                delete meta;
+            }
+        }
+
         if (result->intervals().empty()) result->fillInIntervals();
         // override the file ride time with that set from the filename
         // but only if it matches the GC format
@@ -539,7 +626,7 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
         // Construct the summary text used on the calendar
         QString calendarText;
-        foreach (FieldDefinition field, context->athlete->rideMetadata()->getFields()) {
+        foreach (FieldDefinition field, context->athlete->metadataFields()) {
             if (field.diary == true && result->getTag(field.name, "") != "") {
                 calendarText += QString("%1\n")
                         .arg(result->getTag(field.name, ""));
@@ -614,6 +701,8 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
         else flags += '-';
         result->setTag("Data", flags);
 
+        // json only gets rewritten when the samples change
+        result->setSamplesSaved(suffix.toLower() == "json");
     }
 
     return result;
@@ -870,6 +959,44 @@ void RideFile::updateAvg(RideFilePoint* point)
     avgPoint->gear = totalPoint->gear/totalCount;
 }
 
+void RideFile::updatePresent(RideFilePoint* point)
+{
+    dataPresent.secs     |= (point->secs != 0);
+    dataPresent.cad      |= (point->cad != 0);
+    dataPresent.hr       |= (point->hr != 0);
+    dataPresent.km       |= (point->km != 0);
+    dataPresent.kph      |= (point->kph != 0);
+    dataPresent.nm       |= (point->nm != 0);
+    dataPresent.watts    |= (point->watts != 0);
+    dataPresent.alt      |= (point->alt != 0);
+    dataPresent.lon      |= (point->lon != 0);
+    dataPresent.lat      |= (point->lat != 0);
+    dataPresent.headwind |= (point->headwind != 0);
+    dataPresent.slope    |= (point->slope != 0);
+    dataPresent.temp     |= (point->temp != NoTemp);
+    dataPresent.lrbalance|= (point->lrbalance != 0);
+    dataPresent.lte      |= (point->lte != 0);
+    dataPresent.rte      |= (point->rte != 0);
+    dataPresent.lps      |= (point->lps != 0);
+    dataPresent.rps      |= (point->rps != 0);
+    dataPresent.lpco     |= (point->lpco != 0);
+    dataPresent.rpco     |= (point->rpco != 0);
+    dataPresent.lppb     |= (point->lppb != 0);
+    dataPresent.rppb     |= (point->rppb != 0);
+    dataPresent.lppe     |= (point->lppe != 0);
+    dataPresent.rppe     |= (point->rppe != 0);
+    dataPresent.lpppb    |= (point->lpppb != 0);
+    dataPresent.rpppb    |= (point->rpppb != 0);
+    dataPresent.lpppe    |= (point->lpppe != 0);
+    dataPresent.rpppe    |= (point->rpppe != 0);
+    dataPresent.smo2     |= (point->smo2 != 0);
+    dataPresent.thb      |= (point->thb != 0);
+    dataPresent.rvert    |= (point->rvert != 0);
+    dataPresent.rcad     |= (point->rcad != 0);
+    dataPresent.rcontact |= (point->rcontact != 0);
+    dataPresent.interval |= (point->interval != 0);
+}
+
 void RideFile::appendPoint(double secs, double cad, double hr, double km,
                            double kph, double nm, double watts, double alt,
                            double lon, double lat, double headwind,
@@ -882,6 +1009,10 @@ void RideFile::appendPoint(double secs, double cad, double hr, double km,
                            double rvert, double rcad, double rcontact,
                            int interval)
 {
+    if (view_) return; // read-only
+    dstale = DerivedAll;
+    samplesSaved_ = false;
+
     // negative values are not good, make them zero
     // although alt, lat, lon, headwind, slope and temperature can be negative of course!
     if (!std::isfinite(secs) || secs<0) secs=0;
@@ -927,40 +1058,7 @@ void RideFile::appendPoint(double secs, double cad, double hr, double km,
                                              interval);
     dataPoints_.append(point);
 
-    dataPresent.secs     |= (secs != 0);
-    dataPresent.cad      |= (cad != 0);
-    dataPresent.hr       |= (hr != 0);
-    dataPresent.km       |= (km != 0);
-    dataPresent.kph      |= (kph != 0);
-    dataPresent.nm       |= (nm != 0);
-    dataPresent.watts    |= (watts != 0);
-    dataPresent.alt      |= (alt != 0);
-    dataPresent.lon      |= (lon != 0);
-    dataPresent.lat      |= (lat != 0);
-    dataPresent.headwind |= (headwind != 0);
-    dataPresent.slope    |= (slope != 0);
-    dataPresent.temp     |= (temp != NoTemp);
-    dataPresent.lrbalance|= (lrbalance != 0);
-    dataPresent.lte      |= (lte != 0);
-    dataPresent.rte      |= (rte != 0);
-    dataPresent.lps      |= (lps != 0);
-    dataPresent.rps      |= (rps != 0);
-    dataPresent.lpco     |= (lpco != 0);
-    dataPresent.rpco     |= (rpco != 0);
-    dataPresent.lppb     |= (lppb != 0);
-    dataPresent.rppb     |= (rppb != 0);
-    dataPresent.lppe     |= (lppe != 0);
-    dataPresent.rppe     |= (rppe != 0);
-    dataPresent.lpppb    |= (lpppb != 0);
-    dataPresent.rpppb    |= (rpppb != 0);
-    dataPresent.lpppe    |= (lpppe != 0);
-    dataPresent.rpppe    |= (rpppe != 0);
-    dataPresent.smo2     |= (smo2 != 0);
-    dataPresent.thb      |= (thb != 0);
-    dataPresent.rvert    |= (rvert != 0);
-    dataPresent.rcad     |= (rcad != 0);
-    dataPresent.rcontact |= (rcontact != 0);
-    dataPresent.interval |= (interval != 0);
+    updatePresent(point);
 
     updateMin(point);
     updateMax(point);
@@ -984,6 +1082,11 @@ void RideFile::appendPoint(const RideFilePoint &point)
 void
 RideFile::setDataPresent(SeriesType series, bool value)
 {
+    if (isDataPresent(series) != value) {
+        dstale |= derivedFrom(series);
+        forgetSmoothed();
+    }
+
     switch (series) {
         case secs : dataPresent.secs = value; break;
         case cad : dataPresent.cad = value; break;
@@ -1080,6 +1183,10 @@ RideFile::isDataPresent(SeriesType series)
 void
 RideFile::setPointValue(int index, SeriesType series, double value)
 {
+    if (view_) return; // read-only
+    dstale |= derivedFrom(series);
+    samplesSaved_ = false;
+    forgetSmoothed();
     switch (series) {
         case secs : dataPoints_[index]->secs = value; break;
         case cad : dataPoints_[index]->cad = value; break;
@@ -1445,6 +1552,10 @@ RideFile::minimumFor(SeriesType series)
 void
 RideFile::deletePoint(int index)
 {
+    if (view_) return; // read-only
+    dstale = DerivedAll;
+    samplesSaved_ = false;
+    forgetSmoothed();
     delete dataPoints_[index];
     dataPoints_.remove(index);
 }
@@ -1452,6 +1563,10 @@ RideFile::deletePoint(int index)
 void
 RideFile::deletePoints(int index, int count)
 {
+    if (view_) return; // read-only
+    dstale = DerivedAll;
+    samplesSaved_ = false;
+    forgetSmoothed();
     for(int i=index; i<(index+count); i++) delete dataPoints_[i];
     dataPoints_.remove(index, count);
 }
@@ -1459,12 +1574,20 @@ RideFile::deletePoints(int index, int count)
 void
 RideFile::insertPoint(int index, RideFilePoint *point)
 {
+    if (view_) return; // read-only
+    dstale = DerivedAll;
+    samplesSaved_ = false;
+    forgetSmoothed();
     dataPoints_.insert(index, point);
 }
 
 void
 RideFile::appendPoints(QVector <struct RideFilePoint *> newRows)
 {
+    if (view_) return; // read-only
+    dstale = DerivedAll;
+    samplesSaved_ = false;
+    forgetSmoothed();
     dataPoints_ += newRows;
 }
 
@@ -1472,7 +1595,8 @@ void
 RideFile::emitSaved()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = true;
+    dstale |= DerivedFromConfig; // metadata may have changed
     emit saved();
 }
 
@@ -1480,20 +1604,26 @@ void
 RideFile::emitReverted()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = true;
+    dstale = DerivedAll;
+    forgetSmoothed();
     emit reverted();
 }
 
 void
 RideFile::emitModified()
 {
+    // derived series affected were marked stale as they changed
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = true;
+    samplesSaved_ = false;
+    forgetSmoothed(); // some tools change the samples directly
     emit modified();
 }
 
 void RideFile::appendReference(const RideFilePoint &point)
 {
+    samplesSaved_ = false; // not in the sidecar
     referencePoints_.append(new RideFilePoint(point.secs,point.cad,point.hr,point.km,point.kph,point.nm,
                                               point.watts,point.alt,point.lon,point.lat,
                                               point.headwind, point.slope, point.temp, point.lrbalance, 
@@ -1508,6 +1638,7 @@ void RideFile::appendReference(const RideFilePoint &point)
 
 void RideFile::removeReference(int index)
 {
+    samplesSaved_ = false; // not in the sidecar
     referencePoints_.remove(index);
 }
 
@@ -1542,82 +1673,92 @@ RideFile::parseRideFileName(const QString &name, QDateTime *dt)
 // performance." Journal of Applied Physiology 70:399-404
 //
 
+// which derived series are computed from each series
+int
+RideFile::derivedFrom(SeriesType series)
+{
+    switch (series) {
+    case secs : return DerivedDelta | DerivedXP;
+    case kph : return DerivedDelta | DerivedGear;
+    case watts : return DerivedDelta | DerivedNP | DerivedXP | DerivedAPower | DerivedTISS | DerivedGear;
+    case cad : return DerivedDelta | DerivedGear;
+    case nm :
+    case hr : return DerivedDelta;
+    case alt : return DerivedAPower | DerivedSlope;
+    case km :
+    case slope : return DerivedSlope;
+    case smo2 :
+    case thb : return DerivedHb;
+    default : return 0;
+    }
+}
+
 void
 RideFile::recalculateDerivedSeries(bool force)
 {
     // derived data is calculated from the data that is present
     // we should set to 0 where we cannot derive since we may
     // be called after data is deleted or added
-    if (!force && dstale == false) return; // we're already up to date
+    if (force) dstale = DerivedAll;
+    if (!dstale) return; // we're already up to date
+    if (view_) return; // derived data belongs to the parent
 
-    //
-    // NP Initialisation -- working variables
-    //
-    QVector<double> NProlling;
-    int NProllingwindowsize = 30 / (recIntSecs_ ? recIntSecs_ : 1);
-    if (NProllingwindowsize > 1) NProlling.resize(NProllingwindowsize);
-    double NPtotal = 0;
-    int NPcount = 0;
-    int NPindex = 0;
-    double NPsum = 0;
-
-    //
-    // XPower Initialisation -- working variables
-    //
-    static const double EPSILON = 0.1;
-    static const double NEGLIGIBLE = 0.1;
-    double XPsecsDelta = recIntSecs_ ? recIntSecs_ : 1;
-    double XPsampsPerWindow = 25.0 / XPsecsDelta;
-    double XPattenuation = XPsampsPerWindow / (XPsampsPerWindow + XPsecsDelta);
-    double XPsampleWeight = XPsecsDelta / (XPsampsPerWindow + XPsecsDelta);
-    double XPlastSecs = 0.0;
-    double XPweighted = 0.0;
-    double XPtotal = 0.0;
-    int XPcount = 0;
-
-    //
-    // APower Initialisation -- working variables
-    double APtotal=0;
-    double APcount=0;
+    recalculate(dstale);
+}
 
-    // aTISS - Aerobic Training Impact Scoring System
-    static const double a = 0.663788683661645f;
-    static const double b = -7.5095428451195f;
-    static const double c = -0.86118031563782f;
-    //static const double t = 2;
-    // anTISS
-    static const double an = 0.238923886004611f;
-    //static const double bn = -12.2066385296127f;
-    static const double bn = -61.849f;
-    static const double cn = -1.73549567522521f;
+void
+RideFile::recalculateDerivedSeries(SeriesType series)
+{
+    if (view_) return; // derived data belongs to the parent
 
-    int CP = 0;
-    //int WPRIME = 0;
-    double aTISS = 0.0f;
-    double anTISS = 0.0f;
+    int want;
+    switch (series) {
+    case kphd :
+    case wattsd :
+    case cadd :
+    case nmd :
+    case hrd : want = DerivedDelta; break;
+    case NP : want = DerivedNP; break;
+    case xPower : want = DerivedXP; break;
+    case aPower : want = DerivedAPower; break;
+    case aTISS :
+    case anTISS : want = DerivedTISS; break;
+    case slope : want = DerivedSlope; break;
+    case gear : want = DerivedGear; break;
+    case o2hb :
+    case hhb : want = DerivedHb; break;
+    default : want = 0; break;
+    }
 
-    // set WPrime and CP
-    if (context->athlete->zones()) {
-        int zoneRange = context->athlete->zones()->whichRange(startTime().date());
-        CP = zoneRange >= 0 ? context->athlete->zones()->getCP(zoneRange) : 0;
-        //WPRIME = zoneRange >= 0 ? context->athlete->zones()->getWprime(zoneRange) : 0;
+    // only if it needs it
+    if (dstale & want) recalculate(dstale & want);
+}
 
-        // did we override CP in metadata / metrics ?
-        int oCP = getTag("CP","0").toInt();
-        if (oCP) CP=oCP;
-    }
+void
+RideFile::recalculate(int which)
+{
+    if (which & DerivedDelta) deriveDeltas();
+    if (which & DerivedNP) deriveNP();
+    if (which & DerivedXP) deriveXP();
+    if (which & DerivedAPower) deriveAPower();
+    if (which & DerivedTISS) deriveTISS();
+    if (which & DerivedSlope) deriveSlope();
+    if (which & DerivedGear) deriveGear();
+    if (which & DerivedHb) deriveHb();
 
-    // wheelsize - use meta, then config then drop to 2100
-    double wheelsize = getTag(tr("Wheelsize"), "0.0").toDouble();
-    if (wheelsize == 0) wheelsize = appsettings->value(this, GC_WHEELSIZE, 2100).toInt();
-    wheelsize /= 1000.00f; // need it in meters
+    // and we're done, the derived series are smoothed too
+    dstale &= ~which;
+    forgetSmoothed();
+}
 
+void
+RideFile::deriveDeltas()
+{
     // last point looked at
     RideFilePoint *lastP = NULL;
 
     foreach(RideFilePoint *p, dataPoints_) {
 
-        // Delta
         if (lastP) {
 
             double deltaSpeed = (p->kph - lastP->kph) / 3.60f;
@@ -1644,13 +1785,27 @@ RideFile::recalculateDerivedSeries(bool force)
 
             }
         }
+        lastP = p;
+    }
+}
 
-        //
-        // NP
-        //
-        if (dataPresent.watts && NProllingwindowsize > 1) {
+void
+RideFile::deriveNP()
+{
+    QVector<double> NProlling;
+    int NProllingwindowsize = 30 / (recIntSecs_ ? recIntSecs_ : 1);
+    if (NProllingwindowsize > 1) NProlling.resize(NProllingwindowsize);
+    double NPtotal = 0;
+    int NPcount = 0;
+    int NPindex = 0;
+    double NPsum = 0;
+
+    bool want = dataPresent.watts && NProllingwindowsize > 1;
+    if (want) dataPresent.np = true;
+
+    foreach(RideFilePoint *p, dataPoints_) {
 
-            dataPresent.np = true;
+        if (want) {
 
             // sum last 30secs
             NPsum += p->watts;
@@ -1679,13 +1834,31 @@ RideFile::recalculateDerivedSeries(bool force)
         // now the min and max values for NP
         if (p->np > maxPoint->np) maxPoint->np = p->np;
         if (p->np < minPoint->np) minPoint->np = p->np;
+    }
 
-        //
-        // xPower
-        //
-        if (dataPresent.watts) {
+    avgPoint->np = NPcount ? (NPtotal / NPcount) : 0;
+    totalPoint->np = NPtotal;
+}
 
-            dataPresent.xp = true;
+void
+RideFile::deriveXP()
+{
+    static const double EPSILON = 0.1;
+    static const double NEGLIGIBLE = 0.1;
+    double XPsecsDelta = recIntSecs_ ? recIntSecs_ : 1;
+    double XPsampsPerWindow = 25.0 / XPsecsDelta;
+    double XPattenuation = XPsampsPerWindow / (XPsampsPerWindow + XPsecsDelta);
+    double XPsampleWeight = XPsecsDelta / (XPsampsPerWindow + XPsecsDelta);
+    double XPlastSecs = 0.0;
+    double XPweighted = 0.0;
+    double XPtotal = 0.0;
+    int XPcount = 0;
+
+    if (dataPresent.watts) dataPresent.xp = true;
+
+    foreach(RideFilePoint *p, dataPoints_) {
+
+        if (dataPresent.watts) {
 
             while ((XPweighted > NEGLIGIBLE) && (p->secs > XPlastSecs + XPsecsDelta + EPSILON)) {
                 XPweighted *= XPattenuation;
@@ -1703,75 +1876,156 @@ RideFile::recalculateDerivedSeries(bool force)
             p->xp = pow(XPtotal / XPcount, 0.25);
         }
 
-        // now the min and max values for NP
+        // now the min and max values for xPower
         if (p->xp > maxPoint->xp) maxPoint->xp = p->xp;
         if (p->xp < minPoint->xp) minPoint->xp = p->xp;
+    }
 
-        // aPower
-        if (dataPresent.watts == true && dataPresent.alt == true) {
+    avgPoint->xp = XPcount ? (XPtotal / XPcount) : 0;
+    totalPoint->xp = XPtotal;
+}
 
-            dataPresent.apower = true;
+void
+RideFile::deriveAPower()
+{
+    static const double a0  = -174.1448622f;
+    static const double a1  = 1.0899959f;
+    static const double a2  = -0.0015119f;
+    static const double a3  = 7.2674E-07f;
 
-            static const double a0  = -174.1448622f;
-            static const double a1  = 1.0899959f;
-            static const double a2  = -0.0015119f;
-            static const double a3  = 7.2674E-07f;
-            //static const double E = 2.71828183f;
+    double APtotal=0;
+    double APcount=0;
 
-            if (p->alt > 0) {
-                // pbar [mbar]= 0.76*EXP( -alt[m] / 7000 )*1000 
-                double pbar = 0.76f * exp(p->alt / -7000.00f) * 1000.00f;
+    bool want = dataPresent.watts == true && dataPresent.alt == true;
+    if (want) dataPresent.apower = true;
 
-                // %Vo2max= a0 + a1 * pbar + a2 * pbar ^2 + a3 * pbar ^3 (with pbar in mbar)
-                double vo2maxPCT = a0 + (a1 * pbar) + (a2 * pow(pbar,2)) + (a3 * pow(pbar,3)); 
+    foreach(RideFilePoint *p, dataPoints_) {
 
-                p->apower = double(p->watts / vo2maxPCT) * 100;
+        if (want && p->alt > 0) {
 
-            } else {
+            // pbar [mbar]= 0.76*EXP( -alt[m] / 7000 )*1000 
+            double pbar = 0.76f * exp(p->alt / -7000.00f) * 1000.00f;
 
-                p->apower = p->watts;
-            }
+            // %Vo2max= a0 + a1 * pbar + a2 * pbar ^2 + a3 * pbar ^3 (with pbar in mbar)
+            double vo2maxPCT = a0 + pbar * (a1 + pbar * (a2 + pbar * a3));
+
+            p->apower = double(p->watts / vo2maxPCT) * 100;
 
         } else {
 
             p->apower = p->watts;
         }
 
-        // now the min and max values for NP
+        // now the min and max values for aPower
         if (p->apower > maxPoint->apower) maxPoint->apower = p->apower;
         if (p->apower < minPoint->apower) minPoint->apower = p->apower;
 
         APtotal += p->apower;
         APcount++;
+    }
 
-        // Anaerobic and Aerobic TISS
-        if (CP && dataPresent.watts) {
+    avgPoint->apower = APcount ? (APtotal / APcount) : 0;
+    totalPoint->apower = APtotal;
+}
 
-            // a * exp (b * exp (c * fraction of cp) ) 
-            aTISS += recIntSecs_ * (a * exp(b * exp(c * (double(p->watts) / double(CP)))));
-            anTISS += recIntSecs_ * (an * exp(bn * exp(cn * (double(p->watts) / double(CP)))));
-            p->atiss = aTISS;
-            p->antiss = anTISS;
-        }
+void
+RideFile::deriveTISS()
+{
+    // aTISS - Aerobic Training Impact Scoring System
+    static const double a = 0.663788683661645f;
+    static const double b = -7.5095428451195f;
+    static const double c = -0.86118031563782f;
+    // anTISS
+    static const double an = 0.238923886004611f;
+    static const double bn = -61.849f;
+    static const double cn = -1.73549567522521f;
 
-        if (!dataPresent.slope && dataPresent.alt && dataPresent.km) {
-            if (lastP) {
-                double deltaDistance = (p->km - lastP->km) * 1000;
-                double deltaAltitude = p->alt - lastP->alt;
-                if (deltaDistance>0) {
-                    p->slope = (deltaAltitude / deltaDistance) * 100;
-                } else {
-                    p->slope = 0;
-                }
-                if (p->slope > 20 || p->slope < -20) {
-                    p->slope = lastP->slope;
-                }
+    int CP = 0;
+
+    // set CP
+    if (context->athlete->zones()) {
+        int zoneRange = context->athlete->config()->zoneRange(startTime().date());
+        CP = zoneRange >= 0 ? context->athlete->zones()->getCP(zoneRange) : 0;
+
+        // did we override CP in metadata / metrics ?
+        int oCP = getTag("CP","0").toInt();
+        if (oCP) CP=oCP;
+    }
+    if (!CP || !dataPresent.watts) return;
+
+    // fraction of CP scaled once, not per sample
+    const double ac = c / double(CP);
+    const double anc = cn / double(CP);
+    double aTISS = 0.0f;
+    double anTISS = 0.0f;
+
+    foreach(RideFilePoint *p, dataPoints_) {
+
+        // a * exp (b * exp (c * fraction of cp) ) 
+        aTISS += recIntSecs_ * (a * exp(b * exp(ac * p->watts)));
+        anTISS += recIntSecs_ * (an * exp(bn * exp(anc * p->watts)));
+        p->atiss = aTISS;
+        p->antiss = anTISS;
+    }
+}
+
+void
+RideFile::deriveSlope()
+{
+    // only when we don't have it
+    if (dataPresent.slope || !dataPresent.alt || !dataPresent.km) return;
+
+    RideFilePoint *lastP = NULL;
+    foreach(RideFilePoint *p, dataPoints_) {
+
+        if (lastP) {
+            double deltaDistance = (p->km - lastP->km) * 1000;
+            double deltaAltitude = p->alt - lastP->alt;
+            if (deltaDistance>0) {
+                p->slope = (deltaAltitude / deltaDistance) * 100;
+            } else {
+                p->slope = 0;
+            }
+            if (p->slope > 20 || p->slope < -20) {
+                p->slope = lastP->slope;
             }
         }
+        lastP = p;
+    }
+
+    // Smooth the slope now it has been derived
+    int smoothPoints = 10;
+    // initialise rolling average
+    double rtot = 0;
+    for (int i=smoothPoints; i>0 && dataPoints_.count()-i >=0; i--) {
+        rtot += dataPoints_[dataPoints_.count()-i]->slope;
+    }
+
+    // now run backwards setting the rolling average
+    for (int i=dataPoints_.count()-1; i>=smoothPoints; i--) {
+        double here = dataPoints_[i]->slope;
+        dataPoints_[i]->slope = rtot / smoothPoints;
+        rtot -= here;
+        rtot += dataPoints_[i-smoothPoints]->slope;
+    }
+    setDataPresent(RideFile::slope, true);
+}
+
+void
+RideFile::deriveGear()
+{
+    // wheelsize - use meta, then config then drop to 2100
+    double wheelsize = getTag(tr("Wheelsize"), "0.0").toDouble();
+    if (wheelsize == 0) wheelsize = appsettings->value(this, GC_WHEELSIZE, 2100).toInt();
+    wheelsize /= 1000.00f; // need it in meters
+
+    bool cycling = !isRun() && !isSwim();
+
+    foreach(RideFilePoint *p, dataPoints_) {
 
         // can we derive gear ratio ?
         // needs speed and cadence
-        if (p->kph && p->cad && !isRun() && !isSwim()) {
+        if (p->kph && p->cad && cycling) {
 
             // need to say we got it
             setDataPresent(RideFile::gear, true);
@@ -1812,25 +2066,6 @@ RideFile::recalculateDerivedSeries(bool force)
         } else {
             p->gear = 0.0f;
         }
-
-        // split out O2Hb and HHb when we have SmO2 and tHb
-        // O2Hb is oxygenated haemoglobin and HHb is deoxygenated haemoglobin
-        if (dataPresent.smo2 && dataPresent.thb) {
-
-            if (p->smo2 > 0 && p->thb > 0) {
-                setDataPresent(RideFile::o2hb, true);
-                setDataPresent(RideFile::hhb, true);
-
-                p->o2hb = (p->thb * p->smo2) / 100.00f;
-                p->hhb = p->thb - p->o2hb;
-            } else {
-
-                p->o2hb = p->hhb = 0;
-            }
-        }
-
-        // last point
-        lastP = p;
     }
 
     // remove gear outlier (for single outlier values = 1 second) and
@@ -1860,38 +2095,28 @@ RideFile::recalculateDerivedSeries(bool force)
 
         }
     }
+}
 
-    // Smooth the slope if it has been derived
-    if (!dataPresent.slope && dataPresent.alt && dataPresent.km) {
-        int smoothPoints = 10;
-        // initialise rolling average
-        double rtot = 0;
-        for (int i=smoothPoints; i>0 && dataPoints_.count()-i >=0; i--) {
-            rtot += dataPoints_[dataPoints_.count()-i]->slope;
-        }
-
-        // now run backwards setting the rolling average
-        for (int i=dataPoints_.count()-1; i>=smoothPoints; i--) {
-            double here = dataPoints_[i]->slope;
-            dataPoints_[i]->slope = rtot / smoothPoints;
-            rtot -= here;
-            rtot += dataPoints_[i-smoothPoints]->slope;
-        }
-        setDataPresent(RideFile::slope, true);
-    }
+void
+RideFile::deriveHb()
+{
+    // split out O2Hb and HHb when we have SmO2 and tHb
+    // O2Hb is oxygenated haemoglobin and HHb is deoxygenated haemoglobin
+    if (!dataPresent.smo2 || !dataPresent.thb) return;
 
-    // Averages and Totals
-    avgPoint->np = NPcount ? (NPtotal / NPcount) : 0;
-    totalPoint->np = NPtotal;
+    foreach(RideFilePoint *p, dataPoints_) {
 
-    avgPoint->xp = XPcount ? (XPtotal / XPcount) : 0;
-    totalPoint->xp = XPtotal;
+        if (p->smo2 > 0 && p->thb > 0) {
+            setDataPresent(RideFile::o2hb, true);
+            setDataPresent(RideFile::hhb, true);
 
-    avgPoint->apower = APcount ? (APtotal / APcount) : 0;
-    totalPoint->apower = APtotal;
+            p->o2hb = (p->thb * p->smo2) / 100.00f;
+            p->hhb = p->thb - p->o2hb;
+        } else {
 
-    // and we're done
-    dstale=false;
+            p->o2hb = p->hhb = 0;
+        }
+    }
 }
 
 RideFile *
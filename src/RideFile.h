@@ -27,10 +27,12 @@
 #include <QMap>
 #include <QVector>
 #include <QObject>
+#include <QSharedPointer>
 
 class RideItem;
 class RideCache;
 class WPrime;
+class Smoother;
 class RideFile;
 struct RideFilePoint;
 struct RideFileDataPresent;
@@ -142,6 +144,13 @@ class RideFile : public QObject // QObject to emit signals
         RideFile(const QDateTime &startTime, double recIntSecs);
         virtual ~RideFile();
 
+        // a read-only view of samples begin to end (inclusive) of the
+        // parent, the samples are shared not copied so it can be passed
+        // to metrics and RideFileCache for an interval cheaply. The parent
+        // must outlive the view and its derived series are used as is
+        RideFile(RideFile *parent, int begin, int end);
+        bool isView() const { return view_; }
+
         // construct a new ridefile using the current one, but
         // resample the data and fill gaps in recording with
         // the max gap to interpolate also passed as a parameter
@@ -200,11 +209,16 @@ class RideFile : public QObject // QObject to emit signals
         //
         // YOU MUST ALWAYS CALL THIS BEFORE ACESSING
         // THE DERIVED DATA. IT IS REFRESHED ON DEMAND.
-        // STATE IS MAINTAINED IN 'bool dstale' BELOW
-        // TO ENSURE IT IS ONLY REFRESHED IF NEEDED
+        // STATE IS MAINTAINED IN 'int dstale' BELOW
+        // TO ENSURE IT IS ONLY REFRESHED IF NEEDED,
+        // EACH GROUP OF SERIES IS MARKED STALE WHEN
+        // THE SERIES IT IS DERIVED FROM ARE CHANGED
         //
         void recalculateDerivedSeries(bool force=false);
 
+        // just the one derived series (e.g. NP) if stale
+        void recalculateDerivedSeries(SeriesType series);
+
         // Working with DATAPRESENT flags
         inline const RideFileDataPresent *areDataPresent() const { return &dataPresent; }
         bool isDataPresent(SeriesType series);
@@ -213,7 +227,7 @@ class RideFile : public QObject // QObject to emit signals
         const QDateTime &startTime() const { return startTime_; }
         void setStartTime(const QDateTime &value) { startTime_ = value; }
         double recIntSecs() const { return recIntSecs_; }
-        void setRecIntSecs(double value) { recIntSecs_ = value; }
+        void setRecIntSecs(double value) { recIntSecs_ = value; dstale = DerivedAll; }
         const QString &deviceType() const { return deviceType_; }
         void setDeviceType(const QString &value) { deviceType_ = value; }
         const QString &fileFormat() const { return fileFormat_; }
@@ -234,6 +248,7 @@ class RideFile : public QObject // QObject to emit signals
         const QList<RideFileCalibration> &calibrations() const { return calibrations_; }
         void addCalibration(double start, int value, const QString &name) {
             calibrations_.append(RideFileCalibration(start, value, name));
+            samplesSaved_ = false; // not in the sidecar
         }
 
         // Working with REFERENCES
@@ -258,9 +273,20 @@ class RideFile : public QObject // QObject to emit signals
  
         WPrime *wprimeData(); // return wprime, init/refresh if needed
 
+        // the ride plot's smoothed series, kept with the samples so they can
+        // be smoothed in the background before the ride is shown and forgotten
+        // when the samples change
+        QSharedPointer<Smoother> smoother();
+
         // METRIC OVERRIDES
         QMap<QString,QMap<QString,QString> > metricOverrides;
 
+        // the samples are just as they are in the json file on disk, so
+        // saving metadata, tags and intervals can go to the sidecar alone
+        // changing samples, references or calibrations clears it
+        bool samplesSaved() const { return samplesSaved_; }
+        void setSamplesSaved(bool x) { samplesSaved_ = x; }
+
         // editor data is held here and updated
         // as rows/columns are added/removed
         // this is a workaround to avoid holding
@@ -314,6 +340,8 @@ class RideFile : public QObject // QObject to emit signals
         QMap<QString,QString> tags_;
         EditorData *data;
         WPrime *wprime_;
+        QSharedPointer<Smoother> smoother_;
+        void forgetSmoothed();
         double weight_; // cached to save calls to getWeight();
         double totalCount, totalTemp;
 
@@ -321,8 +349,35 @@ class RideFile : public QObject // QObject to emit signals
         void updateMin(RideFilePoint* point);
         void updateMax(RideFilePoint* point);
         void updateAvg(RideFilePoint* point);
-
-        bool dstale; // is derived data up to date?
+        void updatePresent(RideFilePoint* point);
+
+        // derived series are computed in groups, each
+        // with its own stale bit in dstale
+        enum derived { DerivedDelta = 0x01,    // kphd, wattsd, cadd, nmd, hrd
+                       DerivedNP = 0x02,
+                       DerivedXP = 0x04,
+                       DerivedAPower = 0x08,
+                       DerivedTISS = 0x10,     // aTISS and anTISS
+                       DerivedSlope = 0x20,    // when not recorded
+                       DerivedGear = 0x40,
+                       DerivedHb = 0x80,       // O2Hb and HHb
+                       DerivedAll = 0xff,
+                       DerivedFromConfig = DerivedTISS | DerivedGear // CP, wheelsize
+                     };
+        static int derivedFrom(SeriesType series);
+        void recalculate(int which);
+        void deriveDeltas();
+        void deriveNP();
+        void deriveXP();
+        void deriveAPower();
+        void deriveTISS();
+        void deriveSlope();
+        void deriveGear();
+        void deriveHb();
+
+        int dstale; // which derived series are out of date
+        bool view_; // samples belong to another ride
+        bool samplesSaved_; // see samplesSaved()
 };
 
 struct RideFilePoint
@@ -443,6 +498,10 @@ class RideFileFactory {
         }
         QRegExp rideFileRegExp() const;
         RideFileReader *readerForSuffix(QString) const; 
+
+        // metadata saved since the samples were, read over the top
+        // of what is in the ride file itself when it is opened
+        static QString sidecarFileName(QString rideFileName) { return rideFileName + ".meta"; }
 };
 
 #endif // _RideFile_h
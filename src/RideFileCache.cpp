@@ -17,16 +17,19 @@
  */
 
 #include "RideFileCache.h"
+#include "GcTrace.h"
 #include "MainWindow.h"
 #include "Context.h"
 #include "Athlete.h"
 #include "RideCache.h"
+#include "FileJournal.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include "PaceZones.h"
 #include "LTMSettings.h" // getAllBestsFor needs this
 
 #include <cmath> // for pow()
+#include <cstring> // for memcpy()
 #include <QDebug>
 #include <QFileInfo>
 #include <QMessageBox>
@@ -157,22 +160,20 @@ RideFileCache::checkStale(Context *context, RideItem*item)
     if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
 
         // we have a file, it is more recent than the ride file
-        // but is it the latest version?
+        // but is it the latest version? the journal has the
+        // header and crc if the files haven't changed
         RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
+        QByteArray header = context->athlete->journal->header(cacheFileName, sizeof(head));
+        if (header.size() == int(sizeof(head))) {
 
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-            cacheFile.close();
+            memcpy(&head, header.constData(), sizeof(head));
 
             // its more recent -or- the crc is the same
             if (rideFileInfo.lastModified() <= cacheFileInfo.lastModified() ||
-                head.crc == RideFile::computeFileCRC(rideFileName)) {
+                head.crc == context->athlete->journal->crc(rideFileName)) {
 
                 // it is the same ?
-                if (head.version == RideFileCacheVersion && head.WEIGHT == item->getWeight()) {
+                if (head.version == RideFileCacheVersion && head.WEIGHT == item->check.weight) {
 
                     // WE'RE GOOD
                     return false;
@@ -754,6 +755,8 @@ void RideFileCache::RideFileCache::compute()
         return;
     }
 
+    GC_TRACE("RideFileCache::compute");
+
     // all the mean maxes
     MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); thread1.start();
     MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); thread2.start();
@@ -782,6 +785,11 @@ void RideFileCache::RideFileCache::compute()
     computeDistribution(aPowerDistribution, RideFile::aPower);
     computeDistribution(smo2Distribution, RideFile::smo2);
 
+    // and the joint distributions
+    computeJoint(joint[RideFileJoint::powerCad], RideFileJoint::powerCad);
+    computeJoint(joint[RideFileJoint::powerHr], RideFileJoint::powerHr);
+    computeJoint(joint[RideFileJoint::speedSlope], RideFileJoint::speedSlope);
+
     // wait for them threads
     thread1.wait();
     thread2.wait();
@@ -1299,9 +1307,10 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
     if (ride->isDataPresent(needSeries) == false) return;
 
     // get zones that apply, if any
-    int zoneRange = context->athlete->zones() ? context->athlete->zones()->whichRange(ride->startTime().date()) : -1;
-    int hrZoneRange = context->athlete->hrZones() ? context->athlete->hrZones()->whichRange(ride->startTime().date()) : -1;
-    int paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? context->athlete->paceZones(ride->isSwim())->whichRange(ride->startTime().date()) : -1;
+    const AthleteConfig *config = context->athlete->config();
+    int zoneRange = context->athlete->zones() ? config->zoneRange(ride->startTime().date()) : -1;
+    int hrZoneRange = context->athlete->hrZones() ? config->hrZoneRange(ride->startTime().date()) : -1;
+    int paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? config->paceZoneRange(ride->startTime().date(), ride->isSwim()) : -1;
 
     if (zoneRange != -1) CP=context->athlete->zones()->getCP(zoneRange);
     else CP=0;
@@ -1392,6 +1401,92 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
     }
 }
 
+//
+// JOINT DISTRIBUTIONS
+//
+static const struct {
+    RideFile::SeriesType x, y;
+    double xbin, ybin, ymin;
+} jointGrid[RideFileJoint::jointCount] = {
+    { RideFile::watts, RideFile::cad, 5.0, 1.0, 0.0 },     // powerCad
+    { RideFile::watts, RideFile::hr, 5.0, 1.0, 0.0 },      // powerHr
+    { RideFile::kph, RideFile::slope, 1.0, 0.5, -50.0 }    // speedSlope
+};
+
+RideFile::SeriesType RideFileJoint::xSeries(JointType type) { return jointGrid[type].x; }
+RideFile::SeriesType RideFileJoint::ySeries(JointType type) { return jointGrid[type].y; }
+double RideFileJoint::xBinSize(JointType type) { return jointGrid[type].xbin; }
+double RideFileJoint::yBinSize(JointType type) { return jointGrid[type].ybin; }
+double RideFileJoint::yMinimum(JointType type) { return jointGrid[type].ymin; }
+
+void
+RideFileJoint::add(const RideFileJoint &other)
+{
+    for (int i=0; i<other.cells.size(); i++)
+        sums[other.cells[i]] += other.secs[i];
+}
+
+void
+RideFileJoint::finish()
+{
+    // anything we had before too
+    for (int i=0; i<cells.size(); i++) sums[cells[i]] += secs[i];
+
+    // back to cells sorted by cell number
+    QList<quint32> keys = sums.keys();
+    qSort(keys);
+
+    cells.resize(keys.count());
+    secs.resize(keys.count());
+    for (int i=0; i<keys.count(); i++) {
+        cells[i] = keys[i];
+        secs[i] = sums.value(keys[i]);
+    }
+    sums.clear();
+}
+
+void
+RideFileCache::computeJoint(RideFileJoint &joint, RideFileJoint::JointType type)
+{
+    RideFile::SeriesType xseries = RideFileJoint::xSeries(type);
+    RideFile::SeriesType yseries = RideFileJoint::ySeries(type);
+    double xbin = RideFileJoint::xBinSize(type);
+    double ybin = RideFileJoint::yBinSize(type);
+    double ymin = RideFileJoint::yMinimum(type);
+
+    joint.cells.resize(0);
+    joint.secs.resize(0);
+
+    // only bother if both data series are actually present
+    if (ride->isDataPresent(xseries) == false || ride->isDataPresent(yseries) == false) return;
+
+    // time in each cell, the map keeps them sorted
+    QMap<quint32, float> grid;
+
+    foreach(RideFilePoint *dp, ride->dataPoints()) {
+        double x = dp->value(xseries);
+        double y = dp->value(yseries);
+
+        // stopped, coasting or dropouts -- but slope can be zero or less
+        if (x <= 0 || (y <= 0 && yseries != RideFile::slope)) continue;
+
+        int xoffset = x / xbin;
+        int yoffset = (y - ymin) / ybin;
+        if (xoffset > 0xffff || yoffset < 0 || yoffset > 0xffff) continue;
+
+        grid[(quint32(xoffset) << 16) | quint32(yoffset)] += ride->recIntSecs();
+    }
+
+    joint.cells.reserve(grid.count());
+    joint.secs.reserve(grid.count());
+    QMapIterator<quint32, float> i(grid);
+    while (i.hasNext()) {
+        i.next();
+        joint.cells.append(i.key());
+        joint.secs.append(i.value());
+    }
+}
+
 //
 // AGGREGATE FOR A GIVEN DATE RANGE
 //
@@ -1422,6 +1517,7 @@ static void distAggregate(QVector<double> &into, QVector<double> &other)
 RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome)
                : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
 {
+    GC_TRACE("RideFileCache::aggregate");
 
     // remember parameters for getting heat
     this->filter = filter;
@@ -1482,7 +1578,7 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
 
     // set cursor busy whilst we aggregate -- bit of feedback
     // and less intrusive than a popup box
-    context->mainWindow->setCursor(Qt::WaitCursor);
+    if (context->mainWindow) context->mainWindow->setCursor(Qt::WaitCursor);
 
     // Iterate over the ride files (not the cpx files since they /might/ not
     // exist, or /might/ be out of date.
@@ -1534,6 +1630,9 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
                 distAggregate(aPowerDistributionDouble, rideCache.aPowerDistributionDouble);
                 distAggregate(smo2DistributionDouble, rideCache.smo2DistributionDouble);
 
+                for (int i=0; i<RideFileJoint::jointCount; i++)
+                    joint[i].add(rideCache.joint[i]);
+
                 // cumulate timeinzones
                 for (int i=0; i<10; i++) {
                     paceTimeInZone[i] += rideCache.paceTimeInZone[i];
@@ -1549,8 +1648,11 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
         }
     }
 
+    // sort the joint distributions back into cells
+    for (int i=0; i<RideFileJoint::jointCount; i++) joint[i].finish();
+
     // set the cursor back to normal
-    context->mainWindow->setCursor(Qt::ArrowCursor);
+    if (context->mainWindow) context->mainWindow->setCursor(Qt::ArrowCursor);
 
     // lets add to the cache for others to re-use -- but not if filtered or incomplete
     if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
@@ -1644,6 +1746,9 @@ RideFileCache::serialize(QDataStream *out)
     head.wattsKgDistCount = wattsKgDistribution.size();
     head.aPowerDistCount = aPowerDistribution.size();
     head.smo2DistCount = smo2Distribution.size();
+    head.powerCadJointCount = joint[RideFileJoint::powerCad].cells.size();
+    head.powerHrJointCount = joint[RideFileJoint::powerHr].cells.size();
+    head.speedSlopeJointCount = joint[RideFileJoint::speedSlope].cells.size();
 
     out->writeRawData((const char *) &head, sizeof(head));
 
@@ -1684,6 +1789,12 @@ RideFileCache::serialize(QDataStream *out)
     out->writeRawData((const char *) hrCPTimeInZone.data(), sizeof(float) * hrCPTimeInZone.size());
     out->writeRawData((const char *) paceTimeInZone.data(), sizeof(float) * paceTimeInZone.size());
     out->writeRawData((const char *) paceCPTimeInZone.data(), sizeof(float) * paceCPTimeInZone.size());
+
+    // joint distributions
+    for (int i=0; i<RideFileJoint::jointCount; i++) {
+        out->writeRawData((const char *) joint[i].cells.data(), sizeof(quint32) * joint[i].cells.size());
+        out->writeRawData((const char *) joint[i].secs.data(), sizeof(float) * joint[i].secs.size());
+    }
 }
 
 void
@@ -1765,6 +1876,16 @@ RideFileCache::readCache()
         inFile.readRawData((char *) paceTimeInZone.data(), sizeof(float) * 10);
         inFile.readRawData((char *) paceCPTimeInZone.data(), sizeof(float) * 4);
 
+        // joint distributions
+        joint[RideFileJoint::powerCad].cells.resize(head.powerCadJointCount);
+        joint[RideFileJoint::powerHr].cells.resize(head.powerHrJointCount);
+        joint[RideFileJoint::speedSlope].cells.resize(head.speedSlopeJointCount);
+        for (int i=0; i<RideFileJoint::jointCount; i++) {
+            joint[i].secs.resize(joint[i].cells.size());
+            inFile.readRawData((char *) joint[i].cells.data(), sizeof(quint32) * joint[i].cells.size());
+            inFile.readRawData((char *) joint[i].secs.data(), sizeof(float) * joint[i].secs.size());
+        }
+
         // setup the doubles the users use
         doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
         doubleArray(hrMeanMaxDouble, hrMeanMax, RideFile::hr);
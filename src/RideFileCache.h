@@ -22,6 +22,7 @@
 #include <QString>
 #include <QDataStream>
 #include <QVector>
+#include <QHash>
 #include <QThread>
 
 class Context;
@@ -41,7 +42,7 @@ typedef double data_t;
 // arrays when plotting CP curves and histograms. It is precoputed
 // to save time and cached in a file .cpx
 //
-static const unsigned int RideFileCacheVersion = 22;
+static const unsigned int RideFileCacheVersion = 23;
 // revision history:
 // version  date         description
 // 1        29-Apr-11    Initial - header, mean-max & distribution data blocks
@@ -65,12 +66,14 @@ static const unsigned int RideFileCacheVersion = 22;
 // 20       17-Nov-14    Added Polarized Zones for HR and Pace
 // 21       27-Nov-14    Added SmO2 distribution 
 // 22       02-Feb-15    Added weight to header
+// 23       18-Oct-15    Added joint distributions for power/cad, power/hr and speed/slope
 
 // The cache file (.cpx) has a binary format:
 // 1 x Header data - describing the version and contents of the cache
 // n x Blocks - meanmax or distribution arrays
 // 1 x Watts TIZ - 10 floats
 // 1 x Heartrate TIZ - 10 floats
+// n x Joint distributions - cells then seconds for each
 
 // The header is written directly to disk, the only
 // field which is endian sensitive is the count field
@@ -106,7 +109,10 @@ struct RideFileCacheHeader {
                  npDistCount,
                  wattsKgDistCount,
                  aPowerDistCount,
-                 smo2DistCount;
+                 smo2DistCount,
+                 powerCadJointCount,
+                 powerHrJointCount,
+                 speedSlopeJointCount;
 
     int LTHR, // used to calculate Time in Zone (TIZ)
         CP;   // used to calculate Time in Zone (TIZ)
@@ -116,6 +122,40 @@ struct RideFileCacheHeader {
 };
 
 
+// Joint distributions, time spent in each cell of a 2d grid for a
+// pair of data series (e.g. power and cadence). A ride only visits a
+// small part of the grid so we only keep the cells that have any time
+// in them, sorted by cell number. The cell number has the x bin in the
+// top 16 bits and the y bin in the bottom 16 bits.
+class RideFileJoint
+{
+    public:
+        enum jointtype { powerCad=0, powerHr, speedSlope, jointCount };
+        typedef enum jointtype JointType;
+
+        QVector<quint32> cells;
+        QVector<float> secs;
+
+        // how the grid is laid out for each type
+        static RideFile::SeriesType xSeries(JointType);
+        static RideFile::SeriesType ySeries(JointType);
+        static double xBinSize(JointType);
+        static double yBinSize(JointType);
+        static double yMinimum(JointType);
+
+        // the middle of the cell in series units
+        static double x(JointType type, quint32 cell) { return ((cell >> 16) + 0.5) * xBinSize(type); }
+        static double y(JointType type, quint32 cell) { return ((cell & 0xffff) + 0.5) * yBinSize(type) + yMinimum(type); }
+
+        // sum another one in, e.g. when aggregating a date range, the
+        // totals are kept in a hash so call finish() after the last one
+        void add(const RideFileJoint &other);
+        void finish();
+
+    private:
+        QHash<quint32, float> sums;
+};
+
 // Each block of data is an array of uint32_t (32-bit "local-endian")
 // integers so the "count" setting within the block definition tells
 // us how long it is so we can read in one instruction and reference
@@ -198,6 +238,7 @@ class RideFileCache
         QVector<float> &hrCPZoneArray() { return hrCPTimeInZone; } // Polarized Zones
         QVector<float> &paceZoneArray() { return paceTimeInZone; }
         QVector<float> &paceCPZoneArray() { return paceCPTimeInZone; } // Polarized Zones
+        RideFileJoint &jointDistribution(RideFileJoint::JointType type) { return joint[type]; }
 
         QVector<float> &heatMeanMaxArray();  // will compute if neccessary
 
@@ -221,6 +262,7 @@ class RideFileCache
         // NOW replaced computeMeanMax with MeanMaxComputer class see bottom of file
         //void computeMeanMax(QVector<float>&, RideFile::SeriesType);      // compute mean max arrays
         void computeDistribution(QVector<float>&, RideFile::SeriesType); // compute the distributions
+        void computeJoint(RideFileJoint&, RideFileJoint::JointType); // compute the joint distributions
 
 
     private:
@@ -334,6 +376,11 @@ class RideFileCache
         QVector<float> hrCPTimeInZone;   // time in zone in seconds for polarized zones
         QVector<float> paceTimeInZone;      // time in zone in seconds
         QVector<float> paceCPTimeInZone;   // time in zone in seconds for polarized zones
+
+        //
+        // JOINT DISTRIBUTION
+        //
+        RideFileJoint joint[RideFileJoint::jointCount];
 };
 
 // Ride Bests in an associative array
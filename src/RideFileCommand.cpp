@@ -31,7 +31,7 @@ static bool doubles_equal(double a, double b)
 //----------------------------------------------------------------------
 // The public interface to the commands
 //----------------------------------------------------------------------
-RideFileCommand::RideFileCommand(RideFile *ride) : ride(ride), stackptr(0), inLUW(false), luw(NULL)
+RideFileCommand::RideFileCommand(RideFile *ride) : ride(ride), stackptr(0), inLUW(false), luw(NULL), values(NULL)
 {
     connect(ride, SIGNAL(saved()), this, SLOT(clearHistory()));
     connect(ride, SIGNAL(reverted()), this, SLOT(clearHistory()));
@@ -39,12 +39,26 @@ RideFileCommand::RideFileCommand(RideFile *ride) : ride(ride), stackptr(0), inLU
 
 RideFileCommand::~RideFileCommand()
 {
+    if (values) delete values;
     clearHistory();
 }
 
 void
 RideFileCommand::setPointValue(int index, RideFile::SeriesType series, double value)
 {
+    // bulk changes in a LUW are applied as we go but are
+    // only recorded as deltas, one command for all of them
+    if (inLUW) {
+        if (!values) values = new SetPointValuesCommand(ride);
+
+        double oldvalue = ride->getPointValue(index, series);
+        if (!doubles_equal(oldvalue, value)) {
+            ride->setPointValue(index, series, value);
+            values->addValue(index, series, oldvalue, value);
+        }
+        return;
+    }
+
     SetPointValueCommand *cmd = new SetPointValueCommand(ride, index, series,
                                     ride->getPointValue(index, series), value);
     doCommand(cmd);
@@ -121,10 +135,31 @@ RideFileCommand::startLUW(QString name)
     beginCommand(false, luw);
 }
 
+void
+RideFileCommand::closeValues()
+{
+    if (!values) return;
+
+    SetPointValuesCommand *cmd = values;
+    values = NULL;
+
+    if (cmd->runs.count() == 0) {
+        delete cmd;
+        return;
+    }
+
+    // already applied, so just record it and tell everyone
+    luw->addCommand(cmd);
+    beginCommand(false, cmd);
+    cmd->docount++;
+    endCommand(false, cmd);
+}
+
 void
 RideFileCommand::endLUW()
 {
     if (inLUW == false) return; // huh?
+    closeValues();
     inLUW = false;
 
     // add to the stack if it isn't empty
@@ -140,6 +175,7 @@ RideFileCommand::doCommand(RideCommand *cmd, bool noexec)
     // is collected by each command as it is
     // created.
     if (inLUW) {
+        closeValues(); // keep the worklist in order
         luw->addCommand(cmd);
         beginCommand(false, cmd);
         cmd->doCommand(); // luw must be executed as added!!!
@@ -287,6 +323,59 @@ SetPointValueCommand::undoCommand()
     return true;
 }
 
+// Set many values
+SetPointValuesCommand::SetPointValuesCommand(RideFile *ride) :
+            RideCommand(ride) // base class looks after these
+{
+    type = RideCommand::SetPointValues;
+    description = tr("Set Values");
+}
+
+void
+SetPointValuesCommand::addValue(int row, RideFile::SeriesType series, double oldvalue, double newvalue)
+{
+    // extend the run for this series if we can
+    QHash<int,int>::const_iterator it = open.find(series);
+    if (it != open.end()) {
+        Run &run = runs[it.value()];
+        if (run.row + run.newvalues.count() == row) {
+            run.oldvalues.append(oldvalue);
+            run.newvalues.append(newvalue);
+            return;
+        }
+    }
+
+    Run add;
+    add.series = series;
+    add.row = row;
+    add.oldvalues.append(oldvalue);
+    add.newvalues.append(newvalue);
+    runs.append(add);
+    open.insert(series, runs.count()-1);
+}
+
+bool
+SetPointValuesCommand::doCommand()
+{
+    foreach(const Run &run, runs) {
+        for (int i=0; i<run.newvalues.count(); i++)
+            ride->setPointValue(run.row+i, run.series, run.newvalues[i]);
+    }
+    return true;
+}
+
+bool
+SetPointValuesCommand::undoCommand()
+{
+    // reverse order, the same point may be set more than once
+    for (int r=runs.count(); r > 0; r--) {
+        const Run &run = runs[r-1];
+        for (int i=run.oldvalues.count(); i > 0; i--)
+            ride->setPointValue(run.row+i-1, run.series, run.oldvalues[i-1]);
+    }
+    return true;
+}
+
 // Remove a point
 DeletePointCommand::DeletePointCommand(RideFile *ride, int row, RideFilePoint point) :
         RideCommand(ride), // base class looks after these
@@ -26,6 +26,7 @@
 #include <QFile>
 #include <QList>
 #include <QMap>
+#include <QHash>
 #include <QVector>
 #include <QApplication>
 
@@ -35,6 +36,7 @@
 //                           for undo/redo functionality
 class RideCommand;
 class LUWCommand;
+class SetPointValuesCommand;
 
 class RideFileCommand : public QObject
 {
@@ -86,6 +88,11 @@ class RideFileCommand : public QObject
         int stackptr;
         bool inLUW;
         LUWCommand *luw;
+
+        // value changes within a LUW are collected
+        // into one command until something else happens
+        SetPointValuesCommand *values;
+        void closeValues();
 };
 
 // The Command itself, as a base class with
@@ -94,7 +101,7 @@ class RideCommand
 {
     public:
         // supported command types
-        enum commandtype { NoOp, LUW, SetPointValue, DeletePoint, DeletePoints, InsertPoint, AppendPoints, SetDataPresent };
+        enum commandtype { NoOp, LUW, SetPointValue, SetPointValues, DeletePoint, DeletePoints, InsertPoint, AppendPoints, SetDataPresent };
         typedef enum commandtype CommandType;
 
 
@@ -142,6 +149,31 @@ class SetPointValueCommand : public RideCommand
         double oldvalue, newvalue;
 };
 
+// many values, held by column as runs of consecutive rows
+// so bulk edits from the fix tools are one command not one per sample
+class SetPointValuesCommand : public RideCommand
+{
+    Q_DECLARE_TR_FUNCTIONS(SetPointValuesCommand)
+
+    public:
+        SetPointValuesCommand(RideFile *ride);
+        bool doCommand();
+        bool undoCommand();
+
+        // record a change that has already been applied
+        void addValue(int row, RideFile::SeriesType series, double oldvalue, double newvalue);
+
+        struct Run {
+            RideFile::SeriesType series;
+            int row; // first row
+            QVector<double> oldvalues, newvalues;
+        };
+
+        // state
+        QVector<Run> runs;  // in the order they were made
+        QHash<int, int> open; // series -> run being extended
+};
+
 class DeletePointCommand : public RideCommand
 {
     Q_DECLARE_TR_FUNCTIONS(DeletePointCommand)
@@ -428,6 +428,15 @@ RideFileTableModel::endCommand(bool undo, RideCommand *cmd)
             dataChanged(cell, cell);
             break;
         }
+        case RideCommand::SetPointValues:
+        {
+            SetPointValuesCommand *spv = (SetPointValuesCommand*)cmd;
+            foreach(const SetPointValuesCommand::Run &run, spv->runs) {
+                int column = headingsType.indexOf(run.series);
+                dataChanged(index(run.row, column), index(run.row + run.newvalues.count() - 1, column));
+            }
+            break;
+        }
         case RideCommand::InsertPoint:
             if (!undo) endInsertRows();
             else endRemoveRows();
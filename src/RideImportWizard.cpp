@@ -21,6 +21,7 @@
 #include "MainWindow.h"
 
 #include "RideItem.h"
+#include "RideCache.h"
 #include "RideFile.h"
 #include "RideImportWizard.h"
 
@@ -36,6 +37,106 @@
 #include <QDebug>
 #include <QWaitCondition>
 #include <QMessageBox>
+#include <QEventLoop>
+#include <QFuture>
+#include <QFutureWatcher>
+#if QT_VERSION > 0x050000
+# include <QtConcurrent>
+#else
+# include <QtConcurrentRun>
+#endif
+
+// how many files we read, process and write in the background
+// ahead of the one we're looking at, to bound memory use
+#define IMPORT_AHEAD (QThread::idealThreadCount() * 2)
+
+// parsing a file in the background for validation
+struct RideImportParse {
+    RideImportParse() : ride(NULL) {}
+    RideFile *ride;
+    QList<RideFile*> rides; // if its an archive
+    QStringList errors;
+};
+
+static RideImportParse
+importParse(Context *context, QString filename)
+{
+    RideImportParse returning;
+    QFile file(filename);
+    returning.ride = RideFileFactory::instance().openRideFile(context, file, returning.errors, &returning.rides);
+    return returning;
+}
+
+// nobody wants it any more, the wizard was aborted
+static void
+importDiscard(QFuture<RideImportParse> future)
+{
+    RideImportParse parsed = future.result();
+    if (!parsed.rides.contains(parsed.ride)) delete parsed.ride;
+    qDeleteAll(parsed.rides);
+}
+
+// saving a file in the background, leaving the
+// ride cache to be updated on the GUI thread
+struct RideImportSave {
+    int row;
+    QString filename, importsFulltarget, importsTarget, activitiesTarget, tmpTarget, finalTarget;
+    QDateTime ridedatetime;
+    QString error; // set if it failed
+    QString warning; // set if it worked, but not completely
+};
+
+static RideImportSave
+importSave(Context *context, RideImportSave job)
+{
+    // copy the source file to /imports with adjusted name
+    if (job.importsFulltarget != "") {
+        QFile source(job.filename);
+        if (!source.copy(job.importsFulltarget))
+            job.warning = RideImportWizard::tr("Error - copy of %1 to import directory failed").arg(job.importsTarget);
+    }
+
+    // open the file with the respective format reader and export as .JSON
+    QStringList errors;
+    QFile thisfile(job.filename);
+    RideFile *ride(RideFileFactory::instance().openRideFile(context, thisfile, errors));
+
+    // did the input file parse ok ? (should be fine here - since it was alrady checked before - but just in case)
+    if (ride) {
+
+        // update ridedatetime and set the Source File name
+        ride->setStartTime(job.ridedatetime);
+        ride->setTag("Source Filename", job.importsTarget);
+        ride->setTag("Filename", job.activitiesTarget);
+
+        // serialize
+        JsonFileReader reader;
+        QFile target(job.tmpTarget);
+        if (!reader.writeRideFile(context, ride, target))
+            job.error = RideImportWizard::tr("Error - .JSON creation failed");
+
+        delete ride;
+
+    } else {
+        job.error = RideImportWizard::tr("Error - Import of activitiy file failed");
+    }
+    return job;
+}
+
+// wait for the background work without blocking the GUI
+template <typename T>
+static T
+waitFor(QFuture<T> future)
+{
+    if (!future.isFinished()) {
+        QEventLoop loop;
+        QFutureWatcher<T> watcher;
+        QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        watcher.setFuture(future);
+        loop.exec();
+    }
+    return future.result();
+}
 
 // drag and drop passes urls ... convert to a list of files and call main constructor
 RideImportWizard::RideImportWizard(QList<QUrl> *urls, Context *context, QWidget *parent) : QDialog(parent), context(context)
@@ -403,10 +504,18 @@ RideImportWizard::process()
     QApplication::processEvents();
 
     // Pass 2 - Read in with the relevant RideFileReader method
+    //          files are parsed in the background a few ahead of
+    //          the one we're looking at
 
     phaseLabel->setText(tr("Step 2 of 4: Validating Files"));
+    QHash<QString, QFuture<RideImportParse> > parsing;
    for (int i=0; i< filenames.count(); i++) {
 
+        // keep the next few parsing
+        for (int j=i; j < filenames.count() && parsing.count() < IMPORT_AHEAD; j++) {
+            if (parsing.contains(filenames[j]) || tableWidget->item(j,5)->text().startsWith(tr("Error"))) continue;
+            parsing.insert(filenames[j], QtConcurrent::run(importParse, context, filenames[j]));
+        }
 
         // does the status say Queued?
         if (!tableWidget->item(i,5)->text().startsWith(tr("Error"))) {
@@ -418,13 +527,22 @@ RideImportWizard::process()
               tableWidget->setCurrentCell(i,5);
               QApplication::processEvents();
 
-              if (aborted) { done(0); }
+              if (aborted) {
+                  // tidy up after the ones still parsing once they finish
+                  foreach(QFuture<RideImportParse> future, parsing) QtConcurrent::run(importDiscard, future);
+                  done(0);
+                  return 0;
+              }
               if (!isActiveWindow()) activateWindow();
               this->repaint();
               QApplication::processEvents();
 
-              QList<RideFile*> rides;
-              RideFile *ride = RideFileFactory::instance().openRideFile(context, thisfile, errors, &rides);
+              // collect it from the background (it may be listed twice)
+              RideImportParse parsed = waitFor(parsing.contains(filenames[i]) ? parsing.take(filenames[i])
+                                               : QtConcurrent::run(importParse, context, filenames[i]));
+              QList<RideFile*> rides = parsed.rides;
+              RideFile *ride = parsed.ride;
+              errors = parsed.errors;
 
               // is this an archive of files?
               if (rides.count() > 1) {
@@ -583,7 +701,11 @@ RideImportWizard::process()
         }
         progressBar->setValue(progressBar->value()+1);
         QApplication::processEvents();
-        if (aborted) { done(0); }
+        if (aborted) {
+            foreach(QFuture<RideImportParse> future, parsing) QtConcurrent::run(importDiscard, future);
+            done(0);
+            return 0;
+        }
         if (!isActiveWindow()) activateWindow();
         this->repaint();
 
@@ -881,19 +1003,13 @@ RideImportWizard::abortClicked()
     QChar zero = QLatin1Char ( '0' );
 
 
-    // Saving now - process the files one-by-one
+    // Saving now - first work out where each one is going
+    QList<RideImportSave> jobs;
+    QSet<QString> claimed; // two with the same start time
     for (int i=0; i< filenames.count(); i++) {
 
         if (tableWidget->item(i,5)->text().startsWith(tr("Error"))) continue; // skip errors
 
-        tableWidget->item(i,5)->setText(tr("Saving..."));
-        tableWidget->setCurrentCell(i,5);
-        QApplication::processEvents();
-        if (aborted) { done(0); }
-        if (!isActiveWindow()) activateWindow();
-        this->repaint();
-
-
         // SAVE STEP 3 - prepare the new file names for the next steps - basic name and .JSON in GC format
 
         QDateTime ridedatetime = QDateTime(QDate().fromString(tableWidget->item(i,1)->text(), tr("dd MMM yyyy")),
@@ -912,84 +1028,87 @@ RideImportWizard::abortClicked()
         QString finalActivitiesFulltarget = homeActivities.canonicalPath() + "/" + activitiesTarget;
 
         // check if a ride at this point of time already exists in /activities - if yes, skip import
-        if (QFileInfo(finalActivitiesFulltarget).exists()) { tableWidget->item(i,5)->setText(tr("Error - Activity file exists")); continue; }
-
+        if (QFileInfo(finalActivitiesFulltarget).exists() || claimed.contains(activitiesTarget)) {
+            tableWidget->item(i,5)->setText(tr("Error - Activity file exists"));
+            continue;
+        }
+        claimed.insert(activitiesTarget);
 
         // SAVE STEP 4 - copy the source file to "/imports" directory (if it's not taken from there as source)
         // add the date/time of the target to the source file name (for identification)
 
         // copy the sourceFile to /imports ONLY if the source is NOT coming from /imports itself
         QFileInfo sourceFileInfo (filenames[i]);
-        QString importsTarget;
+        QString importsTarget, importsFulltarget;
         if (sourceFileInfo.canonicalPath() != homeImports.canonicalPath()) {
 
             // add the GC file base name to create unique file names during import
             // there should not be 2 ride files with exactly the same time stamp (as this is also not foreseen for the .json)
             importsTarget = sourceFileInfo.baseName() + "_" + targetnosuffix + "." + sourceFileInfo.suffix();
-            QString importsFulltarget = homeImports.canonicalPath() + "/" + importsTarget;
-            // copy the source file to /imports with adjusted name
-            QFile source(filenames[i]);
-            if (!source.copy(importsFulltarget)) {
-                tableWidget->item(i,5)->setText(tr("Error - copy of %1 to import directory failed").arg(importsTarget));
-            }
+            importsFulltarget = homeImports.canonicalPath() + "/" + importsTarget;
         } else {
             // file is re-imported from /imports - keep the name for .JSON Source File Tag
             importsTarget = sourceFileInfo.fileName();
         }
 
+        RideImportSave job;
+        job.row = i;
+        job.filename = filenames[i];
+        job.importsFulltarget = importsFulltarget;
+        job.importsTarget = importsTarget;
+        job.activitiesTarget = activitiesTarget;
+        job.tmpTarget = tmpActivitiesFulltarget;
+        job.finalTarget = finalActivitiesFulltarget;
+        job.ridedatetime = ridedatetime;
+        jobs << job;
+
+        tableWidget->item(i,5)->setText(tr("Queued"));
+    }
+
+    // SAVE STEP 5 - copy, open the file with the respective format reader and export as .JSON in the
+    // background, a few ahead of the one we're adding to the ride cache.
+    // to track if addRideCache() has caused an error due to bad data we work with a interim directory for the activities
+    // -- first   export to /tmpactivities
+    // -- second  create RideCache() entry
+    // -- third   move file from /tmpactivities to /activities
+    QList<QFuture<RideImportSave> > saving;
+    int queued = 0;
+    for (int k=0; k < jobs.count(); k++) {
+
+        // keep the next few going
+        while (queued < jobs.count() && saving.count() < IMPORT_AHEAD) {
+            tableWidget->item(jobs[queued].row,5)->setText(tr("Saving file..."));
+            saving << QtConcurrent::run(importSave, context, jobs[queued]);
+            queued++;
+        }
 
-        // SAVE STEP 5 - open the file with the respective format reader and export as .JSON
-        // to track if addRideCache() has caused an error due to bad data we work with a interim directory for the activities
-        // -- first   export to /tmpactivities
-        // -- second  create RideCache() entry
-        // -- third   move file from /tmpactivities to /activities
-
-        tableWidget->item(i,5)->setText(tr("Saving file..."));
-
-        // serialize the file to .JSON
-        QStringList errors;
-        QFile thisfile(filenames[i]);
-        RideFile *ride(RideFileFactory::instance().openRideFile(context, thisfile, errors));
-
-        // did the input file parse ok ? (should be fine here - since it was alrady checked before - but just in case)
-        if (ride) {
-
-            // update ridedatetime and set the Source File name
-            ride->setStartTime(ridedatetime);
-            ride->setTag("Source Filename", importsTarget);
-            ride->setTag("Filename", activitiesTarget);
-
-            // serialize
-            JsonFileReader reader;
-            QFile target(tmpActivitiesFulltarget);
-            if (reader.writeRideFile(context, ride, target)) {
-
-                // now try adding the Ride to the RideCache - since this may fail due to various reason, the activity file
-                // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
-                // - only after the step was succesfull the file is moved
-                // to the "clean" activities folder
-                context->athlete->addRide(QFileInfo(tmpActivitiesFulltarget).fileName(),
-                                          tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
-                                          true);                                       // file is available only in /tmpActivities, so use this one please
-                // rideCache is successfully updated, let's move the file to the real /activities
-                if (moveFile(tmpActivitiesFulltarget, finalActivitiesFulltarget)) {
-                    tableWidget->item(i,5)->setText(tr("File Saved"));
-                    // and correct the path locally stored in Ride Item
-                    context->ride->setFileName(homeActivities.canonicalPath(), activitiesTarget);
-                }  else {
-                    tableWidget->item(i,5)->setText(tr("Error - Moving %1 to activities folder").arg(activitiesTarget));
-                }
+        RideImportSave saved = waitFor(saving.takeFirst());
+        int i = saved.row;
+        tableWidget->setCurrentCell(i,5);
 
+        if (saved.error == "") {
+
+            // now try adding the Ride to the RideCache - since this may fail due to various reason, the activity file
+            // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
+            // - only after the step was succesfull the file is moved
+            // to the "clean" activities folder
+            context->athlete->addRide(QFileInfo(saved.tmpTarget).fileName(),
+                                      tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
+                                      true,                                        // file is available only in /tmpActivities, so use this one please
+                                      true);                                       // metrics and .cpx are refreshed in the background afterwards
+            // rideCache is successfully updated, let's move the file to the real /activities
+            if (moveFile(saved.tmpTarget, saved.finalTarget)) {
+                tableWidget->item(i,5)->setText(saved.warning != "" ? saved.warning : tr("File Saved"));
+                // and correct the path locally stored in Ride Item
+                context->ride->setFileName(homeActivities.canonicalPath(), saved.activitiesTarget);
             }  else {
-                tableWidget->item(i,5)->setText(tr("Error - .JSON creation failed"));
+                tableWidget->item(i,5)->setText(tr("Error - Moving %1 to activities folder").arg(saved.activitiesTarget));
             }
+
         } else {
-            tableWidget->item(i,5)->setText(tr("Error - Import of activitiy file failed"));
+            tableWidget->item(i,5)->setText(saved.error);
         }
 
-        // clear
-        delete ride;
-
         QApplication::processEvents();
         if (aborted) { done(0); }
         progressBar->setValue(progressBar->value()+1);
@@ -997,6 +1116,9 @@ RideImportWizard::abortClicked()
         this->repaint();
     }
 
+    // compute the metrics and .cpx for all of them in the background
+    context->athlete->rideCache->refresh();
+
     // how did we get on in the end then ...
     int completed = 0;
     for (int i=0; i< filenames.count(); i++)
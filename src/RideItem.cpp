@@ -17,9 +17,13 @@
  */
 
 #include "RideItem.h"
+#include "GcTrace.h"
 #include "RideMetric.h"
 #include "RideFile.h"
 #include "RideFileCache.h"
+#include "RideCache.h"
+#include "FileJournal.h"
+#include "Route.h"
 #include "RideMetadata.h"
 #include "Context.h"
 #include "Zones.h"
@@ -39,14 +43,14 @@
 // merge wizard and interval navigator
 RideItem::RideItem() 
     : 
-    ride_(NULL), fileCache_(NULL), context(NULL), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
+    ride_(NULL), fileCache_(NULL), context(NULL), isdirty(false), isstale(true), isedit(false), skipsave(false), lastUsed(0), path(""), fileName(""),
     color(QColor(1,1,1)), isRun(false), isSwim(false), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), weight(0) {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
 }
 
 RideItem::RideItem(RideFile *ride, Context *context) 
     : 
-    ride_(ride), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
+    ride_(ride), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), lastUsed(0), path(""), fileName(""),
     color(QColor(1,1,1)), isRun(false), isSwim(false), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), weight(0) 
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
@@ -54,7 +58,7 @@ RideItem::RideItem(RideFile *ride, Context *context)
 
 RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context *context) 
     :
-    ride_(NULL), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(path), 
+    ride_(NULL), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), lastUsed(0), path(path), 
     fileName(fileName), dateTime(dateTime), color(QColor(1,1,1)), isRun(false), isSwim(false), fingerprint(0), 
     metacrc(0), crc(0), timestamp(0), dbversion(0), weight(0) 
 {
@@ -65,7 +69,7 @@ RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context
 // pre-computed metrics and storing ride metadata
 RideItem::RideItem(RideFile *ride, QDateTime &dateTime, Context *context)
     :
-    ride_(ride), fileCache_(NULL), context(context), isdirty(true), isstale(true), isedit(false), skipsave(false), dateTime(dateTime),
+    ride_(ride), fileCache_(NULL), context(context), isdirty(true), isstale(true), isedit(false), skipsave(false), lastUsed(0), dateTime(dateTime),
     fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), weight(0)
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
@@ -113,9 +117,9 @@ RideItem::setFrom(QHash<QString, RideMetricPtr> computed)
 
 // calculate metadata crc
 unsigned long 
-RideItem::metaCRC()
+RideItem::metaCRC(const QMap<QString,QString> &metadata)
 {
-    QMapIterator<QString,QString> i(metadata_);
+    QMapIterator<QString,QString> i(metadata);
     QByteArray ba;
     i.toFront();
     while(i.hasNext()) {
@@ -128,13 +132,23 @@ RideItem::metaCRC()
 
 RideFile *RideItem::ride(bool open)
 {
-    if (!open || ride_) return ride_;
+    if (!open || ride_) {
+        // most recently used
+        if (open && ride_ && context && context->athlete->rideCache) lastUsed = context->athlete->rideCache->tick();
+        return ride_;
+    }
 
-    // open the ride file
-    QFile file(path + "/" + fileName);
-    ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
+    // open the ride file, unless it was opened in the background for us
+    if (context && context->athlete->rideCache) ride_ = context->athlete->rideCache->takePrefetched(this);
+    if (ride_ == NULL) {
+        QFile file(path + "/" + fileName);
+        ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
+    }
     if (ride_ == NULL) return NULL; // failed to read ride
 
+    // count it against the memory budget
+    if (context && context->athlete->rideCache) context->athlete->rideCache->opened(this);
+
     // refresh if stale..
     refresh();
 
@@ -163,7 +177,9 @@ RideFileCache *
 RideItem::fileCache()
 {
     if (!fileCache_) {
-        fileCache_ = new RideFileCache(context, fileName, getWeight(), ride());
+        // if it was closed to save memory the .cpx is still good so don't reopen it
+        RideFile *rideFile = (isOpen() || isDirty()) ? ride() : NULL;
+        fileCache_ = new RideFileCache(context, path + "/" + fileName, getWeight(), rideFile);
         if (isDirty()) fileCache_->refresh(ride()); // refresh from what we have now !
     }
     return fileCache_;
@@ -200,10 +216,10 @@ RideItem::notifyRideDataChanged()
     // refresh the metrics
     isstale=true;
 
-    // force a recompute of derived data series
+    // recompute the derived data series that were affected
     if (ride_) {
         ride_->wstale = true;
-        ride_->recalculateDerivedSeries(true);
+        ride_->recalculateDerivedSeries();
     }
 
     // refresh the cache
@@ -284,6 +300,7 @@ void
 RideItem::close()
 {
     if (ride_) {
+        if (context && context->athlete && context->athlete->rideCache) context->athlete->rideCache->closed(this);
         delete ride_;
         ride_ = NULL;
     }
@@ -303,8 +320,11 @@ RideItem::checkStale()
     // if we're marked stale already then just return that !
     if (isstale) return true;
 
-    // just change it .. its as quick to change as it is to check !
-    color = context->athlete->colorEngine->colorFor(getText(context->athlete->rideMetadata()->getColorField(), ""));
+    // what we compare with, from the snapshots so any thread will do
+    const AthleteConfig *config = context->athlete->config();
+    check.weight = weightFor(config, check.metadata);
+    check.fingerprint = config->fingerprint(dateTime.date());
+    check.metacrc = metaCRC(check.metadata);
 
     // upgraded metrics
     if (dbversion != DBSchemaVersion) {
@@ -315,11 +335,10 @@ RideItem::checkStale()
 
         // has weight changed?
         unsigned long prior  = 1000.0f * weight;
-        unsigned long now = 1000.0f * getWeight();
+        unsigned long now = 1000.0f * check.weight;
 
         if (prior != now) {
 
-            getWeight();
             isstale = true;
 
         } else {
@@ -332,9 +351,7 @@ RideItem::checkStale()
             // metrics for older rides !
 
             // get the new zone configuration fingerprint that applies for the ride date
-            unsigned long rfingerprint = static_cast<unsigned long>(context->athlete->zones()->getFingerprint(dateTime.date()))
-                        + static_cast<unsigned long>(context->athlete->paceZones()->getFingerprint(dateTime.date()))
-                        + static_cast<unsigned long>(context->athlete->hrZones()->getFingerprint(dateTime.date()));
+            unsigned long rfingerprint = check.fingerprint;
 
             if (fingerprint != rfingerprint) {
 
@@ -349,14 +366,22 @@ RideItem::checkStale()
                 // has timestamp changed ?
                 if (timestamp < QFileInfo(file).lastModified().toTime_t()) {
 
-                    // if timestamp has changed then check crc
-                    unsigned long fcrc = RideFile::computeFileCRC(fullPath);
+                    // if timestamp has changed then check crc, the journal
+                    // knows it if the file hasn't changed since last time
+                    unsigned long fcrc = context->athlete->journal->crc(fullPath);
 
                     if (crc == 0 || crc != fcrc) {
                         crc = fcrc; // update as expensive to calculate
                         isstale = true;
                     }
                 }
+
+                // metadata saved to the sidecar since, the ride file
+                // itself won't have changed (e.g. we crashed before
+                // the cache was saved)
+                QFileInfo sidecar(RideFileFactory::sidecarFileName(fullPath));
+                if (sidecar.exists() && timestamp < sidecar.lastModified().toTime_t())
+                    isstale = true;
             }
         }
     }
@@ -365,7 +390,7 @@ RideItem::checkStale()
     if (isstale == false) isstale = RideFileCache::checkStale(context, this);
 
     // we need to mark stale in case "special" fields may have changed (e.g. CP)
-    if (metacrc != metaCRC()) isstale = true;
+    if (metacrc != check.metacrc) isstale = true;
 
     return isstale;
 }
@@ -375,6 +400,8 @@ RideItem::refresh()
 {
     if (!isstale) return;
 
+    GC_TRACE("RideItem::refresh");
+
     // if already open no need to close
     bool doclose = false;
     if (!isOpen()) doclose = true;
@@ -393,7 +420,7 @@ RideItem::refresh()
         // first class stuff
         isRun = f->isRun();
         isSwim = f->isSwim();
-        color = context->athlete->colorEngine->colorFor(f->getTag(context->athlete->rideMetadata()->getColorField(), ""));
+        color = context->athlete->colorEngine->colorFor(metadata_);
         present = f->getTag("Data", "");
 
         // refresh metrics etc
@@ -422,9 +449,7 @@ RideItem::refresh()
         isstale = false;
 
         // update fingerprints etc, crc done above
-        fingerprint = static_cast<unsigned long>(context->athlete->zones()->getFingerprint(dateTime.date()))
-                    + static_cast<unsigned long>(context->athlete->paceZones()->getFingerprint(dateTime.date()))
-                    + static_cast<unsigned long>(context->athlete->hrZones()->getFingerprint(dateTime.date()));
+        fingerprint = context->athlete->config()->fingerprint(dateTime.date());
 
         dbversion = DBSchemaVersion;
         timestamp = QDateTime::currentDateTime().toTime_t();
@@ -432,6 +457,9 @@ RideItem::refresh()
         // RideFile cache needs refreshing possibly
         RideFileCache updater(context, context->athlete->home->activities().canonicalPath() + "/" + fileName, getWeight(), ride_, true);
 
+        // and the gps index used when searching for routes
+        context->athlete->routes->index->addRide(fileName, crc, f);
+
         // we now match
         metacrc = metaCRC();
 
@@ -440,9 +468,11 @@ RideItem::refresh()
             close();
         } else {
 
-            // if it is open then recompute
+            // if it is open then recompute, only the series
+            // that depend upon config or metadata (CP, wheelsize)
             ride_->wstale = true;
-            ride_->recalculateDerivedSeries(true);
+            ride_->dstale |= RideFile::DerivedFromConfig;
+            ride_->recalculateDerivedSeries();
         }
 
     } else {
@@ -453,20 +483,27 @@ RideItem::refresh()
 
 double
 RideItem::getWeight()
+{
+    weight = weightFor(context->athlete->config(), metadata_);
+    return weight;
+}
+
+double
+RideItem::weightFor(const AthleteConfig *config, const QMap<QString,QString> &metadata) const
 {
     // withings first
-    weight = context->athlete->getWithingsWeight(dateTime.date());
+    double returning = config->withingsWeight(dateTime.date());
 
     // from metadata
-    if (!weight) weight = metadata_.value("Weight", "0.0").toDouble();
+    if (!returning) returning = metadata.value("Weight", "0.0").toDouble();
 
     // global options
-    if (!weight) weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
+    if (!returning) returning = config->weight(); // default to 75kg
     
     // No weight default is weird, we'll set to 80kg
-    if (weight <= 0.00) weight = 80.00;
+    if (returning <= 0.00) returning = 80.00;
 
-    return weight;
+    return returning;
 }
 
 double
@@ -32,6 +32,7 @@ class RideFileCache;
 class RideCache;
 class RideCacheModel;
 class Context;
+class AthleteConfig;
 
 Q_DECLARE_METATYPE(RideItem*)
 
@@ -60,7 +61,11 @@ class RideItem : public QObject
 
         QStringList errors_;
 
-        unsigned long metaCRC();
+        unsigned long metaCRC() { return metaCRC(metadata_); }
+        static unsigned long metaCRC(const QMap<QString,QString> &metadata);
+
+        // withings, then metadata, then athlete weight, then 80kg
+        double weightFor(const AthleteConfig *config, const QMap<QString,QString> &metadata) const;
 
     public slots:
         void modified();
@@ -80,6 +85,7 @@ class RideItem : public QObject
         bool isstale;     // metric data is out of date and needs recomputing
         bool isedit;      // is being edited at the moment
         bool skipsave;    // on exit we don't save the state to force rebuild at startup
+        int lastUsed;     // RideCache tick when ride() was last called, for closing old rides
 
         // set from another, e.g. during load of rideDB.json
         void setFrom(RideItem&);
@@ -121,6 +127,7 @@ class RideItem : public QObject
         // ride() will open the ride if it isn't already when open=true
         // if we pass false then it will just return ride_ so we can
         // traverse currently open rides when config changes
+        // close() also lets the RideCache know it's no longer open
         void close();
         bool isOpen();
 
@@ -136,6 +143,18 @@ class RideItem : public QObject
         void setDirty(bool);
         bool isDirty() { return isdirty; }
         bool checkStale(); // check if we need to refresh
+
+        // what checkStale compares with, the metadata can change on
+        // the gui thread whilst the refresh threads are checking so
+        // prepareCheck takes a copy first (it is shared, so cheap) and
+        // checkStale works out the rest from it and the config snapshot
+        struct StaleCheck {
+            QMap<QString,QString> metadata;
+            double weight;
+            unsigned long fingerprint, metacrc;
+            StaleCheck() : weight(0), fingerprint(0), metacrc(0) {}
+        } check;
+        void prepareCheck() { check.metadata = metadata_; }
         bool isStale() { return isstale; }
 
         // refresh when stale
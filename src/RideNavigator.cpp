@@ -67,6 +67,7 @@ RideNavigator::RideNavigator(Context *context, bool mainwindow) : context(contex
     sortModel = new BUGFIXQSortFilterProxyModel(this);
     sortModel->setSourceModel(groupByModel);
     sortModel->setDynamicSortFilter(true);
+    sortModel->setSortRole(SORTROLE); // numbers not the formatted text
 
     if (!mainwindow) {
         searchFilterBox = new SearchFilterBox(this, context, false);
@@ -788,7 +789,7 @@ class groupRange {
     QList<range> ranges;    // list of ranges we can put them in
 };
 
-static QList<groupRange> groupRanges;
+static QHash<QString, groupRange> groupRanges; // by column name
 bool
 GroupByModel::initGroupRanges()
 {
@@ -803,7 +804,7 @@ GroupByModel::initGroupRanges()
     add = groupRange::range( 300,  450, tr("High Stress")); addColumn.ranges << add;
     add = groupRange::range( 450,  0.00, tr("Very High Stress")); addColumn.ranges << add;
 
-    groupRanges << addColumn;
+    groupRanges.insert(addColumn.column, addColumn);
     addColumn.ranges.clear();
 
     // Intensity Factor
@@ -817,7 +818,7 @@ GroupByModel::initGroupRanges()
     add = groupRange::range( 1.2, 1.5, tr("Anaerobic Capacity")); addColumn.ranges << add;
     add = groupRange::range( 1.5,  0.0, tr("Maximal")); addColumn.ranges << add;
 
-    groupRanges << addColumn;
+    groupRanges.insert(addColumn.column, addColumn);
     addColumn.ranges.clear();
 
     // Variability Index
@@ -828,7 +829,7 @@ GroupByModel::initGroupRanges()
     add = groupRange::range( 1.1,  1.2, tr("Variable")); addColumn.ranges << add;
     add = groupRange::range( 1.2,  0.0, tr("Highly Variable")); addColumn.ranges << add;
 
-    groupRanges << addColumn;
+    groupRanges.insert(addColumn.column, addColumn);
     addColumn.ranges.clear();
 
     // Duration (seconds)
@@ -839,7 +840,7 @@ GroupByModel::initGroupRanges()
     add = groupRange::range( 10800,  18000, tr("Less than 5 hours")); addColumn.ranges << add;
     add = groupRange::range( 18000,  0.0, tr("More than 5 hours")); addColumn.ranges << add;
 
-    groupRanges << addColumn;
+    groupRanges.insert(addColumn.column, addColumn);
     addColumn.ranges.clear();
 
     // Distance (km)
@@ -850,7 +851,7 @@ GroupByModel::initGroupRanges()
     add = groupRange::range( 80,  140, tr("Long")); addColumn.ranges << add;
     add = groupRange::range( 140,  0, tr("Very Long")); addColumn.ranges << add;
 
-    groupRanges << addColumn;
+    groupRanges.insert(addColumn.column, addColumn);
     addColumn.ranges.clear();
 
     return true;
@@ -864,21 +865,20 @@ GroupByModel::groupFromValue(QString headingName, QString value, double rank, do
     if (!_initGroupRanges)
         _initGroupRanges = initGroupRanges();
     // Check for predefined thresholds / zones / bands for this metric/column
-    foreach (groupRange orange, groupRanges) {
-        if (orange.column == headingName) {
-
-            double number = value.toDouble();
-            // use thresholds defined for this column/metric
-            foreach(groupRange::range range, orange.ranges) {
-
-                // 0-x is lower, x-0 is upper, 0-0 is no data and x-x is a range
-                if (range.low == 0.0 && range.high == 0.0 && number == 0.0) return range.name;
-                else if (range.high != 0.0 && range.low == 0.0 && number < range.high) return range.name;
-                else if (range.low != 0.0 && range.high == 0.0 && number >= range.low) return range.name;
-                else if (number < range.high && number >= range.low) return range.name;
-            }
-            return tr("Undefined");
+    QHash<QString, groupRange>::const_iterator orange = groupRanges.constFind(headingName);
+    if (orange != groupRanges.constEnd()) {
+
+        double number = value.toDouble();
+        // use thresholds defined for this column/metric
+        foreach(const groupRange::range &range, orange.value().ranges) {
+
+            // 0-x is lower, x-0 is upper, 0-0 is no data and x-x is a range
+            if (range.low == 0.0 && range.high == 0.0 && number == 0.0) return range.name;
+            else if (range.high != 0.0 && range.low == 0.0 && number < range.high) return range.name;
+            else if (range.low != 0.0 && range.high == 0.0 && number >= range.low) return range.name;
+            else if (number < range.high && number >= range.low) return range.name;
         }
+        return tr("Undefined");
     }
 
     // Use upper quartile for anything left that is a metric
@@ -962,6 +962,7 @@ RideNavigator::setRide(RideItem*rideItem)
                 tableView->selectionModel()->select(row, QItemSelectionModel::Rows | QItemSelectionModel::ClearAndSelect);
                 tableView->selectionModel()->setCurrentIndex(tableView->model()->index(j,0,group), QItemSelectionModel::NoUpdate);
                 tableView->scrollTo(tableView->model()->index(j,3,group), QAbstractItemView::PositionAtCenter);
+                prefetchNeighbours(tableView->model()->index(j,0,group));
 
                 currentItem = rideItem;
                 repaint();
@@ -990,7 +991,33 @@ RideNavigator::selectionChanged(QItemSelection selected)
 
     // lets notify others
     context->athlete->selectRideFile(filename);
+    prefetchNeighbours(ref);
+}
+
+void
+RideNavigator::prefetchNeighbours(QModelIndex index)
+{
+    // the sidebar's navigator does it for everyone
+    if (!mainwindow || !index.isValid()) return;
+
+    QStringList filenames;
+    for (int direction=0; direction<2; direction++) {
+
+        // group headings aren't rides, step over them
+        QModelIndex next = index;
+        int count = 0;
+        while (count < RIDECACHE_PREFETCH) {
+            next = direction ? tableView->indexBelow(next) : tableView->indexAbove(next);
+            if (!next.isValid()) break;
+            if (!next.parent().isValid()) continue;
+
+            filenames << tableView->model()->data(tableView->model()->index(next.row(), 3, next.parent()), Qt::DisplayRole).toString();
+            count++;
+        }
+    }
 
+    foreach(RideItem *item, context->athlete->rideCache->rides())
+        if (filenames.contains(item->fileName)) context->athlete->rideCache->prefetch(item);
 }
 
 void
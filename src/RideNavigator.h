@@ -175,6 +175,10 @@ class RideNavigator : public GcWindow
         QVBoxLayout *mainLayout;
         RideItem *currentItem;
 
+        // open the rides above and below in the background, as sorted
+        // and grouped here, since those are the ones stepped to next
+        void prefetchNeighbours(QModelIndex index);
+
         // properties
         int _sortByIndex;
         int _sortByOrder;
@@ -38,6 +38,7 @@
 
 #include <QtGui>
 #include "RideNavigator.h"
+#include "RideCacheModel.h"
 #include "RideItem.h"
 #include "RideFile.h"
 
@@ -79,8 +80,15 @@ private:
 
     QMap<QString, QVector<int>*> groupToSourceRow;
     QVector<int> sourceRowToGroupRow;
+    QVector<int> sourceRowToGroup;
     QList<rankx> rankedRows;
 
+    // what each row was grouped by, so we can tell if a change
+    // to the row moves it to another group or just repaints it
+    QString groupByHeading;
+    QVector<QString> groupByValue;
+    QVector<double> groupByRank;
+
     void clearGroups() {
         // Wipe current
         QMapIterator<QString, QVector<int>*> i(groupToSourceRow);
@@ -92,7 +100,10 @@ private:
         groupIndexes.clear();
         groupToSourceRow.clear();
         sourceRowToGroupRow.clear();
+        sourceRowToGroup.clear();
         rankedRows.clear();
+        groupByValue.clear();
+        groupByRank.clear();
     }
 
     static bool initGroupRanges();
@@ -148,7 +159,7 @@ public:
         setIndexes();
 
         connect(model, SIGNAL(modelReset()), this, SLOT(sourceModelChanged()));
-        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceModelChanged()));
+        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
         connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(sourceModelChanged()));
         connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(sourceModelChanged()));
         connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(sourceModelChanged()));
@@ -359,7 +370,13 @@ public:
             } else {
 
                 // column 1 = ride_time we have to use ride_date
-                if (proxyIndex.column() == 1)  {
+                if (proxyIndex.column() == 1 && role == SORTROLE) {
+
+                    int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
+                    if (groupNo >= 0 && groupNo < groups.count())
+                        returning = sourceModel()->data(sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()), dateColumn), role);
+
+                } else if (proxyIndex.column() == 1)  {
                     QString date;
 
                     // hideous code, sorry
@@ -376,7 +393,7 @@ public:
                     returning = sourceModel()->data(mapToSource(proxyIndex), role);
 
                     // -255 temperature means not present
-                    if (mapToSource(proxyIndex).column() == tempIndex && returning.toDouble() == RideFile::NoTemp) {
+                    if (role != SORTROLE && mapToSource(proxyIndex).column() == tempIndex && returning.toDouble() == RideFile::NoTemp) {
                          returning = "";
                     }
                 }
@@ -491,9 +508,7 @@ public:
 
         if (row < 0 || row >= rankedRows.count()) return ("");
         if (groupBy == -1) return tr("All Rides");
-        else return groupFromValue(headerData(groupBy+2, // accommodate virtual column
-                                    Qt::Horizontal).toString(),
-                                    sourceModel()->data(sourceModel()->index(row,groupBy)).toString(),
+        else return groupFromValue(groupByHeading, groupByValue[row],
                                     rankedRows[row].value, rankedRows.count());
 
     }
@@ -517,12 +532,17 @@ public:
 
         if (groupBy >= 0) {
 
+            groupByHeading = headerData(groupBy+2, Qt::Horizontal).toString(); // accommodate virtual column
+
             // rank all the values
             for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
+                QModelIndex index = sourceModel()->index(i,groupBy);
                 rankx rank;
-                rank.value = sourceModel()->data(sourceModel()->index(i,groupBy)).toDouble();
+                rank.value = sourceModel()->data(index, SORTROLE).toDouble();
                 rank.row = i;
                 rankedRows << rank;
+                groupByRank << rank.value;
+                groupByValue << sourceModel()->data(index).toString();
             }
 
             // rank the entries
@@ -570,11 +590,16 @@ public:
 
         // Update list of groups
         int group=0;
+        sourceRowToGroup.resize(sourceRowToGroupRow.count());
         QMapIterator<QString, QVector<int>*> j(groupToSourceRow);
         while (j.hasNext()) {
             j.next();
             groups << j.key();
-            groupIndexes << createIndex(group++,0,(void*)NULL);
+            groupIndexes << createIndex(group,0,(void*)NULL);
+
+            // and which group each row ended up in
+            foreach(int row, *j.value()) sourceRowToGroup[row] = group;
+            group++;
         }
 
         // all done. let the views know everything changed
@@ -582,6 +607,34 @@ public:
     }
 
 public slots:
+    void sourceDataChanged(QModelIndex topLeft, QModelIndex bottomRight) {
+
+        // regroup everything if any of the rows might move group
+        int rows = sourceModel()->rowCount(QModelIndex());
+        if (!topLeft.isValid() || !bottomRight.isValid() || topLeft.row() < 0 ||
+            bottomRight.row() >= rows || sourceRowToGroup.count() != rows) {
+            sourceModelChanged();
+            return;
+        }
+        if (groupBy >= 0) {
+            for (int i=topLeft.row(); i<=bottomRight.row(); i++) {
+                QModelIndex index = sourceModel()->index(i,groupBy);
+                if (sourceModel()->data(index).toString() != groupByValue[i] ||
+                    sourceModel()->data(index, SORTROLE).toDouble() != groupByRank[i]) {
+                    sourceModelChanged();
+                    return;
+                }
+            }
+        }
+
+        // still in the same groups, just the values changed
+        for (int i=topLeft.row(); i<=bottomRight.row(); i++) {
+            void *parent = (void*)&groupIndexes[sourceRowToGroup[i]];
+            emit dataChanged(createIndex(sourceRowToGroupRow[i], 0, parent),
+                             createIndex(sourceRowToGroupRow[i], columnCount()-1, parent));
+        }
+    }
+
     void sourceModelChanged() {
 
         // notify everyone we're changing
@@ -648,7 +701,7 @@ class SearchFilter : public QSortFilterProxyModel
 
 	// make sure changes are propogated upstream
         connect(model, SIGNAL(modelReset()), this, SIGNAL(modelReset()));
-        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SIGNAL(modelReset()));
+        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
         connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SIGNAL(modelReset()));
         connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SIGNAL(modelReset()));
         connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SIGNAL(modelReset()));
@@ -668,6 +721,13 @@ class SearchFilter : public QSortFilterProxyModel
 
     public slots:
 
+    void sourceDataChanged(QModelIndex topLeft, QModelIndex bottomRight) {
+
+        // rows only line up with the source when we aren't filtering
+        if (searchActive) emit modelReset();
+        else emit dataChanged(index(topLeft.row(), topLeft.column()), index(bottomRight.row(), bottomRight.column()));
+    }
+
     void setStrings(QStringList list) {
         beginResetModel();
         strings = list;
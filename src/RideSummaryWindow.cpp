@@ -943,24 +943,12 @@ RideSummaryWindow::htmlSummary()
             summary += "cellspacing=0 border=0>";
             bool even = false;
             foreach (RideFileInterval interval, ride->intervals()) {
-                RideFile f(ride);
-                for (int i = ride->intervalBegin(interval); i>= 0 &&i < ride->dataPoints().size(); ++i) {
-                    const RideFilePoint *p = ride->dataPoints()[i];
-                    if (p->secs > interval.stop)
-                        break;
-                    f.appendPoint(p->secs, p->cad, p->hr, p->km, p->kph, p->nm,
-                                p->watts, p->alt, p->lon, p->lat, p->headwind,
-                                p->slope, p->temp, p->lrbalance,
-                                p->lte, p->rte, p->lps, p->rps,
-                                p->lpco, p->rpco, p->lppb, p->rppb, p->lppe, p->rppe, p->lpppb, p->rpppb, p->lpppe, p->rpppe,
-                                p->smo2, p->thb, p->rvert, p->rcad, p->rcontact, 0);
-
-                    // derived data
-                    RideFilePoint *l = f.dataPoints().last();
-                    l->np = p->np;
-                    l->xp = p->xp;
-                    l->apower = p->apower;
-                }
+                // a view on the interval, no need to copy the samples
+                int begin = ride->intervalBegin(interval);
+                int end = begin;
+                while (end >= 0 && end < ride->dataPoints().size() && ride->dataPoints()[end]->secs <= interval.stop) end++;
+                RideFile f(ride, begin, end-1);
+
                 if (f.dataPoints().size() == 0) {
                     // Interval empty, do not compute any metrics
                     continue;
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideXmlReader.h"
+
+RideXmlReader::RideXmlReader(QFile &file) : file(&file), mapped(NULL)
+{
+    if (file.size() > 0) mapped = file.map(0, file.size());
+
+    if (mapped) {
+        // a buffer over the mapping, nothing is copied
+        bytes = QByteArray::fromRawData((const char*)mapped, file.size());
+        buffer.setData(bytes);
+        buffer.open(QIODevice::ReadOnly);
+        setDevice(&buffer);
+    } else {
+        // can't map it (e.g. empty) so read from the file
+        setDevice(&file);
+    }
+}
+
+RideXmlReader::RideXmlReader(const QByteArray &data) : QXmlStreamReader(data), file(NULL), mapped(NULL)
+{
+}
+
+RideXmlReader::~RideXmlReader()
+{
+    setDevice(NULL);
+    if (mapped) {
+        buffer.close();
+        file->unmap(mapped);
+    }
+}
+
+double
+RideXmlReader::toDouble(const QStringRef &text, double def)
+{
+    bool ok = false;
+#if QT_VERSION >= 0x050100
+    double returning = text.toDouble(&ok);
+#else
+    double returning = text.toString().toDouble(&ok);
+#endif
+    return ok ? returning : def;
+}
+
+double
+RideXmlReader::number()
+{
+    double returning = 0.0;
+
+    while (!atEnd()) {
+        switch (readNext()) {
+        case Characters:
+            if (!isWhitespace()) returning = toDouble(text());
+            break;
+        case StartElement:
+            skipCurrentElement();
+            break;
+        case EndElement:
+            return returning;
+        default:
+            break;
+        }
+    }
+    return returning;
+}
+
+double
+RideXmlReader::number(const QXmlStreamAttributes &attributes, const char *name, double def)
+{
+    QStringRef value = attributes.value(QLatin1String(name));
+    if (value.isEmpty()) return def;
+    return toDouble(value, def);
+}
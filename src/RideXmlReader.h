@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideXmlReader_h
+#define _GC_RideXmlReader_h 1
+#include "GoldenCheetah.h"
+
+#include <QFile>
+#include <QBuffer>
+#include <QByteArray>
+#include <QXmlStreamReader>
+
+//
+// A pull parser for the XML ride file formats.
+//
+// The file is mapped into memory and read a chunk at a time, so
+// memory use doesn't grow with the size of the file the way it does
+// when loading a QDomDocument. Numbers are converted straight from
+// the parser's own buffer rather than making a QString for each.
+//
+// The file must already be open and stay open while reading.
+//
+class RideXmlReader : public QXmlStreamReader
+{
+    public:
+        RideXmlReader(QFile &file);
+        RideXmlReader(const QByteArray &data); // already in memory
+        ~RideXmlReader();
+
+        // the text of the current element as a number, reads
+        // up to the end of the element, 0 if it isn't a number
+        double number();
+
+        // an attribute of the current element as a number
+        double number(const QXmlStreamAttributes &attributes, const char *name, double def = 0.0);
+
+        // without making a QString where Qt lets us
+        static double toDouble(const QStringRef &text, double def = 0.0);
+
+    private:
+        QFile *file;
+        uchar *mapped;
+        QByteArray bytes;
+        QBuffer buffer;
+};
+
+#endif // _GC_RideXmlReader_h
@@ -126,7 +126,7 @@ RouteSegment::removeRideInRoute(RideFile* ride)
 }
 
 void
-RouteSegment::searchRouteInRide(RideFile* ride, bool freememory, QTextStream* out)
+RouteSegment::searchRouteInRide(RideFile* ride, bool freememory, QTextStream* out, int from)
 {
     //*out << "searchRouteInRide " << ride->startTime().toString() << "\r\n";
 
@@ -137,7 +137,7 @@ RouteSegment::searchRouteInRide(RideFile* ride, bool freememory, QTextStream* ou
     double precision = -1;
 
     int diverge = 0;
-    int lastpoint = -1; // Last point to match
+    int lastpoint = from-1; // Last point to match, nothing matches before from
     double start = -1, stop = -1; // Start and stop secs
 
     //foreach (RoutePoint routepoint, this->getPoints()) {
@@ -272,10 +272,22 @@ RouteSegment::searchRouteInAllRides(Context* context)
 
     out << "SEARCH NEW ROUTE STARTS: " << QDateTime::currentDateTime().toString() + "\r\n";
 
-    QStringList filenames;
-    foreach(RideItem *item, context->athlete->rideCache->rides())
-        filenames << item->fileName;
-    QStringListIterator iterator(filenames);
+    // the gps index tells us which rides pass near every point on
+    // the route and where to start looking, the rest can be skipped
+    // without opening them. Rides not indexed yet are always opened.
+    RouteIndex *index = context->athlete->routes->index;
+    QMap<QString, int> candidates = index->candidates(points);
+
+    QList<RideItem*> items;
+    int skipped = 0;
+    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+        if (index->isIndexed(item->fileName, item->crc) && !candidates.contains(item->fileName)) {
+            out << "Skipping: " << item->fileName << " not near route\r\n";
+            skipped++;
+        } else {
+            items << item;
+        }
+    }
     QStringList errors;
 
     // update statistics for ride files which are out of date
@@ -287,8 +299,8 @@ RouteSegment::searchRouteInAllRides(Context* context)
 
     int processed=0;
 
-    while (iterator.hasNext()) {
-        QString name = iterator.next();
+    foreach(RideItem *item, items) {
+        QString name = item->fileName;
         QFile file(context->athlete->home->activities().canonicalPath() + "/" + name);
         out << "Opening: " << name;
 
@@ -302,7 +314,7 @@ RouteSegment::searchRouteInAllRides(Context* context)
 
         // create the dialog if we need to show progress for long running uodate
         if ((elapsedtime > 2000) && bar == NULL) {
-            bar = new GProgressDialog(title, 0, filenames.count(), context->mainWindow->init, context->mainWindow);
+            bar = new GProgressDialog(title, 0, items.count(), context->mainWindow->init, context->mainWindow);
             bar->show(); // lets hide until elapsed time is > 2 seconds
 
             // lets make sure it goes to the center!
@@ -313,17 +325,31 @@ RouteSegment::searchRouteInAllRides(Context* context)
             QString title = tr("Searching route in all rides...\nElapsed: %1\n%2").arg(elapsedString).arg(name);
             bar->setLabelText(title);
             bar->setValue(++processed);
-        }
+        } else ++processed;
         QApplication::processEvents();
 
 
         ride = RideFileFactory::instance().openRideFile(context, file, errors);
-        if (ride->isDataPresent(RideFile::lat)) {
-            out << " with GPS datas " << "\r\n";
-            searchRouteInRide(ride, true, &out);
+        if (ride && !index->isIndexed(name, item->crc)) {
+
+            // index it whilst we have it open
+            index->addRide(name, item->crc, ride);
+
+            if (!index->candidates(points).contains(name)) {
+                out << " not near route " << "\r\n";
+                delete ride;
+                ride = NULL;
+                continue;
+            }
         }
-        else
+
+        if (ride && ride->isDataPresent(RideFile::lat)) {
+            out << " with GPS datas " << "\r\n";
+            searchRouteInRide(ride, true, &out, candidates.value(name, 0));
+        } else {
             out << " no GPS datas " << "\r\n";
+            if (ride) delete ride;
+        }
 
         if (bar && bar->wasCanceled()) {
             out << "SEARCH NEW ROUTE CANCELED: " << QDateTime::currentDateTime().toString() + "\r\n";
@@ -337,7 +363,7 @@ RouteSegment::searchRouteInAllRides(Context* context)
     // stop logging
     out << "SEARCH NEW ROUTE ENDS: " << QDateTime::currentDateTime().toString() + "\r\n";
 
-    QMessageBox::information(context->mainWindow, tr("Route"), tr("This route '%1' was found %2 times in %3 activities.").arg(this->getName()).arg(this->getRides().count()).arg(processed));
+    QMessageBox::information(context->mainWindow, tr("Route"), tr("This route '%1' was found %2 times in %3 activities.").arg(this->getName()).arg(this->getRides().count()).arg(processed + skipped));
 
     log.close();
 }
@@ -388,6 +414,8 @@ Routes::Routes(Context *context, const QDir &home)
     connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(addRide(RideItem*)));
     connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(deleteRide(RideItem*)));
 
+    index = new RouteIndex(context);
+
     readRoutes();
 }
 
@@ -456,6 +484,7 @@ Routes::addRide(RideItem* ride)
 void
 Routes::deleteRide(RideItem* ride)
 {
+    index->removeRide(ride->fileName);
     removeRideInRoutes(ride->ride());
 }
 
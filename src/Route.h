@@ -27,6 +27,7 @@
 #include <QFile>
 
 #include "Context.h"
+#include "RouteIndex.h"
 
 class  RideFile;
 class  RouteRide2;
@@ -56,7 +57,7 @@ class RouteSegment
         double distance(double lat1, double lon1, double lat2, double lon2);
 
         void searchRouteInAllRides(Context *context);
-        void searchRouteInRide(RideFile* ride, bool freememory, QTextStream* log);
+        void searchRouteInRide(RideFile* ride, bool freememory, QTextStream* log, int from=0);
 
         void removeRideInRoute(RideFile* ride);
 
@@ -90,6 +91,9 @@ class Routes : public QObject {
         void writeRoutes();
         QList<RouteSegment> routes;
 
+        // gps index of all rides, to prune route searching
+        RouteIndex *index;
+
         void createRouteFromInterval(IntervalItem *activeInterval);
         void searchRoutesInRide(RideFile* ride);
         void removeRideInRoutes(RideFile* ride);
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RouteIndex.h"
+
+#include "Athlete.h"
+#include "Context.h"
+#include "Route.h"
+#include "RideFile.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QMutexLocker>
+#include <cmath>
+
+// number of cells around the equator and pole to pole
+static const int LONCELLS = int(360.0 / ROUTEINDEX_CELL + 0.5);
+static const int LATCELLS = int(180.0 / ROUTEINDEX_CELL + 0.5);
+
+RouteIndex::RouteIndex(Context *context) : context(context), dirty(false)
+{
+    load();
+}
+
+bool
+RouteIndex::validGPS(double lat, double lon)
+{
+    // same rules as RouteSegment::searchRouteInRide
+    return lat != 0 && lon != 0 &&
+           ceil(lat) != 180 && ceil(lon) != 180 &&
+           ceil(lat) != 540 && ceil(lon) != 540 &&
+           lat >= -90 && lat <= 90 && lon >= -180 && lon <= 180;
+}
+
+int
+RouteIndex::latIndex(double lat)
+{
+    int idx = int(floor((lat + 90.0) / ROUTEINDEX_CELL));
+    if (idx < 0) idx = 0;
+    if (idx > LATCELLS) idx = LATCELLS;
+    return idx;
+}
+
+int
+RouteIndex::lonIndex(double lon)
+{
+    int idx = int(floor((lon + 180.0) / ROUTEINDEX_CELL));
+    return ((idx % LONCELLS) + LONCELLS) % LONCELLS;
+}
+
+quint32
+RouteIndex::key(int latIdx, int lonIdx)
+{
+    // wrap across the date line
+    lonIdx = ((lonIdx % LONCELLS) + LONCELLS) % LONCELLS;
+    return quint32(latIdx) * quint32(LONCELLS) + quint32(lonIdx);
+}
+
+bool
+RouteIndex::isIndexed(QString filename, unsigned long crc)
+{
+    QMutexLocker locker(&lock);
+
+    QHash<QString, Entry>::const_iterator it = rides.find(filename);
+    return it != rides.end() && it.value().crc == crc;
+}
+
+void
+RouteIndex::addRide(QString filename, unsigned long crc, const RideFile *ride)
+{
+    if (!ride || isIndexed(filename, crc)) return;
+
+    // scan the samples without holding the lock
+    Entry add;
+    add.crc = crc;
+
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+    if (ride->isDataPresent(RideFile::lat)) {
+        for (int i=0; i<points.count(); i++) {
+            const RideFilePoint *p = points[i];
+            if (!validGPS(p->lat, p->lon)) continue;
+
+            quint32 k = key(latIndex(p->lat), lonIndex(p->lon));
+            if (!add.cells.contains(k)) add.cells.insert(k, i);
+        }
+    }
+
+    // rides without GPS are still recorded, so we know
+    // not to open them when searching for a route
+    QMutexLocker locker(&lock);
+    unindex(filename);
+    rides.insert(filename, add);
+    foreach(quint32 k, add.cells.keys()) cells[k].insert(filename);
+    dirty = true;
+}
+
+void
+RouteIndex::removeRide(QString filename)
+{
+    QMutexLocker locker(&lock);
+    unindex(filename);
+}
+
+void
+RouteIndex::unindex(QString filename)
+{
+    QHash<QString, Entry>::iterator it = rides.find(filename);
+    if (it == rides.end()) return;
+
+    foreach(quint32 k, it.value().cells.keys()) {
+        QHash<quint32, QSet<QString> >::iterator c = cells.find(k);
+        if (c != cells.end()) {
+            c.value().remove(filename);
+            if (c.value().isEmpty()) cells.erase(c);
+        }
+    }
+    rides.erase(it);
+    dirty = true;
+}
+
+QSet<QString>
+RouteIndex::near(int latIdx, int lonIdx, QHash<QString,int> *first)
+{
+    // cells shrink east-west towards the poles, so widen the
+    // neighbourhood to keep covering the 100m match tolerance
+    double lat = (latIdx + 0.5) * ROUTEINDEX_CELL - 90.0;
+    double width = 111.2 * ROUTEINDEX_CELL * cos(lat * 3.14159265358979323846 / 180.0);
+    int span = (width > 0.1) ? 1 : LONCELLS / 2;
+
+    QSet<QString> returning;
+    for (int dlat=-1; dlat<=1; dlat++) {
+
+        int la = latIdx + dlat;
+        if (la < 0 || la > LATCELLS) continue;
+
+        for (int dlon=-span; dlon<=span; dlon++) {
+
+            quint32 k = key(la, lonIdx + dlon);
+            QHash<quint32, QSet<QString> >::const_iterator c = cells.find(k);
+            if (c == cells.end()) continue;
+
+            foreach(QString filename, c.value()) {
+                returning.insert(filename);
+
+                // earliest sample in the neighbourhood
+                if (first) {
+                    int index = rides.value(filename).cells.value(k, 0);
+                    if (!first->contains(filename) || first->value(filename) > index)
+                        first->insert(filename, index);
+                }
+            }
+        }
+    }
+    return returning;
+}
+
+QMap<QString, int>
+RouteIndex::candidates(QList<RoutePoint> points)
+{
+    QMutexLocker locker(&lock);
+
+    QMap<QString, int> returning;
+    QHash<QString, int> start;
+    QSet<QString> matching;
+    QSet<quint32> seen;
+    bool firstpoint = true;
+
+    // every route point must have a sample within 100m
+    // so a ride must visit the neighbourhood of each of them
+    foreach(RoutePoint point, points) {
+
+        if (!validGPS(point.lat, point.lon)) continue;
+
+        int la = latIndex(point.lat);
+        int lo = lonIndex(point.lon);
+
+        // routes are dense, most points share a cell
+        quint32 k = key(la, lo);
+        if (seen.contains(k)) continue;
+        seen.insert(k);
+
+        if (firstpoint) {
+            matching = near(la, lo, &start);
+            firstpoint = false;
+        } else {
+            matching.intersect(near(la, lo, NULL));
+        }
+
+        if (matching.isEmpty()) break;
+    }
+
+    foreach(QString filename, matching) returning.insert(filename, start.value(filename, 0));
+    return returning;
+}
+
+void
+RouteIndex::load()
+{
+    QFile file(QString("%1/routes.idx").arg(context->athlete->home->cache().canonicalPath()));
+    if (!file.open(QFile::ReadOnly)) return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    qint32 version = 0;
+    stream >> version;
+    if (version != ROUTEINDEX_VERSION) return; // will be rebuilt
+
+    qint32 count = 0;
+    stream >> count;
+
+    QMutexLocker locker(&lock);
+    for (int i=0; i<count && stream.status() == QDataStream::Ok; i++) {
+
+        QString filename;
+        quint64 crc;
+        Entry add;
+
+        stream >> filename >> crc >> add.cells;
+        if (stream.status() != QDataStream::Ok) break;
+
+        add.crc = crc;
+        rides.insert(filename, add);
+        foreach(quint32 k, add.cells.keys()) cells[k].insert(filename);
+    }
+
+    // truncated or corrupt, throw it away and rebuild
+    if (stream.status() != QDataStream::Ok) {
+        rides.clear();
+        cells.clear();
+    }
+    dirty = false;
+}
+
+void
+RouteIndex::save()
+{
+    QMutexLocker locker(&lock);
+    if (!dirty) return;
+
+    QFile file(QString("%1/routes.idx").arg(context->athlete->home->cache().canonicalPath()));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    stream << qint32(ROUTEINDEX_VERSION);
+    stream << qint32(rides.count());
+
+    QHashIterator<QString, Entry> it(rides);
+    while (it.hasNext()) {
+        it.next();
+        stream << it.key() << quint64(it.value().crc) << it.value().cells;
+    }
+    file.close();
+    dirty = false;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RouteIndex_h
+#define _GC_RouteIndex_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+
+class Context;
+class RideFile;
+struct RoutePoint;
+
+// bump when the on-disk format changes, old indexes are discarded
+#define ROUTEINDEX_VERSION 1
+
+// grid cell size in degrees, roughly 1km north-south and always
+// much larger than the 100m route matching tolerance
+#define ROUTEINDEX_CELL 0.01
+
+//
+// A coarse spatial index of the GPS tracks of all activities
+//
+// Each activity is reduced to the set of grid cells its track passes
+// through, along with the first sample seen in each cell. An inverted
+// map from cell to activities lets route searching skip the activities
+// that never come near the route without opening them.
+//
+// The index is maintained as rides are refreshed by the ride cache and
+// persisted in the athlete's cache folder so it survives restarts.
+// It is accessed from the ride cache worker threads and the GUI
+// thread so all access is serialised.
+//
+class RouteIndex
+{
+    public:
+        RouteIndex(Context *context);
+
+        // cache/routes.idx
+        void load();
+        void save();
+
+        // (re)index the ride if the crc has changed
+        void addRide(QString filename, unsigned long crc, const RideFile *ride);
+        void removeRide(QString filename);
+
+        // has the file content been indexed already ?
+        bool isIndexed(QString filename, unsigned long crc);
+
+        // rides that pass within a cell of every point on the route
+        // mapped to the first sample that could match the route start
+        QMap<QString, int> candidates(QList<RoutePoint> points);
+
+        // same test used when searching routes
+        static bool validGPS(double lat, double lon);
+
+    private:
+        Context *context;
+        QMutex lock;
+        bool dirty;
+
+        struct Entry {
+            unsigned long crc;
+            QHash<quint32, int> cells; // cell -> first sample index
+        };
+
+        QHash<QString, Entry> rides;
+        QHash<quint32, QSet<QString> > cells; // cell -> filenames
+
+        void unindex(QString filename); // lock must be held
+        QSet<QString> near(int latIdx, int lonIdx, QHash<QString,int> *first); // lock must be held
+
+        static int latIndex(double lat);
+        static int lonIndex(double lon);
+        static quint32 key(int latIdx, int lonIdx);
+};
+
+#endif // _GC_RouteIndex_h
@@ -175,10 +175,28 @@ MainWindow::saveSilent(Context *context, RideItem *rideItem)
     log += '\n' + rideItem->ride()->command->changeLog();
     rideItem->ride()->setTag("Change History", log);
 
-    // save in GC format
     JsonFileReader reader;
+    QString sidecar = RideFileFactory::sidecarFileName(savedFile.fileName());
+
+    // if only the metadata, tags or intervals changed the samples on
+    // disk are still good, so just write those to the sidecar
+    if (!convert && currentFI.baseName() == targetnosuffix && rideItem->ride()->samplesSaved() &&
+        reader.writeRideMetadata(rideItem->ride(), sidecar)) {
+
+        // mark clean as we have now saved the data
+        context->athlete->rideCache->written(savedFile.fileName());
+        rideItem->ride()->emitSaved();
+        return;
+    }
+
+    // save in GC format
     reader.writeRideFile(context, rideItem->ride(), savedFile);
 
+    // which has all the metadata too
+    QFile::remove(sidecar);
+    QFile::remove(RideFileFactory::sidecarFileName(currentFI.absoluteFilePath()));
+    rideItem->ride()->setSamplesSaved(true);
+
     // rename the file and update the rideItem list to reflect the change
     if (convert) {
 
@@ -192,6 +210,8 @@ MainWindow::saveSilent(Context *context, RideItem *rideItem)
 
 
     // mark clean as we have now saved the data
+    context->athlete->rideCache->written(currentFI.absoluteFilePath());
+    context->athlete->rideCache->written(savedFile.fileName());
     rideItem->ride()->emitSaved();
 }
 
@@ -37,6 +37,7 @@
 #define GC_SETTINGS_CALENDAR_SIZES  "mainwindow/calendarSizes"
 #define GC_TABS_TO_HIDE             "mainwindow/tabsToHide"
 #define GC_ELEVATION_HYSTERESIS     "elevationHysteresis"
+#define GC_RIDEMEMORY               "rideMemory"
 #define GC_SETTINGS_SUMMARY_METRICS "rideSummaryWindow/summaryMetrics"
 #define GC_SETTINGS_BESTS_METRICS    "rideSummaryWindow/bestsMetrics"
 #define GC_SETTINGS_INTERVAL_METRICS "rideSummaryWindow/intervalMetrics"
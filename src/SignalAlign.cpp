@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SignalAlign.h"
+
+#include <complex>
+#include <algorithm>
+#include <cmath>
+
+typedef std::complex<double> cplx;
+
+// in place radix 2 transform, the size must be a power of 2
+static void
+fft(QVector<cplx> &x, bool inverse)
+{
+    const int n = x.count();
+    cplx *v = x.data();
+
+    // into bit reversed order
+    for (int i=1, j=0; i<n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(v[i], v[j]);
+    }
+
+    // twiddles computed once, rather than accumulated, to keep the precision
+    const double pi = 3.14159265358979323846;
+    QVector<cplx> twiddle(n/2);
+    for (int k=0; k<n/2; k++) {
+        double angle = 2.0 * pi * k / n;
+        twiddle[k] = cplx(cos(angle), inverse ? sin(angle) : -sin(angle));
+    }
+
+    for (int len=2; len<=n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i=0; i<n; i+=len) {
+            for (int k=0; k<half; k++) {
+                cplx u = v[i+k];
+                cplx t = v[i+k+half] * twiddle[k*step];
+                v[i+k] = u + t;
+                v[i+k+half] = u - t;
+            }
+        }
+    }
+
+    if (inverse) for (int i=0; i<n; i++) v[i] /= double(n);
+}
+
+QVector<double>
+SignalAlign::correlate(const QVector<double> &a, const QVector<double> &b, int minLag, int maxLag)
+{
+    QVector<double> returning;
+    if (maxLag < minLag) return returning;
+    returning.fill(0.0, maxLag - minLag + 1);
+
+    const int na = a.count();
+    const int nb = b.count();
+    if (na < 2 || nb < 2) return returning;
+
+    // r is the same if we take a constant away, so take away
+    // the mean to keep the sums small and not lose precision
+    double ma = 0, mb = 0;
+    for (int i=0; i<na; i++) ma += a[i];
+    for (int i=0; i<nb; i++) mb += b[i];
+    ma /= double(na);
+    mb /= double(nb);
+
+    // sums and sums of squares, so any overlap is two lookups
+    QVector<double> sa(na+1), saa(na+1), sb(nb+1), sbb(nb+1);
+    sa[0] = saa[0] = sb[0] = sbb[0] = 0;
+
+    // the cross products for every lag are the inverse transform of
+    // A times the conjugate of B, padded so they don't wrap around
+    int n = 1;
+    while (n < na + nb) n <<= 1;
+    QVector<cplx> A(n), B(n);
+
+    for (int i=0; i<na; i++) {
+        double x = a[i] - ma;
+        sa[i+1] = sa[i] + x;
+        saa[i+1] = saa[i] + x*x;
+        A[i] = cplx(x, 0);
+    }
+    for (int i=0; i<nb; i++) {
+        double x = b[i] - mb;
+        sb[i+1] = sb[i] + x;
+        sbb[i+1] = sbb[i] + x*x;
+        B[i] = cplx(x, 0);
+    }
+
+    fft(A, false);
+    fft(B, false);
+    for (int k=0; k<n; k++) A[k] *= std::conj(B[k]);
+    fft(A, true);
+
+    for (int lag=minLag; lag<=maxLag; lag++) {
+
+        // b[lo..hi) overlaps a[lo+lag..hi+lag)
+        int lo = qMax(0, -lag);
+        int hi = qMin(nb, na - lag);
+        int c = hi - lo;
+        if (c < 2) continue;
+
+        double sab = A[lag >= 0 ? lag : n + lag].real();
+        double xa = sa[hi+lag] - sa[lo+lag];
+        double xaa = saa[hi+lag] - saa[lo+lag];
+        double xb = sb[hi] - sb[lo];
+        double xbb = sbb[hi] - sbb[lo];
+
+        double va = c * xaa - xa * xa;
+        double vb = c * xbb - xb * xb;
+        if (va <= 0 || vb <= 0) continue; // flat
+
+        returning[lag - minLag] = (c * sab - xa * xb) / sqrt(va * vb);
+    }
+    return returning;
+}
+
+double
+SignalAlign::correlation(const QVector<double> &a, const QVector<double> &b, int lag)
+{
+    int lo = qMax(0, -lag);
+    int hi = qMin(b.count(), a.count() - lag);
+    int c = hi - lo;
+    if (c < 2) return 0;
+
+    double ma = 0, mb = 0;
+    for (int i=lo; i<hi; i++) {
+        ma += a[i+lag];
+        mb += b[i];
+    }
+    ma /= double(c);
+    mb /= double(c);
+
+    double sab = 0, saa = 0, sbb = 0;
+    for (int i=lo; i<hi; i++) {
+        double x = a[i+lag] - ma;
+        double y = b[i] - mb;
+        sab += x * y;
+        saa += x * x;
+        sbb += y * y;
+    }
+    if (saa <= 0 || sbb <= 0) return 0;
+    return sab / sqrt(saa * sbb);
+}
+
+QVector<double>
+SignalAlign::halve(const QVector<double> &x)
+{
+    QVector<double> returning(x.count() / 2);
+    for (int i=0; i<returning.count(); i++) returning[i] = (x[2*i] + x[2*i+1]) / 2.0;
+    return returning;
+}
+
+int
+SignalAlign::align(const QVector<double> &a, const QVector<double> &b, int minLag, int maxLag, double &r)
+{
+    r = 0;
+    if (maxLag < minLag) return 0;
+
+    // long recordings, find roughly where at half the resolution
+    // then look either side of that at this resolution
+    if ((a.count() > SIGNALALIGN_COARSE || b.count() > SIGNALALIGN_COARSE) &&
+        (maxLag - minLag) > 4 * SIGNALALIGN_REFINE) {
+
+        double coarse;
+        int lag = 2 * align(halve(a), halve(b), (minLag / 2) - 1, (maxLag / 2) + 1, coarse);
+        lag = qBound(minLag, lag, maxLag);
+
+        int best = lag;
+        r = -2; // less than any r
+        for (int l=qMax(minLag, lag - SIGNALALIGN_REFINE); l<=qMin(maxLag, lag + SIGNALALIGN_REFINE); l++) {
+            double rl = correlation(a, b, l);
+            if (rl > r) {
+                r = rl;
+                best = l;
+            }
+        }
+        return best;
+    }
+
+    // short enough to look at every lag
+    QVector<double> rs = correlate(a, b, minLag, maxLag);
+    int best = minLag;
+    r = rs[0];
+    for (int i=1; i<rs.count(); i++) {
+        if (rs[i] > r) {
+            r = rs[i];
+            best = minLag + i;
+        }
+    }
+    return best;
+}
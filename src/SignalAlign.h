@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_SignalAlign_h
+#define _GC_SignalAlign_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+
+// recordings longer than this are searched coarse to fine
+#define SIGNALALIGN_COARSE 16384
+
+// lags either side of the coarse answer checked at the finer resolution
+#define SIGNALALIGN_REFINE 2
+
+//
+// Finding the lag between two recordings of the same thing, e.g. a shared
+// series in two devices recording the same ride, or heart rate lagging
+// power in the same ride. Samples are at the same, regular, interval.
+//
+// The measure is the normalised cross-correlation (Pearson r) of the
+// samples that overlap at each lag. The cross products for every lag at
+// once are computed with an FFT and the sums and sums of squares of the
+// overlaps from prefix sums, so it is O(n log n) rather than O(n) per lag.
+//
+// Long recordings are averaged down until short enough, searched in full,
+// then the answer is refined within a few lags at each finer resolution.
+//
+// Lags are the offset of b into a; b[i] is compared with a[i+lag].
+//
+class SignalAlign
+{
+    public:
+
+        // r for every lag from minLag to maxLag inclusive, 0 where
+        // the overlap is too short or either side is constant
+        static QVector<double> correlate(const QVector<double> &a, const QVector<double> &b,
+                                         int minLag, int maxLag);
+
+        // r for one lag
+        static double correlation(const QVector<double> &a, const QVector<double> &b, int lag);
+
+        // the lag with the best r, which is returned in r
+        static int align(const QVector<double> &a, const QVector<double> &b,
+                         int minLag, int maxLag, double &r);
+
+    private:
+        static QVector<double> halve(const QVector<double> &x);
+};
+
+#endif // _GC_SignalAlign_h
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Smoother.h"
+#include "RideFile.h" // for NoTemp
+
+#include <QMutexLocker>
+#include <cmath>
+
+#if QT_VERSION > 0x050000
+# include <QtConcurrent>
+#else
+# include <QtConcurrentRun>
+#endif
+
+Smoother::Smoother() : generation(0), aborted(false)
+{
+}
+
+Smoother::~Smoother()
+{
+    cancel();
+}
+
+void
+Smoother::clear()
+{
+    cancel();
+
+    QMutexLocker locker(&lock);
+    generation++;
+    upto.clear();
+    before.clear();
+    cache.clear();
+    windows.clear();
+}
+
+void
+Smoother::cancel()
+{
+    aborted = true;
+    future.waitForFinished();
+    aborted = false;
+}
+
+bool
+Smoother::timebase(const QVector<double> &time, QVector<int> &u, QVector<int> &b, int &g)
+{
+    if (time.isEmpty()) return false;
+
+    QMutexLocker locker(&lock);
+
+    if (upto.isEmpty()) {
+
+        // one entry per second, the same as AllPlot::recalc
+        int secs = (int) ceil(time.last());
+        if (secs < 0) secs = 0;
+
+        upto.resize(secs + 1);
+        before.resize(secs + 1);
+
+        int i = 0, j = 0;
+        for (int s=0; s<=secs; s++) {
+            while (i < time.count() && time[i] <= s) i++;
+            while (j < time.count() && time[j] < s) j++;
+            upto[s] = i;
+            before[s] = j;
+        }
+    }
+
+    u = upto;
+    b = before;
+    g = generation;
+    return true;
+}
+
+QVector<double>
+Smoother::compute(const QVector<int> &u, const QVector<int> &b, const Series &series, int window, bool cancellable)
+{
+    const int n = series.values.count();
+    const int secs = u.count();
+
+    QVector<double> returning(secs);
+    if (n == 0) {
+        returning.fill(0.0);
+        return returning;
+    }
+
+    // prefix sums of the samples, as read
+    QVector<double> sum(n + 1);
+    const double *v = series.values.constData();
+    double *p = sum.data();
+    double last = 0;
+
+    p[0] = 0;
+    switch (series.t) {
+    case Raw:
+        for (int i=0; i<n; i++) p[i+1] = p[i] + v[i];
+        break;
+    case Positive:
+        for (int i=0; i<n; i++) p[i+1] = p[i] + (v[i] > 0 ? v[i] : 0);
+        break;
+    case Balance:
+        for (int i=0; i<n; i++) p[i+1] = p[i] + (v[i] > 0 ? v[i] : 50);
+        break;
+    case Temperature:
+        for (int i=0; i<n; i++) {
+            if (v[i] != RideFile::NoTemp) last = v[i];
+            p[i+1] = p[i] + last;
+        }
+        break;
+    }
+
+    // mean of the samples in [s - window, s], as AllPlot::recalc always did
+    const int *hi = u.constData();
+    const int *lo = b.constData();
+    double *out = returning.data();
+
+    for (int s=0; s<secs; s++) {
+
+        // every now and then check if we have been told to stop
+        if (cancellable && (s & 4095) == 0 && aborted) return QVector<double>();
+
+        int h = hi[s];
+        int l = (s - window >= 0) ? lo[s - window] : 0;
+
+        if (h > l) out[s] = (p[h] - p[l]) / double(h - l);
+        else if (series.hold) out[s] = s > 0 ? out[s-1] : v[0];
+        else out[s] = 0;
+    }
+    return returning;
+}
+
+void
+Smoother::remember(QPair<int,int> key, QVector<double> values)
+{
+    // make room, dropping the least recently used window
+    windows.removeAll(key.second);
+    windows.prepend(key.second);
+    while (windows.count() > SMOOTHER_WINDOWS) {
+        int drop = windows.takeLast();
+        QMutableHashIterator<QPair<int,int>, QVector<double> > it(cache);
+        while (it.hasNext()) {
+            it.next();
+            if (it.key().second == drop) it.remove();
+        }
+    }
+    cache.insert(key, values);
+}
+
+QVector<double>
+Smoother::smooth(const QVector<double> &time, const Series &series, int window)
+{
+    QVector<int> u, b;
+    int g;
+    if (!timebase(time, u, b, g)) return QVector<double>();
+
+    // absent series are all zero, not worth caching
+    if (series.values.isEmpty()) return QVector<double>(u.count(), 0.0);
+
+    QPair<int,int> key(series.id, window);
+    {
+        QMutexLocker locker(&lock);
+        if (cache.contains(key)) {
+            windows.removeAll(window);
+            windows.prepend(window);
+            return cache.value(key);
+        }
+    }
+
+    QVector<double> returning = compute(u, b, series, window, false);
+
+    QMutexLocker locker(&lock);
+    if (g == generation) remember(key, returning);
+    return returning;
+}
+
+QVector<double>
+Smoother::latest(const QVector<double> &time, const QVector<double> &values)
+{
+    QVector<int> u, b;
+    int g;
+    if (!timebase(time, u, b, g)) return QVector<double>();
+
+    QVector<double> returning(u.count());
+    for (int s=0; s<u.count(); s++)
+        returning[s] = (u[s] > 0 && u[s] <= values.count()) ? values[u[s]-1] : 0;
+    return returning;
+}
+
+QVector<int>
+Smoother::samples(const QVector<double> &time, int window)
+{
+    QVector<int> u, b;
+    int g;
+    if (!timebase(time, u, b, g)) return QVector<int>();
+
+    QVector<int> returning(u.count());
+    for (int s=0; s<u.count(); s++)
+        returning[s] = u[s] - ((s - window >= 0) ? b[s - window] : 0);
+    return returning;
+}
+
+QFuture<void>
+Smoother::prepare(const QVector<double> &time, QList<Series> series, int window)
+{
+    // only one at a time
+    cancel();
+
+    future = QtConcurrent::run(this, &Smoother::run, time, series, window);
+    return future;
+}
+
+void
+Smoother::run(QVector<double> time, QList<Series> series, int window)
+{
+    QVector<int> u, b;
+    int g;
+    if (!timebase(time, u, b, g)) return;
+
+    foreach(Series s, series) {
+
+        if (aborted) return;
+        if (s.values.isEmpty()) continue;
+
+        QPair<int,int> key(s.id, window);
+        {
+            QMutexLocker locker(&lock);
+            if (cache.contains(key)) continue;
+        }
+
+        QVector<double> result = compute(u, b, s, window, true);
+        if (aborted) return;
+
+        QMutexLocker locker(&lock);
+        if (g == generation) remember(key, result);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2015 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_Smoother_h
+#define _GC_Smoother_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QFuture>
+
+// how many different window sizes to keep in the cache
+#define SMOOTHER_WINDOWS 4
+
+//
+// Moving average smoothing of ride series, as used by the ride plot
+//
+// Each series is smoothed to one value per second, being the mean of the
+// samples timed from window seconds before it up to and including it.
+// Rather than sliding a window of samples across the ride for every
+// series at once we work one column at a time using prefix sums, so the
+// cost is two passes over the series regardless of the window size, and
+// absent series cost nothing.
+//
+// Results are cached per series and window, so moving the smoothing slider
+// back and forth, hovering intervals or reselecting the ride does not
+// recompute. prepare() fills the cache on a worker thread, a subsequent
+// call cancels it if it is still running.
+//
+// The cache must be cleared with clear() whenever the samples change.
+//
+class Smoother
+{
+    public:
+
+        // how samples are read before averaging
+        enum transform { Raw,           // as is
+                         Positive,      // negative values as 0
+                         Balance,       // missing (0) as 50
+                         Temperature    // missing as the previous sample
+                       };
+
+        // a series to smooth, identified by the caller
+        struct Series {
+            Series() : id(0), t(Raw), hold(false) {}
+            Series(int id, QVector<double> values, transform t = Raw, bool hold = false)
+                  : id(id), values(values), t(t), hold(hold) {}
+
+            int id;
+            QVector<double> values;
+            transform t;
+            bool hold; // seconds with no samples repeat the last value rather than 0
+        };
+
+        Smoother();
+        ~Smoother();
+
+        // the samples changed, forget everything
+        void clear();
+
+        // one value per second for the ride, all series have the
+        // same number of seconds, an empty series gives all zeroes
+        QVector<double> smooth(const QVector<double> &time, const Series &series, int window);
+
+        // value of the last sample at or before each second
+        QVector<double> latest(const QVector<double> &time, const QVector<double> &values);
+
+        // how many samples were averaged for each second
+        QVector<int> samples(const QVector<double> &time, int window);
+
+        // smooth on a worker thread to fill the cache
+        QFuture<void> prepare(const QVector<double> &time, QList<Series> series, int window);
+        void cancel();
+
+    private:
+        QMutex lock;
+        int generation;               // bumped by clear()
+        volatile bool aborted;
+        QFuture<void> future;
+
+        // timebase, for second s the samples at or before s are
+        // [0, upto[s]) and the samples before s are [0, before[s])
+        QVector<int> upto, before;
+        QHash<QPair<int,int>, QVector<double> > cache; // (series, window)
+        QList<int> windows;                             // most recent first
+
+        bool timebase(const QVector<double> &time, QVector<int> &upto, QVector<int> &before, int &generation);
+        QVector<double> compute(const QVector<int> &upto, const QVector<int> &before,
+                                const Series &series, int window, bool cancellable);
+        void remember(QPair<int,int> key, QVector<double> values); // lock must be held
+        void run(QVector<double> time, QList<Series> series, int window);
+};
+
+#endif // _GC_Smoother_h
@@ -21,6 +21,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QHash>
 #include "TimeUtils.h"
 
 class RideItem;
@@ -60,6 +61,18 @@ class FilterSet
         }
 
         int count() { return filters_.count(); }
+
+        // to tell filter sets apart, the filter text itself in a
+        // canonical order since the lists are and'ed and order is moot
+        QString key() {
+            QStringList lists;
+            foreach(QStringList list, filters_) {
+                list.sort();
+                lists << list.join(QString(QChar(0)));
+            }
+            lists.sort();
+            return lists.join(QString(QChar(1)));
+        }
 };
 
 class Specification
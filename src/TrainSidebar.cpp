@@ -17,6 +17,7 @@
  */
 
 #include "TrainSidebar.h"
+#include "GcTrace.h"
 #include "MainWindow.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -38,6 +39,7 @@
 #include "ComputrainerController.h"
 #include "ANTlocalController.h"
 #include "NullController.h"
+#include "ReplayController.h"
 #ifdef GC_HAVE_WFAPI
 #include "KickrController.h"
 #endif
@@ -545,6 +547,8 @@ TrainSidebar::configChanged(qint32)
 #endif
         } else if (Devices.at(i).type == DEV_NULL) {
             Devices[i].controller = new NullController(this, &Devices[i]);
+        } else if (Devices.at(i).type == DEV_REPLAY) {
+            Devices[i].controller = new ReplayController(this, &Devices[i]);
         } else if (Devices.at(i).type == DEV_ANTLOCAL) {
             Devices[i].controller = new ANTlocalController(this, &Devices[i]);
 #ifdef GC_HAVE_WFAPI
@@ -1071,6 +1075,7 @@ void TrainSidebar::updateData(RealtimeData &rtData)
 
 void TrainSidebar::guiUpdate()           // refreshes the telemetry
 {
+    GC_TRACE("TrainSidebar::guiUpdate");
     RealtimeData rtData;
     rtData.setLap(displayLap + displayWorkoutLap); // user laps + predefined workout lap
     rtData.mode = mode;
@@ -1118,7 +1123,7 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
 					// to within defined limits					
 				}
 
-                if (Devices[dev].type == DEV_ANTLOCAL || Devices[dev].type == DEV_NULL) {
+                if (Devices[dev].type == DEV_ANTLOCAL || Devices[dev].type == DEV_NULL || Devices[dev].type == DEV_REPLAY) {
                     rtData.setHb(local.getSmO2(), local.gettHb()); //only moxy data from ant and robot devices right now
                 }
 				
@@ -1179,7 +1184,7 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
             // virtual speed
             double crr = 0.004f; // typical for asphalt surfaces
             double g = 9.81;     // g constant 9.81 m/s
-            double weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, 0.0).toDouble();
+            double weight = context->athlete->config()->weight();
             double m = weight ? weight + 8 : 83; // default to 75kg weight, plus 8kg bike
             double sl = slope / 100; // 10% = 0.1
             double ad = 1.226f; // default air density at sea level
@@ -1207,7 +1212,7 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
 
             // W'bal on the fly
             // using Dave Waterworth's reformulation
-            double TAU = appsettings->cvalue(context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+            double TAU = context->athlete->config()->wbalTau();
 
             // any watts expended in last 200msec?
             double JOULES = double(rtData.getWatts() - FTP) / 5.00f;
@@ -1274,6 +1279,7 @@ void TrainSidebar::warnnoConfig()
 //----------------------------------------------------------------------
 void TrainSidebar::diskUpdate()
 {
+    GC_TRACE("TrainSidebar::diskUpdate");
     int  secs;
 
     long torq = 0, altitude = 0;
@@ -1321,6 +1327,7 @@ void TrainSidebar::diskUpdate()
 
 void TrainSidebar::loadUpdate()
 {
+    GC_TRACE("TrainSidebar::loadUpdate");
     int curLap;
 
     // we hold our horses whilst calibration is taking place...
@@ -49,6 +49,7 @@
 
 
 #include "WPrime.h"
+#include "GcTrace.h"
 #include "Units.h" // for MILES_PER_KM
 #include "Settings.h" // for GC_WBALFORM
 
@@ -83,8 +84,7 @@ WPrime::setRide(RideFile *input)
 {
     bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
 
-    QTime time; // for profiling performance of the code
-    time.start();
+    GC_TRACE("WPrime::setRide");
 
     // remember the ride for next time
     rideFile = input;
@@ -151,7 +151,7 @@ WPrime::setRide(RideFile *input)
     // Get CP
     CP = 250; // default
     if (input->context->athlete->zones()) {
-        int zoneRange = input->context->athlete->zones()->whichRange(input->startTime().date());
+        int zoneRange = input->context->athlete->config()->zoneRange(input->startTime().date());
         CP = zoneRange >= 0 ? input->context->athlete->zones()->getCP(zoneRange) : 0;
         WPRIME = zoneRange >= 0 ? input->context->athlete->zones()->getWprime(zoneRange) : 0;
 
@@ -254,8 +254,6 @@ WPrime::setRide(RideFile *input)
     if (minY < -30000) minY = 0; // the data is definitely out of bounds!
                                  // so lets not exacerbate the problem - truncate
 
-    //qDebug()<<"compute W'bal curve took"<<time.elapsed();
-
     // STEP 3: FIND MATCHES
 
     // SMOOTH DATA SERIES 
@@ -342,8 +340,7 @@ WPrime::setErg(ErgFile *input)
 {
     bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
 
-    QTime time; // for profiling performance of the code
-    time.start();
+    GC_TRACE("WPrime::setErg");
 
     // reset from previous
     values.resize(0); // the memory is kept for next time so this is efficient
@@ -393,7 +390,7 @@ WPrime::setErg(ErgFile *input)
             } else EXP += value; // total expenditure above CP
         }
 
-        TAU = appsettings->cvalue(input->context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+        TAU = input->context->athlete->config()->wbalTau();
 
         // lets run forward from 0s to end of ride
         values.resize(last+1);
@@ -17,7 +17,7 @@
  */
 
 #include "RideMetric.h"
-#include "BestIntervalDialog.h"
+#include "IntervalSearch.h"
 #include "Zones.h"
 #include "Settings.h"
 #include <cmath>
@@ -88,9 +88,8 @@ class PeakWPK : public RideMetric {
         if (!ride->dataPoints().isEmpty()) {
             weight = uride->getWeight();
             //weight = ride->getTag("Weight", appsettings->cvalue(GC_WEIGHT, "75.0").toString()).toDouble(); // default to 75kg
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0 && results.first().avg < 3000) wpk = results.first().avg / weight;
+            IntervalSearch::Result best = IntervalSearch(ride).peak(secs);
+            if (best.isValid() && best.avg < 3000) wpk = best.avg / weight;
             else wpk = 0.0;
         } else {
             wpk = 0.0;
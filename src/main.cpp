@@ -28,6 +28,7 @@
 #include "Colors.h"
 
 #include "GcUpgrade.h"
+#include "GcBatch.h"
 
 // redirect errors to `home'/goldencheetah.log
 // sadly, no equivalent on Windows
@@ -85,6 +86,7 @@ main(int argc, char *argv[])
 #endif
 
     bool help = false;
+    bool batch = false;
 
     // honour command line switches
     foreach (QString arg, sargs) {
@@ -102,6 +104,11 @@ main(int argc, char *argv[])
 #endif
             fprintf (stderr, "\nSpecify the folder and/or athlete to open on startup\n");
             fprintf(stderr, "If no parameters are passed it will reopen the last athlete.\n\n");
+            fprintf(stderr, "--batch             to process athletes without opening a window, see --batch --help\n\n");
+
+        } else if (arg == "--batch") {
+
+            batch = true;
 
         } else if (arg == "--debug") {
 
@@ -121,9 +128,13 @@ main(int argc, char *argv[])
 
     // help or version printed so just exit now
     if (help) {
+        if (batch) GcBatch::usage();
         exit(0);
     }
 
+    // nobody to answer any dialogs, and no windows
+    if (batch) gcbatch = true;
+
     //
     // INITIALISE ONE TIME OBJECTS
     //
@@ -142,7 +153,10 @@ main(int argc, char *argv[])
 #endif
 
     // create the application -- only ever ONE regardless of restarts
-    QApplication *application = new QApplication(argc, argv);
+    // batch doesn't open any windows so doesn't need a display
+    QCoreApplication *application;
+    if (batch) application = new QCoreApplication(argc, argv);
+    else application = new QApplication(argc, argv);
 
 #ifdef Q_OS_MAC
     // get an autorelease pool setup
@@ -150,10 +164,12 @@ main(int argc, char *argv[])
 #endif
 
     // set defaultfont
-    QFont font;
-    font.fromString(appsettings->value(NULL, GC_FONT_DEFAULT, QFont().toString()).toString());
-    font.setPointSize(appsettings->value(NULL, GC_FONT_DEFAULT_SIZE, 10).toInt());
-    application->setFont(font); // set default font
+    if (!batch) {
+        QFont font;
+        font.fromString(appsettings->value(NULL, GC_FONT_DEFAULT, QFont().toString()).toString());
+        font.setPointSize(appsettings->value(NULL, GC_FONT_DEFAULT_SIZE, 10).toInt());
+        QApplication::setFont(font); // set default font
+    }
 
     // set default colors
     GCColor::setupColors();
@@ -213,7 +229,8 @@ main(int argc, char *argv[])
                     if (!home.mkpath(libraryPath)) {
 
                         // tell user why we aborted !
-                        QMessageBox::critical(NULL, "Exiting", QString("Cannot create library directory (%1)").arg(libraryPath));
+                        if (batch) fprintf(stderr, "Cannot create library directory (%s)\n", libraryPath.toLocal8Bit().constData());
+                        else QMessageBox::critical(NULL, "Exiting", QString("Cannot create library directory (%1)").arg(libraryPath));
                         exit(0);
                     }
                 }
@@ -226,7 +243,7 @@ main(int argc, char *argv[])
 
         // now redirect stderr
 #ifndef WIN32
-        if (!debug) nostderr(home.canonicalPath());
+        if (!debug && !batch) nostderr(home.canonicalPath());
 #endif
 
         // install QT Translator to enable QT Dialogs translation
@@ -246,6 +263,15 @@ main(int argc, char *argv[])
         // Initialize metrics once the translator is installed
         RideMetricFactory::instance().initialize();
 
+        // batch processing, then exit, there are no charts or workouts
+        if (batch) {
+            GcBatch *b = new GcBatch(home, args.mid(1));
+            ret = b->exec();
+            delete b;
+            delete application;
+            return ret;
+        }
+
         // Initialize global registry once the translator is installed
         GcWindowRegistry::initialize();
 
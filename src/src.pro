@@ -272,6 +272,7 @@ HEADERS += \
         ANTMessages.h \
         ANTlocalController.h \
         Athlete.h \
+        AthleteConfig.h \
         BatchExportDialog.h \
         BestIntervalDialog.h \
         BinRideFile.h \
@@ -295,6 +296,7 @@ HEADERS += \
         CpPlotCurve.h \
         CPPlot.h \
         CriticalPowerWindow.h \
+        CsvLine.h \
         CsvRideFile.h \
         DataProcessor.h \
         DaysScaleDraw.h \
@@ -310,13 +312,17 @@ HEADERS += \
         ErgDBDownloadDialog.h \
         ErgFilePlot.h \
         ExtendedCriticalPower.h \
+        FileJournal.h \
         FitlogRideFile.h \
         FitlogParser.h \
         FitRideFile.h \ 
         GenerateHeatMapDialog.h \
         GcCalendarModel.h \
+        GcBatch.h \
+        GcBenchmark.h \
         GcCrashDialog.h \
         GcOverlayWidget.h \
+        GcTrace.h \
         GcPane.h \
         GcRideFile.h \
         GcScopeBar.h \
@@ -346,6 +352,7 @@ HEADERS += \
         LapsEditor.h \
         Library.h \
         LibraryParser.h \
+        LODCurveData.h \
         LogTimeScaleDraw.h \
         LTMCanvasPicker.h \
         LTMChartParser.h \
@@ -364,6 +371,7 @@ HEADERS += \
         ManualRideFile.h \
         MergeActivityWizard.h \
         MetadataWindow.h \
+        MetricRollup.h \
         MoxyDevice.h \
         MUPlot.h \
         MUPool.h \
@@ -387,6 +395,7 @@ HEADERS += \
         RealtimeData.h \
         RealtimePlotWindow.h \
         RealtimeController.h \
+        ReplayController.h \
         ReferenceLineDialog.h \
         ComputrainerController.h \
         RealtimePlot.h \
@@ -405,12 +414,16 @@ HEADERS += \
         RideNavigator.h \
         RideNavigatorProxy.h \
         RideWindow.h \
+        RideXmlReader.h \
         IntervalNavigator.h \
+        IntervalSearch.h \
         IntervalNavigatorProxy.h \
         SaveDialogs.h \
         SmallPlot.h \
+        Smoother.h \
         RideSummaryWindow.h \
         Route.h \
+        RouteIndex.h \
         RouteItem.h \
         RouteParser.h \
         RouteWindow.h \
@@ -421,6 +434,7 @@ HEADERS += \
         Serial.h \
         Settings.h \
         ShareDialog.h \
+        SignalAlign.h \
         SpecialFields.h \
         Specification.h \
         SpinScanPlot.h \
@@ -486,6 +500,7 @@ SOURCES += \
         ANTMessage.cpp \
         ANTlocalController.cpp \
         Athlete.cpp \
+        AthleteConfig.cpp \
         BasicRideMetrics.cpp \
         BatchExportDialog.cpp \
         BestIntervalDialog.cpp \
@@ -514,6 +529,7 @@ SOURCES += \
         CpPlotCurve.cpp \
         CPPlot.cpp \
         CriticalPowerWindow.cpp \
+        CsvLine.cpp \
         CsvRideFile.cpp \
         DanielsPoints.cpp \
         DataProcessor.cpp \
@@ -529,6 +545,7 @@ SOURCES += \
         ErgFile.cpp \
         ErgFilePlot.cpp \
         ExtendedCriticalPower.cpp \
+        FileJournal.cpp \
         FitlogRideFile.cpp \
         FitlogParser.cpp \
         FitRideFile.cpp \
@@ -543,8 +560,11 @@ SOURCES += \
         FixTorque.cpp \
         FixHRSpikes.cpp \
         GenerateHeatMapDialog.cpp \
+        GcBatch.cpp \
+        GcBenchmark.cpp \
         GcCrashDialog.cpp \
         GcOverlayWidget.cpp \
+        GcTrace.cpp \
         GcPane.cpp \
         GcRideFile.cpp \
         GcScopeBar.cpp \
@@ -576,6 +596,7 @@ SOURCES += \
         LeftRightBalance.cpp \
         Library.cpp \
         LibraryParser.cpp \
+        LODCurveData.cpp \
         LogTimeScaleDraw.cpp \
         LTMCanvasPicker.cpp \
         LTMChartParser.cpp \
@@ -593,6 +614,7 @@ SOURCES += \
         ManualRideFile.cpp \
         MergeActivityWizard.cpp \
         MetadataWindow.cpp \
+        MetricRollup.cpp \
         MoxyDevice.cpp \
         MUPlot.cpp \
         MUWidget.cpp \
@@ -616,6 +638,7 @@ SOURCES += \
         RawRideFile.cpp \
         RealtimeData.cpp \
         RealtimeController.cpp \
+        ReplayController.cpp \
         ComputrainerController.cpp \
         RealtimePlot.cpp \
         RealtimePlotWindow.cpp \
@@ -635,8 +658,11 @@ SOURCES += \
         RideNavigator.cpp \
         RideSummaryWindow.cpp \
         RideWindow.cpp \
+        RideXmlReader.cpp \
         IntervalNavigator.cpp \
+        IntervalSearch.cpp \
         Route.cpp \
+        RouteIndex.cpp \
         RouteItem.cpp \
         RouteParser.cpp \
         RouteWindow.cpp \
@@ -648,7 +674,9 @@ SOURCES += \
         Serial.cpp \
         Settings.cpp \
         ShareDialog.cpp \
+        SignalAlign.cpp \
         SmallPlot.cpp \
+        Smoother.cpp \
         SpecialFields.cpp \
         Specification.cpp \
         SpinScanPlot.cpp \
@@ -727,6 +755,17 @@ TRANSLATIONS = translations/gc_fr.ts \
 
 } else:message(No translation files in project)
 
+# make benchmarks, over the sample rides and workouts in test
+# results are written to benchmarks.json to compare between builds
+macx {
+    BENCHMARK_BIN = ./$${TARGET}.app/Contents/MacOS/$${TARGET}
+} else {
+    BENCHMARK_BIN = ./$${TARGET}
+}
+benchmarks.commands = $$BENCHMARK_BIN --batch --benchmark=benchmarks.json --corpus=$$PWD/../test
+benchmarks.depends = all
+QMAKE_EXTRA_TARGETS += benchmarks
+
 OTHER_FILES += \
     web/Rider.js \
     web/ride.js \